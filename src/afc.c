@@ -0,0 +1,155 @@
+
+#include <stdint.h>
+
+#include "error.h"
+#include "bang_registers.h"
+#include "doppler_table.h"
+#include "afc.h"
+
+#define AFC_MAX_SHIFT 8
+
+static int32_t s_AFC_round_q8(int32_t q8) {
+	if (q8 >= 0) {
+		return (q8 + 128) / 256;
+	}
+	return -((-q8 + 128) / 256);
+}
+
+static uint32_t s_AFC_sqrt(uint64_t x) {
+	uint64_t r = 0;
+	uint64_t bit = (uint64_t)1 << 62;
+
+	while (bit > x) {
+		bit >>= 2;
+	}
+	while (bit) {
+		if (x >= r + bit) {
+			x -= r + bit;
+			r = (r >> 1) + bit;
+		}
+		else {
+			r >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t)r;
+}
+
+/*
+	Writes word to FREQOFF1/FREQOFF0, just FREQOFF0 if that is
+	all that changed, nothing if neither did.
+*/
+static tcvr_error_t s_AFC_write(afc* a, uint16_t word, uint8_t* status) {
+	tcvr_error_t err;
+	uint8_t      data[2];
+
+	if (a->written && word == a->word) {
+		return ERROR_NONE;
+	}
+
+	if (a->written && (word >> 8) == (a->word >> 8)) {
+		err = REGISTER_write(FREQOFF0, (uint8_t)(word & 0xff), status);
+	}
+	else {
+		// FREQOFF1 holds the high byte, FREQOFF0 follows it
+		data[0] = (uint8_t)(word >> 8);
+		data[1] = (uint8_t)(word & 0xff);
+		err = REGISTER_burst_write(FREQOFF1, data, 2, status);
+	}
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	a->word = word;
+	a->written = 1;
+	a->writes++;
+	return ERROR_NONE;
+}
+
+tcvr_error_t AFC_init(afc* a, const doppler_table* dt, uint8_t shift, uint16_t max_step) {
+	if (!a || !dt) {
+		return ERROR_NULL_POINTER;
+	}
+	if (shift > AFC_MAX_SHIFT) {
+		return ERROR_PARAMETER_OUT_OF_RANGE;
+	}
+
+	a->dt = dt;
+	a->shift = shift;
+	a->max_step = max_step;
+	a->correction_q8 = 0;
+	a->word = 0;
+	a->written = 0;
+
+	a->updates = 0;
+	a->rejected = 0;
+	a->writes = 0;
+	a->sum_abs = 0;
+	a->sum_sq = 0;
+	a->max_abs = 0;
+	return ERROR_NONE;
+}
+
+tcvr_error_t AFC_track(afc* a, uint32_t t, uint8_t* status) {
+	tcvr_error_t  err;
+	doppler_point dp;
+
+	if (!a) {
+		return ERROR_NULL_POINTER;
+	}
+
+	err = DOPPLER_TABLE_lookup(a->dt, t, &dp);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	return s_AFC_write(a, (uint16_t)(dp.freqoff + s_AFC_round_q8(a->correction_q8)), status);
+}
+
+tcvr_error_t AFC_update(afc* a, uint32_t t, uint8_t* status) {
+	tcvr_error_t err;
+	uint8_t      data[2];
+	int32_t      est;
+	uint32_t     mag;
+
+	if (!a) {
+		return ERROR_NULL_POINTER;
+	}
+
+	err = REGISTER_burst_read(FREQOFF_EST1, data, 2, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+	est = (int16_t)((data[0] << 8) | data[1]);
+	mag = (uint32_t)((est < 0) ? -est : est);
+
+	if (mag > a->max_step) {
+		a->rejected++;
+		return ERROR_NONE;
+	}
+
+	a->updates++;
+	a->sum_abs += mag;
+	a->sum_sq += (uint64_t)mag * mag;
+	if (mag > a->max_abs) {
+		a->max_abs = mag;
+	}
+
+	// the estimate is how far off the current tuning still is
+	a->correction_q8 += est * 256 / (1 << a->shift);
+	return AFC_track(a, t, status);
+}
+
+void AFC_report(const afc* a, afc_report* out) {
+	if (!a || !out) {
+		return;
+	}
+
+	out->updates = a->updates;
+	out->rejected = a->rejected;
+	out->writes = a->writes;
+	out->correction = s_AFC_round_q8(a->correction_q8);
+	out->mean_abs = a->updates ? (uint32_t)(a->sum_abs / a->updates) : 0;
+	out->rms = a->updates ? s_AFC_sqrt(a->sum_sq / a->updates) : 0;
+	out->max_abs = a->max_abs;
+}
@@ -0,0 +1,89 @@
+#ifndef _AFC_H_
+#define _AFC_H_
+
+#include <stdint.h>
+#include "error.h"
+#include "doppler_table.h"
+
+/*
+	Closed-loop frequency tracking for a pass. The receiver is
+	tuned to the Doppler table's prediction plus a correction,
+	and after each packet the chip's own estimate of how far off
+	it still was (FREQOFF_EST) moves the correction by
+	1/2^shift of that, so one noisy estimate can't throw it.
+	This is what SAFC does in one step, less the filtering.
+
+	The correction soaks up whatever the prediction got wrong:
+	the orbit model, timing and both crystals. Estimates larger
+	than max_step are taken as a bad packet and ignored.
+
+	FREQOFF is only written when the word changes, and only
+	FREQOFF0 if the high byte stays the same.
+
+	All frequencies are FREQOFF words, see doppler_table.h.
+	Tracking is for RX; TX still goes through
+	DOPPLER_TABLE_retune.
+*/
+typedef struct afc_s {
+	const doppler_table* dt;
+	uint8_t              shift;
+	uint16_t             max_step;
+	int32_t              correction_q8;  // 1/256ths of a word
+	uint16_t             word;           // last written to FREQOFF
+	int                  written;
+
+	// this pass
+	uint32_t             updates;
+	uint32_t             rejected;
+	uint32_t             writes;
+	uint64_t             sum_abs;
+	uint64_t             sum_sq;
+	uint32_t             max_abs;
+} afc;
+
+/*
+	Residual error for a pass, ie. the estimates the loop was
+	fed, after the prediction and correction already applied.
+*/
+typedef struct afc_report_s {
+	uint32_t updates;
+	uint32_t rejected;
+	uint32_t writes;
+	int32_t  correction;     // on top of the prediction, at the end
+	uint32_t mean_abs;
+	uint32_t rms;
+	uint32_t max_abs;
+} afc_report;
+
+/*
+	Starts tracking a pass predicted by dt with a loop gain of
+	1/2^shift, from no correction.
+	Returns ERROR_NONE if successful, ERROR_PARAMETER_OUT_OF_RANGE
+	if shift is over 8.
+*/
+tcvr_error_t AFC_init(afc* a, const doppler_table* dt, uint8_t shift, uint16_t max_step);
+
+/*
+	Retunes to the prediction for mission time t plus the
+	correction, if that changes FREQOFF. Meant to be called as
+	time goes by, eg. once a second.
+	Returns ERROR_NONE if successful, or the error from
+	DOPPLER_TABLE_lookup or the register writes.
+*/
+tcvr_error_t AFC_track(afc* a, uint32_t t, uint8_t* status);
+
+/*
+	Reads FREQOFF_EST after a packet has been received at
+	mission time t, moves the correction and retunes.
+	Returns ERROR_NONE if successful, including when the
+	estimate was rejected, or the error from the register
+	accesses or AFC_track.
+*/
+tcvr_error_t AFC_update(afc* a, uint32_t t, uint8_t* status);
+
+/*
+	Outputs the residual error so far this pass.
+*/
+void AFC_report(const afc* a, afc_report* out);
+
+#endif
@@ -0,0 +1,348 @@
+
+#include <stdint.h>
+#include <string.h>
+
+#include "error.h"
+#include "crc.h"
+#include "arq.h"
+
+// how much of each new measurement goes into the smoothed loss, 1/2^n
+#define ARQ_LOSS_SHIFT 3
+
+#define ARQ_SLOT(seq) ((uint16_t)(seq) % ARQ_MAX_WINDOW)
+
+static void s_ARQ_put16(uint8_t* p, uint16_t v) {
+	p[0] = (uint8_t)(v & 0xff);
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t s_ARQ_get16(const uint8_t* p) {
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/*
+	Appends the CRC to the len bytes at frame.
+*/
+static void s_ARQ_seal(uint8_t* frame, uint8_t len) {
+	s_ARQ_put16(&frame[len], CRC16(frame, len));
+}
+
+/*
+	Folds n_lost out of n_lost + n_acked into the smoothed loss
+	and sizes the window from it.
+*/
+static void s_ARQ_tx_measure(arq_tx* tx, uint32_t n_lost, uint32_t n_acked) {
+	int32_t  sample;
+	uint32_t loss;
+
+	if (n_lost + n_acked == 0) {
+		return;
+	}
+
+	sample = (int32_t)(n_lost * 256 / (n_lost + n_acked));
+	tx->loss_q8 = (uint16_t)((int32_t)tx->loss_q8 + (sample - (int32_t)tx->loss_q8) / (1 << ARQ_LOSS_SHIFT));
+
+	loss = tx->loss_q8;
+	if (loss > ARQ_LOSS_FOR_MIN_WINDOW) {
+		loss = ARQ_LOSS_FOR_MIN_WINDOW;
+	}
+	tx->window = (uint16_t)(ARQ_MAX_WINDOW - (ARQ_MAX_WINDOW - ARQ_MIN_WINDOW) * loss / ARQ_LOSS_FOR_MIN_WINDOW);
+}
+
+void ARQ_tx_init(arq_tx* tx, uint32_t rto) {
+	if (!tx) {
+		return;
+	}
+
+	memset(tx, 0, sizeof(*tx));
+	tx->window = ARQ_MAX_WINDOW;
+	tx->rto = rto;
+}
+
+tcvr_error_t ARQ_tx_submit(arq_tx* tx, const uint8_t* payload, uint8_t len) {
+	arq_tx_slot* slot;
+
+	if (!tx || (!payload && len)) {
+		return ERROR_NULL_POINTER;
+	}
+	if (len > ARQ_MAX_PAYLOAD) {
+		return ERROR_ARQ_PAYLOAD_TOO_LONG;
+	}
+	if ((uint16_t)(tx->next - tx->base) >= tx->window) {
+		return ERROR_ARQ_WINDOW_FULL;
+	}
+
+	slot = &tx->slots[ARQ_SLOT(tx->next)];
+	memcpy(slot->data, payload, len);
+	slot->len = len;
+	slot->state = ARQ_SLOT_QUEUED;
+	slot->sends = 0;
+
+	tx->next++;
+	tx->submitted++;
+	return ERROR_NONE;
+}
+
+tcvr_error_t ARQ_tx_next(arq_tx* tx, uint32_t now, uint8_t* out, uint8_t max, uint8_t* out_len) {
+	arq_tx_slot* slot = 0;
+	uint16_t     seq;
+
+	if (!tx || !out || !out_len) {
+		return ERROR_NULL_POINTER;
+	}
+	*out_len = 0;
+
+	// in sequence order, anything lost comes before anything new
+	for (seq = tx->base; seq != tx->next; seq++) {
+		slot = &tx->slots[ARQ_SLOT(seq)];
+		if (slot->state == ARQ_SLOT_QUEUED) {
+			break;
+		}
+		if (slot->state == ARQ_SLOT_SENT && now - slot->sent_at >= tx->rto) {
+			tx->timeouts++;
+			s_ARQ_tx_measure(tx, 1, 0);
+			break;
+		}
+	}
+	if (seq == tx->next) {
+		return ERROR_NONE;
+	}
+
+	if (slot->len + ARQ_DATA_OVERHEAD > max) {
+		return ERROR_ARQ_BUFFER_TOO_SMALL;
+	}
+
+	out[0] = ARQ_TYPE_DATA;
+	s_ARQ_put16(&out[1], seq);
+	memcpy(&out[3], slot->data, slot->len);
+	s_ARQ_seal(out, (uint8_t)(slot->len + 3));
+	*out_len = (uint8_t)(slot->len + ARQ_DATA_OVERHEAD);
+
+	if (slot->sends) {
+		tx->resent++;
+	}
+	slot->sends++;
+	slot->state = ARQ_SLOT_SENT;
+	slot->sent_at = now;
+	slot->order = ++tx->order;
+	tx->sent++;
+	return ERROR_NONE;
+}
+
+tcvr_error_t ARQ_tx_ack(arq_tx* tx, const uint8_t* frame, uint8_t len) {
+	arq_tx_slot* slot;
+	uint16_t     cum;
+	uint32_t     bitmap;
+	uint32_t     newest = 0;
+	uint32_t     n_acked = 0;
+	uint32_t     n_lost = 0;
+	uint16_t     seq;
+	uint8_t      i;
+
+	if (!tx || !frame) {
+		return ERROR_NULL_POINTER;
+	}
+	if (len != ARQ_ACK_SIZE || frame[0] != ARQ_TYPE_ACK) {
+		tx->bad_acks++;
+		return ERROR_ARQ_BAD_FRAME;
+	}
+	if (CRC16_check(frame, len) != ERROR_NONE) {
+		tx->bad_acks++;
+		return ERROR_CRC_MISMATCH;
+	}
+
+	cum = s_ARQ_get16(&frame[1]);
+	bitmap = (uint32_t)frame[3] | ((uint32_t)frame[4] << 8) |
+	         ((uint32_t)frame[5] << 16) | ((uint32_t)frame[6] << 24);
+
+	// can't have received what hasn't been sent
+	if ((int16_t)(cum - tx->next) > 0) {
+		tx->bad_acks++;
+		return ERROR_ARQ_BAD_FRAME;
+	}
+
+	// everything before cum has arrived
+	while ((int16_t)(cum - tx->base) > 0) {
+		slot = &tx->slots[ARQ_SLOT(tx->base)];
+		if (slot->state == ARQ_SLOT_SENT) {
+			n_acked++;
+		}
+		if (slot->order > newest) {
+			newest = slot->order;
+		}
+		slot->state = ARQ_SLOT_FREE;
+		tx->base++;
+		tx->acked++;
+	}
+
+	// and so have these, out of order
+	for (i = 0; i < 32; i++) {
+		if (!(bitmap & ((uint32_t)1 << i))) {
+			continue;
+		}
+		seq = (uint16_t)(cum + 1 + i);
+		if ((uint16_t)(seq - tx->base) >= (uint16_t)(tx->next - tx->base)) {
+			continue;
+		}
+		slot = &tx->slots[ARQ_SLOT(seq)];
+		if (slot->state == ARQ_SLOT_ACKED || slot->state == ARQ_SLOT_FREE) {
+			continue;
+		}
+		if (slot->state == ARQ_SLOT_SENT) {
+			n_acked++;
+		}
+		if (slot->order > newest) {
+			newest = slot->order;
+		}
+		slot->state = ARQ_SLOT_ACKED;
+	}
+
+	// anything sent before something that got there didn't
+	for (seq = tx->base; seq != tx->next; seq++) {
+		slot = &tx->slots[ARQ_SLOT(seq)];
+		if (slot->state == ARQ_SLOT_SENT && slot->order < newest) {
+			slot->state = ARQ_SLOT_QUEUED;
+			n_lost++;
+			tx->lost++;
+		}
+	}
+
+	// slide past what was acknowledged out of order
+	while (tx->base != tx->next && tx->slots[ARQ_SLOT(tx->base)].state == ARQ_SLOT_ACKED) {
+		tx->slots[ARQ_SLOT(tx->base)].state = ARQ_SLOT_FREE;
+		tx->base++;
+		tx->acked++;
+	}
+
+	s_ARQ_tx_measure(tx, n_lost, n_acked);
+	return ERROR_NONE;
+}
+
+uint16_t ARQ_tx_pending(const arq_tx* tx) {
+	if (!tx) {
+		return 0;
+	}
+	return (uint16_t)(tx->next - tx->base);
+}
+
+void ARQ_rx_init(arq_rx* rx) {
+	if (!rx) {
+		return;
+	}
+
+	memset(rx, 0, sizeof(*rx));
+}
+
+tcvr_error_t ARQ_rx_receive(arq_rx* rx, const uint8_t* frame, uint8_t len) {
+	arq_rx_slot* slot;
+	uint16_t     seq;
+
+	if (!rx || !frame) {
+		return ERROR_NULL_POINTER;
+	}
+	if (len < ARQ_DATA_OVERHEAD || len > ARQ_MAX_FRAME || frame[0] != ARQ_TYPE_DATA) {
+		rx->bad++;
+		return ERROR_ARQ_BAD_FRAME;
+	}
+	if (CRC16_check(frame, len) != ERROR_NONE) {
+		rx->bad++;
+		return ERROR_CRC_MISMATCH;
+	}
+
+	// whatever happens to it, the sender needs to hear back
+	rx->ack_due = 1;
+	rx->received++;
+
+	seq = s_ARQ_get16(&frame[1]);
+	if ((uint16_t)(seq - rx->deliver) >= ARQ_MAX_WINDOW) {
+		if ((int16_t)(seq - rx->deliver) < 0) {
+			rx->duplicates++;
+		}
+		else {
+			rx->out_of_window++;
+		}
+		return ERROR_NONE;
+	}
+
+	slot = &rx->slots[ARQ_SLOT(seq)];
+	if ((int16_t)(seq - rx->expected) < 0 || slot->full) {
+		rx->duplicates++;
+		return ERROR_NONE;
+	}
+
+	slot->len = (uint8_t)(len - ARQ_DATA_OVERHEAD);
+	memcpy(slot->data, &frame[3], slot->len);
+	slot->full = 1;
+
+	while ((uint16_t)(rx->expected - rx->deliver) < ARQ_MAX_WINDOW && rx->slots[ARQ_SLOT(rx->expected)].full) {
+		rx->expected++;
+	}
+	return ERROR_NONE;
+}
+
+tcvr_error_t ARQ_rx_deliver(arq_rx* rx, uint8_t* out, uint8_t max, uint8_t* out_len) {
+	arq_rx_slot* slot;
+
+	if (!rx || !out || !out_len) {
+		return ERROR_NULL_POINTER;
+	}
+	*out_len = 0;
+
+	if (rx->deliver == rx->expected) {
+		return ERROR_NONE;
+	}
+
+	slot = &rx->slots[ARQ_SLOT(rx->deliver)];
+	if (slot->len > max) {
+		return ERROR_ARQ_BUFFER_TOO_SMALL;
+	}
+
+	memcpy(out, slot->data, slot->len);
+	*out_len = slot->len;
+	slot->full = 0;
+	rx->deliver++;
+	rx->delivered++;
+
+	// a full window may have been holding expected back
+	while ((uint16_t)(rx->expected - rx->deliver) < ARQ_MAX_WINDOW && rx->slots[ARQ_SLOT(rx->expected)].full) {
+		rx->expected++;
+	}
+	return ERROR_NONE;
+}
+
+tcvr_error_t ARQ_rx_ack(arq_rx* rx, uint8_t* out, uint8_t max, uint8_t* out_len) {
+	uint32_t bitmap = 0;
+	uint16_t seq;
+	uint8_t  i;
+
+	if (!rx || !out || !out_len) {
+		return ERROR_NULL_POINTER;
+	}
+	*out_len = 0;
+
+	if (max < ARQ_ACK_SIZE) {
+		return ERROR_ARQ_BUFFER_TOO_SMALL;
+	}
+	if (!rx->ack_due) {
+		return ERROR_NONE;
+	}
+
+	for (i = 0; i < 32; i++) {
+		seq = (uint16_t)(rx->expected + 1 + i);
+		if ((uint16_t)(seq - rx->deliver) < ARQ_MAX_WINDOW && rx->slots[ARQ_SLOT(seq)].full) {
+			bitmap |= (uint32_t)1 << i;
+		}
+	}
+
+	out[0] = ARQ_TYPE_ACK;
+	s_ARQ_put16(&out[1], rx->expected);
+	out[3] = (uint8_t)(bitmap & 0xff);
+	out[4] = (uint8_t)(bitmap >> 8);
+	out[5] = (uint8_t)(bitmap >> 16);
+	out[6] = (uint8_t)(bitmap >> 24);
+	s_ARQ_seal(out, 7);
+	*out_len = ARQ_ACK_SIZE;
+
+	rx->ack_due = 0;
+	return ERROR_NONE;
+}
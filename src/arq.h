@@ -0,0 +1,173 @@
+#ifndef _ARQ_H_
+#define _ARQ_H_
+
+#include <stdint.h>
+#include "error.h"
+
+/*
+	Selective-repeat ARQ for bulk downlink. The sender numbers
+	each payload and keeps it until the receiver has it; the
+	receiver holds frames that arrive out of order until the gaps
+	before them are filled, and hands payloads out in order.
+
+	The receiver answers with one ACK per uplink slot, however many
+	frames came in: the first sequence number it is still missing,
+	and a bitmap of which of the ARQ_MAX_WINDOW after that it has.
+	A frame sent before one the bitmap shows as received must
+	have been lost, and is resent straight away. Frames no ACK has
+	covered within rto are resent too.
+
+	Frames (on top of the packet layer, which supplies the length):
+
+		DATA  0x01, uint16 seq, payload, CRC16
+		ACK   0x02, uint16 first missing seq, uint32 bitmap, CRC16
+
+	little-endian, CRC16 as in crc.h, least significant byte first.
+	Bit i of the bitmap is seq first missing + 1 + i.
+
+	Loss is measured from each ACK, what it showed lost against
+	what it acknowledged, and smoothed. The sender's window shrinks
+	linearly from ARQ_MAX_WINDOW at no loss to ARQ_MIN_WINDOW at
+	ARQ_LOSS_FOR_MIN_WINDOW and over, so at low elevation fewer
+	frames pile up behind each hole, and the receiver's window
+	never outruns what it can hold.
+
+	All buffers are inside the structures, nothing is allocated.
+	Times are whatever the caller counts in, eg. milliseconds,
+	and may wrap.
+*/
+#define ARQ_MAX_WINDOW   32  // one bitmap's worth
+#define ARQ_MIN_WINDOW   4
+#define ARQ_MAX_PAYLOAD  120 // frame and length byte still fit in the FIFO
+
+#define ARQ_TYPE_DATA    0x01
+#define ARQ_TYPE_ACK     0x02
+
+#define ARQ_DATA_OVERHEAD 5
+#define ARQ_ACK_SIZE      9
+#define ARQ_MAX_FRAME     (ARQ_MAX_PAYLOAD + ARQ_DATA_OVERHEAD)
+
+// smoothed loss, in 1/256ths, at which the window is smallest
+#define ARQ_LOSS_FOR_MIN_WINDOW 64
+
+typedef enum arq_slot_state_e {
+	ARQ_SLOT_FREE,
+	ARQ_SLOT_QUEUED,       // to be sent, first time or again
+	ARQ_SLOT_SENT,         // waiting for an ACK
+	ARQ_SLOT_ACKED         // acknowledged out of order
+} arq_slot_state;
+
+typedef struct arq_tx_slot_s {
+	uint8_t  data[ARQ_MAX_PAYLOAD];
+	uint8_t  len;
+	uint8_t  state;
+	uint16_t sends;
+	uint32_t sent_at;
+	uint32_t order;        // when it was last sent, counting sends
+} arq_tx_slot;
+
+typedef struct arq_tx_s {
+	arq_tx_slot slots[ARQ_MAX_WINDOW];
+	uint16_t    base;      // oldest not acknowledged
+	uint16_t    next;      // given to the next payload
+	uint16_t    window;
+	uint16_t    loss_q8;   // smoothed loss, 1/256ths
+	uint32_t    rto;
+	uint32_t    order;
+
+	uint32_t    submitted;
+	uint32_t    sent;      // every frame, first sends and resends
+	uint32_t    resent;
+	uint32_t    acked;
+	uint32_t    lost;      // shown lost by an ACK
+	uint32_t    timeouts;
+	uint32_t    bad_acks;
+} arq_tx;
+
+typedef struct arq_rx_slot_s {
+	uint8_t data[ARQ_MAX_PAYLOAD];
+	uint8_t len;
+	uint8_t full;
+} arq_rx_slot;
+
+typedef struct arq_rx_s {
+	arq_rx_slot slots[ARQ_MAX_WINDOW];
+	uint16_t    deliver;   // next to hand out
+	uint16_t    expected;  // first not yet received
+	uint8_t     ack_due;
+
+	uint32_t    received;
+	uint32_t    duplicates;
+	uint32_t    out_of_window;
+	uint32_t    bad;       // failed the CRC or malformed
+	uint32_t    delivered;
+} arq_rx;
+
+/*
+	Starts a sender with the full window, resending what hasn't
+	been acknowledged after rto.
+*/
+void ARQ_tx_init(arq_tx* tx, uint32_t rto);
+
+/*
+	Queues a payload of len bytes to be sent.
+	Returns ERROR_NONE if successful, ERROR_ARQ_WINDOW_FULL if the
+	window is, ERROR_ARQ_PAYLOAD_TOO_LONG if len is over
+	ARQ_MAX_PAYLOAD.
+*/
+tcvr_error_t ARQ_tx_submit(arq_tx* tx, const uint8_t* payload, uint8_t len);
+
+/*
+	Writes the next DATA frame due at time now into out, which
+	holds max bytes: the oldest lost or timed out frame, or else
+	the oldest not yet sent. *out_len is set to its length, 0 if
+	nothing is due.
+	Returns ERROR_NONE if successful, ERROR_ARQ_BUFFER_TOO_SMALL
+	if the frame doesn't fit.
+*/
+tcvr_error_t ARQ_tx_next(arq_tx* tx, uint32_t now, uint8_t* out, uint8_t max, uint8_t* out_len);
+
+/*
+	Takes an ACK frame, frees what it acknowledges, queues what
+	it shows lost to be resent and adjusts the window.
+	Returns ERROR_NONE if successful, ERROR_CRC_MISMATCH or
+	ERROR_ARQ_BAD_FRAME if it isn't a good ACK for this sender.
+*/
+tcvr_error_t ARQ_tx_ack(arq_tx* tx, const uint8_t* frame, uint8_t len);
+
+/*
+	Returns how many payloads are not yet acknowledged.
+*/
+uint16_t ARQ_tx_pending(const arq_tx* tx);
+
+/*
+	Starts a receiver expecting sequence number 0.
+*/
+void ARQ_rx_init(arq_rx* rx);
+
+/*
+	Takes a DATA frame. Duplicates and frames too far ahead are
+	dropped, but still get an ACK.
+	Returns ERROR_NONE if successful, ERROR_CRC_MISMATCH or
+	ERROR_ARQ_BAD_FRAME if it isn't a good DATA frame.
+*/
+tcvr_error_t ARQ_rx_receive(arq_rx* rx, const uint8_t* frame, uint8_t len);
+
+/*
+	Copies the next payload in order into out, which holds max
+	bytes. *out_len is set to its length, 0 if it hasn't arrived.
+	Returns ERROR_NONE if successful, ERROR_ARQ_BUFFER_TOO_SMALL
+	if the payload doesn't fit.
+*/
+tcvr_error_t ARQ_rx_deliver(arq_rx* rx, uint8_t* out, uint8_t max, uint8_t* out_len);
+
+/*
+	Writes the ACK for everything received since the last one
+	into out, for the uplink slot. *out_len is set to
+	ARQ_ACK_SIZE, or 0 if nothing has come in since.
+	Returns ERROR_NONE if successful, ERROR_ARQ_BUFFER_TOO_SMALL
+	if max is under ARQ_ACK_SIZE.
+*/
+tcvr_error_t ARQ_rx_ack(arq_rx* rx, uint8_t* out, uint8_t max, uint8_t* out_len);
+
+#endif
@@ -0,0 +1,431 @@
+
+#include <stdint.h>
+
+#include "error.h"
+#include "rxtx.h"
+#include "crc.h"
+#include "ax25.h"
+
+// a run of 1s long enough to abort; the count stops there
+#define AX25_ABORT_ONES 7
+
+/*
+	Stuffing table, by 1s in a row so far (0 to 4) and the next
+	byte: the bits to send, least significant first, in the low
+	16 bits, how many in the next 8, and the 1s in a row after in
+	the top 8.
+*/
+static uint32_t s_AX25_stuff[5][256];
+
+/*
+	Unstuffing table, by 1s in a row so far (0 to 7) and the next
+	raw byte: the data bits in the low 8 bits, how many in the
+	next 4, the 1s in a row after in the next 3. AX25_EVENT is set
+	instead if a flag or abort ends in the byte, which then has to
+	be taken a bit at a time.
+*/
+#define AX25_EVENT 0x8000
+static uint16_t s_AX25_unstuff[AX25_ABORT_ONES + 1][256];
+static int      s_AX25_ready = 0;
+
+static void s_AX25_init(void) {
+	uint32_t bits, n;
+	int      ones, start, byte, i, b;
+	int      event;
+
+	for (start = 0; start < 5; start++) {
+		for (byte = 0; byte < 256; byte++) {
+			ones = start;
+			bits = 0;
+			n = 0;
+			for (i = 0; i < 8; i++) {
+				b = (byte >> i) & 1;
+				bits |= (uint32_t)b << n++;
+				ones = b ? ones + 1 : 0;
+				if (ones == 5) {
+					n++; // the stuffed 0
+					ones = 0;
+				}
+			}
+			s_AX25_stuff[start][byte] = bits | (n << 16) | ((uint32_t)ones << 24);
+		}
+	}
+
+	for (start = 0; start <= AX25_ABORT_ONES; start++) {
+		for (byte = 0; byte < 256; byte++) {
+			ones = start;
+			bits = 0;
+			n = 0;
+			event = 0;
+			for (i = 0; i < 8 && !event; i++) {
+				b = (byte >> i) & 1;
+				if (b) {
+					if (ones == 6) {
+						event = 1;
+					}
+					else if (ones < 6) {
+						ones++;
+						if (ones < 6) {
+							bits |= 1u << n++;
+						}
+					}
+				}
+				else {
+					if (ones == 6) {
+						event = 1;
+					}
+					else if (ones < 5) {
+						n++;
+					}
+					ones = 0;
+				}
+			}
+			s_AX25_unstuff[start][byte] = event ? AX25_EVENT : (uint16_t)(bits | (n << 8) | ((uint32_t)ones << 12));
+		}
+	}
+
+	s_AX25_ready = 1;
+}
+
+static uint64_t s_AX25_load64(const uint8_t* p) {
+	uint64_t x = 0;
+	int      i;
+
+	for (i = 7; i >= 0; i--) {
+		x = (x << 8) | p[i];
+	}
+	return x;
+}
+
+static void s_AX25_store64(uint8_t* p, uint64_t x) {
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		p[i] = (uint8_t)(x >> (8*i));
+	}
+}
+
+/*
+	Returns nonzero if the 64 bits x, after ones 1s in a row,
+	hold five 1s in a row anywhere: a stuffed bit, flag or abort.
+*/
+static int s_AX25_has_run(uint64_t x, uint8_t ones) {
+	if (x == ~(uint64_t)0) {
+		return 1;
+	}
+	if (ones + __builtin_ctzll(~x) >= 5) {
+		return 1;
+	}
+	return (x & (x >> 1) & (x >> 2) & (x >> 3) & (x >> 4)) != 0;
+}
+
+// 1s in a row at the end of x, which has_run said is no more than 4
+static uint8_t s_AX25_trailing_ones(uint64_t x) {
+	return (uint8_t)__builtin_clzll(~x);
+}
+
+/*
+	Bit writer for the encoder, least significant bit first.
+*/
+typedef struct ax25_writer_s {
+	uint8_t* out;
+	uint32_t pos;
+	uint32_t max;
+	uint64_t acc;
+	uint8_t  nbits;
+	uint8_t  overflow;
+} ax25_writer;
+
+static void s_AX25_put(ax25_writer* w, uint32_t bits, uint8_t n) {
+	w->acc |= (uint64_t)bits << w->nbits;
+	w->nbits += n;
+	while (w->nbits >= 8) {
+		if (w->pos < w->max) {
+			w->out[w->pos++] = (uint8_t)w->acc;
+		}
+		else {
+			w->overflow = 1;
+		}
+		w->acc >>= 8;
+		w->nbits -= 8;
+	}
+}
+
+static int s_AX25_put64(ax25_writer* w, uint64_t x) {
+	if (w->pos + 8 > w->max) {
+		return 0;
+	}
+	s_AX25_store64(w->out + w->pos, w->acc | (x << w->nbits));
+	w->acc = w->nbits ? x >> (64 - w->nbits) : 0;
+	w->pos += 8;
+	return 1;
+}
+
+static uint8_t s_AX25_stuff_byte(ax25_writer* w, uint8_t ones, uint8_t byte) {
+	uint32_t e = s_AX25_stuff[ones][byte];
+
+	s_AX25_put(w, e & 0xffff, (uint8_t)((e >> 16) & 0xff));
+	return (uint8_t)(e >> 24);
+}
+
+tcvr_error_t AX25_encode(const uint8_t* frame, uint16_t len, uint8_t* out, uint32_t max, uint32_t* out_len) {
+	ax25_writer w = { out, 0, max, 0, 0, 0 };
+	uint16_t    fcs;
+	uint8_t     ones = 0;
+	uint64_t    x;
+	uint32_t    i = 0;
+
+	if (!frame || !out || !out_len) {
+		return ERROR_NULL_POINTER;
+	}
+	if (!s_AX25_ready) {
+		s_AX25_init();
+	}
+
+	fcs = CRC16(frame, len);
+
+	s_AX25_put(&w, AX25_FLAG, 8);
+	while (i < len) {
+		if (i + 8 <= len) {
+			x = s_AX25_load64(frame + i);
+			if (!s_AX25_has_run(x, ones) && s_AX25_put64(&w, x)) {
+				ones = s_AX25_trailing_ones(x);
+				i += 8;
+				continue;
+			}
+		}
+		ones = s_AX25_stuff_byte(&w, ones, frame[i++]);
+	}
+	ones = s_AX25_stuff_byte(&w, ones, (uint8_t)(fcs & 0xff));
+	s_AX25_stuff_byte(&w, ones, (uint8_t)(fcs >> 8));
+	s_AX25_put(&w, AX25_FLAG, 8);
+	if (w.nbits) {
+		s_AX25_put(&w, 0, 8 - w.nbits);
+	}
+
+	if (w.overflow) {
+		return ERROR_AX25_BUFFER_TOO_SMALL;
+	}
+	*out_len = w.pos;
+	return ERROR_NONE;
+}
+
+void AX25_decoder_init(ax25_decoder* dec, uint8_t* frame, uint16_t max) {
+	if (!dec) {
+		return;
+	}
+	if (!s_AX25_ready) {
+		s_AX25_init();
+	}
+
+	dec->frame = frame;
+	dec->max = max;
+	dec->len = 0;
+	dec->acc = 0;
+	dec->nbits = 0;
+	dec->ones = 0;
+	dec->in_frame = 0;
+	dec->bitpos = 0;
+	dec->raw = 0;
+	dec->raw_len = 0;
+	dec->frames = 0;
+	dec->bad_fcs = 0;
+	dec->dropped = 0;
+}
+
+static void s_AX25_emit(ax25_decoder* dec, uint32_t bits, uint8_t n) {
+	dec->acc |= (uint64_t)bits << dec->nbits;
+	dec->nbits += n;
+	while (dec->nbits >= 8) {
+		if (dec->len >= dec->max) {
+			// too long for the buffer, wait for the next flag
+			dec->in_frame = 0;
+			dec->dropped++;
+			return;
+		}
+		dec->frame[dec->len++] = (uint8_t)dec->acc;
+		dec->acc >>= 8;
+		dec->nbits -= 8;
+	}
+}
+
+static void s_AX25_emit64(ax25_decoder* dec, uint64_t x) {
+	s_AX25_store64(dec->frame + dec->len, dec->acc | (x << dec->nbits));
+	dec->acc = dec->nbits ? x >> (64 - dec->nbits) : 0;
+	dec->len += 8;
+}
+
+/*
+	A flag ends whatever frame was being decoded and starts the
+	next. The flag's leading 0 and first five 1s were taken as
+	data, so they come off the end.
+	Returns the length of the frame, FCS removed, if it was a good
+	one, 0 otherwise.
+*/
+static uint16_t s_AX25_flag(ax25_decoder* dec) {
+	uint32_t bits = (uint32_t)dec->len*8 + dec->nbits;
+	uint16_t good = 0;
+
+	if (dec->in_frame && bits >= 6) {
+		bits -= 6;
+		if ((bits & 7) == 0 && bits/8 >= AX25_MIN_FRAME) {
+			if (CRC16_check(dec->frame, bits/8) == ERROR_NONE) {
+				dec->frames++;
+				good = (uint16_t)(bits/8 - 2);
+			}
+			else {
+				dec->bad_fcs++;
+			}
+		}
+	}
+
+	dec->in_frame = 1;
+	dec->len = 0;
+	dec->acc = 0;
+	dec->nbits = 0;
+	return good;
+}
+
+/*
+	Takes the bits of byte from bit from up, one at a time, until
+	a good frame is complete.
+	Returns the index of the next bit to take, 8 if all were.
+*/
+static uint8_t s_AX25_slow_byte(ax25_decoder* dec, uint8_t byte, uint8_t from, uint16_t* frame_len) {
+	uint8_t i;
+	uint8_t ones;
+
+	for (i = from; i < 8; i++) {
+		if ((byte >> i) & 1) {
+			if (dec->ones >= 6) {
+				if (dec->ones == 6 && dec->in_frame) {
+					if (dec->len > 0) {
+						dec->dropped++;
+					}
+					dec->in_frame = 0;
+				}
+				dec->ones = AX25_ABORT_ONES;
+				continue;
+			}
+			if (++dec->ones < 6 && dec->in_frame) {
+				s_AX25_emit(dec, 1, 1);
+			}
+		}
+		else {
+			ones = dec->ones;
+			dec->ones = 0;
+			if (ones == 6) {
+				*frame_len = s_AX25_flag(dec);
+				if (*frame_len) {
+					return i + 1;
+				}
+			}
+			else if (ones < 5 && dec->in_frame) {
+				s_AX25_emit(dec, 0, 1);
+			}
+		}
+	}
+	return 8;
+}
+
+tcvr_error_t AX25_decode(ax25_decoder* dec, const uint8_t* raw, uint32_t len, uint32_t* used, uint16_t* frame_len) {
+	uint32_t i = 0;
+	uint16_t e;
+	uint64_t x;
+	uint8_t  next;
+
+	if (!dec || !raw || !used || !frame_len) {
+		return ERROR_NULL_POINTER;
+	}
+	*frame_len = 0;
+
+	// the rest of a byte a frame ended in
+	if (dec->bitpos && len > 0) {
+		next = s_AX25_slow_byte(dec, raw[0], dec->bitpos, frame_len);
+		if (next < 8) {
+			dec->bitpos = next;
+			*used = 0;
+			return ERROR_NONE;
+		}
+		dec->bitpos = 0;
+		i = 1;
+		if (*frame_len) {
+			*used = i;
+			return ERROR_NONE;
+		}
+	}
+
+	while (i < len) {
+		if (i + 8 <= len) {
+			x = s_AX25_load64(raw + i);
+			if (!s_AX25_has_run(x, dec->ones) && (!dec->in_frame || dec->len + 8 < dec->max)) {
+				if (dec->in_frame) {
+					s_AX25_emit64(dec, x);
+				}
+				dec->ones = s_AX25_trailing_ones(x);
+				i += 8;
+				continue;
+			}
+		}
+
+		e = s_AX25_unstuff[dec->ones][raw[i]];
+		if (!(e & AX25_EVENT)) {
+			if (dec->in_frame) {
+				s_AX25_emit(dec, e & 0xff, (e >> 8) & 0xf);
+			}
+			dec->ones = (e >> 12) & 0x7;
+			i++;
+			continue;
+		}
+
+		next = s_AX25_slow_byte(dec, raw[i], 0, frame_len);
+		if (next < 8) {
+			dec->bitpos = next;
+			*used = i;
+			return ERROR_NONE;
+		}
+		i++;
+		if (*frame_len) {
+			break;
+		}
+	}
+
+	*used = i;
+	return ERROR_NONE;
+}
+
+tcvr_error_t AX25_rx_drain(ax25_decoder* dec, uint8_t* raw, uint16_t* frame_len, uint8_t* status) {
+	tcvr_error_t err;
+	uint32_t     used;
+	uint8_t      avail;
+	uint8_t      got;
+
+	if (!dec || !raw || !frame_len) {
+		return ERROR_NULL_POINTER;
+	}
+	*frame_len = 0;
+
+	// what was left after the last frame comes first
+	if (dec->raw_len) {
+		AX25_decode(dec, dec->raw, dec->raw_len, &used, frame_len);
+		dec->raw += used;
+		dec->raw_len -= (uint8_t)used;
+		if (*frame_len) {
+			return ERROR_NONE;
+		}
+	}
+
+	err = RX_queue_len(&avail, status);
+	if (err != ERROR_NONE || avail == 0) {
+		return err;
+	}
+	err = RX_burst_dequeue(raw, avail, &got, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	AX25_decode(dec, raw, got, &used, frame_len);
+	dec->raw = raw + used;
+	dec->raw_len = (uint8_t)(got - used);
+	return ERROR_NONE;
+}
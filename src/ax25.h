@@ -0,0 +1,95 @@
+#ifndef _AX25_H_
+#define _AX25_H_
+
+#include <stdint.h>
+#include "error.h"
+
+/*
+	HDLC framing as used by AX.25: frames between 0x7e flags, a 0
+	stuffed after every five 1s inside a frame so the data never
+	looks like a flag, and the CRC16 FCS (see crc.h) at the end,
+	least significant byte first. Bits go on air least significant
+	first, so the bit stream is simply the bytes in order, each
+	read from bit 0 up. Seven 1s in a row abort a frame.
+
+	Stuffing and unstuffing go a byte at a time through tables.
+	Runs of 64 bits with no five 1s in a row, which is most data,
+	need no stuffing at all and are copied a word at a time.
+
+	The raw bits come from the RX FIFO and whole frames are decoded
+	straight into the caller's frame buffer. That may even be the
+	buffer the raw bits are in, if the whole frame is in it: the
+	decoded bytes never catch up with the raw ones. To send, a
+	frame can be encoded straight into a packet ring slot (see
+	packet_ring.h) and fed to the TX FIFO from there.
+*/
+#define AX25_FLAG      0x7e
+
+// smallest AX.25 frame: two addresses, control, and the FCS
+#define AX25_MIN_FRAME 17
+
+/*
+	Worst case encoded size of a frame of len bytes, FCS
+	included: one stuffed bit for each five, and a flag either
+	side.
+*/
+#define AX25_ENCODED_SIZE(len) ((((uint32_t)(len) + 2) * 8 * 6 / 5 + 7) / 8 + 3)
+
+typedef struct ax25_decoder_s {
+	uint8_t*  frame;       // caller's buffer the frame is decoded into
+	uint16_t  max;         // its size
+	uint16_t  len;         // whole bytes decoded into it
+	uint64_t  acc;         // decoded bits not yet a whole byte
+	uint8_t   nbits;
+	uint8_t   ones;        // 1s in a row on air
+	uint8_t   in_frame;    // 0 while hunting for a flag
+	uint8_t   bitpos;      // bits of the next raw byte already taken
+
+	// raw bits left over from AX25_rx_drain
+	uint8_t*  raw;
+	uint8_t   raw_len;
+
+	uint32_t  frames;      // good frames
+	uint32_t  bad_fcs;     // frames that failed the FCS
+	uint32_t  dropped;     // aborted or too long for the buffer
+} ax25_decoder;
+
+/*
+	Encodes a frame of len bytes: opening flag, the frame and its
+	FCS, bit stuffed, and closing flag. The last byte is padded
+	with 0s after the closing flag. *out_len is set to the number
+	of bytes written to out.
+	Returns ERROR_NONE if successful, ERROR_AX25_BUFFER_TOO_SMALL if
+	the encoded frame doesn't fit in max bytes (at most
+	AX25_ENCODED_SIZE(len) are needed).
+*/
+tcvr_error_t AX25_encode(const uint8_t* frame, uint16_t len, uint8_t* out, uint32_t max, uint32_t* out_len);
+
+/*
+	Starts hunting for a frame, decoding into frame, which holds
+	max bytes.
+*/
+void AX25_decoder_init(ax25_decoder* dec, uint8_t* frame, uint16_t max);
+
+/*
+	Decodes up to len raw bytes, stopping as soon as a frame with
+	a good FCS is complete. *used is set to the number of bytes
+	taken and *frame_len to the length of the frame, FCS removed,
+	or 0 if none was completed. The frame stays in the decoder's
+	buffer until the next call. Call again with whatever is left
+	of the raw bytes.
+	Returns ERROR_NONE if successful.
+*/
+tcvr_error_t AX25_decode(ax25_decoder* dec, const uint8_t* raw, uint32_t len, uint32_t* used, uint16_t* frame_len);
+
+/*
+	Decodes whatever is in the RX FIFO, dequeuing it into raw
+	(TRANSCEIVER_FIFO_SIZE bytes, the caller's). Stops as AX25_decode
+	does when a frame is complete; the rest of raw is kept and
+	decoded first on the next call, so raw must be left alone
+	until then.
+	Returns ERROR_NONE if successful, or the error from rxtx.c.
+*/
+tcvr_error_t AX25_rx_drain(ax25_decoder* dec, uint8_t* raw, uint16_t* frame_len, uint8_t* status);
+
+#endif
@@ -1,15 +1,18 @@
 
 #include "spi.h"
+#include "stats.h"
 #include "bang_registers.h"
 
-#define _DEBUG_BANG_REGISTERS_
-
+// build with -D_DEBUG_BANG_REGISTERS_ (make DEBUG=1) to trace every access
 #ifdef _DEBUG_BANG_REGISTERS_
+#ifdef TCVR_FREESTANDING
+#error "register tracing needs stdio, which the freestanding build doesn't have"
+#endif
 #include <stdio.h>
 #endif
 
 static int s_REGISTER_address_is_in_extended_space(register_name rn) {
-	return (((rn & (EXTENDED_REGISTER_SPACE << 2)) >> 2) == EXTENDED_REGISTER_SPACE_ADDRESS);
+	return ((rn >> 8) == EXTENDED_REGISTER_SPACE_ADDRESS);
 }
 
 static uint8_t s_REGISTER_extract_address(register_name rn) {
@@ -17,14 +20,31 @@ static uint8_t s_REGISTER_extract_address(register_name rn) {
 		return (uint8_t)(rn & 0xff);
 	}
 	else {
-		return (uint8_t)(rn & 0x2f);	
+		return (uint8_t)(rn & 0x3f);
 	}
 }
 
-// Publicly Exported Functions
-// ===========================
+/*
+	Fills addr with the address byte(s) for a register access.
+	Extended registers are addressed with the command bits on the
+	EXTENDED_REGISTER_SPACE_ADDRESS byte, followed by the plain
+	8-bit address. The first byte clocked back is the chip status.
+	Returns how many bytes there are.
+*/
+static uint8_t s_REGISTER_address(register_name rn, uint8_t command, uint8_t* addr) {
+	if (s_REGISTER_address_is_in_extended_space(rn)) {
+		addr[0] = command | EXTENDED_REGISTER_SPACE_ADDRESS;
+		addr[1] = s_REGISTER_extract_address(rn);
+		return 2;
+	}
 
-tcvr_error_t REGISTER_write(register_name rn, uint8_t data, uint8_t* status) {
+	addr[0] = command | s_REGISTER_extract_address(rn);
+	return 1;
+}
+
+static tcvr_error_t s_REGISTER_write(register_name rn, uint8_t data, uint8_t* status) {
+	uint8_t addr[2];
+	uint8_t addr_len;
 	uint8_t byt = 0;
 
 #ifdef _DEBUG_BANG_REGISTERS_
@@ -34,30 +54,28 @@ tcvr_error_t REGISTER_write(register_name rn, uint8_t data, uint8_t* status) {
 	if (rn < FIRST_REGISTER_NAME || rn > LAST_REGISTER_NAME) {
 		return ERROR_REGISTER_INVALID_NAME;
 	}
+	addr_len = s_REGISTER_address(rn, SPI_WRITE | SPI_SINGLE, addr);
 
 	SPI_start_transaction();
 
-	// Signal extended space address if necessary
-	if (s_REGISTER_address_is_in_extended_space(rn)) {
-		byt = (SPI_WRITE | SPI_SINGLE) | EXTENDED_REGISTER_SPACE_ADDRESS;
-		SPI_transfer_byte(byt);
-	}
-
-	// OR together single-write command and register address
-	byt = (SPI_WRITE | SPI_SINGLE) | s_REGISTER_extract_address(rn);
-	SPI_transfer_byte(byt);
+	// Send single-write command and register address
+	SPI_transfer_bytes(addr, 0, addr_len);
 
 	// Write output byte to the register over SPI
-	byt = SPI_transfer_byte(data);
+	SPI_transfer_bytes(&data, &byt, 1);
+
+	SPI_stop_transaction();
+
 	if (status) { // output chip status byte
 		*status = byt;
 	}
-
-	SPI_stop_transaction();
 	return ERROR_NONE;
 }
 
-tcvr_error_t REGISTER_read(register_name rn, uint8_t* data, uint8_t* status) {
+static tcvr_error_t s_REGISTER_read(register_name rn, uint8_t* data, uint8_t* status) {
+	uint8_t addr[2];
+	uint8_t addr_len;
+	uint8_t reply[2];
 	uint8_t byt = 0;
 
 #ifdef _DEBUG_BANG_REGISTERS_
@@ -67,34 +85,32 @@ tcvr_error_t REGISTER_read(register_name rn, uint8_t* data, uint8_t* status) {
 	if (rn < FIRST_REGISTER_NAME || rn > LAST_REGISTER_NAME) {
 		return ERROR_REGISTER_INVALID_NAME;
 	}
+	addr_len = s_REGISTER_address(rn, SPI_READ | SPI_SINGLE, addr);
 
 	SPI_start_transaction();
 
-	if (s_REGISTER_address_is_in_extended_space(rn)) {
-		byt = (SPI_READ | SPI_SINGLE) | EXTENDED_REGISTER_SPACE_ADDRESS;
-		SPI_transfer_byte(byt);
-	}
-
 	// transfer register address
-	byt = (SPI_READ | SPI_SINGLE) | s_REGISTER_extract_address(rn);
-	byt = SPI_transfer_byte(byt);
-	if (status) { // output chip status
-		*status = byt;
-	}
+	SPI_transfer_bytes(addr, reply, addr_len);
 
 	// read input byte to the register over SPI
-	byt = SPI_transfer_byte(0); // byte transferred is ignored
+	SPI_transfer_bytes(0, &byt, 1); // byte transferred is ignored
+
+	SPI_stop_transaction();
+
+	if (status) { // output chip status
+		*status = reply[0];
+	}
 	if (data) {
 		*data = byt;
 	}
-
-	SPI_stop_transaction();
 	return ERROR_NONE;
 }
 
-tcvr_error_t REGISTER_burst_write(register_name rn, uint8_t* data_arr, uint8_t data_len, uint8_t* status) {
+static tcvr_error_t s_REGISTER_burst_write(register_name rn, uint8_t* data_arr, uint8_t data_len, uint8_t* status) {
+	uint8_t addr[2];
+	uint8_t addr_len;
 	uint8_t byt = 0;
-	uint8_t i;
+
 	if (rn < FIRST_REGISTER_NAME || rn > LAST_REGISTER_NAME) {
 		return ERROR_REGISTER_INVALID_NAME;
 	}
@@ -104,37 +120,30 @@ tcvr_error_t REGISTER_burst_write(register_name rn, uint8_t* data_arr, uint8_t d
 	if (data_len <= 1) {
 		return ERROR_PARAMETER_OUT_OF_RANGE;
 	}
+	addr_len = s_REGISTER_address(rn, SPI_WRITE | SPI_BURST, addr);
 
 	SPI_start_transaction();
 
-	// Signal if address is extended address if necessary
-	if (s_REGISTER_address_is_in_extended_space(rn)) {
-		byt = (SPI_WRITE | SPI_BURST) | EXTENDED_REGISTER_SPACE_ADDRESS;
-		SPI_transfer_byte(byt);
-	}
+	// Signal starting register address
+	SPI_transfer_bytes(addr, 0, addr_len);
 
-	// Signal register address
-	byt = (SPI_WRITE | SPI_BURST) | s_REGISTER_extract_address(rn);
-	SPI_start_transaction();
+	// Write output bytes to the registers over SPI, the status comes back with the last
+	SPI_transfer_bytes(data_arr, 0, data_len - 1);
+	SPI_transfer_bytes(&data_arr[data_len - 1], &byt, 1);
 
-	// Write the address byte over SPI
-	SPI_transfer_byte(byt);
+	SPI_stop_transaction();
 
-	// Write output bytes to the registers over SPI
-	for (i = 0; i < data_len; i++) {
-		byt = SPI_transfer_byte(data_arr[i]);		
-	}
 	if (status) {
 		*status = byt;
 	}
-
-	SPI_stop_transaction();
 	return ERROR_NONE;
 }
 
-tcvr_error_t REGISTER_burst_read(register_name rn, uint8_t* data_arr, uint8_t data_len, uint8_t* status) {
-	uint8_t byt = 0;
-	uint8_t i;
+static tcvr_error_t s_REGISTER_burst_read(register_name rn, uint8_t* data_arr, uint8_t data_len, uint8_t* status) {
+	uint8_t addr[2];
+	uint8_t addr_len;
+	uint8_t reply[2];
+
 	if (rn < FIRST_REGISTER_NAME || rn > LAST_REGISTER_NAME) {
 		return ERROR_REGISTER_INVALID_NAME;
 	}
@@ -144,38 +153,62 @@ tcvr_error_t REGISTER_burst_read(register_name rn, uint8_t* data_arr, uint8_t da
 	if (data_len <= 1) {
 		return ERROR_PARAMETER_OUT_OF_RANGE;
 	}
+	addr_len = s_REGISTER_address(rn, SPI_READ | SPI_BURST, addr);
 
 	SPI_start_transaction();
 
-	// Signal that registers are in extended space, if necessary
-	if (s_REGISTER_address_is_in_extended_space(rn)) {
-		byt = (SPI_READ | SPI_BURST) | EXTENDED_REGISTER_SPACE_ADDRESS;
-		SPI_transfer_byte(byt);
-	}
-
 	// Signal starting register address
-	byt = (SPI_READ | SPI_BURST) | s_REGISTER_extract_address(rn);
-	byt = SPI_transfer_byte(byt);
-	if (status) { // output chip status byte
-		*status = byt;
-	}
+	SPI_transfer_bytes(addr, reply, addr_len);
 
 	// Read bytes into array
-	for (i = 0; i < data_len; i++) {
-		data_arr[i] = SPI_transfer_byte(0);		
-	}
+	SPI_transfer_bytes(0, data_arr, data_len);
 
 	SPI_stop_transaction();
+
+	if (status) { // output chip status byte
+		*status = reply[0];
+	}
 	return ERROR_NONE;
 }
 
-tcvr_error_t REGISTER_write_bitfield(register_name rn, uint8_t data,
-                                     bit_t ms_bit, bit_t ls_bit,
-                                     uint8_t* status) {
+// Publicly Exported Functions
+// ===========================
+
+tcvr_error_t REGISTER_write(register_name rn, uint8_t data, uint8_t* status) {
+	uint64_t     start = STATS_start();
+	tcvr_error_t err = s_REGISTER_write(rn, data, status);
+
+	STATS_record(STATS_API_REGISTER_WRITE, start, err);
+	return err;
+}
+
+tcvr_error_t REGISTER_read(register_name rn, uint8_t* data, uint8_t* status) {
+	uint64_t     start = STATS_start();
+	tcvr_error_t err = s_REGISTER_read(rn, data, status);
+
+	STATS_record(STATS_API_REGISTER_READ, start, err);
+	return err;
+}
+
+tcvr_error_t REGISTER_burst_write(register_name rn, uint8_t* data_arr, uint8_t data_len, uint8_t* status) {
+	uint64_t     start = STATS_start();
+	tcvr_error_t err = s_REGISTER_burst_write(rn, data_arr, data_len, status);
+
+	STATS_record(STATS_API_REGISTER_BURST_WRITE, start, err);
+	return err;
+}
+
+tcvr_error_t REGISTER_burst_read(register_name rn, uint8_t* data_arr, uint8_t data_len, uint8_t* status) {
+	uint64_t     start = STATS_start();
+	tcvr_error_t err = s_REGISTER_burst_read(rn, data_arr, data_len, status);
+
+	STATS_record(STATS_API_REGISTER_BURST_READ, start, err);
+	return err;
+}
+
+tcvr_error_t REGISTER_write_masked(register_name rn, uint8_t data, uint8_t mask, uint8_t* status) {
 	tcvr_error_t err = ERROR_NONE;
-	bit_t        bit = 0;
 	uint8_t      old_data = 0;
-	uint8_t      mask = 0;
 
 	if (rn < FIRST_REGISTER_NAME || rn > LAST_REGISTER_NAME) {
 		return ERROR_REGISTER_INVALID_NAME;
@@ -187,47 +220,19 @@ tcvr_error_t REGISTER_write_bitfield(register_name rn, uint8_t data,
 		return err;
 	}
 
-	// make sure bits are in appropriate significance order
-	if (ls_bit > ms_bit) {
-		bit_t tmp = ls_bit;
-		ls_bit = ms_bit;
-		ms_bit = tmp;
-	}
-
-	// shift the new data by appropriate amount
-	bit = BIT_0;
-	while (bit < ls_bit) {
-		data <<= 1;
-		bit <<=1;
-	}
-
-	// make a mask for the bitfield
-	mask = BITS_bitfield_mask(ms_bit, ls_bit);
-
-	// use that mask on the new data
-	data &= mask;
-
-	// invert the mask to use on the old data
-	mask = ~mask;
-
-	// mask away the bitfield from the old data
-	old_data &= mask;
-
-	// combine the new and old data
-	data |= old_data;
+	// replace the masked bits, keep the rest
+	data = (uint8_t)((old_data & ~mask) | (data & mask));
 
 	// write the data to the register
 	return REGISTER_write(rn, data, status);
 }
 
-tcvr_error_t REGISTER_read_bitfield(register_name rn, bit_t ms_bit, bit_t ls_bit,
-                                    uint8_t* data, uint8_t* status) {
+tcvr_error_t REGISTER_read_masked(register_name rn, uint8_t mask, uint8_t shift,
+                                  uint8_t* data, uint8_t* status) {
 	tcvr_error_t err = ERROR_NONE;
-	bit_t        bit = 0;
-	uint8_t      mask = 0;
 
-	if (rn < FIRST_REGISTER_NAME || rn > LAST_REGISTER_NAME) {
-		return ERROR_REGISTER_INVALID_NAME;
+	if (!data) {
+		return ERROR_NULL_POINTER;
 	}
 
 	// read the data
@@ -236,6 +241,15 @@ tcvr_error_t REGISTER_read_bitfield(register_name rn, bit_t ms_bit, bit_t ls_bit
 		return err;
 	}
 
+	*data = (uint8_t)((*data & mask) >> shift);
+	return ERROR_NONE;
+}
+
+tcvr_error_t REGISTER_write_bitfield(register_name rn, uint8_t data,
+                                     bit_t ms_bit, bit_t ls_bit,
+                                     uint8_t* status) {
+	uint8_t mask;
+
 	// make sure bits are in appropriate significance order
 	if (ls_bit > ms_bit) {
 		bit_t tmp = ls_bit;
@@ -243,18 +257,28 @@ tcvr_error_t REGISTER_read_bitfield(register_name rn, bit_t ms_bit, bit_t ls_bit
 		ms_bit = tmp;
 	}
 
-	// make a mask for the bitfield
+	if (ls_bit == 0) {
+		return ERROR_PARAMETER_OUT_OF_RANGE;
+	}
+
+	// ls_bit is a single bit, its position is how far to shift the data
 	mask = BITS_bitfield_mask(ms_bit, ls_bit);
+	return REGISTER_write_masked(rn, (uint8_t)(data << __builtin_ctz(ls_bit)), mask, status);
+}
 
-	// use that mask on the new data
-	*data &= mask;
+tcvr_error_t REGISTER_read_bitfield(register_name rn, bit_t ms_bit, bit_t ls_bit,
+                                    uint8_t* data, uint8_t* status) {
+	// make sure bits are in appropriate significance order
+	if (ls_bit > ms_bit) {
+		bit_t tmp = ls_bit;
+		ls_bit = ms_bit;
+		ms_bit = tmp;
+	}
 
-	// shift the data by appropriate amount
-	bit = ls_bit;
-	while (bit > BIT_0) {
-		*data >>= 1;
-		bit >>=1;
+	if (ls_bit == 0) {
+		return ERROR_PARAMETER_OUT_OF_RANGE;
 	}
 
-	return ERROR_NONE;
+	// ls_bit is a single bit, its position is how far to shift the field down
+	return REGISTER_read_masked(rn, BITS_bitfield_mask(ms_bit, ls_bit), (uint8_t)__builtin_ctz(ls_bit), data, status);
 }
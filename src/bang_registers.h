@@ -1,7 +1,9 @@
 #ifndef _BANG_REGISTERS_H_
 #define _BANG_REGISTERS_H_
 
+#include <stdint.h>
 #include "error.h"
+#include "bits.h"
 
 #define STANDARD_REGISTER_SPACE 0x2e
 #define EXTENDED_REGISTER_SPACE 0xff
@@ -23,16 +25,45 @@
 */
 typedef uint16_t register_name;
 
-#define FS_CFG       (register_name)0x0021
-#define NUM_TX_BYTES (register_name)0x2fd6
-#define NUM_RX_BYTES (register_name)0x2fd7
+#define DEVIATION_M    (register_name)0x000a
+#define MODCFG_DEV_E   (register_name)0x000b
+#define DCFILT_CFG     (register_name)0x000c
+#define PREAMBLE_CFG1  (register_name)0x000d
+#define PREAMBLE_CFG0  (register_name)0x000e
+#define FREQ_IF_CFG    (register_name)0x000f
+#define IQIC           (register_name)0x0010
+#define CHAN_BW        (register_name)0x0011
+#define MDMCFG1        (register_name)0x0012
+#define MDMCFG0        (register_name)0x0013
+#define SYMBOL_RATE2   (register_name)0x0014
+#define SYMBOL_RATE1   (register_name)0x0015
+#define SYMBOL_RATE0   (register_name)0x0016
+#define SETTLING_CFG   (register_name)0x0020
+#define FS_CFG         (register_name)0x0021
+#define WOR_CFG1       (register_name)0x0022
+#define WOR_CFG0       (register_name)0x0023
+#define WOR_EVENT0_MSB (register_name)0x0024
+#define WOR_EVENT0_LSB (register_name)0x0025
+#define RFEND_CFG1     (register_name)0x0029
+#define RFEND_CFG0     (register_name)0x002a
+#define FREQOFF1       (register_name)0x2f0a
+#define FREQOFF0       (register_name)0x2f0b
+#define FREQ2          (register_name)0x2f0c
+#define FREQ1          (register_name)0x2f0d
+#define FREQ0          (register_name)0x2f0e
+#define RSSI1          (register_name)0x2f71
+#define RSSI0          (register_name)0x2f72
+#define FREQOFF_EST1   (register_name)0x2f77
+#define FREQOFF_EST0   (register_name)0x2f78
+#define NUM_TX_BYTES   (register_name)0x2fd6
+#define NUM_RX_BYTES   (register_name)0x2fd7
 
 /*
 	Bounds checking constants for valid registers.
 	Make sure first is the first register_name in 
 	enumeration above, and last is the last.
 */
-#define FIRST_REGISTER_NAME FS_CFG
+#define FIRST_REGISTER_NAME DEVIATION_M
 #define LAST_REGISTER_NAME  NUM_RX_BYTES
 
 /*
@@ -61,6 +92,30 @@ tcvr_error_t REGISTER_write_bitfield(register_name rn, uint8_t data, bit_t ms_bi
 */
 tcvr_error_t REGISTER_read_bitfield(register_name rn, bit_t ms_bit, bit_t ls_bit, uint8_t* data, uint8_t* status);
 
+/*
+	Writes the bits of data under mask to the specified register,
+	leaving the others as they are, and reads the chip status.
+	Returns ERROR_NONE if successful, or the error from the read
+	or write.
+*/
+tcvr_error_t REGISTER_write_masked(register_name rn, uint8_t data, uint8_t mask, uint8_t* status);
+/*
+	Reads the bits under mask from the specified register, shifted
+	down by shift, and reads the chip status.
+	Returns ERROR_NONE if successful, or the error from the read.
+*/
+tcvr_error_t REGISTER_read_masked(register_name rn, uint8_t mask, uint8_t shift, uint8_t* data, uint8_t* status);
+
+/*
+	The same for a field defined with BITS_FIELD, so its mask and
+	shift are constants, eg.
+	REGISTER_write_field(FS_CFG, FS_CFG_FSD_BANDSELECT, band, status).
+*/
+#define REGISTER_write_field(rn, field, value, status) \
+	REGISTER_write_masked(rn, field##_value(value), field##_MASK, status)
+#define REGISTER_read_field(rn, field, data, status) \
+	REGISTER_read_masked(rn, field##_MASK, field##_SHIFT, data, status)
+
 
 /*
 	Writes a sequence of bytes to a sequence of registers, starting with
@@ -2,21 +2,12 @@
 #include "bits.h"
 
 uint8_t BITS_bitfield_mask(bit_t ms_bit, bit_t ls_bit) {
-	uint8_t mask = 0;
-	bit_t   bit;
-
 	if (ls_bit > ms_bit) {
 		bit_t tmp = ls_bit;
 		ls_bit = ms_bit;
 		ms_bit = tmp;
 	}
 
-	bit = ms_bit;
-	while (ms_bit >= ls_bit) {
-		mask |= bit;
-		bit >>= 1;
-	}
-
-	return mask;
+	// everything up to ms_bit, less everything below ls_bit
+	return (uint8_t)((ms_bit | (ms_bit - 1)) & ~(ls_bit - 1));
 }
-
@@ -21,4 +21,40 @@ typedef uint8_t bit_t;
 */
 uint8_t BITS_bitfield_mask(bit_t ms_bit, bit_t ls_bit);
 
+/*
+	Register fields known at compile time. BITS_FIELD(NAME, ms, ls),
+	with ms and ls bit numbers 7..0, at file scope defines
+
+		NAME_MASK, NAME_SHIFT, NAME_MAX   constants
+		NAME_get(reg)                     the field's value in reg
+		NAME_set(reg, value)              reg with the field replaced
+		NAME_value(value)                 value in place, for or'ing
+
+	each of which is a single and/shift. A field that doesn't fit
+	in a byte fails to build, and so does BITS_FIELD_CONST(NAME, v)
+	with a constant v too wide for the field. C only.
+*/
+#define BITS_FIELD_MASK(ms, ls) ((uint8_t)((0xffu >> (7 - (ms))) & (0xffu << (ls))))
+
+#define BITS_FIELD(name, ms, ls) \
+	_Static_assert((ms) <= 7 && (ls) <= (ms), #name " must lie within a byte"); \
+	enum { \
+		name##_SHIFT = (ls), \
+		name##_MASK = BITS_FIELD_MASK(ms, ls), \
+		name##_MAX = (1 << ((ms) - (ls) + 1)) - 1 \
+	}; \
+	static inline uint8_t name##_get(uint8_t reg) { \
+		return (uint8_t)((reg & name##_MASK) >> name##_SHIFT); \
+	} \
+	static inline uint8_t name##_set(uint8_t reg, uint8_t value) { \
+		return (uint8_t)((reg & ~name##_MASK) | ((value << name##_SHIFT) & name##_MASK)); \
+	} \
+	static inline uint8_t name##_value(uint8_t value) { \
+		return (uint8_t)((value << name##_SHIFT) & name##_MASK); \
+	}
+
+#define BITS_FIELD_CONST(name, v) \
+	((uint8_t)(0 * sizeof(struct { _Static_assert((v) >= 0 && (v) <= name##_MAX, #v " does not fit " #name); char c; }) + \
+	           ((v) << name##_SHIFT)))
+
 #endif
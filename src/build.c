@@ -10,6 +10,26 @@
 #include "status_byte.h"
 #include "freq_synth_config.h"
 #include "chip_reset.h"
+#include "doppler_table.h"
+#include "rate_plan.h"
+#include "packet_ring.h"
+#include "radio_service.h"
+#include "crc.h"
+#include "whitening.h"
+#include "conv.h"
+#include "reed_solomon.h"
+#include "ax25.h"
+#include "tx_batch.h"
+#include "power.h"
+#include "clock.h"
+#include "status_tracker.h"
+#include "turnaround.h"
+#include "stats.h"
+#include "linux_bus.h"
+#include "survey.h"
+#include "afc.h"
+#include "arq.h"
+#include "compress.h"
 
 
 /*
@@ -0,0 +1,28 @@
+
+#include <stdint.h>
+
+#include "clock.h"
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(TCVR_FREESTANDING)
+#include <time.h>
+
+static uint64_t s_CLOCK_monotonic(void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+#define CLOCK_DEFAULT_SOURCE s_CLOCK_monotonic
+#else
+#define CLOCK_DEFAULT_SOURCE 0
+#endif
+
+static clock_source s_CLOCK_source = CLOCK_DEFAULT_SOURCE;
+
+void CLOCK_set_source(clock_source source) {
+	s_CLOCK_source = source ? source : CLOCK_DEFAULT_SOURCE;
+}
+
+uint64_t CLOCK_now_us(void) {
+	return s_CLOCK_source ? s_CLOCK_source() : 0;
+}
@@ -0,0 +1,24 @@
+#ifndef _CLOCK_H_
+#define _CLOCK_H_
+
+#include <stdint.h>
+
+/*
+	Microsecond time for timestamps and timeouts. On a hosted
+	build it is the monotonic clock; in the freestanding build
+	and anywhere else the caller supplies a source, eg. a
+	hardware timer, and until then the time reads 0.
+*/
+typedef uint64_t (*clock_source)(void);
+
+/*
+	Sets where the time comes from. NULL goes back to the default.
+*/
+void CLOCK_set_source(clock_source source);
+
+/*
+	Returns the current time in microseconds.
+*/
+uint64_t CLOCK_now_us(void);
+
+#endif
@@ -0,0 +1,458 @@
+
+#include <stdint.h>
+#include <string.h>
+
+#include "error.h"
+#include "compress.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COMPRESS_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#define COMPRESS_KEY_FLAG   0x80
+#define COMPRESS_COUNT_MASK 0x7f
+
+// offsets under this take one byte
+#define COMPRESS_LZ_SHORT_OFFSET 0x80
+#define COMPRESS_LZ_MAX_OFFSET   0x7fff
+
+static int s_COMPRESS_ready = 0;
+static int s_COMPRESS_simd = 0;
+
+static void s_COMPRESS_init(void) {
+#ifdef COMPRESS_HAVE_SSE2
+	__builtin_cpu_init();
+	s_COMPRESS_simd = __builtin_cpu_supports("sse2");
+#endif
+	s_COMPRESS_ready = 1;
+}
+
+// small values of either sign to small unsigned ones: 0, -1, 1, -2 ...
+static uint32_t s_COMPRESS_zigzag(uint32_t d) {
+	return (d << 1) ^ (0u - (d >> 31));
+}
+
+static uint32_t s_COMPRESS_unzigzag(uint32_t z) {
+	return (z >> 1) ^ (0u - (z & 1));
+}
+
+/*
+	Writes v as a varint, 7 bits a byte from the bottom, the top
+	bit set on all but the last. There is always room for 5.
+*/
+static uint16_t s_COMPRESS_put_varint(uint8_t* out, uint32_t v) {
+	uint16_t n = 0;
+
+	while (v >= 0x80) {
+		out[n++] = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+	out[n++] = (uint8_t)v;
+	return n;
+}
+
+/*
+	Reads a varint from the len bytes at in. Returns how many
+	bytes it took, 0 if it runs off the end or past 32 bits.
+*/
+static uint16_t s_COMPRESS_get_varint(const uint8_t* in, uint16_t len, uint32_t* v) {
+	uint32_t r = 0;
+	uint16_t n;
+
+	for (n = 0; n < len && n < 5; n++) {
+		r |= (uint32_t)(in[n] & 0x7f) << (7 * n);
+		if (!(in[n] & 0x80)) {
+			*v = r;
+			return (uint16_t)(n + 1);
+		}
+	}
+	return 0;
+}
+
+tcvr_error_t COMPRESS_delta_init(compress_delta* cd, uint8_t channels, uint16_t key_interval) {
+	if (!cd) {
+		return ERROR_NULL_POINTER;
+	}
+	if (channels == 0 || channels > COMPRESS_MAX_CHANNELS) {
+		return ERROR_PARAMETER_OUT_OF_RANGE;
+	}
+
+	memset(cd, 0, sizeof(*cd));
+	cd->channels = channels;
+	cd->key_interval = key_interval;
+	return ERROR_NONE;
+}
+
+tcvr_error_t COMPRESS_delta_encode(compress_delta* cd, const int32_t* samples, uint8_t* out, uint16_t max, uint16_t* out_len) {
+	uint8_t  record[COMPRESS_DELTA_BOUND(COMPRESS_MAX_CHANNELS)];
+	uint16_t n = 1;
+	int      key;
+	uint8_t  i;
+
+	if (!cd || !samples || !out || !out_len) {
+		return ERROR_NULL_POINTER;
+	}
+
+	key = cd->records == 0 || (cd->key_interval && cd->since_key >= cd->key_interval);
+	record[0] = (uint8_t)((key ? COMPRESS_KEY_FLAG : 0) | (cd->count & COMPRESS_COUNT_MASK));
+	for (i = 0; i < cd->channels; i++) {
+		n += s_COMPRESS_put_varint(&record[n],
+		                           s_COMPRESS_zigzag((uint32_t)samples[i] - (key ? 0 : (uint32_t)cd->last[i])));
+	}
+	if (n > max) {
+		return ERROR_COMPRESS_BUFFER_TOO_SMALL;
+	}
+
+	memcpy(out, record, n);
+	*out_len = n;
+
+	memcpy(cd->last, samples, cd->channels * sizeof(cd->last[0]));
+	cd->count = (uint8_t)((cd->count + 1) & COMPRESS_COUNT_MASK);
+	cd->since_key = key ? 1 : (uint16_t)(cd->since_key + 1);
+	cd->records++;
+	if (key) {
+		cd->keys++;
+	}
+	return ERROR_NONE;
+}
+
+tcvr_error_t COMPRESS_delta_decode(compress_delta* cd, const uint8_t* in, uint16_t len, int32_t* samples, uint16_t* used) {
+	uint32_t values[COMPRESS_MAX_CHANNELS];
+	uint16_t n = 1;
+	uint16_t got;
+	int      key;
+	uint8_t  i;
+
+	if (!cd || !in || !samples || !used) {
+		return ERROR_NULL_POINTER;
+	}
+	if (len == 0) {
+		return ERROR_COMPRESS_CORRUPT;
+	}
+
+	for (i = 0; i < cd->channels; i++) {
+		got = s_COMPRESS_get_varint(&in[n], (uint16_t)(len - n), &values[i]);
+		if (got == 0) {
+			return ERROR_COMPRESS_CORRUPT;
+		}
+		n += got;
+	}
+	*used = n;
+
+	key = (in[0] & COMPRESS_KEY_FLAG) != 0;
+	if (!key && (!cd->synced || (in[0] & COMPRESS_COUNT_MASK) != cd->count)) {
+		cd->synced = 0;
+		cd->out_of_sync++;
+		return ERROR_COMPRESS_OUT_OF_SYNC;
+	}
+
+	for (i = 0; i < cd->channels; i++) {
+		cd->last[i] = (int32_t)(s_COMPRESS_unzigzag(values[i]) + (key ? 0 : (uint32_t)cd->last[i]));
+		samples[i] = cd->last[i];
+	}
+	cd->count = (uint8_t)((in[0] + 1) & COMPRESS_COUNT_MASK);
+	cd->synced = 1;
+	cd->records++;
+	if (key) {
+		cd->keys++;
+	}
+	return ERROR_NONE;
+}
+
+static uint16_t s_COMPRESS_lz_hash(const uint8_t* p) {
+	uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+
+	return (uint16_t)((v * 2654435761u) >> (32 - COMPRESS_LZ_HASH_BITS));
+}
+
+// pos must have COMPRESS_LZ_MIN_MATCH bytes after it in the window
+static void s_COMPRESS_lz_insert(compress_lz* lz, uint16_t pos) {
+	uint16_t h = s_COMPRESS_lz_hash(&lz->window[pos]);
+
+	lz->chain[pos] = lz->head[h];
+	lz->head[h] = (uint16_t)(pos + 1);
+}
+
+/*
+	Writes the part of a length over 15 that the token's nibble
+	couldn't hold: bytes of 255 and then the rest.
+	Returns the new output length, or 0 if it ran out of room.
+*/
+static uint16_t s_COMPRESS_lz_put_length(uint8_t* out, uint16_t max, uint16_t n, uint16_t v) {
+	for (;;) {
+		if (n >= max) {
+			return 0;
+		}
+		if (v < 255) {
+			out[n++] = (uint8_t)v;
+			return n;
+		}
+		out[n++] = 255;
+		v -= 255;
+	}
+}
+
+/*
+	Writes a sequence: the literals, then the match of match_len
+	bytes offset back, if match_len isn't 0.
+	Returns the new output length, or 0 if it ran out of room.
+*/
+static uint16_t s_COMPRESS_lz_sequence(uint8_t* out, uint16_t max, uint16_t n,
+                                       const uint8_t* literals, uint16_t lit_len,
+                                       uint16_t offset, uint16_t match_len) {
+	uint16_t m = match_len ? (uint16_t)(match_len - COMPRESS_LZ_MIN_MATCH) : 0;
+
+	if (n >= max) {
+		return 0;
+	}
+	out[n++] = (uint8_t)(((lit_len < 15 ? lit_len : 15) << 4) | (m < 15 ? m : 15));
+	if (lit_len >= 15 && !(n = s_COMPRESS_lz_put_length(out, max, n, (uint16_t)(lit_len - 15)))) {
+		return 0;
+	}
+	if (lit_len > max - n) {
+		return 0;
+	}
+	memcpy(&out[n], literals, lit_len);
+	n += lit_len;
+
+	if (!match_len) {
+		return n;
+	}
+	if (offset < COMPRESS_LZ_SHORT_OFFSET) {
+		if (n >= max) {
+			return 0;
+		}
+		out[n++] = (uint8_t)offset;
+	}
+	else {
+		if (n + 2 > max) {
+			return 0;
+		}
+		out[n++] = (uint8_t)(0x80 | (offset >> 8));
+		out[n++] = (uint8_t)(offset & 0xff);
+	}
+	if (m >= 15) {
+		n = s_COMPRESS_lz_put_length(out, max, n, (uint16_t)(m - 15));
+	}
+	return n;
+}
+
+tcvr_error_t COMPRESS_lz_init(compress_lz* lz, const uint8_t* dict, uint16_t dict_len) {
+	if (!lz || (!dict && dict_len)) {
+		return ERROR_NULL_POINTER;
+	}
+	if (dict_len > COMPRESS_LZ_MAX_DICT) {
+		return ERROR_COMPRESS_TOO_LONG;
+	}
+
+	if (dict_len) {
+		memcpy(lz->window, dict, dict_len);
+	}
+	lz->dict_len = dict_len;
+	return ERROR_NONE;
+}
+
+tcvr_error_t COMPRESS_lz_compress(compress_lz* lz, const uint8_t* in, uint16_t len, uint8_t* out, uint16_t max, uint16_t* out_len) {
+	uint16_t end;
+	uint16_t pos;
+	uint16_t lit;
+	uint16_t cand, best_len, best_off, l, tries;
+	uint16_t n = 0;
+	uint16_t i;
+
+	if (!lz || (!in && len) || !out || !out_len) {
+		return ERROR_NULL_POINTER;
+	}
+	if (len > COMPRESS_LZ_MAX_INPUT) {
+		return ERROR_COMPRESS_TOO_LONG;
+	}
+
+	// the dictionary is matched against like earlier input
+	end = (uint16_t)(lz->dict_len + len);
+	memcpy(&lz->window[lz->dict_len], in, len);
+	memset(lz->head, 0, sizeof(lz->head));
+	for (i = 0; i + COMPRESS_LZ_MIN_MATCH <= lz->dict_len; i++) {
+		s_COMPRESS_lz_insert(lz, i);
+	}
+
+	pos = lit = lz->dict_len;
+	while (pos + COMPRESS_LZ_MIN_MATCH <= end) {
+		best_len = 0;
+		best_off = 0;
+		cand = lz->head[s_COMPRESS_lz_hash(&lz->window[pos])];
+		for (tries = 0; cand && tries < COMPRESS_LZ_MAX_CHAIN; tries++, cand = lz->chain[cand - 1]) {
+			if (pos - (cand - 1) > COMPRESS_LZ_MAX_OFFSET) {
+				break;
+			}
+			for (l = 0; pos + l < end && lz->window[cand - 1 + l] == lz->window[pos + l]; l++) {
+			}
+			if (l > best_len) {
+				best_len = l;
+				best_off = (uint16_t)(pos - (cand - 1));
+			}
+		}
+
+		// a long offset costs a byte more, so has to save one more
+		if (best_len < COMPRESS_LZ_MIN_MATCH + (best_off >= COMPRESS_LZ_SHORT_OFFSET)) {
+			s_COMPRESS_lz_insert(lz, pos);
+			pos++;
+			continue;
+		}
+
+		n = s_COMPRESS_lz_sequence(out, max, n, &lz->window[lit], (uint16_t)(pos - lit), best_off, best_len);
+		if (n == 0) {
+			return ERROR_COMPRESS_BUFFER_TOO_SMALL;
+		}
+		for (i = 0; i < best_len; i++, pos++) {
+			if (pos + COMPRESS_LZ_MIN_MATCH <= end) {
+				s_COMPRESS_lz_insert(lz, pos);
+			}
+		}
+		lit = pos;
+	}
+
+	if (end > lit) {
+		n = s_COMPRESS_lz_sequence(out, max, n, &lz->window[lit], (uint16_t)(end - lit), 0, 0);
+		if (n == 0) {
+			return ERROR_COMPRESS_BUFFER_TOO_SMALL;
+		}
+	}
+
+	*out_len = n;
+	return ERROR_NONE;
+}
+
+#ifdef COMPRESS_HAVE_SSE2
+/*
+	Copies len bytes 16 at a time, then the rest one at a time.
+	Where the two overlap, dst must be at least 16 past src.
+*/
+__attribute__((target("sse2")))
+static void s_COMPRESS_copy_sse2(uint8_t* dst, const uint8_t* src, uint16_t len) {
+	while (len >= 16) {
+		_mm_storeu_si128((__m128i*)dst, _mm_loadu_si128((const __m128i*)src));
+		dst += 16;
+		src += 16;
+		len -= 16;
+	}
+	while (len--) {
+		*dst++ = *src++;
+	}
+}
+#endif
+
+/*
+	Copies forward, so a match may overlap what it produces, eg.
+	offset 1 repeats a byte. Only 16 at a time if distance, how
+	far dst is past src, allows it.
+*/
+static void s_COMPRESS_copy(uint8_t* dst, const uint8_t* src, uint16_t len, uint16_t distance) {
+#ifdef COMPRESS_HAVE_SSE2
+	if (s_COMPRESS_simd && distance >= 16) {
+		s_COMPRESS_copy_sse2(dst, src, len);
+		return;
+	}
+#endif
+	(void)distance;
+	while (len--) {
+		*dst++ = *src++;
+	}
+}
+
+/*
+	Reads the rest of a length whose nibble was 15, onto v.
+	Returns the new input position, 0 if it runs off the end.
+*/
+static uint16_t s_COMPRESS_lz_get_length(const uint8_t* in, uint16_t len, uint16_t ip, uint16_t* v) {
+	uint8_t b;
+
+	do {
+		if (ip >= len) {
+			return 0;
+		}
+		b = in[ip++];
+		*v = (uint16_t)(*v + b);
+	} while (b == 255);
+	return ip;
+}
+
+tcvr_error_t COMPRESS_lz_decompress(const uint8_t* dict, uint16_t dict_len, const uint8_t* in, uint16_t len,
+                                    uint8_t* out, uint16_t max, uint16_t* out_len) {
+	uint16_t ip = 0;
+	uint16_t op = 0;
+	uint16_t lit, match, offset, from_dict;
+	uint8_t  token;
+
+	if ((!dict && dict_len) || (!in && len) || !out || !out_len) {
+		return ERROR_NULL_POINTER;
+	}
+	if (!s_COMPRESS_ready) {
+		s_COMPRESS_init();
+	}
+
+	while (ip < len) {
+		token = in[ip++];
+
+		lit = token >> 4;
+		if (lit == 15 && !(ip = s_COMPRESS_lz_get_length(in, len, ip, &lit))) {
+			return ERROR_COMPRESS_CORRUPT;
+		}
+		if (lit > len - ip) {
+			return ERROR_COMPRESS_CORRUPT;
+		}
+		if (lit > max - op) {
+			return ERROR_COMPRESS_BUFFER_TOO_SMALL;
+		}
+		// input and output never overlap
+		s_COMPRESS_copy(&out[op], &in[ip], lit, 16);
+		ip += lit;
+		op += lit;
+
+		if (ip == len) {
+			break;
+		}
+
+		offset = in[ip++];
+		if (offset >= COMPRESS_LZ_SHORT_OFFSET) {
+			if (ip >= len) {
+				return ERROR_COMPRESS_CORRUPT;
+			}
+			offset = (uint16_t)(((offset & 0x7f) << 8) | in[ip++]);
+		}
+		match = (uint16_t)((token & 0x0f) + COMPRESS_LZ_MIN_MATCH);
+		if ((token & 0x0f) == 15 && !(ip = s_COMPRESS_lz_get_length(in, len, ip, &match))) {
+			return ERROR_COMPRESS_CORRUPT;
+		}
+		if (offset == 0 || offset > op + dict_len) {
+			return ERROR_COMPRESS_CORRUPT;
+		}
+		if (match > max - op) {
+			return ERROR_COMPRESS_BUFFER_TOO_SMALL;
+		}
+
+		// the part from the dictionary, then the part from the output
+		if (offset > op) {
+			from_dict = (uint16_t)(offset - op);
+			if (from_dict > match) {
+				from_dict = match;
+			}
+			memcpy(&out[op], &dict[dict_len - (offset - op)], from_dict);
+			op += from_dict;
+			match -= from_dict;
+		}
+		if (match) {
+			s_COMPRESS_copy(&out[op], &out[op - offset], match, offset);
+			op += match;
+		}
+	}
+
+	*out_len = op;
+	return ERROR_NONE;
+}
+
+int COMPRESS_use_simd(int enable) {
+	s_COMPRESS_init();
+	s_COMPRESS_simd = s_COMPRESS_simd && enable;
+	return s_COMPRESS_simd;
+}
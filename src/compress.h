@@ -0,0 +1,136 @@
+#ifndef _COMPRESS_H_
+#define _COMPRESS_H_
+
+#include <stdint.h>
+#include "error.h"
+
+/*
+	Telemetry compression, to get more of it down per pass at the
+	same bit rate. Two stages, either of which can be used alone:
+
+	Delta records. Each record is a set of sensor channels, sent
+	as the zig-zag varint of how far each moved since the last
+	record: a channel that hasn't moved takes 1 byte, one that
+	moved less than 64 either way too. A record starts with a
+	header byte, the top bit set for a key record (encoded against
+	zero, so it stands alone) and a 7-bit count in the rest. A
+	delta record that doesn't follow the last one decoded is
+	refused, so one lost frame costs the records up to the next
+	key, not the rest of the pass.
+
+	LZ. Byte-oriented LZ77 for frame-sized inputs, primed with a
+	dictionary both ends hold (eg. a typical frame), since a
+	single frame has little history of its own to match. Each
+	sequence is a token, then its literals, then where to copy
+	from:
+
+		token   literal count in the high nibble, match length
+		        less COMPRESS_LZ_MIN_MATCH in the low, 15 meaning
+		        more follows in bytes of 255 and a last under 255
+		offset  1 to 127 in one byte, up to 32767 in two, the
+		        first with the top bit set holding the high bits
+
+	The last sequence stops after its literals. Output is never
+	more than COMPRESS_LZ_BOUND of the input.
+
+	Nothing is allocated: the compressor's tables live in
+	compress_lz, and decompressing takes no state at all. On x86
+	the decompressor copies 16 bytes at a time with SSE2 where
+	it can, for the ground station's backlog.
+*/
+#define COMPRESS_MAX_CHANNELS     32
+#define COMPRESS_DELTA_BOUND(ch)  (1 + 5 * (ch))
+
+#define COMPRESS_LZ_MAX_DICT      256
+#define COMPRESS_LZ_MAX_INPUT     256
+#define COMPRESS_LZ_MIN_MATCH     3
+#define COMPRESS_LZ_HASH_BITS     8
+#define COMPRESS_LZ_MAX_CHAIN     8   // candidates tried per position
+#define COMPRESS_LZ_BOUND(n)      ((n) + (n) / 255 + 2)
+
+typedef struct compress_delta_s {
+	int32_t  last[COMPRESS_MAX_CHANNELS];
+	uint8_t  channels;
+	uint8_t  count;          // of the next record, 7 bits
+	uint8_t  synced;         // decoding: last holds a good record
+	uint16_t key_interval;   // encoding: a key record every this many
+	uint16_t since_key;
+
+	uint32_t records;
+	uint32_t keys;
+	uint32_t out_of_sync;    // decoding: delta records refused
+} compress_delta;
+
+typedef struct compress_lz_s {
+	uint8_t  window[COMPRESS_LZ_MAX_DICT + COMPRESS_LZ_MAX_INPUT];
+	uint16_t head[1 << COMPRESS_LZ_HASH_BITS];  // newest position + 1, by hash
+	uint16_t chain[COMPRESS_LZ_MAX_DICT + COMPRESS_LZ_MAX_INPUT];
+	uint16_t dict_len;
+} compress_lz;
+
+/*
+	Starts a delta encoder or decoder for records of channels
+	channels. An encoder sends a key record first and then every
+	key_interval records, 0 meaning only first.
+	Returns ERROR_NONE if successful, ERROR_PARAMETER_OUT_OF_RANGE
+	if channels is 0 or over COMPRESS_MAX_CHANNELS.
+*/
+tcvr_error_t COMPRESS_delta_init(compress_delta* cd, uint8_t channels, uint16_t key_interval);
+
+/*
+	Writes the record for samples into out, which holds max bytes.
+	*out_len is set to its length, at most
+	COMPRESS_DELTA_BOUND(channels).
+	Returns ERROR_NONE if successful, ERROR_COMPRESS_BUFFER_TOO_SMALL
+	if it doesn't fit.
+*/
+tcvr_error_t COMPRESS_delta_encode(compress_delta* cd, const int32_t* samples, uint8_t* out, uint16_t max, uint16_t* out_len);
+
+/*
+	Decodes the record at the start of the len bytes at in into
+	samples. *used is set to how many bytes it took, so records
+	can be packed back to back.
+	Returns ERROR_NONE if successful, ERROR_COMPRESS_CORRUPT if the
+	record is cut short, ERROR_COMPRESS_OUT_OF_SYNC if it is a
+	delta from a record that wasn't decoded (*used is still set,
+	to skip it).
+*/
+tcvr_error_t COMPRESS_delta_decode(compress_delta* cd, const uint8_t* in, uint16_t len, int32_t* samples, uint16_t* used);
+
+/*
+	Primes the compressor with dict_len bytes of dictionary, which
+	the decompressor will need too. dict may be 0 if dict_len is.
+	Returns ERROR_NONE if successful, ERROR_COMPRESS_TOO_LONG if
+	dict_len is over COMPRESS_LZ_MAX_DICT.
+*/
+tcvr_error_t COMPRESS_lz_init(compress_lz* lz, const uint8_t* dict, uint16_t dict_len);
+
+/*
+	Compresses len bytes from in into out, which holds max bytes.
+	*out_len is set to the compressed length.
+	Returns ERROR_NONE if successful, ERROR_COMPRESS_TOO_LONG if
+	len is over COMPRESS_LZ_MAX_INPUT, ERROR_COMPRESS_BUFFER_TOO_SMALL
+	if the output doesn't fit (it always does in
+	COMPRESS_LZ_BOUND(len)).
+*/
+tcvr_error_t COMPRESS_lz_compress(compress_lz* lz, const uint8_t* in, uint16_t len, uint8_t* out, uint16_t max, uint16_t* out_len);
+
+/*
+	Decompresses len bytes from in into out, which holds max
+	bytes, with the dictionary the compressor was primed with.
+	*out_len is set to the decompressed length.
+	Returns ERROR_NONE if successful, ERROR_COMPRESS_BUFFER_TOO_SMALL
+	if the output doesn't fit, ERROR_COMPRESS_CORRUPT if the input
+	is cut short or copies from before the dictionary.
+*/
+tcvr_error_t COMPRESS_lz_decompress(const uint8_t* dict, uint16_t dict_len, const uint8_t* in, uint16_t len,
+                                    uint8_t* out, uint16_t max, uint16_t* out_len);
+
+/*
+	Turns the SSE2 copies on or off, eg. to compare the two. They
+	are never used where the CPU lacks them.
+	Returns 1 if they are now in use, 0 otherwise.
+*/
+int COMPRESS_use_simd(int enable);
+
+#endif
@@ -0,0 +1,365 @@
+
+#include <stdint.h>
+#include <string.h>
+
+#include "error.h"
+#include "conv.h"
+
+#if defined(__SSE2__)
+#define CONV_HAVE_SIMD 1
+#include <emmintrin.h>
+#else
+#define CONV_HAVE_SIMD 0
+#endif
+
+/*
+	The shift register holds the newest bit at the bottom, so the
+	generators are bit reversed: 171 octal is 0x4f, 133 is 0x6d.
+	Both have their top and bottom taps set, which is what makes
+	the butterflies below symmetric.
+*/
+#define CONV_POLY_A 0x4f
+#define CONV_POLY_B 0x6d
+
+// worst branch metric, both soft symbols fully wrong
+#define CONV_BRANCH_MAX 510
+
+// starting metric of the states a terminated frame can't be in
+#define CONV_UNREACHED  4096
+
+// steps between renormalizations, to keep metrics well inside int16
+#define CONV_RENORM     8
+
+// soft symbols expanded from hard bytes at a time
+#define CONV_HARD_CHUNK 64
+
+static int     s_CONV_ready = 0;
+static int     s_CONV_simd = CONV_HAVE_SIMD;
+static uint8_t s_CONV_out[128];  // two coded bits for each 7 bit register
+
+/*
+	Expected soft symbols, 0 or 255, on the branch from state i
+	(i < 32) with a 0 in. The other three branches of butterfly i
+	expect the same or the complement.
+*/
+_Alignas(16) static uint16_t s_CONV_expect_a[32];
+_Alignas(16) static uint16_t s_CONV_expect_b[32];
+
+static int s_CONV_parity(uint8_t x) {
+	x ^= x >> 4;
+	x ^= x >> 2;
+	x ^= x >> 1;
+	return x & 1;
+}
+
+static void s_CONV_init(void) {
+	int r;
+
+	for (r = 0; r < 128; r++) {
+		s_CONV_out[r] = (uint8_t)((s_CONV_parity(r & CONV_POLY_A) << 1) | s_CONV_parity(r & CONV_POLY_B));
+	}
+	for (r = 0; r < 32; r++) {
+		s_CONV_expect_a[r] = (s_CONV_out[r << 1] & 2) ? 255 : 0;
+		s_CONV_expect_b[r] = (s_CONV_out[r << 1] & 1) ? 255 : 0;
+	}
+	s_CONV_ready = 1;
+}
+
+void CONV_encoder_reset(conv_encoder* enc) {
+	if (enc) {
+		enc->state = 0;
+	}
+}
+
+void CONV_encode(conv_encoder* enc, const uint8_t* data, uint32_t len, uint8_t* coded) {
+	uint32_t state;
+	uint32_t out;
+	int      i;
+
+	if (!enc || !data || !coded) {
+		return;
+	}
+	if (!s_CONV_ready) {
+		s_CONV_init();
+	}
+
+	state = enc->state;
+	while (len--) {
+		out = 0;
+		for (i = 7; i >= 0; i--) {
+			state = (state << 1) | ((*data >> i) & 1);
+			out = (out << 2) | s_CONV_out[state & 0x7f];
+			state &= 0x3f;
+		}
+		*coded++ = (uint8_t)(out >> 8);
+		*coded++ = (uint8_t)out;
+		data++;
+	}
+	enc->state = (uint8_t)state;
+}
+
+void CONV_encode_flush(conv_encoder* enc, uint8_t* coded) {
+	uint32_t state;
+	uint32_t out = 0;
+	int      i;
+
+	if (!enc || !coded) {
+		return;
+	}
+	if (!s_CONV_ready) {
+		s_CONV_init();
+	}
+
+	state = enc->state;
+	for (i = 0; i < CONV_TAIL_BITS; i++) {
+		state <<= 1;
+		out = (out << 2) | s_CONV_out[state & 0x7f];
+		state &= 0x3f;
+	}
+	out <<= 16 - 2*CONV_TAIL_BITS;
+	coded[0] = (uint8_t)(out >> 8);
+	coded[1] = (uint8_t)out;
+	enc->state = 0;
+}
+
+void CONV_decoder_reset(conv_decoder* dec) {
+	int i;
+
+	if (!dec) {
+		return;
+	}
+	dec->metrics[0] = 0;
+	for (i = 1; i < 64; i++) {
+		dec->metrics[i] = CONV_UNREACHED;
+	}
+	dec->steps = 0;
+	dec->held = -1;
+}
+
+static void s_CONV_renormalize(uint16_t* m) {
+	uint16_t low = m[0];
+	int      i;
+
+	for (i = 1; i < 64; i++) {
+		if (m[i] < low) {
+			low = m[i];
+		}
+	}
+	for (i = 0; i < 64; i++) {
+		m[i] -= low;
+	}
+}
+
+/*
+	One add-compare-select per state per symbol pair. Butterfly i
+	takes states i and i+32 to states 2i and 2i+1. The decision
+	bit of state 2i goes to bit i of the step's word, that of 2i+1
+	to bit 32+i.
+*/
+static void s_CONV_acs_scalar(conv_decoder* dec, const uint8_t* sym, uint32_t pairs) {
+	uint16_t  a[64], b[64];
+	uint16_t* old = a;
+	uint16_t* new = b;
+	uint16_t* swap;
+	uint64_t  d;
+	uint32_t  bm, cbm, x, y;
+	int       i;
+
+	memcpy(old, dec->metrics, sizeof(a));
+	while (pairs--) {
+		d = 0;
+		for (i = 0; i < 32; i++) {
+			bm = (sym[0] ^ s_CONV_expect_a[i]) + (sym[1] ^ s_CONV_expect_b[i]);
+			cbm = CONV_BRANCH_MAX - bm;
+
+			x = old[i] + bm;
+			y = old[i + 32] + cbm;
+			new[2*i] = (uint16_t)(x > y ? y : x);
+			d |= (uint64_t)(x > y) << i;
+
+			x = old[i] + cbm;
+			y = old[i + 32] + bm;
+			new[2*i + 1] = (uint16_t)(x > y ? y : x);
+			d |= (uint64_t)(x > y) << (32 + i);
+		}
+		dec->decisions[dec->steps++] = d;
+		sym += 2;
+
+		if ((dec->steps % CONV_RENORM) == 0) {
+			s_CONV_renormalize(new);
+		}
+		swap = old;
+		old = new;
+		new = swap;
+	}
+	memcpy(dec->metrics, old, sizeof(a));
+}
+
+#if CONV_HAVE_SIMD
+/*
+	The same, 8 states a lane. Metrics stay below 0x8000, so the
+	signed 16 bit compares are safe.
+*/
+static void s_CONV_acs_sse2(conv_decoder* dec, const uint8_t* sym, uint32_t pairs) {
+	__m128i  m[8], n[8];
+	__m128i  ea[4], eb[4];
+	__m128i  s0, s1, bm, cbm, x, y, even, odd, de, dd;
+	__m128i  full = _mm_set1_epi16(CONV_BRANCH_MAX);
+	uint64_t d;
+	uint32_t mask;
+	int      g;
+
+	for (g = 0; g < 8; g++) {
+		m[g] = _mm_load_si128((const __m128i*)(dec->metrics + 8*g));
+	}
+	for (g = 0; g < 4; g++) {
+		ea[g] = _mm_load_si128((const __m128i*)(s_CONV_expect_a + 8*g));
+		eb[g] = _mm_load_si128((const __m128i*)(s_CONV_expect_b + 8*g));
+	}
+
+	while (pairs--) {
+		s0 = _mm_set1_epi16(sym[0]);
+		s1 = _mm_set1_epi16(sym[1]);
+		d = 0;
+		for (g = 0; g < 4; g++) {
+			bm = _mm_add_epi16(_mm_xor_si128(s0, ea[g]), _mm_xor_si128(s1, eb[g]));
+			cbm = _mm_sub_epi16(full, bm);
+
+			x = _mm_add_epi16(m[g], bm);
+			y = _mm_add_epi16(m[g + 4], cbm);
+			even = _mm_min_epi16(x, y);
+			de = _mm_cmpgt_epi16(x, y);
+
+			x = _mm_add_epi16(m[g], cbm);
+			y = _mm_add_epi16(m[g + 4], bm);
+			odd = _mm_min_epi16(x, y);
+			dd = _mm_cmpgt_epi16(x, y);
+
+			n[2*g] = _mm_unpacklo_epi16(even, odd);
+			n[2*g + 1] = _mm_unpackhi_epi16(even, odd);
+
+			// low byte: states 2i, high byte: states 2i+1
+			mask = (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(de, dd));
+			d |= (uint64_t)(mask & 0xff) << (8*g);
+			d |= (uint64_t)(mask >> 8) << (32 + 8*g);
+		}
+		dec->decisions[dec->steps++] = d;
+		sym += 2;
+
+		for (g = 0; g < 8; g++) {
+			m[g] = n[g];
+		}
+		if ((dec->steps % CONV_RENORM) == 0) {
+			x = _mm_min_epi16(_mm_min_epi16(_mm_min_epi16(m[0], m[1]), _mm_min_epi16(m[2], m[3])),
+			                  _mm_min_epi16(_mm_min_epi16(m[4], m[5]), _mm_min_epi16(m[6], m[7])));
+			x = _mm_min_epi16(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+			x = _mm_min_epi16(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+			x = _mm_min_epi16(x, _mm_shufflelo_epi16(_mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1)));
+			for (g = 0; g < 8; g++) {
+				m[g] = _mm_sub_epi16(m[g], x);
+			}
+		}
+	}
+
+	for (g = 0; g < 8; g++) {
+		_mm_store_si128((__m128i*)(dec->metrics + 8*g), m[g]);
+	}
+}
+#endif
+
+static void s_CONV_acs(conv_decoder* dec, const uint8_t* sym, uint32_t pairs) {
+	if (!s_CONV_ready) {
+		s_CONV_init();
+	}
+#if CONV_HAVE_SIMD
+	if (s_CONV_simd) {
+		s_CONV_acs_sse2(dec, sym, pairs);
+		return;
+	}
+#endif
+	s_CONV_acs_scalar(dec, sym, pairs);
+}
+
+tcvr_error_t CONV_decode_update(conv_decoder* dec, const uint8_t* coded, uint32_t len) {
+	uint8_t  soft[CONV_HARD_CHUNK * 8];
+	uint32_t n, i;
+	int      j;
+
+	if (!dec || !coded) {
+		return ERROR_NULL_POINTER;
+	}
+	if (dec->steps + len*4 > CONV_MAX_STEPS) {
+		return ERROR_FEC_FRAME_TOO_LONG;
+	}
+
+	while (len) {
+		n = (len < CONV_HARD_CHUNK) ? len : CONV_HARD_CHUNK;
+		for (i = 0; i < n; i++) {
+			for (j = 0; j < 8; j++) {
+				soft[8*i + j] = (coded[i] & (0x80 >> j)) ? 255 : 0;
+			}
+		}
+		s_CONV_acs(dec, soft, n*4);
+		coded += n;
+		len -= n;
+	}
+
+	return ERROR_NONE;
+}
+
+tcvr_error_t CONV_decode_soft(conv_decoder* dec, const uint8_t* symbols, uint32_t count) {
+	uint8_t pair[2];
+
+	if (!dec || !symbols) {
+		return ERROR_NULL_POINTER;
+	}
+	if (dec->steps + (count + (dec->held >= 0)) / 2 > CONV_MAX_STEPS) {
+		return ERROR_FEC_FRAME_TOO_LONG;
+	}
+
+	if (dec->held >= 0 && count) {
+		pair[0] = (uint8_t)dec->held;
+		pair[1] = *symbols++;
+		count--;
+		dec->held = -1;
+		s_CONV_acs(dec, pair, 1);
+	}
+	if (count >= 2) {
+		s_CONV_acs(dec, symbols, count / 2);
+	}
+	if (count & 1) {
+		dec->held = symbols[count - 1];
+	}
+
+	return ERROR_NONE;
+}
+
+tcvr_error_t CONV_decode_final(conv_decoder* dec, uint8_t* data, uint32_t len) {
+	uint32_t bits, t;
+	uint32_t state = 0;
+	uint64_t d;
+
+	if (!dec || !data) {
+		return ERROR_NULL_POINTER;
+	}
+	bits = len * 8;
+	if (len > CONV_MAX_FRAME || bits + CONV_TAIL_BITS > dec->steps) {
+		return ERROR_PARAMETER_OUT_OF_RANGE;
+	}
+
+	memset(data, 0, len);
+	for (t = bits + CONV_TAIL_BITS; t > 0; t--) {
+		if (t <= bits && (state & 1)) {
+			data[(t - 1) >> 3] |= (uint8_t)(0x80 >> ((t - 1) & 7));
+		}
+		d = dec->decisions[t - 1];
+		state = (state >> 1) | ((uint32_t)((d >> ((state & 1)*32 + (state >> 1))) & 1) << 5);
+	}
+
+	return ERROR_NONE;
+}
+
+int CONV_use_simd(int enable) {
+	s_CONV_simd = CONV_HAVE_SIMD && enable;
+	return s_CONV_simd;
+}
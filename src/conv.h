@@ -0,0 +1,102 @@
+#ifndef _CONV_H_
+#define _CONV_H_
+
+#include <stdint.h>
+#include "error.h"
+
+/*
+	Rate 1/2, constraint length 7 convolutional code, the NASA
+	standard one: generators 171 and 133 octal (0x79, 0x5b), the
+	171 symbol sent first, neither inverted. Each data bit becomes
+	two coded bits, so each data byte becomes two coded bytes.
+
+	Frames are terminated: CONV_encode_flush shifts the encoder
+	back to zero with CONV_TAIL_BITS zero bits, which come out as
+	two more bytes (the last four bits are padding). A frame of n
+	data bytes is CONV_ENCODED_SIZE(n) bytes on air.
+
+	The decoder is a Viterbi decoder over the 64 state trellis. It
+	is fed as the coded bytes arrive, eg. a FIFO's worth at a time,
+	and only traces back once the whole frame is in. With SSE2 the
+	add-compare-select runs on 8 states at a time; otherwise it is
+	done a state at a time. Both give the same result.
+
+	Received bits can be hard (CONV_decode_update, packed bytes
+	straight from the RX FIFO) or soft (CONV_decode_soft, one byte
+	per coded bit, 0 a confident 0 through 255 a confident 1).
+*/
+#define CONV_TAIL_BITS   6
+#define CONV_MAX_FRAME   256 // data bytes
+#define CONV_ENCODED_SIZE(n) (2*(uint32_t)(n) + 2)
+
+// trellis steps a decoder has room for: the frame, tail and padding
+#define CONV_MAX_STEPS   (CONV_MAX_FRAME*8 + CONV_TAIL_BITS + 2)
+
+typedef struct conv_encoder_s {
+	uint8_t state;  // last 6 data bits in
+} conv_encoder;
+
+typedef struct conv_decoder_s {
+	_Alignas(16)
+	uint16_t metrics[64];                // path metric of each state
+	uint64_t decisions[CONV_MAX_STEPS];  // survivor bits of each step
+	uint32_t steps;
+	int16_t  held;                       // soft symbol waiting for its pair, or -1
+} conv_decoder;
+
+/*
+	Starts a new frame.
+*/
+void CONV_encoder_reset(conv_encoder* enc);
+
+/*
+	Encodes len data bytes into 2*len coded bytes, continuing from
+	the last call.
+*/
+void CONV_encode(conv_encoder* enc, const uint8_t* data, uint32_t len, uint8_t* coded);
+
+/*
+	Ends the frame: writes the tail's 2 coded bytes and resets the
+	encoder.
+*/
+void CONV_encode_flush(conv_encoder* enc, uint8_t* coded);
+
+/*
+	Starts a new frame, at state zero.
+*/
+void CONV_decoder_reset(conv_decoder* dec);
+
+/*
+	Runs len bytes of hard coded bits, most significant bit first,
+	through the trellis.
+	Returns ERROR_NONE if successful, ERROR_FEC_FRAME_TOO_LONG if
+	the frame would overrun CONV_MAX_STEPS.
+*/
+tcvr_error_t CONV_decode_update(conv_decoder* dec, const uint8_t* coded, uint32_t len);
+
+/*
+	Runs count soft coded bits through the trellis. An odd count
+	is fine, the last symbol is held for the next call.
+	Returns ERROR_NONE if successful, ERROR_FEC_FRAME_TOO_LONG if
+	the frame would overrun CONV_MAX_STEPS.
+*/
+tcvr_error_t CONV_decode_soft(conv_decoder* dec, const uint8_t* symbols, uint32_t count);
+
+/*
+	Traces back the most likely path through a terminated frame of
+	len data bytes and writes them to data. Any coded bits after the
+	tail, eg. the padding, are ignored.
+	Returns ERROR_NONE if successful, ERROR_PARAMETER_OUT_OF_RANGE
+	if fewer than len bytes' worth of steps (and the tail) have been
+	run through the trellis.
+*/
+tcvr_error_t CONV_decode_final(conv_decoder* dec, uint8_t* data, uint32_t len);
+
+/*
+	Turns the SSE2 add-compare-select on or off, eg. to compare
+	the two. It is never used if it wasn't compiled in.
+	Returns 1 if it is now in use, 0 otherwise.
+*/
+int CONV_use_simd(int enable);
+
+#endif
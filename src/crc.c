@@ -0,0 +1,305 @@
+
+#include <stdint.h>
+
+#include <stdatomic.h>
+
+#include "error.h"
+#include "crc.h"
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(TCVR_FREESTANDING)
+#define CRC_HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CRC_HAVE_CLMUL
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+// reflected polynomials, for the tables
+#define CRC16_POLY_REFLECTED 0x8408
+#define CRC32_POLY_REFLECTED 0xedb88320
+
+// full polynomials, x^32 included, for the folding constants
+#define CRC16_POLY_SHIFTED 0x110210000ULL // CCITT times x^16
+#define CRC32_POLY         0x104c11db7ULL
+
+// anything shorter is quicker through the table
+#define CRC_CLMUL_MIN_LEN 64
+
+static uint16_t       s_CRC16_table[256];
+static uint32_t       s_CRC32_table[256];
+static int            s_CRC_have_clmul = 0;
+static atomic_int     s_CRC_clmul;
+
+#ifdef CRC_HAVE_PTHREAD
+static pthread_once_t s_CRC_once = PTHREAD_ONCE_INIT;
+#else
+static int            s_CRC_ready = 0;
+#endif
+
+/*
+	Folding constants, in the order used: x^(4*128+32), x^(4*128-32)
+	to fold 64 bytes, then x^(128+32), x^(128-32) to fold 16.
+*/
+static uint64_t s_CRC16_fold[4];
+static uint64_t s_CRC32_fold[4];
+
+static uint32_t s_CRC_reflect32(uint32_t x) {
+	uint32_t r = 0;
+	int      i;
+
+	for (i = 0; i < 32; i++) {
+		r = (r << 1) | ((x >> i) & 1);
+	}
+	return r;
+}
+
+/*
+	Returns x^n mod poly, where poly has degree 32, bit reflected
+	and shifted up one as the folding loop expects.
+*/
+static uint64_t s_CRC_fold_constant(unsigned int n, uint64_t poly) {
+	uint64_t r = 1;
+
+	while (n--) {
+		r <<= 1;
+		if (r & (1ULL << 32)) {
+			r ^= poly;
+		}
+	}
+	return (uint64_t)s_CRC_reflect32((uint32_t)r) << 1;
+}
+
+static void s_CRC_fold_constants(uint64_t poly, uint64_t k[4]) {
+	k[0] = s_CRC_fold_constant(4*128 + 32, poly);
+	k[1] = s_CRC_fold_constant(4*128 - 32, poly);
+	k[2] = s_CRC_fold_constant(128 + 32, poly);
+	k[3] = s_CRC_fold_constant(128 - 32, poly);
+}
+
+static void s_CRC_init(void) {
+	uint32_t c;
+	int      i, j;
+
+	for (i = 0; i < 256; i++) {
+		c = (uint32_t)i;
+		for (j = 0; j < 8; j++) {
+			c = (c >> 1) ^ ((c & 1) ? CRC16_POLY_REFLECTED : 0);
+		}
+		s_CRC16_table[i] = (uint16_t)c;
+
+		c = (uint32_t)i;
+		for (j = 0; j < 8; j++) {
+			c = (c >> 1) ^ ((c & 1) ? CRC32_POLY_REFLECTED : 0);
+		}
+		s_CRC32_table[i] = c;
+	}
+
+	s_CRC_fold_constants(CRC16_POLY_SHIFTED, s_CRC16_fold);
+	s_CRC_fold_constants(CRC32_POLY, s_CRC32_fold);
+
+#ifdef CRC_HAVE_CLMUL
+	__builtin_cpu_init();
+	s_CRC_have_clmul = __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse2");
+#endif
+	atomic_store_explicit(&s_CRC_clmul, s_CRC_have_clmul, memory_order_relaxed);
+}
+
+/*
+	Builds the tables the first time any thread needs them. The
+	flight build has no threads, so there a flag will do.
+*/
+static void s_CRC_init_once(void) {
+#ifdef CRC_HAVE_PTHREAD
+	pthread_once(&s_CRC_once, s_CRC_init);
+#else
+	if (!s_CRC_ready) {
+		s_CRC_init();
+		s_CRC_ready = 1;
+	}
+#endif
+}
+
+static uint16_t s_CRC16_table_update(uint16_t crc, const uint8_t* data, uint32_t len) {
+	while (len--) {
+		crc = (crc >> 8) ^ s_CRC16_table[(crc ^ *data++) & 0xff];
+	}
+	return crc;
+}
+
+static uint32_t s_CRC32_table_update(uint32_t crc, const uint8_t* data, uint32_t len) {
+	while (len--) {
+		crc = (crc >> 8) ^ s_CRC32_table[(crc ^ *data++) & 0xff];
+	}
+	return crc;
+}
+
+#ifdef CRC_HAVE_CLMUL
+/*
+	Folds len bytes, at least CRC_CLMUL_MIN_LEN and a multiple of
+	16, into 16 bytes congruent to crc followed by the data,
+	modulo the polynomial k was made from. The CRC of those 16
+	bytes, from a zero register, is then the CRC of the whole.
+
+	A 16-bit CRC folds the same way as a 32-bit one, with the
+	polynomial multiplied by x^16: the result is still congruent
+	modulo the real polynomial.
+*/
+__attribute__((target("pclmul,sse2")))
+static void s_CRC_clmul_fold(uint32_t crc, const uint8_t* p, uint32_t len, const uint64_t k[4], uint8_t out[16]) {
+	__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+	x1 = _mm_loadu_si128((const __m128i*)(p + 0));
+	x2 = _mm_loadu_si128((const __m128i*)(p + 16));
+	x3 = _mm_loadu_si128((const __m128i*)(p + 32));
+	x4 = _mm_loadu_si128((const __m128i*)(p + 48));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+	p += 64;
+	len -= 64;
+
+	// four lanes of 16 bytes, 64 bytes a step
+	x0 = _mm_set_epi64x((long long)k[1], (long long)k[0]);
+	while (len >= 64) {
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+		x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+		x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)(p + 0)));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)(p + 16)));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)(p + 32)));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)(p + 48)));
+
+		p += 64;
+		len -= 64;
+	}
+
+	// fold the four lanes into one
+	x0 = _mm_set_epi64x((long long)k[3], (long long)k[2]);
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), x2);
+
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), x3);
+
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), x4);
+
+	// then whatever 16 byte blocks are left
+	while (len >= 16) {
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)p));
+		p += 16;
+		len -= 16;
+	}
+
+	_mm_storeu_si128((__m128i*)out, x1);
+}
+#endif
+
+uint16_t CRC16_update(uint16_t crc, const uint8_t* data, uint32_t len) {
+	s_CRC_init_once();
+	if (!data) {
+		return crc;
+	}
+
+#ifdef CRC_HAVE_CLMUL
+	if (len >= CRC_CLMUL_MIN_LEN && atomic_load_explicit(&s_CRC_clmul, memory_order_relaxed)) {
+		uint8_t  folded[16];
+		uint32_t bulk = len & ~(uint32_t)15;
+
+		s_CRC_clmul_fold(crc, data, bulk, s_CRC16_fold, folded);
+		crc = s_CRC16_table_update(0, folded, 16);
+		data += bulk;
+		len -= bulk;
+	}
+#endif
+
+	return s_CRC16_table_update(crc, data, len);
+}
+
+uint16_t CRC16_final(uint16_t crc) {
+	return crc ^ 0xffff;
+}
+
+uint16_t CRC16(const uint8_t* data, uint32_t len) {
+	return CRC16_final(CRC16_update(CRC16_INIT, data, len));
+}
+
+uint32_t CRC32_update(uint32_t crc, const uint8_t* data, uint32_t len) {
+	s_CRC_init_once();
+	if (!data) {
+		return crc;
+	}
+
+#ifdef CRC_HAVE_CLMUL
+	if (len >= CRC_CLMUL_MIN_LEN && atomic_load_explicit(&s_CRC_clmul, memory_order_relaxed)) {
+		uint8_t  folded[16];
+		uint32_t bulk = len & ~(uint32_t)15;
+
+		s_CRC_clmul_fold(crc, data, bulk, s_CRC32_fold, folded);
+		crc = s_CRC32_table_update(0, folded, 16);
+		data += bulk;
+		len -= bulk;
+	}
+#endif
+
+	return s_CRC32_table_update(crc, data, len);
+}
+
+uint32_t CRC32_final(uint32_t crc) {
+	return crc ^ 0xffffffff;
+}
+
+uint32_t CRC32(const uint8_t* data, uint32_t len) {
+	return CRC32_final(CRC32_update(CRC32_INIT, data, len));
+}
+
+tcvr_error_t CRC16_check(const uint8_t* frame, uint32_t len) {
+	uint16_t fcs;
+
+	if (!frame) {
+		return ERROR_NULL_POINTER;
+	}
+	if (len < 2) {
+		return ERROR_CRC_MISMATCH;
+	}
+
+	fcs = (uint16_t)(frame[len - 2] | (frame[len - 1] << 8));
+	return (CRC16(frame, len - 2) == fcs) ? ERROR_NONE : ERROR_CRC_MISMATCH;
+}
+
+tcvr_error_t CRC32_check(const uint8_t* frame, uint32_t len) {
+	uint32_t fcs;
+
+	if (!frame) {
+		return ERROR_NULL_POINTER;
+	}
+	if (len < 4) {
+		return ERROR_CRC_MISMATCH;
+	}
+
+	fcs = (uint32_t)frame[len - 4] | ((uint32_t)frame[len - 3] << 8) |
+	      ((uint32_t)frame[len - 2] << 16) | ((uint32_t)frame[len - 1] << 24);
+	return (CRC32(frame, len - 4) == fcs) ? ERROR_NONE : ERROR_CRC_MISMATCH;
+}
+
+int CRC_use_clmul(int enable) {
+	int clmul;
+
+	s_CRC_init_once();
+	clmul = s_CRC_have_clmul && enable;
+	atomic_store_explicit(&s_CRC_clmul, clmul, memory_order_relaxed);
+	return clmul;
+}
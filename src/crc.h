@@ -0,0 +1,57 @@
+#ifndef _CRC_H_
+#define _CRC_H_
+
+#include <stdint.h>
+#include "error.h"
+
+/*
+	Software frame integrity checks, for frames the CC1120's own
+	packet engine does not cover (eg. infinite packet mode).
+
+	CRC16 is the CCITT polynomial, x^16 + x^12 + x^5 + 1, as used
+	by HDLC and AX.25 (CRC-16/X-25): reflected, initial value
+	0xffff, final value inverted. Check value 0x906e.
+
+	CRC32 is the IEEE 802.3 polynomial: reflected, initial value
+	0xffffffff, final value inverted. Check value 0xcbf43926.
+
+	Both are table driven, one byte at a time. On x86 with
+	carry-less multiply (PCLMULQDQ), detected at run time, buffers
+	of 64 bytes or more are folded 64 bytes per step instead.
+
+	The _update functions work on the raw register, so a frame
+	can be checked in pieces as it is drained:
+
+		crc = CRC16_INIT;
+		crc = CRC16_update(crc, piece, piece_len);  ...
+		fcs = CRC16_final(crc);
+*/
+#define CRC16_INIT 0xffff
+#define CRC32_INIT 0xffffffff
+
+uint16_t CRC16_update(uint16_t crc, const uint8_t* data, uint32_t len);
+uint16_t CRC16_final(uint16_t crc);
+uint16_t CRC16(const uint8_t* data, uint32_t len);
+
+uint32_t CRC32_update(uint32_t crc, const uint8_t* data, uint32_t len);
+uint32_t CRC32_final(uint32_t crc);
+uint32_t CRC32(const uint8_t* data, uint32_t len);
+
+/*
+	Checks a frame whose last 2 (or 4) bytes are its CRC,
+	least significant byte first.
+	Returns ERROR_NONE if it matches, ERROR_CRC_MISMATCH otherwise.
+*/
+tcvr_error_t CRC16_check(const uint8_t* frame, uint32_t len);
+tcvr_error_t CRC32_check(const uint8_t* frame, uint32_t len);
+
+/*
+	Turns the carry-less multiply path on or off, eg. to compare
+	the two. It is never used if the CPU lacks it. Both paths give
+	the same CRC, so it may be called while other threads are
+	checking frames.
+	Returns 1 if it is now in use, 0 otherwise.
+*/
+int CRC_use_clmul(int enable);
+
+#endif
@@ -0,0 +1,129 @@
+
+#include <stdint.h>
+
+#include "error.h"
+#include "bang_registers.h"
+#include "doppler_table.h"
+
+static uint16_t s_DOPPLER_TABLE_read_u16(const uint8_t* p) {
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t s_DOPPLER_TABLE_read_u32(const uint8_t* p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void s_DOPPLER_TABLE_read_point(const doppler_table* dt, uint16_t i, doppler_point* dp) {
+	const uint8_t* p = dt->points + (uint32_t)i * DOPPLER_TABLE_POINT_SIZE;
+
+	dp->freqoff = (int16_t)s_DOPPLER_TABLE_read_u16(p);
+	dp->elevation = (int8_t)p[2];
+	dp->rssi = (int8_t)p[3];
+}
+
+/*
+	Rounds a + (b - a) * num / den to the nearest integer,
+	where a and b are 16 bit values and 0 <= num < den <= 65535.
+	|b - a| * num + den / 2 is then below 2^32, so the product is
+	taken as an unsigned magnitude rather than overflowing int32_t.
+*/
+static int32_t s_DOPPLER_TABLE_interpolate(int32_t a, int32_t b, int32_t num, int32_t den) {
+	uint32_t delta = (uint32_t)((b >= a) ? b - a : a - b) * (uint32_t)num;
+	int32_t  step = (int32_t)((delta + (uint32_t)den / 2) / (uint32_t)den);
+
+	return (b >= a) ? a + step : a - step;
+}
+
+tcvr_error_t DOPPLER_TABLE_load(doppler_table* dt, const uint8_t* buf, uint16_t buf_len) {
+	uint16_t num_points;
+	uint16_t step;
+	uint32_t start;
+
+	if (!dt || !buf) {
+		return ERROR_NULL_POINTER;
+	}
+	if (buf_len < DOPPLER_TABLE_HEADER_SIZE) {
+		return ERROR_DOPPLER_TABLE_MALFORMED;
+	}
+
+	num_points = s_DOPPLER_TABLE_read_u16(buf);
+	step = s_DOPPLER_TABLE_read_u16(buf + 2);
+	start = s_DOPPLER_TABLE_read_u32(buf + 4);
+	if (num_points < 2 || step == 0 ||
+	    buf_len < DOPPLER_TABLE_HEADER_SIZE + (uint32_t)num_points * DOPPLER_TABLE_POINT_SIZE) {
+		return ERROR_DOPPLER_TABLE_MALFORMED;
+	}
+	// the last point's time must not wrap past the end of mission time
+	if ((uint32_t)(num_points - 1) * step > UINT32_MAX - start) {
+		return ERROR_DOPPLER_TABLE_MALFORMED;
+	}
+
+	dt->num_points = num_points;
+	dt->step = step;
+	dt->start = start;
+	dt->points = buf + DOPPLER_TABLE_HEADER_SIZE;
+	return ERROR_NONE;
+}
+
+tcvr_error_t DOPPLER_TABLE_end(const doppler_table* dt, uint32_t* end) {
+	if (!dt || !end) {
+		return ERROR_NULL_POINTER;
+	}
+
+	*end = dt->start + (uint32_t)(dt->num_points - 1) * dt->step;
+	return ERROR_NONE;
+}
+
+tcvr_error_t DOPPLER_TABLE_lookup(const doppler_table* dt, uint32_t t, doppler_point* dp) {
+	doppler_point a, b;
+	uint32_t      offset;
+	uint16_t      i;
+	int32_t       frac;
+
+	if (!dt || !dp) {
+		return ERROR_NULL_POINTER;
+	}
+	if (t < dt->start) {
+		return ERROR_DOPPLER_TABLE_TIME_OUT_OF_RANGE;
+	}
+
+	offset = t - dt->start;
+	if (offset / dt->step >= (uint32_t)(dt->num_points - 1)) {
+		// only the very last point can be looked up exactly
+		if (offset != (uint32_t)(dt->num_points - 1) * dt->step) {
+			return ERROR_DOPPLER_TABLE_TIME_OUT_OF_RANGE;
+		}
+		s_DOPPLER_TABLE_read_point(dt, dt->num_points - 1, dp);
+		return ERROR_NONE;
+	}
+
+	i = (uint16_t)(offset / dt->step);
+	frac = (int32_t)(offset % dt->step);
+
+	s_DOPPLER_TABLE_read_point(dt, i, &a);
+	s_DOPPLER_TABLE_read_point(dt, i + 1, &b);
+
+	dp->freqoff = (int16_t)s_DOPPLER_TABLE_interpolate(a.freqoff, b.freqoff, frac, dt->step);
+	dp->elevation = (int8_t)s_DOPPLER_TABLE_interpolate(a.elevation, b.elevation, frac, dt->step);
+	dp->rssi = (int8_t)s_DOPPLER_TABLE_interpolate(a.rssi, b.rssi, frac, dt->step);
+	return ERROR_NONE;
+}
+
+tcvr_error_t DOPPLER_TABLE_retune(const doppler_table* dt, uint32_t t, int transmit, uint8_t* status) {
+	tcvr_error_t  err = ERROR_NONE;
+	doppler_point dp;
+	uint16_t      word;
+	uint8_t       data[2];
+
+	err = DOPPLER_TABLE_lookup(dt, t, &dp);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	word = (uint16_t)((transmit) ? -dp.freqoff : dp.freqoff);
+
+	// FREQOFF1 holds the high byte, FREQOFF0 follows it
+	data[0] = (uint8_t)(word >> 8);
+	data[1] = (uint8_t)(word & 0xff);
+	return REGISTER_burst_write(FREQOFF1, data, 2, status);
+}
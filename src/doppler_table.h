@@ -0,0 +1,76 @@
+#ifndef _DOPPLER_TABLE_H_
+#define _DOPPLER_TABLE_H_
+
+#include <stdint.h>
+#include "error.h"
+
+/*
+	Precomputed Doppler correction for one pass, generated on the
+	ground by orbital/dtable and uplinked, so that the flight side
+	only has to interpolate between points instead of evaluating
+	the orbit.
+
+	Serialized table, all fields little-endian:
+
+		offset  size  field
+		0       2     number of points, >= 2
+		2       2     seconds between points, > 0
+		4       4     time of the first point, mission seconds
+		8       4*n   points, each:
+		                int16 FREQOFF word for RX (see below)
+		                int8  elevation, degrees
+		                int8  expected RSSI, dBm
+
+	The FREQOFF word is the correction that tunes the receiver
+	onto the Doppler shifted uplink, in units of
+	fxosc / (LO divider * 2^18) Hz. Transmitting needs the
+	opposite correction for the downlink to land on the carrier.
+*/
+#define DOPPLER_TABLE_HEADER_SIZE 8
+#define DOPPLER_TABLE_POINT_SIZE  4
+
+typedef struct doppler_table_s {
+	const uint8_t* points; // points inside the caller's buffer
+	uint16_t       num_points;
+	uint16_t       step;
+	uint32_t       start;
+} doppler_table;
+
+typedef struct doppler_point_s {
+	int16_t freqoff;
+	int8_t  elevation;
+	int8_t  rssi;
+} doppler_point;
+
+/*
+	Checks a serialized table and points dt at it. The buffer
+	is not copied, so it must outlive dt.
+	Returns ERROR_NONE if successful, ERROR_DOPPLER_TABLE_MALFORMED
+	if it is too short for its points, or its last point falls
+	after mission time 2^32 - 1.
+*/
+tcvr_error_t DOPPLER_TABLE_load(doppler_table* dt, const uint8_t* buf, uint16_t buf_len);
+
+/*
+	Outputs the time of the last point in the table.
+	Returns ERROR_NONE if successful.
+*/
+tcvr_error_t DOPPLER_TABLE_end(const doppler_table* dt, uint32_t* end);
+
+/*
+	Linearly interpolates the table at mission time t, in seconds,
+	using integer arithmetic only.
+	Returns ERROR_NONE if successful,
+	ERROR_DOPPLER_TABLE_TIME_OUT_OF_RANGE if t is outside the table.
+*/
+tcvr_error_t DOPPLER_TABLE_lookup(const doppler_table* dt, uint32_t t, doppler_point* dp);
+
+/*
+	Writes the interpolated FREQOFF word for mission time t to
+	FREQOFF1/FREQOFF0 in a single burst, and reads the chip status.
+	Negates the correction if transmit is non-zero.
+	Returns ERROR_NONE if successful.
+*/
+tcvr_error_t DOPPLER_TABLE_retune(const doppler_table* dt, uint32_t t, int transmit, uint8_t* status);
+
+#endif
@@ -13,6 +13,21 @@
 #define ERROR_STROBE         0x0500
 #define ERROR_BANG_REGISTERS 0x0600
 #define ERROR_RXTX           0x0700
+#define ERROR_DOPPLER_TABLE  0x0800
+#define ERROR_RATE_PLAN      0x0900
+#define ERROR_PACKET_RING    0x0A00
+#define ERROR_RADIO_SERVICE  0x0B00
+#define ERROR_CRC            0x0C00
+#define ERROR_FEC            0x0D00
+#define ERROR_AX25           0x0E00
+#define ERROR_TX_BATCH       0x0F00
+#define ERROR_POWER          0x1000
+#define ERROR_STATUS         0x1100
+#define ERROR_TURNAROUND     0x1200
+#define ERROR_STATS          0x1300
+#define ERROR_SURVEY         0x1400
+#define ERROR_ARQ            0x1500
+#define ERROR_COMPRESS       0x1600
 
 typedef int tcvr_error_t;
 
@@ -27,15 +42,15 @@ enum miscellaneous_error_e {
 	ERROR_BITS_??? = ERROR_BITS + 1
 };*/
 
-/* No bits errors defined yet */
-/*enum gpio_error_e {
-	ERROR_GPIO_??? = ERROR_GPIO + 1
-};*/
+enum gpio_error_e {
+	ERROR_GPIO_OPEN_FAILED = ERROR_GPIO + 1,
+	ERROR_GPIO_REQUEST_FAILED
+};
 
-/* No spi errors defined yet */
-/*enum spi_error_e {
-	ERROR_SPI_??? = ERROR_SPI + 1
-};*/
+enum spi_error_e {
+	ERROR_SPI_OPEN_FAILED = ERROR_SPI + 1,
+	ERROR_SPI_CONFIG_FAILED
+};
 
 enum strobe_error_e {
 	ERROR_STROBE_INVALID_NAME = ERROR_STROBE + 1
@@ -50,4 +65,81 @@ enum rxtx_error_e {
 	ERROR_RXTX_ENQUEUING_TO_FULL_TX_FIFO
 };
 
+enum doppler_table_error_e {
+	ERROR_DOPPLER_TABLE_MALFORMED = ERROR_DOPPLER_TABLE + 1,
+	ERROR_DOPPLER_TABLE_TIME_OUT_OF_RANGE
+};
+
+enum rate_plan_error_e {
+	ERROR_RATE_PLAN_MALFORMED = ERROR_RATE_PLAN + 1,
+	ERROR_RATE_PLAN_FINISHED,
+	ERROR_RATE_PLAN_PROFILE_UNKNOWN
+};
+
+enum packet_ring_error_e {
+	ERROR_PACKET_RING_EMPTY = ERROR_PACKET_RING + 1,
+	ERROR_PACKET_RING_FULL,
+	ERROR_PACKET_RING_FRAME_TOO_LONG
+};
+
+enum radio_service_error_e {
+	ERROR_RADIO_SERVICE_STOPPED = ERROR_RADIO_SERVICE + 1
+};
+
+enum crc_error_e {
+	ERROR_CRC_MISMATCH = ERROR_CRC + 1
+};
+
+enum fec_error_e {
+	ERROR_FEC_FRAME_TOO_LONG = ERROR_FEC + 1,
+	ERROR_FEC_UNCORRECTABLE,
+	ERROR_FEC_BAD_DEPTH
+};
+
+enum ax25_error_e {
+	ERROR_AX25_BUFFER_TOO_SMALL = ERROR_AX25 + 1
+};
+
+enum tx_batch_error_e {
+	ERROR_TX_BATCH_FULL = ERROR_TX_BATCH + 1,
+	ERROR_TX_BATCH_FRAME_TOO_LONG
+};
+
+enum power_error_e {
+	ERROR_POWER_PROFILE_UNKNOWN = ERROR_POWER + 1
+};
+
+enum status_error_e {
+	ERROR_STATUS_TIMEOUT = ERROR_STATUS + 1
+};
+
+enum turnaround_error_e {
+	ERROR_TURNAROUND_BUSY = ERROR_TURNAROUND + 1,
+	ERROR_TURNAROUND_NOTHING_SCHEDULED,
+	ERROR_TURNAROUND_CLOCK_STOPPED
+};
+
+enum stats_error_e {
+	ERROR_STATS_BUFFER_TOO_SMALL = ERROR_STATS + 1
+};
+
+enum survey_error_e {
+	ERROR_SURVEY_NO_BAND = ERROR_SURVEY + 1,
+	ERROR_SURVEY_NO_SAMPLES
+};
+
+enum arq_error_e {
+	ERROR_ARQ_WINDOW_FULL = ERROR_ARQ + 1,
+	ERROR_ARQ_PAYLOAD_TOO_LONG,
+	ERROR_ARQ_BUFFER_TOO_SMALL,
+	ERROR_ARQ_BAD_FRAME
+};
+
+enum compress_error_e {
+	ERROR_COMPRESS_BUFFER_TOO_SMALL = ERROR_COMPRESS + 1,
+	ERROR_COMPRESS_TOO_LONG,
+	ERROR_COMPRESS_CORRUPT,
+	ERROR_COMPRESS_OUT_OF_SYNC
+};
+
 #endif
@@ -7,11 +7,9 @@
 //#include "xosc.h"
 #include "freq_synth_config.h"
 
-#define FREQCONFIG_LOCK_ENABLED_MS_BIT BIT_4
-#define FREQCONFIG_LOCK_ENABLED_LS_BIT BIT_4
-
-#define FREQCONFIG_BAND_MS_BIT BIT_3
-#define FREQCONFIG_BAND_LS_BIT BIT_0
+// FS_CFG
+BITS_FIELD(FREQCONFIG_LOCK_ENABLED, 4, 4)
+BITS_FIELD(FREQCONFIG_BAND, 3, 0)
 
 /*
 	radio frequency = (VCO frequency / LO Divider) Hz
@@ -35,7 +33,7 @@ tcvr_error_t FREQCONFIG_read_band(freq_band* fb, uint8_t* status) {
 	uint8_t      data;
 
 	// read bitfield
-	err = REGISTER_read_bitfield(FS_CFG, FREQCONFIG_BAND_MS_BIT, FREQCONFIG_BAND_LS_BIT, &data, status);
+	err = REGISTER_read_field(FS_CFG, FREQCONFIG_BAND, &data, status);
 	if (err != ERROR_NONE) {
 		return err;
 	}
@@ -52,7 +50,7 @@ tcvr_error_t FREQCONFIG_read_out_of_lock_detector_enabled(int* enabled, uint8_t*
 	uint8_t      data;
 
 	// read bitfield
-	err = REGISTER_read_bitfield(FS_CFG, FREQCONFIG_LOCK_ENABLED_MS_BIT, FREQCONFIG_LOCK_ENABLED_LS_BIT, &data, status);
+	err = REGISTER_read_field(FS_CFG, FREQCONFIG_LOCK_ENABLED, &data, status);
 	if (err != ERROR_NONE) {
 		return err;
 	}
@@ -67,12 +65,12 @@ tcvr_error_t FREQCONFIG_read_out_of_lock_detector_enabled(int* enabled, uint8_t*
 tcvr_error_t FREQCONFIG_set_band(freq_band fb, uint8_t* status) {
 	uint8_t data = (uint8_t)fb;
 
-	return REGISTER_write_bitfield(FS_CFG, data, FREQCONFIG_BAND_MS_BIT, FREQCONFIG_BAND_LS_BIT, status);
+	return REGISTER_write_field(FS_CFG, FREQCONFIG_BAND, data, status);
 }
 
 tcvr_error_t FREQCONFIG_set_out_of_lock_detector_enabled(int enable, uint8_t* status) {
 	uint8_t data = (enable) ? 1 : 0;
 
-	return REGISTER_write_bitfield(FS_CFG, data, FREQCONFIG_LOCK_ENABLED_MS_BIT, FREQCONFIG_LOCK_ENABLED_LS_BIT, status);
+	return REGISTER_write_field(FS_CFG, FREQCONFIG_LOCK_ENABLED, data, status);
 }
 
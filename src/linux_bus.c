@@ -0,0 +1,347 @@
+
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+#include <linux/spi/spidev.h>
+
+#include "error.h"
+#include "gpio.h"
+#include "spi.h"
+#include "clock.h"
+#include "stats.h"
+#include "linux_bus.h"
+
+#define LINUX_BUS_CONSUMER "transceiver"
+
+static int s_LINUX_BUS_sys_open(const char* path, int flags) {
+	return open(path, flags);
+}
+
+static int s_LINUX_BUS_sys_close(int fd) {
+	return close(fd);
+}
+
+static int s_LINUX_BUS_sys_ioctl(int fd, unsigned long request, void* arg) {
+	return ioctl(fd, request, arg);
+}
+
+static const linux_bus_io s_LINUX_BUS_system = {
+	s_LINUX_BUS_sys_open,
+	s_LINUX_BUS_sys_close,
+	s_LINUX_BUS_sys_ioctl
+};
+
+static const linux_bus_io* s_LINUX_BUS_io = &s_LINUX_BUS_system;
+static int                 s_LINUX_BUS_spi_fd = -1;
+static int                 s_LINUX_BUS_chip_fd = -1;
+static int                 s_LINUX_BUS_csn_fd = -1;
+static int                 s_LINUX_BUS_ready_fd = -1;
+static uint32_t            s_LINUX_BUS_speed_hz = 0;
+static linux_bus_stats     s_LINUX_BUS_stats;
+
+static spi_status_hook     s_LINUX_BUS_status_hook = 0;
+static void*               s_LINUX_BUS_status_ctx = 0;
+
+// the transaction queued so far
+static struct spi_ioc_transfer s_LINUX_BUS_xfers[LINUX_BUS_MAX_TRANSFERS];
+static uint8_t*                s_LINUX_BUS_dest[LINUX_BUS_MAX_TRANSFERS];
+static uint32_t                s_LINUX_BUS_offset[LINUX_BUS_MAX_TRANSFERS];
+static uint8_t                 s_LINUX_BUS_tx[LINUX_BUS_BUF_SIZE];
+static uint8_t                 s_LINUX_BUS_rx[LINUX_BUS_BUF_SIZE];
+static uint32_t                s_LINUX_BUS_num_xfers = 0;
+static uint32_t                s_LINUX_BUS_used = 0;
+static int                     s_LINUX_BUS_first_byte = 0;
+static int                     s_LINUX_BUS_cs_held = 0; // spidev left CSn asserted
+
+/*
+	Sends what is queued as one message and hands out what came
+	back. Unless last, spidev keeps CSn asserted after it (that is
+	what cs_change on the final transfer of a message means), so
+	the transaction carries on in the next one.
+*/
+static void s_LINUX_BUS_flush(int last) {
+	uint32_t n = s_LINUX_BUS_num_xfers;
+	uint32_t i;
+	int      ret = -1;
+
+	if (n == 0) {
+		if (!last || !s_LINUX_BUS_cs_held) {
+			return;
+		}
+		// nothing left to send, just let go of CSn
+		memset(&s_LINUX_BUS_xfers[0], 0, sizeof(s_LINUX_BUS_xfers[0]));
+		s_LINUX_BUS_dest[0] = 0;
+		n = 1;
+	}
+	if (s_LINUX_BUS_csn_fd < 0 && !last) {
+		s_LINUX_BUS_xfers[n - 1].cs_change = 1;
+	}
+
+	if (s_LINUX_BUS_spi_fd >= 0) {
+		ret = s_LINUX_BUS_io->ioctl(s_LINUX_BUS_spi_fd, SPI_IOC_MESSAGE(n), s_LINUX_BUS_xfers);
+		s_LINUX_BUS_stats.messages++;
+		s_LINUX_BUS_stats.transfers += n;
+		if (ret < 0) {
+			s_LINUX_BUS_stats.failed++;
+		}
+	}
+	if (ret < 0) {
+		memset(s_LINUX_BUS_rx, 0xff, s_LINUX_BUS_used);
+	}
+
+	for (i = 0; i < n; i++) {
+		if (s_LINUX_BUS_dest[i]) {
+			memcpy(s_LINUX_BUS_dest[i], &s_LINUX_BUS_rx[s_LINUX_BUS_offset[i]], s_LINUX_BUS_xfers[i].len);
+		}
+	}
+	if (s_LINUX_BUS_first_byte && s_LINUX_BUS_used > 0) {
+		s_LINUX_BUS_first_byte = 0;
+		if (s_LINUX_BUS_status_hook) {
+			s_LINUX_BUS_status_hook(s_LINUX_BUS_rx[0], s_LINUX_BUS_status_ctx);
+		}
+	}
+
+	s_LINUX_BUS_cs_held = (s_LINUX_BUS_csn_fd < 0 && !last);
+	s_LINUX_BUS_num_xfers = 0;
+	s_LINUX_BUS_used = 0;
+}
+
+/*
+	Requests one line from the open gpiochip, an output starting
+	high or an input.
+	Returns the line's fd, or -1.
+*/
+static int s_LINUX_BUS_request_line(int line, int output) {
+	struct gpio_v2_line_request req;
+
+	memset(&req, 0, sizeof(req));
+	req.offsets[0] = (uint32_t)line;
+	req.num_lines = 1;
+	strncpy(req.consumer, LINUX_BUS_CONSUMER, sizeof(req.consumer) - 1);
+
+	if (output) {
+		req.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+		req.config.num_attrs = 1;
+		req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+		req.config.attrs[0].attr.values = 1;
+		req.config.attrs[0].mask = 1;
+	}
+	else {
+		req.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+	}
+
+	if (s_LINUX_BUS_io->ioctl(s_LINUX_BUS_chip_fd, GPIO_V2_GET_LINE_IOCTL, &req) < 0) {
+		return -1;
+	}
+	return req.fd;
+}
+
+static void s_LINUX_BUS_close_fd(int* fd) {
+	if (*fd >= 0) {
+		s_LINUX_BUS_io->close(*fd);
+		*fd = -1;
+	}
+}
+
+// Publicly Exported Functions
+// ===========================
+
+tcvr_error_t LINUX_BUS_open(const linux_bus_config* cfg, const linux_bus_io* io) {
+	uint8_t  mode = SPI_MODE_0;
+	uint8_t  bits = 8;
+	uint32_t speed;
+
+	if (!cfg || !cfg->spidev) {
+		return ERROR_NULL_POINTER;
+	}
+	if ((cfg->csn_line >= 0 || cfg->ready_line >= 0) && !cfg->gpiochip) {
+		return ERROR_NULL_POINTER;
+	}
+
+	LINUX_BUS_close();
+	s_LINUX_BUS_io = io ? io : &s_LINUX_BUS_system;
+	memset(&s_LINUX_BUS_stats, 0, sizeof(s_LINUX_BUS_stats));
+
+	if (cfg->csn_line >= 0) {
+		mode |= SPI_NO_CS;
+	}
+	speed = cfg->speed_hz;
+
+	s_LINUX_BUS_spi_fd = s_LINUX_BUS_io->open(cfg->spidev, O_RDWR);
+	if (s_LINUX_BUS_spi_fd < 0) {
+		return ERROR_SPI_OPEN_FAILED;
+	}
+	if (s_LINUX_BUS_io->ioctl(s_LINUX_BUS_spi_fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+	    s_LINUX_BUS_io->ioctl(s_LINUX_BUS_spi_fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+	    s_LINUX_BUS_io->ioctl(s_LINUX_BUS_spi_fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed) < 0) {
+		LINUX_BUS_close();
+		return ERROR_SPI_CONFIG_FAILED;
+	}
+	s_LINUX_BUS_speed_hz = speed;
+
+	if (cfg->csn_line < 0 && cfg->ready_line < 0) {
+		return ERROR_NONE;
+	}
+
+	s_LINUX_BUS_chip_fd = s_LINUX_BUS_io->open(cfg->gpiochip, O_RDWR);
+	if (s_LINUX_BUS_chip_fd < 0) {
+		LINUX_BUS_close();
+		return ERROR_GPIO_OPEN_FAILED;
+	}
+	if (cfg->csn_line >= 0) {
+		s_LINUX_BUS_csn_fd = s_LINUX_BUS_request_line(cfg->csn_line, 1);
+		if (s_LINUX_BUS_csn_fd < 0) {
+			LINUX_BUS_close();
+			return ERROR_GPIO_REQUEST_FAILED;
+		}
+	}
+	if (cfg->ready_line >= 0) {
+		s_LINUX_BUS_ready_fd = s_LINUX_BUS_request_line(cfg->ready_line, 0);
+		if (s_LINUX_BUS_ready_fd < 0) {
+			LINUX_BUS_close();
+			return ERROR_GPIO_REQUEST_FAILED;
+		}
+	}
+	return ERROR_NONE;
+}
+
+void LINUX_BUS_close(void) {
+	s_LINUX_BUS_close_fd(&s_LINUX_BUS_ready_fd);
+	s_LINUX_BUS_close_fd(&s_LINUX_BUS_csn_fd);
+	s_LINUX_BUS_close_fd(&s_LINUX_BUS_chip_fd);
+	s_LINUX_BUS_close_fd(&s_LINUX_BUS_spi_fd);
+
+	s_LINUX_BUS_num_xfers = 0;
+	s_LINUX_BUS_used = 0;
+	s_LINUX_BUS_cs_held = 0;
+}
+
+void LINUX_BUS_get_stats(linux_bus_stats* out) {
+	if (out) {
+		*out = s_LINUX_BUS_stats;
+	}
+}
+
+// spi.h
+// ===========================
+
+void SPI_start_transaction(void) {
+	uint64_t start;
+
+	if (s_LINUX_BUS_csn_fd >= 0) {
+		GPIO_write_SS(LOW);
+	}
+	if (s_LINUX_BUS_ready_fd >= 0) {
+		start = CLOCK_now_us();
+		while (GPIO_read_MISO() == HIGH) {
+			if (CLOCK_now_us() - start >= LINUX_BUS_READY_TIMEOUT_US) {
+				s_LINUX_BUS_stats.ready_timeouts++;
+				break;
+			}
+		}
+	}
+
+	s_LINUX_BUS_first_byte = 1;
+	STATS_add(STATS_CSN_CYCLES, 1);
+}
+
+void SPI_stop_transaction(void) {
+	s_LINUX_BUS_flush(1);
+	if (s_LINUX_BUS_csn_fd >= 0) {
+		GPIO_write_SS(HIGH);
+	}
+}
+
+void SPI_transfer_bytes(const uint8_t* out, uint8_t* in, uint32_t len) {
+	struct spi_ioc_transfer* xfer;
+	uint32_t                 chunk;
+
+	STATS_add(STATS_BYTES, len);
+
+	while (len > 0) {
+		if (s_LINUX_BUS_num_xfers == LINUX_BUS_MAX_TRANSFERS || s_LINUX_BUS_used == LINUX_BUS_BUF_SIZE) {
+			s_LINUX_BUS_flush(0);
+		}
+		chunk = LINUX_BUS_BUF_SIZE - s_LINUX_BUS_used;
+		chunk = (len < chunk) ? len : chunk;
+
+		if (out) {
+			memcpy(&s_LINUX_BUS_tx[s_LINUX_BUS_used], out, chunk);
+			out += chunk;
+		}
+		else {
+			memset(&s_LINUX_BUS_tx[s_LINUX_BUS_used], 0, chunk);
+		}
+
+		xfer = &s_LINUX_BUS_xfers[s_LINUX_BUS_num_xfers];
+		memset(xfer, 0, sizeof(*xfer));
+		xfer->tx_buf = (uintptr_t)&s_LINUX_BUS_tx[s_LINUX_BUS_used];
+		xfer->rx_buf = (uintptr_t)&s_LINUX_BUS_rx[s_LINUX_BUS_used];
+		xfer->len = chunk;
+		xfer->speed_hz = s_LINUX_BUS_speed_hz;
+		xfer->bits_per_word = 8;
+
+		s_LINUX_BUS_dest[s_LINUX_BUS_num_xfers] = in;
+		s_LINUX_BUS_offset[s_LINUX_BUS_num_xfers] = s_LINUX_BUS_used;
+		if (in) {
+			in += chunk;
+		}
+
+		s_LINUX_BUS_num_xfers++;
+		s_LINUX_BUS_used += chunk;
+		len -= chunk;
+	}
+}
+
+uint8_t SPI_transfer_byte(uint8_t byte_out) {
+	uint8_t byte_in = 0xff;
+
+	SPI_transfer_bytes(&byte_out, &byte_in, 1);
+	s_LINUX_BUS_flush(0);
+	return byte_in;
+}
+
+void SPI_set_status_hook(spi_status_hook hook, void* ctx) {
+	s_LINUX_BUS_status_hook = hook;
+	s_LINUX_BUS_status_ctx = ctx;
+}
+
+// gpio.h, master side
+// ===========================
+
+void GPIO_write_MOSI(uint8_t hiOrLo) {
+	// the SPI controller owns MOSI
+}
+
+void GPIO_write_SCLK(uint8_t hiOrLo) {
+	// and SCLK
+}
+
+void GPIO_write_SS(uint8_t hiOrLo) {
+	struct gpio_v2_line_values lv;
+
+	if (s_LINUX_BUS_csn_fd < 0) {
+		return;
+	}
+	lv.bits = hiOrLo ? 1 : 0;
+	lv.mask = 1;
+	s_LINUX_BUS_io->ioctl(s_LINUX_BUS_csn_fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &lv);
+}
+
+uint8_t GPIO_read_MISO() {
+	struct gpio_v2_line_values lv;
+
+	// without a ready line, take the chip as ready
+	if (s_LINUX_BUS_ready_fd < 0) {
+		return LOW;
+	}
+	lv.bits = 0;
+	lv.mask = 1;
+	if (s_LINUX_BUS_io->ioctl(s_LINUX_BUS_ready_fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &lv) < 0) {
+		return LOW;
+	}
+	return (lv.bits & 1) ? HIGH : LOW;
+}
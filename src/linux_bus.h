@@ -0,0 +1,75 @@
+#ifndef _LINUX_BUS_H_
+#define _LINUX_BUS_H_
+
+#include <stdint.h>
+#include "error.h"
+
+/*
+	Drives the chip from Linux through hardware SPI (spidev) and
+	the GPIO character device, in place of bit-banging. It
+	provides spi.h and the master side of gpio.h, so it links
+	instead of spi.o and gpio.o (see make linux).
+
+	SPI_transfer_bytes calls are queued and a whole transaction,
+	eg. the address byte plus a register burst or a FIFO drain,
+	goes out as one SPI_IOC_MESSAGE when it stops. Only
+	SPI_transfer_byte, whose caller needs the byte straight away,
+	sends early.
+
+	CSn is either left to spidev, or driven from a GPIO line,
+	in which case start waits for the chip to pull SO low
+	(CHIP_RDYn) on the ready line, if there is one, before
+	clocking anything. That line reads back as GPIO_read_MISO.
+
+	Every system call goes through a linux_bus_io, so the whole
+	thing runs against a fake one without hardware.
+*/
+typedef struct linux_bus_io_s {
+	int (*open)(const char* path, int flags);
+	int (*close)(int fd);
+	int (*ioctl)(int fd, unsigned long request, void* arg);
+} linux_bus_io;
+
+typedef struct linux_bus_config_s {
+	const char* spidev;      // eg. "/dev/spidev0.0"
+	uint32_t    speed_hz;
+	const char* gpiochip;    // eg. "/dev/gpiochip0", NULL for no GPIO
+	int         csn_line;    // line offsets on gpiochip, -1 for none,
+	int         ready_line;  // in which case spidev drives CSn
+} linux_bus_config;
+
+typedef struct linux_bus_stats_s {
+	uint32_t messages;       // SPI_IOC_MESSAGE calls
+	uint32_t transfers;      // transfers within them
+	uint32_t failed;         // messages the kernel refused, read back as 0xff
+	uint32_t ready_timeouts; // SO still high after LINUX_BUS_READY_TIMEOUT_US
+} linux_bus_stats;
+
+// how many transfers and bytes one message can carry before it goes out early
+#define LINUX_BUS_MAX_TRANSFERS    8
+#define LINUX_BUS_BUF_SIZE         512
+
+#define LINUX_BUS_READY_TIMEOUT_US 1000
+
+/*
+	Opens and configures spidev (mode 0, 8 bits, speed_hz) and
+	requests the GPIO lines, CSn as an output held high. io NULL
+	uses the real system calls. Closes whatever was open first.
+	Returns ERROR_NONE if successful, ERROR_SPI_OPEN_FAILED,
+	ERROR_SPI_CONFIG_FAILED, ERROR_GPIO_OPEN_FAILED or
+	ERROR_GPIO_REQUEST_FAILED.
+*/
+tcvr_error_t LINUX_BUS_open(const linux_bus_config* cfg, const linux_bus_io* io);
+
+/*
+	Closes everything. Transfers while closed read back 0xff, as
+	from a bus with nothing on it.
+*/
+void LINUX_BUS_close(void);
+
+/*
+	Outputs the counts since open.
+*/
+void LINUX_BUS_get_stats(linux_bus_stats* out);
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * FILE:    doppler.cpp
+ * PURPOSE: predict doppler shift, azimuth and elevation around an
+ *          overhead pass
+ * NOTES:   usage: doppler [-t] [seconds]
+ *          Writes one sample per second, 10 minutes by default, to the
+ *          columnar savefile.bin (see pass_file.h). -t also exports the
+ *          old fixed-width text to savefile.txt.
+ *          The maths lives in gc_doppler.cpp.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "orbit_model.h"
+#include "gc_doppler.h"
+#include "pass_file.h"
+
+using namespace std;
+
+// radians to degrees
+#define RAD_TO_DEG 180/3.14159 // deg
+#define DEG_TO_RAD 3.14159/180 // rad
+
+// the writer's block buffers are too big for the stack
+static pass_writer writer;
+
+int main (int argc, char** argv)
+{
+	bool text = false;
+	long duration = 10*60; // s
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-t") == 0) {
+			text = true;
+		} else {
+			duration = atol(argv[i]);
+		}
+	}
+	if (duration <= 0) {
+		fprintf(stderr, "usage: doppler [-t] [seconds]\n");
+		return 1;
+	}
+
+	if (pass_writer_open(&writer, "savefile.bin", 0, 1, duration) != 0) { // notice a pattern in file names?
+		fprintf(stderr, "could not create savefile.bin\n");
+		return 1;
+	}
+
+	double lat_deg = 0, long_deg = 0; // deg
+	float lat_sat = 0, long_sat = 0; // deg
+	pass_sample sample;
+
+	satellite sat = gc_satellite();
+
+	for (long t = 0; t < duration; t+=1) {
+		sat_angles(sat, t, &lat_deg, &long_deg);
+		lat_sat = lat_deg;   // deg
+		long_sat = long_deg; // deg
+
+		sample.value[PASS_LAT_SAT] = lat_sat;
+		sample.value[PASS_LONG_SAT] = long_sat;
+		sample.value[PASS_LAT_SAT_TR] = asin(sin(lat_sat*DEG_TO_RAD)) * RAD_TO_DEG;        // deg
+		sample.value[PASS_LONG_SAT_TR] = atan2(sin(long_sat*DEG_TO_RAD)*cos(lat_sat*DEG_TO_RAD),
+		                                       cos(long_sat*DEG_TO_RAD)*cos(lat_sat*DEG_TO_RAD) ) * RAD_TO_DEG; // deg
+		sample.value[PASS_AZ] = calc_azimuth(lat_sat, long_sat);      // deg
+		sample.value[PASS_EL] = calc_elevation(lat_sat, long_sat);    // deg
+		sample.value[PASS_F_DOPPLER] = calc_doppler(lat_sat, long_sat); // Hz
+
+		if (pass_writer_append(&writer, &sample) != 0) {
+			fprintf(stderr, "could not write savefile.bin\n");
+			return 1;
+		}
+	}
+
+	if (pass_writer_close(&writer) != 0) {
+		fprintf(stderr, "could not write savefile.bin\n");
+		return 1;
+	}
+
+	if (text) {
+		pass_reader reader;
+		FILE* ofp = fopen("savefile.txt", "w");
+		if (!ofp || pass_reader_open(&reader, "savefile.bin") != 0) {
+			fprintf(stderr, "could not export savefile.txt\n");
+			return 1;
+		}
+		pass_export_text(&reader, ofp);
+		pass_reader_close(&reader);
+		fclose(ofp);
+	}
+
+	return 0;
+}
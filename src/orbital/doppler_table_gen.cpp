@@ -0,0 +1,181 @@
+/*
+ * FILE:    doppler_table_gen.cpp
+ * PURPOSE: turn a predicted pass into a Doppler lookup table for the
+ *          satellite, and report how far the flight side's interpolation
+ *          strays from calc_doppler
+ * NOTES:   usage: dtable [step [outfile [pass]]]
+ *          step is the spacing of the table points in seconds (default 10),
+ *          pass picks which of the next day's passes to tabulate (default 0).
+ *          The table format is described in ../doppler_table.h; the error
+ *          report runs the driver's own interpolation code over every
+ *          second of the pass.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+
+#include "orbit_model.h"
+#include "gc_doppler.h"
+#include "pass_finder.h"
+
+extern "C" {
+#include "../xosc.h"
+#include "../doppler_table.h"
+}
+
+using namespace std;
+
+// frequency, same as gc_doppler.cpp
+#define F 437.5E6 // Hz
+// speed of light
+#define C 3E8 // m/s
+
+// crystal fitted to the board
+#define XOSC XOSC_FREQUENCY_32_MHZ
+// LO divider for FREQ_BAND_420_480
+#define LO_DIVIDER 8
+// frequency represented by one FREQOFF LSB
+#define FREQOFF_RESOLUTION ((double)XOSC/(LO_DIVIDER*262144.0)) // Hz
+
+// orbit.m uplink budget, everything except L_path:
+// P_gnd_Tx + G_gnd_PA + L_gnd_cable + G_gnd_ant + L_gnd_point + L_atm + L_ion
+// + L_polar_up + L_sat_point + G_sat_ant + L_sat_cable + G_sat_LNA
+#define UPLINK_GAIN_EXCEPT_PATH (16 + 30 - 3 + 15 - 0.5 - 1.1 - 0.4 - 3 - 10 + 2.2 - 2.5 + 0) // dB
+
+// elevation mask, same as orbit.m
+#define MIN_EL 15 // deg
+
+static double s_doppler(const satellite& sat, double t)
+{
+	double lat_sat, long_sat;
+	sat_angles(sat, t, &lat_sat, &long_sat);
+	return calc_doppler(lat_sat, long_sat); // Hz
+}
+
+static double s_elevation(const satellite& sat, const ground_station& gnd, double t)
+{
+	look_angles look;
+	calc_look(sat, gnd, t, &look);
+	return look.el; // deg
+}
+
+static double s_rssi(const satellite& sat, const ground_station& gnd, double t)
+{
+	look_angles look;
+	calc_look(sat, gnd, t, &look);
+	double L_path = 20*log10(C/F/(4*3.14159*look.range)); // dB
+	return UPLINK_GAIN_EXCEPT_PATH + L_path;               // dBm
+}
+
+static int s_clamp(double x, int lo, int hi)
+{
+	int i = (int)lround(x);
+	return (i < lo) ? lo : ((i > hi) ? hi : i);
+}
+
+static void s_put_u16(vector<uint8_t>* buf, uint16_t x)
+{
+	buf->push_back(x & 0xff);
+	buf->push_back(x >> 8);
+}
+
+static void s_put_u32(vector<uint8_t>* buf, uint32_t x)
+{
+	s_put_u16(buf, x & 0xffff);
+	s_put_u16(buf, x >> 16);
+}
+
+int main(int argc, char** argv)
+{
+	int step = (argc > 1) ? atoi(argv[1]) : 10;
+	const char* outfile = (argc > 2) ? argv[2] : "doppler_table.bin";
+	int which = (argc > 3) ? atoi(argv[3]) : 0;
+
+	if (step < 1 || step > 0xffff) {
+		fprintf(stderr, "step must be between 1 and 65535 seconds\n");
+		return 1;
+	}
+
+	ground_station gnd = gc_ground_station(MIN_EL);
+	satellite sat = gc_satellite();
+
+	pass_search search = default_pass_search();
+	search.t_end = 24*3600;
+	vector<pass> passes;
+	find_passes(&sat, 1, &gnd, 1, search, &passes);
+	if (which < 0 || which >= (int)passes.size()) {
+		fprintf(stderr, "only %u passes in the next day\n", (unsigned)passes.size());
+		return 1;
+	}
+	const pass& p = passes[which];
+
+	// whole seconds, covering the whole pass
+	uint32_t start = (uint32_t)floor(p.aos);
+	uint32_t num_points = (uint32_t)ceil((p.los - start)/step) + 1;
+	if (num_points > 0xffff) {
+		fprintf(stderr, "pass too long for step\n");
+		return 1;
+	}
+
+	vector<uint8_t> buf;
+	s_put_u16(&buf, num_points);
+	s_put_u16(&buf, step);
+	s_put_u32(&buf, start);
+	for (uint32_t i = 0; i < num_points; i++) {
+		double t = start + i*step;
+		s_put_u16(&buf, (uint16_t)s_clamp(s_doppler(sat, t)/FREQOFF_RESOLUTION, -32768, 32767));
+		buf.push_back((uint8_t)s_clamp(s_elevation(sat, gnd, t), -128, 127));
+		buf.push_back((uint8_t)s_clamp(s_rssi(sat, gnd, t), -128, 127));
+	}
+
+	FILE* ofp = fopen(outfile, "wb");
+	if (!ofp || fwrite(&buf[0], 1, buf.size(), ofp) != buf.size()) {
+		fprintf(stderr, "could not write %s\n", outfile);
+		return 1;
+	}
+	fclose(ofp);
+
+	// error report, using the flight side's interpolation
+	doppler_table dt;
+	if (DOPPLER_TABLE_load(&dt, &buf[0], (uint16_t)buf.size()) != ERROR_NONE) {
+		fprintf(stderr, "generated table does not load\n");
+		return 1;
+	}
+	uint32_t end;
+	DOPPLER_TABLE_end(&dt, &end);
+
+	double max_df = 0, sum_df2 = 0, max_quant = 0;
+	double max_del = 0, max_drssi = 0;
+	int n = 0;
+	for (uint32_t t = start; t <= end; t++) {
+		doppler_point dp;
+		DOPPLER_TABLE_lookup(&dt, t, &dp);
+
+		double f = s_doppler(sat, t);
+		double df = fabs(dp.freqoff*FREQOFF_RESOLUTION - f);
+		double quant = fabs(lround(f/FREQOFF_RESOLUTION)*FREQOFF_RESOLUTION - f);
+		double del = fabs(dp.elevation - s_elevation(sat, gnd, t));
+		double drssi = fabs(dp.rssi - s_rssi(sat, gnd, t));
+
+		max_df = (df > max_df) ? df : max_df;
+		max_quant = (quant > max_quant) ? quant : max_quant;
+		max_del = (del > max_del) ? del : max_del;
+		max_drssi = (drssi > max_drssi) ? drssi : max_drssi;
+		sum_df2 += df*df;
+		n++;
+	}
+
+	printf("pass %d: %u points every %d s from t = %u s, max el %.1f deg\n",
+	       which, num_points, step, start, p.max_el);
+	printf("table: %u bytes written to %s\n", (unsigned)buf.size(), outfile);
+	printf("FREQOFF resolution: %.2f Hz\n", FREQOFF_RESOLUTION);
+	printf("doppler error vs calc_doppler over %d s: max %.1f Hz, rms %.1f Hz (quantization alone: max %.1f Hz)\n",
+	       n, max_df, sqrt(sum_df2/n), max_quant);
+	printf("elevation error: max %.1f deg\n", max_del);
+	printf("rssi error: max %.1f dB\n", max_drssi);
+
+	return 0;
+}
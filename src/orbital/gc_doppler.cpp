@@ -12,6 +12,8 @@
  */
 
 #include <cmath>
+#include "orbit_model.h"
+#include "gc_doppler.h"
 // radians to degrees
 #define RAD_TO_DEG 180/3.14159 // deg
 #define DEG_TO_RAD 3.14159/180 // rad
@@ -170,52 +172,22 @@ float calc_azimuth(float lat_sat, float long_sat)
 	              -U_N_X_GND*uxrel - U_N_Y_GND*uyrel                   )*RAD_TO_DEG; // deg
 }
 
-#include <cstdio>
-
-int main (void)
+/*
+	RETURNS:
+		the ground station the calc_* functions are written for
+*/
+ground_station gc_ground_station(double min_el)
 {
-	FILE * ofp = fopen("savefile.txt", "w"); // notice a pattern in file names?
-	
-	char thingy = '*';
-	float lat_sat = 0, long_sat = 0; // deg
-	float lat_sat_tr = 0, long_sat_tr = 0; // deg
-	float el = 0, az = 0; // deg
-	float f_doppler = 0; // Hz
-	
-	/*
-	for (int i = -90; i < 90; i++) {
-		printf("%d %6.2f\n", i, asin(sin(i*DEG_TO_RAD))*RAD_TO_DEG);
-	}
-	*/
-	
-	for (int t = 0; t < 10*60; t+=1) {
-		lat_sat = (LAT_GND)*DEG_TO_RAD + DLATDT*(t-5*60);   // rad
-		long_sat = (LONG_GND)*DEG_TO_RAD + DLONGDT*(t-5*60); // rad
-		
-		lat_sat_tr = asin(sin(lat_sat)) * RAD_TO_DEG;                  // deg
-		long_sat_tr = atan2(sin(long_sat)*cos(lat_sat), 
-		                    cos(long_sat)*cos(lat_sat) ) * RAD_TO_DEG; // deg
-
-		lat_sat = lat_sat * RAD_TO_DEG;   // deg
-		long_sat = long_sat * RAD_TO_DEG; // deg
-		
-		el = calc_elevation(lat_sat, long_sat); // deg
-		az = calc_azimuth(lat_sat, long_sat);   // deg
+	ground_station gnd = { LAT_GND, LONG_GND, min_el };
+	return gnd;
+}
 
-		f_doppler = calc_doppler(lat_sat, long_sat); // Hz
-		
-		if (el >= 45) {
-			thingy = '*';
-		} else {
-			thingy = ' ';
-		}
-		fprintf(ofp, "%c", thingy);
-		fprintf(ofp, " %4d days %2d hours %2d minutes %2d seconds", (int) floor(t/24/3600), (int) floor(t/3600)%24, (int) floor(t/60)%60, (int) t%60);
-		fprintf(ofp, "     lat: %4.0f    long: %4.0f     lat: %4.0f    long: %4.0f     az: %4.0f    el: %4.0f", lat_sat, long_sat, lat_sat_tr, long_sat_tr, az, el);
-		fprintf(ofp, "      doppler: %6.2f kHz\n", f_doppler/1E3);
-		
-	}
-	
-	fclose(ofp);
-	return 0;
+/*
+	RETURNS:
+		the satellite main() has always followed, directly overhead
+		the ground station 5 minutes in
+*/
+satellite gc_satellite(void)
+{
+	return overhead_satellite(HEIGHT, gc_ground_station(0), 5*60);
 }
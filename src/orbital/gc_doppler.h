@@ -0,0 +1,23 @@
+/*
+ * FILE:    gc_doppler.h
+ * PURPOSE: doppler, elevation and azimuth of the polar orbiting satellite
+ *          as seen from the ground station, see gc_doppler.cpp
+ * NOTES:   The carrier frequency, altitude and ground station are fixed in
+ *          gc_doppler.cpp. Angles are unwrapped degrees, as produced by
+ *          sat_angles() in orbit_model.h.
+ */
+
+#ifndef _GC_DOPPLER_H_
+#define _GC_DOPPLER_H_
+
+#include "orbit_model.h"
+
+float calc_doppler(float lat_sat, float long_sat);
+float calc_doppler_sgn(float lat_sat, float long_sat, bool southward);
+float calc_elevation(float lat_sat, float long_sat);
+float calc_azimuth(float lat_sat, float long_sat);
+
+ground_station gc_ground_station(double min_el);
+satellite gc_satellite(void);
+
+#endif
@@ -0,0 +1,182 @@
+/*
+ * FILE:    link_budget.cpp
+ * PURPOSE: orbit.m's link budget along a pass, see link_budget.h
+ */
+
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "orbit_model.h"
+#include "pass_finder.h"
+#include "link_budget.h"
+
+using namespace std;
+
+static const double PI = 3.14159265358979;
+static const double DEG = PI/180; // rad
+
+static const double C_LIGHT = 3E8;     // m/s
+static const double K_BOLTZMANN = 1.38E-23;
+static const double R_EARTH = 6378E3;  // m
+
+// below this the cosecant law stops being meaningful
+static const double MIN_ATM_EL = 5;    // deg
+
+// CC1120 rates within reach of a 12.5 kHz to 50 kHz channel
+const double LINK_RATES[] = { 1200, 2400, 4800, 9600, 19200, 38400 };
+const int LINK_NUM_RATES = sizeof(LINK_RATES)/sizeof(LINK_RATES[0]);
+
+link_budget default_link_budget(void)
+{
+	link_budget lb;
+
+	lb.f = 437.5E6;
+	lb.BW = 12.5E3;
+	lb.T = 270;
+
+	lb.P_sat_Tx = +16;
+	lb.P_gnd_Tx = +16;
+	lb.sens_sat = -120;
+	lb.sens_gnd = -120;
+	lb.sens_rate = 2400;
+
+	lb.G_sat_PA = +16;
+	lb.G_sat_LNA = +0;
+	lb.G_gnd_PA = +30;
+	lb.G_gnd_LNA = +10;
+	lb.L_sat_cable = -2.5;
+	lb.L_gnd_cable = -3;
+	lb.G_sat_ant = +2.2;
+	lb.L_sat_point = -10;
+	lb.G_gnd_ant = +15;
+	lb.L_gnd_point = -0.5;
+	lb.L_polar_up = -3;
+	lb.L_polar_dn = -3;
+
+	lb.L_atm = -1.1;
+	lb.L_ion = -0.4;
+	lb.ref_el = 30;
+
+	lb.min_margin = 3;
+	return lb;
+}
+
+double calc_slant_range(double height, double el)
+{
+	double r_s = R_EARTH + height;
+	double alpha = 180 - asin(sin((90 + el)*DEG)*R_EARTH/r_s)/DEG - (90 + el); // deg
+	return r_s*sin(alpha*DEG)/sin((90 + el)*DEG);
+}
+
+double calc_path_loss(const link_budget& lb, double range)
+{
+	double lambda = C_LIGHT/lb.f;
+	return 20*log10(lambda/(4*PI*range));
+}
+
+double calc_atm_loss(const link_budget& lb, double el)
+{
+	el = max(el, MIN_ATM_EL);
+	return (lb.L_atm + lb.L_ion)*sin(lb.ref_el*DEG)/sin(el*DEG);
+}
+
+double calc_link_rate(const link_budget& lb, double margin)
+{
+	for (int i = LINK_NUM_RATES - 1; i >= 0; i--) {
+		// sensitivity worsens in step with the rate
+		double penalty = 10*log10(LINK_RATES[i]/lb.sens_rate);
+		if (margin - penalty >= lb.min_margin) {
+			return LINK_RATES[i];
+		}
+	}
+	return 0;
+}
+
+void calc_link(const link_budget& lb, const look_angles& look, double t, link_sample* sample)
+{
+	double L_path = calc_path_loss(lb, look.range);
+	double L_atm = calc_atm_loss(lb, look.el);
+	double P_noise = 10*log10(K_BOLTZMANN*lb.T*lb.BW) + 30; // dBm
+
+	// UPLINK
+	double P_sat_Rx_signal = lb.P_gnd_Tx + lb.G_gnd_PA + lb.L_gnd_cable + lb.G_gnd_ant + lb.L_gnd_point
+	                       + L_path + L_atm;
+	double P_sat_Rx = P_sat_Rx_signal + lb.L_polar_up + lb.L_sat_point + lb.G_sat_ant + lb.L_sat_cable + lb.G_sat_LNA;
+	// DOWNLINK
+	double P_gnd_Rx_signal = lb.P_sat_Tx + lb.G_sat_PA + lb.L_sat_cable + lb.G_sat_ant + lb.L_sat_point
+	                       + L_path + L_atm;
+	double P_gnd_Rx = P_gnd_Rx_signal + lb.L_polar_dn + lb.L_gnd_point + lb.G_gnd_ant + lb.L_gnd_cable + lb.G_gnd_LNA;
+
+	sample->t = t;
+	sample->el = look.el;
+	sample->range = look.range;
+	sample->L_path = L_path;
+	sample->L_atm = L_atm;
+	sample->P_sat_Rx = P_sat_Rx;
+	sample->P_gnd_Rx = P_gnd_Rx;
+	sample->margin_up = P_sat_Rx - lb.sens_sat;
+	sample->margin_dn = P_gnd_Rx - lb.sens_gnd;
+	// S/N as orbit.m defines it
+	sample->SNR_up = P_sat_Rx_signal - P_noise;
+	sample->SNR_dn = P_gnd_Rx_signal - P_noise;
+	sample->rate_up = calc_link_rate(lb, sample->margin_up);
+	sample->rate_dn = calc_link_rate(lb, sample->margin_dn);
+}
+
+void calc_pass_link(const link_budget& lb, const satellite& sat, const ground_station& gnd,
+                    const pass& p, double dt, pass_link* pl)
+{
+	int n = (int)floor((p.los - p.aos)/dt) + 1;
+
+	pl->p = p;
+	pl->samples.resize(n);
+	pl->min_margin_dn = HUGE_VAL;
+	pl->max_margin_dn = -HUGE_VAL;
+	pl->bits_fixed = 0;
+	pl->bits_adaptive = 0;
+
+	for (int i = 0; i < n; i++) {
+		double t = p.aos + i*dt;
+		look_angles look;
+		link_sample& s = pl->samples[i];
+
+		calc_look(sat, gnd, t, &look);
+		calc_link(lb, look, t, &s);
+
+		pl->min_margin_dn = min(pl->min_margin_dn, s.margin_dn);
+		pl->max_margin_dn = max(pl->max_margin_dn, s.margin_dn);
+		if (s.margin_dn >= lb.min_margin) {
+			pl->bits_fixed += lb.sens_rate*dt;
+		}
+		pl->bits_adaptive += s.rate_dn*dt;
+	}
+}
+
+void calc_passes_link(const link_budget& lb, const satellite* sats, const ground_station* gnds,
+                      const vector<pass>& passes, double dt, int num_threads,
+                      vector<pass_link>* pls)
+{
+	atomic<size_t> next(0);
+
+	pls->resize(passes.size());
+
+	auto worker = [&]() {
+		size_t i;
+		while ((i = next++) < passes.size()) {
+			const pass& p = passes[i];
+			calc_pass_link(lb, sats[p.sat], gnds[p.gnd], p, dt, &(*pls)[i]);
+		}
+	};
+
+	vector<thread> pool;
+	for (int i = 1; i < num_threads; i++) {
+		pool.push_back(thread(worker));
+	}
+	worker();
+	for (size_t i = 0; i < pool.size(); i++) {
+		pool[i].join();
+	}
+}
@@ -0,0 +1,156 @@
+/*
+ * FILE:    link_budget.h
+ * PURPOSE: orbit.m's link budget, evaluated sample by sample along a pass
+ * NOTES:   orbit.m computes one worst-case budget at the slant range for
+ *          delta = 30 degrees. Here the path loss comes from the actual
+ *          slant range, the atmospheric and ionospheric losses scale with
+ *          elevation (cosecant law, normalised so they equal orbit.m's
+ *          figures at ref_el), and the receiver sensitivity scales with
+ *          data rate so every sample gets the fastest rate the link closes at.
+ *
+ *          All gains and losses are in dB with orbit.m's signs: losses are
+ *          negative numbers that get added.
+ */
+
+#ifndef _LINK_BUDGET_H_
+#define _LINK_BUDGET_H_
+
+#include <vector>
+#include "orbit_model.h"
+#include "pass_finder.h"
+
+/*
+	Everything orbit.m's budget is built from.
+*/
+struct link_budget {
+	double f;            // carrier, Hz
+	double BW;           // receiver bandwidth, Hz
+	double T;            // noise temperature, K
+
+	double P_sat_Tx;     // dBm
+	double P_gnd_Tx;     // dBm
+	double sens_sat;     // dBm, at sens_rate
+	double sens_gnd;     // dBm, at sens_rate
+	double sens_rate;    // bits/s the sensitivities are quoted at
+
+	double G_sat_PA;
+	double G_sat_LNA;
+	double G_gnd_PA;
+	double G_gnd_LNA;
+	double L_sat_cable;
+	double L_gnd_cable;
+	double G_sat_ant;
+	double L_sat_point;
+	double G_gnd_ant;
+	double L_gnd_point;
+	double L_polar_up;
+	double L_polar_dn;
+
+	double L_atm;        // at ref_el
+	double L_ion;        // at ref_el
+	double ref_el;       // deg, orbit.m's delta
+
+	double min_margin;   // dB required before a rate is considered usable
+};
+
+/*
+	Link conditions at one instant.
+*/
+struct link_sample {
+	double t;            // s
+	double el;           // deg
+	double range;        // m
+	double L_path;       // dB
+	double L_atm;        // dB, atmosphere plus ionosphere
+	double P_sat_Rx;     // dBm
+	double P_gnd_Rx;     // dBm
+	double margin_up;    // dB, at sens_rate
+	double margin_dn;    // dB, at sens_rate
+	double SNR_up;       // dB
+	double SNR_dn;       // dB
+	double rate_up;      // bits/s, fastest usable rate, 0 if none
+	double rate_dn;      // bits/s, fastest usable rate, 0 if none
+};
+
+/*
+	Link conditions over a whole pass.
+*/
+struct pass_link {
+	pass                     p;
+	std::vector<link_sample> samples;
+	double                   min_margin_dn;  // dB
+	double                   max_margin_dn;  // dB
+	double                   bits_fixed;     // downlink bits at sens_rate, where the link closes
+	double                   bits_adaptive;  // downlink bits at each sample's rate_dn
+};
+
+/*
+	Data rates to choose from, bits/s, slowest first.
+*/
+extern const double LINK_RATES[];
+extern const int LINK_NUM_RATES;
+
+/*
+	RETURNS:
+		the budget in orbit.m
+	NOTE: orbit.m adds L_gnd_cable twice on the uplink; this uses
+		L_sat_cable on the satellite side instead.
+*/
+link_budget default_link_budget(void);
+
+/*
+	PARAMETERS:
+		height: orbital altitude, m
+		el: elevation, deg
+	RETURNS:
+		slant range in metres, as orbit.m's slant calc
+*/
+double calc_slant_range(double height, double el);
+
+/*
+	RETURNS:
+		free space path loss in dB (negative) for the slant range in metres
+*/
+double calc_path_loss(const link_budget& lb, double range);
+
+/*
+	RETURNS:
+		atmospheric plus ionospheric loss in dB (negative) at elevation el
+*/
+double calc_atm_loss(const link_budget& lb, double el);
+
+/*
+	RETURNS:
+		fastest rate in LINK_RATES with at least lb.min_margin of margin,
+		given the margin at lb.sens_rate, or 0 if none
+*/
+double calc_link_rate(const link_budget& lb, double margin);
+
+/*
+	Evaluates the budget for one look at the satellite.
+*/
+void calc_link(const link_budget& lb, const look_angles& look, double t, link_sample* sample);
+
+/*
+	PARAMETERS:
+		lb: link budget
+		sat, gnd: the satellite and ground station the pass is between
+		p: the pass
+		dt: time between samples, s
+		pl: output
+*/
+void calc_pass_link(const link_budget& lb, const satellite& sat, const ground_station& gnd,
+                    const pass& p, double dt, pass_link* pl);
+
+/*
+	Batch form of calc_pass_link, spread over num_threads threads.
+	PARAMETERS:
+		sats, gnds: arrays the passes index into
+		passes: passes to evaluate, e.g. from find_passes
+		pls: output, one per pass, same order
+*/
+void calc_passes_link(const link_budget& lb, const satellite* sats, const ground_station* gnds,
+                      const std::vector<pass>& passes, double dt, int num_threads,
+                      std::vector<pass_link>* pls);
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * FILE:    link_predict.cpp
+ * PURPOSE: link budget for every pass over the ground station
+ * NOTES:   usage: link [days [threads]]
+ *          Prints orbit.m's worst-case budget, then for every pass the
+ *          downlink margin range and the data volume at orbit.m's fixed
+ *          2400 b/s against the fastest rate each second supports.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "orbit_model.h"
+#include "gc_doppler.h"
+#include "pass_finder.h"
+#include "link_budget.h"
+
+using namespace std;
+
+// orbital altitude, same as gc_doppler.cpp
+#define HEIGHT 800E3 // m
+
+int main(int argc, char** argv)
+{
+	link_budget lb = default_link_budget();
+	pass_search search = default_pass_search();
+	ground_station gnd = gc_ground_station(15);
+	satellite sat = gc_satellite();
+
+	if (argc > 1) {
+		search.t_end = atof(argv[1])*24*3600;
+	}
+	if (argc > 2) {
+		search.num_threads = atoi(argv[2]);
+	}
+
+	// worst case, as orbit.m
+	look_angles worst = { 0, lb.ref_el, calc_slant_range(HEIGHT, lb.ref_el), 0 };
+	link_sample ws;
+	calc_link(lb, worst, 0, &ws);
+	printf("worst case at %.0f degrees: slant %.0f km, L_path %+.2f dB, margin_dn %+.2f dB, margin_up %+.2f dB, SNR_dn %+.2f dB\n",
+	       lb.ref_el, ws.range/1E3, ws.L_path, ws.margin_dn, ws.margin_up, ws.SNR_dn);
+
+	vector<pass> passes;
+	vector<pass_link> pls;
+	find_passes(&sat, 1, &gnd, 1, search, &passes);
+	calc_passes_link(lb, &sat, &gnd, passes, 1, search.num_threads, &pls);
+
+	double total_fixed = 0, total_adaptive = 0;
+	for (size_t i = 0; i < pls.size(); i++) {
+		const pass_link& pl = pls[i];
+		printf("t = %8.0f s   max el: %4.1f   margin_dn: %+6.2f to %+6.2f dB   fixed: %7.0f b   adaptive: %8.0f b\n",
+		       pl.p.aos, pl.p.max_el, pl.min_margin_dn, pl.max_margin_dn, pl.bits_fixed, pl.bits_adaptive);
+		total_fixed += pl.bits_fixed;
+		total_adaptive += pl.bits_adaptive;
+	}
+	printf("%u passes: %.0f bits at %.0f b/s, %.0f bits adaptive (x%.2f)\n",
+	       (unsigned)pls.size(), total_fixed, lb.sens_rate, total_adaptive,
+	       (total_fixed > 0) ? total_adaptive/total_fixed : 0);
+
+	return 0;
+}
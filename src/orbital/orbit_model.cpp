@@ -0,0 +1,117 @@
+/*
+ * FILE:    orbit_model.cpp
+ * PURPOSE: parameterised circular polar orbit, see orbit_model.h
+ * NOTES:   Constants match gc_doppler.cpp. Everything is done in double so
+ *          that searches days to weeks past the epoch keep sub-second timing.
+ */
+
+#include <cmath>
+#include <algorithm>
+#include "orbit_model.h"
+
+using namespace std;
+
+static const double PI = 3.14159265358979;
+static const double DEG = PI/180; // rad
+
+// constants, same as gc_doppler.cpp
+static const double C_LIGHT = 3E8;                         // m/s
+static const double GRAVITATIONAL_CONSTANT = 6.67384E-11;  // m^3.kg^-1.s^-2
+static const double M_EARTH = 5.97219E24;                  // kg
+static const double R_EARTH = 6378E3;                      // m
+static const double DLONGDT = 2*PI/(24*3600);              // rad/s
+
+/*
+	angular rate of the satellite along its orbit, rad/s
+*/
+static double s_dlatdt(const satellite& sat)
+{
+	double r_sat = R_EARTH + sat.height;
+	return sqrt(GRAVITATIONAL_CONSTANT*M_EARTH/(r_sat*r_sat*r_sat));
+}
+
+void sat_angles(const satellite& sat, double t, double* lat_sat, double* long_sat)
+{
+	*lat_sat = sat.lat0 + s_dlatdt(sat)*t/DEG;  // deg
+	*long_sat = sat.long0 + DLONGDT*t/DEG;      // deg
+}
+
+satellite overhead_satellite(double height, const ground_station& gnd, double t)
+{
+	satellite sat = { height, 0, 0 };
+	sat.lat0 = gnd.lat_gnd - s_dlatdt(sat)*t/DEG; // deg
+	sat.long0 = gnd.long_gnd - DLONGDT*t/DEG;     // deg
+	return sat;
+}
+
+/*
+	asin of a dot product of unit vectors, which rounding can push just past 1
+*/
+static double s_asin_clamped(double x)
+{
+	return asin(max(-1.0, min(1.0, x)));
+}
+
+/*
+	Relative position of the satellite from the ground station, plus
+	the unit up vector at the ground station.
+*/
+static void s_relative_position(const satellite& sat, const ground_station& gnd, double t,
+                                double rel[3], double up[3])
+{
+	double r_sat = R_EARTH + sat.height;
+	double theta = sat.lat0*DEG + s_dlatdt(sat)*t; // rad
+	double phi = sat.long0*DEG + DLONGDT*t;        // rad
+
+	up[0] = cos(gnd.long_gnd*DEG)*cos(gnd.lat_gnd*DEG);
+	up[1] = sin(gnd.long_gnd*DEG)*cos(gnd.lat_gnd*DEG);
+	up[2] = sin(gnd.lat_gnd*DEG);
+
+	rel[0] = r_sat*cos(phi)*cos(theta) - R_EARTH*up[0];
+	rel[1] = r_sat*sin(phi)*cos(theta) - R_EARTH*up[1];
+	rel[2] = r_sat*sin(theta)          - R_EARTH*up[2];
+}
+
+double calc_look_elevation(const satellite& sat, const ground_station& gnd, double t)
+{
+	double rel[3], up[3];
+	s_relative_position(sat, gnd, t, rel, up);
+
+	double range = sqrt(rel[0]*rel[0] + rel[1]*rel[1] + rel[2]*rel[2]);
+	return s_asin_clamped((up[0]*rel[0] + up[1]*rel[1] + up[2]*rel[2])/range)/DEG; // deg
+}
+
+void calc_look(const satellite& sat, const ground_station& gnd, double t, look_angles* look)
+{
+	double rel[3], up[3];
+	s_relative_position(sat, gnd, t, rel, up);
+
+	double r_sat = R_EARTH + sat.height;
+	double dlatdt = s_dlatdt(sat);
+	double theta = sat.lat0*DEG + dlatdt*t; // rad
+	double phi = sat.long0*DEG + DLONGDT*t; // rad
+
+	// unit north and east vectors
+	double north[3] = { -cos(gnd.long_gnd*DEG)*sin(gnd.lat_gnd*DEG),
+	                    -sin(gnd.long_gnd*DEG)*sin(gnd.lat_gnd*DEG),
+	                     cos(gnd.lat_gnd*DEG) };
+	double east[3]  = { -sin(gnd.long_gnd*DEG), cos(gnd.long_gnd*DEG), 0 };
+
+	// satellite velocity
+	double v[3] = { r_sat*(-DLONGDT*sin(phi)*cos(theta) - dlatdt*cos(phi)*sin(theta)),
+	                r_sat*( DLONGDT*cos(phi)*cos(theta) - dlatdt*sin(phi)*sin(theta)),
+	                r_sat*( dlatdt*cos(theta)) };
+
+	double range = sqrt(rel[0]*rel[0] + rel[1]*rel[1] + rel[2]*rel[2]);
+
+	look->range = range;
+	look->range_rate = (rel[0]*v[0] + rel[1]*v[1] + rel[2]*v[2])/range;
+	look->el = s_asin_clamped((up[0]*rel[0] + up[1]*rel[1] + up[2]*rel[2])/range)/DEG;
+	look->az = atan2(east[0]*rel[0] + east[1]*rel[1],
+	                 north[0]*rel[0] + north[1]*rel[1] + north[2]*rel[2])/DEG;
+}
+
+double calc_look_doppler(double range_rate, double f)
+{
+	return C_LIGHT/(C_LIGHT + range_rate)*f - f;
+}
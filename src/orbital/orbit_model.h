@@ -0,0 +1,99 @@
+/*
+ * FILE:    orbit_model.h
+ * PURPOSE: parameterised form of the circular polar orbit used by gc_doppler.cpp
+ * NOTES:   gc_doppler.cpp bakes one satellite and one ground station into
+ *          macros. This model takes both as arguments so that many satellites
+ *          and many ground stations can be evaluated side by side.
+ *
+ *          The orbit is the same one gc_doppler.cpp assumes: the satellite
+ *          advances along its polar orbit at DLATDT and the orbital plane
+ *          turns at DLONGDT. Angles are left unwrapped, exactly like the
+ *          lat_sat/long_sat values main() feeds into calc_doppler, so
+ *          sat_angles() output can be passed straight to the calc_* functions.
+ */
+
+#ifndef _ORBIT_MODEL_H_
+#define _ORBIT_MODEL_H_
+
+/*
+	Ground station, degrees.
+	min_el is the elevation mask below which there is no contact.
+*/
+struct ground_station {
+	double lat_gnd;  // deg
+	double long_gnd; // deg
+	double min_el;   // deg
+};
+
+/*
+	Satellite on a circular polar orbit.
+	lat0 and long0 are the (unwrapped) angles at t = 0.
+*/
+struct satellite {
+	double height; // m
+	double lat0;   // deg
+	double long0;  // deg
+};
+
+/*
+	Geometry of a satellite as seen from a ground station.
+*/
+struct look_angles {
+	double az;         // deg
+	double el;         // deg
+	double range;      // m
+	double range_rate; // m/s, positive when receding
+};
+
+/*
+	PARAMETERS:
+		sat: satellite
+		t: time in seconds since the satellite's epoch
+		lat_sat, long_sat: output, unwrapped angles in degrees
+	NOTE: output is in the same form as the lat_sat/long_sat
+		passed to calc_doppler and friends in gc_doppler.cpp.
+*/
+void sat_angles(const satellite& sat, double t, double* lat_sat, double* long_sat);
+
+/*
+	PARAMETERS:
+		height: orbital altitude in metres
+		gnd: ground station
+		t: time in seconds
+	RETURNS:
+		satellite that passes directly over gnd, northward bound, at time t
+	NOTE: overhead_satellite(HEIGHT, gnd, 5*60) is the orbit gc_doppler.cpp's
+		main() steps through.
+*/
+satellite overhead_satellite(double height, const ground_station& gnd, double t);
+
+/*
+	PARAMETERS:
+		sat: satellite
+		gnd: ground station
+		t: time in seconds since the satellite's epoch
+	RETURNS:
+		elevation in degrees
+	NOTE: cheaper than calc_look, used by the pass finder's root search.
+*/
+double calc_look_elevation(const satellite& sat, const ground_station& gnd, double t);
+
+/*
+	PARAMETERS:
+		sat: satellite
+		gnd: ground station
+		t: time in seconds since the satellite's epoch
+		look: output, azimuth, elevation, range and range rate
+*/
+void calc_look(const satellite& sat, const ground_station& gnd, double t, look_angles* look);
+
+/*
+	PARAMETERS:
+		range_rate: m/s, positive when receding
+		f: carrier frequency in hertz
+	RETURNS:
+		doppler shift in hertz
+*/
+double calc_look_doppler(double range_rate, double f);
+
+#endif
@@ -0,0 +1,255 @@
+/*
+ * FILE:    pass_file.cpp
+ * PURPOSE: compact columnar binary file for pass predictions, see pass_file.h
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "pass_file.h"
+
+using namespace std;
+
+static const char PASS_FILE_MAGIC[8] = { 'T', 'C', 'V', 'R', 'P', 'A', 'S', 'S' };
+
+static void s_put_le32(uint8_t* p, uint32_t x)
+{
+	p[0] = x & 0xff;
+	p[1] = (x >> 8) & 0xff;
+	p[2] = (x >> 16) & 0xff;
+	p[3] = (x >> 24) & 0xff;
+}
+
+static void s_put_le64(uint8_t* p, uint64_t x)
+{
+	s_put_le32(p, (uint32_t)(x & 0xffffffff));
+	s_put_le32(p + 4, (uint32_t)(x >> 32));
+}
+
+static uint32_t s_get_le32(const uint8_t* p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t s_get_le64(const uint8_t* p)
+{
+	return (uint64_t)s_get_le32(p) | ((uint64_t)s_get_le32(p + 4) << 32);
+}
+
+static uint64_t s_double_bits(double x)
+{
+	uint64_t bits;
+	memcpy(&bits, &x, sizeof(bits));
+	return bits;
+}
+
+static double s_bits_double(uint64_t bits)
+{
+	double x;
+	memcpy(&x, &bits, sizeof(x));
+	return x;
+}
+
+static bool s_host_is_little_endian(void)
+{
+	uint32_t one = 1;
+	uint8_t first;
+	memcpy(&first, &one, 1);
+	return first == 1;
+}
+
+static long s_column_offset(uint64_t capacity, int column, uint64_t sample)
+{
+	return (long)(PASS_FILE_HEADER_SIZE + 4*(column*capacity + sample));
+}
+
+static int s_write_header(pass_writer* pw)
+{
+	uint8_t header[PASS_FILE_HEADER_SIZE];
+
+	memset(header, 0, sizeof(header));
+	memcpy(header, PASS_FILE_MAGIC, sizeof(PASS_FILE_MAGIC));
+	s_put_le32(header + 8, PASS_FILE_VERSION);
+	s_put_le32(header + 12, PASS_NUM_COLUMNS);
+	s_put_le64(header + 16, pw->num_samples);
+	s_put_le64(header + 24, pw->capacity);
+	s_put_le64(header + 32, s_double_bits(pw->t0));
+	s_put_le64(header + 40, s_double_bits(pw->dt));
+
+	if (fseek(pw->ofp, 0, SEEK_SET) != 0 ||
+	    fwrite(header, 1, sizeof(header), pw->ofp) != sizeof(header)) {
+		return -1;
+	}
+	return 0;
+}
+
+/*
+	Writes the buffered block of every column to its place in the file.
+*/
+static int s_flush(pass_writer* pw)
+{
+	uint8_t  bytes[4*PASS_WRITER_BLOCK];
+	uint64_t first = pw->num_samples - pw->buffered;
+
+	if (pw->buffered == 0) {
+		return 0;
+	}
+
+	for (int c = 0; c < PASS_NUM_COLUMNS; c++) {
+		for (int i = 0; i < pw->buffered; i++) {
+			uint32_t bits;
+			memcpy(&bits, &pw->block[c][i], sizeof(bits));
+			s_put_le32(bytes + 4*i, bits);
+		}
+		if (fseek(pw->ofp, s_column_offset(pw->capacity, c, first), SEEK_SET) != 0 ||
+		    fwrite(bytes, 4, pw->buffered, pw->ofp) != (size_t)pw->buffered) {
+			return -1;
+		}
+	}
+
+	pw->buffered = 0;
+	return 0;
+}
+
+int pass_writer_open(pass_writer* pw, const char* path, double t0, double dt, uint64_t capacity)
+{
+	if (!pw || !path) {
+		return -1;
+	}
+
+	pw->ofp = fopen(path, "wb");
+	if (!pw->ofp) {
+		return -1;
+	}
+	// keep every column 64 byte aligned
+	pw->capacity = (capacity + 15) & ~(uint64_t)15;
+	pw->num_samples = 0;
+	pw->t0 = t0;
+	pw->dt = dt;
+	pw->buffered = 0;
+
+	// reserve the whole file up front, so the columns can be filled in any order
+	if (s_write_header(pw) != 0 ||
+	    fseek(pw->ofp, s_column_offset(pw->capacity, PASS_NUM_COLUMNS, 0) - 1, SEEK_SET) != 0 ||
+	    fputc(0, pw->ofp) == EOF) {
+		fclose(pw->ofp);
+		pw->ofp = NULL;
+		return -1;
+	}
+	return 0;
+}
+
+int pass_writer_append(pass_writer* pw, const pass_sample* sample)
+{
+	if (!pw || !pw->ofp || !sample || pw->num_samples >= pw->capacity) {
+		return -1;
+	}
+
+	for (int c = 0; c < PASS_NUM_COLUMNS; c++) {
+		pw->block[c][pw->buffered] = sample->value[c];
+	}
+	pw->buffered++;
+	pw->num_samples++;
+
+	if (pw->buffered == PASS_WRITER_BLOCK) {
+		return s_flush(pw);
+	}
+	return 0;
+}
+
+int pass_writer_close(pass_writer* pw)
+{
+	int err = 0;
+
+	if (!pw || !pw->ofp) {
+		return -1;
+	}
+
+	if (s_flush(pw) != 0 || s_write_header(pw) != 0) {
+		err = -1;
+	}
+	if (fclose(pw->ofp) != 0) {
+		err = -1;
+	}
+	pw->ofp = NULL;
+	return err;
+}
+
+int pass_reader_open(pass_reader* pr, const char* path)
+{
+	struct stat st;
+
+	if (!pr || !path || !s_host_is_little_endian()) {
+		return -1;
+	}
+	pr->map = NULL;
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return -1;
+	}
+	if (fstat(fd, &st) != 0 || st.st_size < PASS_FILE_HEADER_SIZE) {
+		close(fd);
+		return -1;
+	}
+
+	void* map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		return -1;
+	}
+
+	const uint8_t* header = (const uint8_t*)map;
+	uint64_t num_samples = s_get_le64(header + 16);
+	uint64_t capacity = s_get_le64(header + 24);
+
+	if (memcmp(header, PASS_FILE_MAGIC, sizeof(PASS_FILE_MAGIC)) != 0 ||
+	    s_get_le32(header + 8) != PASS_FILE_VERSION ||
+	    s_get_le32(header + 12) != PASS_NUM_COLUMNS ||
+	    num_samples > capacity ||
+	    (uint64_t)st.st_size < (uint64_t)s_column_offset(capacity, PASS_NUM_COLUMNS, 0)) {
+		munmap(map, st.st_size);
+		return -1;
+	}
+
+	pr->map = map;
+	pr->map_len = st.st_size;
+	pr->num_samples = num_samples;
+	pr->t0 = s_bits_double(s_get_le64(header + 32));
+	pr->dt = s_bits_double(s_get_le64(header + 40));
+	for (int c = 0; c < PASS_NUM_COLUMNS; c++) {
+		pr->column[c] = (const float*)(header + s_column_offset(capacity, c, 0));
+	}
+	return 0;
+}
+
+void pass_reader_close(pass_reader* pr)
+{
+	if (pr && pr->map) {
+		munmap(pr->map, pr->map_len);
+		pr->map = NULL;
+	}
+}
+
+void pass_export_text(const pass_reader* pr, FILE* ofp)
+{
+	for (uint64_t i = 0; i < pr->num_samples; i++) {
+		int t = (int)floor(pr->t0 + i*pr->dt);
+		float el = pr->column[PASS_EL][i];
+
+		fprintf(ofp, "%c", (el >= 45) ? '*' : ' ');
+		fprintf(ofp, " %4d days %2d hours %2d minutes %2d seconds", t/24/3600, (t/3600)%24, (t/60)%60, t%60);
+		fprintf(ofp, "     lat: %4.0f    long: %4.0f     lat: %4.0f    long: %4.0f     az: %4.0f    el: %4.0f",
+		        pr->column[PASS_LAT_SAT][i], pr->column[PASS_LONG_SAT][i],
+		        pr->column[PASS_LAT_SAT_TR][i], pr->column[PASS_LONG_SAT_TR][i],
+		        pr->column[PASS_AZ][i], el);
+		fprintf(ofp, "      doppler: %6.2f kHz\n", pr->column[PASS_F_DOPPLER][i]/1E3);
+	}
+}
@@ -0,0 +1,125 @@
+/*
+ * FILE:    pass_file.h
+ * PURPOSE: compact columnar binary file for pass predictions
+ * NOTES:   Replaces the fixed-width text savefile.txt as the primary
+ *          output. The file is a 64 byte header followed by one array per
+ *          column, all little-endian, so a month of predictions can be
+ *          mmap'd and scanned without parsing:
+ *
+ *          offset  size  field
+ *          0       8     magic, "TCVRPASS"
+ *          8       4     version, PASS_FILE_VERSION
+ *          12      4     number of columns, PASS_NUM_COLUMNS
+ *          16      8     number of samples written
+ *          24      8     capacity, samples reserved per column
+ *          32      8     time of sample 0, s (double)
+ *          40      8     time between samples, s (double)
+ *          48      16    reserved, zero
+ *          64            column c: capacity float32 values at
+ *                        64 + 4*c*capacity
+ *
+ *          capacity is a multiple of 16, so every column starts on a
+ *          64 byte boundary.
+ */
+
+#ifndef _PASS_FILE_H_
+#define _PASS_FILE_H_
+
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+#define PASS_FILE_VERSION     1
+#define PASS_FILE_HEADER_SIZE 64
+
+/*
+	Columns, in file order.
+*/
+enum pass_column {
+	PASS_LAT_SAT = 0,  // deg, unwrapped
+	PASS_LONG_SAT,     // deg, unwrapped
+	PASS_LAT_SAT_TR,   // deg, traditional latitude
+	PASS_LONG_SAT_TR,  // deg, traditional longitude
+	PASS_AZ,           // deg
+	PASS_EL,           // deg
+	PASS_F_DOPPLER,    // Hz
+	PASS_NUM_COLUMNS
+};
+
+/*
+	One row, indexed by pass_column.
+*/
+struct pass_sample {
+	float value[PASS_NUM_COLUMNS];
+};
+
+// samples buffered per column before they are written out
+#define PASS_WRITER_BLOCK 4096
+
+/*
+	Streaming writer. Memory use is fixed by PASS_WRITER_BLOCK,
+	no matter how long the prediction is.
+*/
+struct pass_writer {
+	FILE*    ofp;
+	uint64_t capacity;
+	uint64_t num_samples;
+	double   t0;
+	double   dt;
+	int      buffered;
+	float    block[PASS_NUM_COLUMNS][PASS_WRITER_BLOCK];
+};
+
+/*
+	Read-only view of an mmap'd pass file.
+*/
+struct pass_reader {
+	void*        map;
+	size_t       map_len;
+	uint64_t     num_samples;
+	double       t0;
+	double       dt;
+	const float* column[PASS_NUM_COLUMNS];
+};
+
+/*
+	PARAMETERS:
+		pw: writer
+		path: file to create
+		t0, dt: time of the first sample and time between samples, s
+		capacity: most samples that will be appended
+	RETURNS:
+		0 if successful, -1 otherwise
+*/
+int pass_writer_open(pass_writer* pw, const char* path, double t0, double dt, uint64_t capacity);
+
+/*
+	Appends one sample.
+	RETURNS:
+		0 if successful, -1 if capacity is reached or writing failed
+*/
+int pass_writer_append(pass_writer* pw, const pass_sample* sample);
+
+/*
+	Writes out buffered samples, records the sample count and closes the file.
+	RETURNS:
+		0 if successful, -1 otherwise
+*/
+int pass_writer_close(pass_writer* pw);
+
+/*
+	Maps a pass file and checks its header.
+	RETURNS:
+		0 if successful, -1 otherwise
+	NOTE: columns are used in place, so this needs a little-endian host.
+*/
+int pass_reader_open(pass_reader* pr, const char* path);
+void pass_reader_close(pass_reader* pr);
+
+/*
+	Writes the samples as the fixed-width text gc_doppler.cpp used to
+	produce in savefile.txt.
+*/
+void pass_export_text(const pass_reader* pr, FILE* ofp);
+
+#endif
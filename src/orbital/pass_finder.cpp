@@ -0,0 +1,317 @@
+/*
+ * FILE:    pass_finder.cpp
+ * PURPOSE: search long horizons for satellite passes, see pass_finder.h
+ */
+
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "orbit_model.h"
+#include "pass_finder.h"
+
+using namespace std;
+
+// golden ratio conjugate
+static const double GOLDEN = 0.6180339887498949;
+
+/*
+	A unit of work for the thread pool.
+*/
+struct pass_task {
+	int    sat;
+	int    gnd;
+	double t_begin; // chunk start, s
+	double t_end;   // chunk end, s
+};
+
+/*
+	Elevation above the mask; a pass is wherever this is >= 0.
+*/
+static double s_mask_el(const satellite& sat, const ground_station& gnd, double t)
+{
+	return calc_look_elevation(sat, gnd, t) - gnd.min_el;
+}
+
+/*
+	Brent's method for the mask crossing in [a, b].
+	Requires fa and fb to have opposite signs (or one of them zero).
+*/
+static double s_find_crossing(const satellite& sat, const ground_station& gnd,
+                              double a, double fa, double b, double fb, double tol)
+{
+	double c = a, fc = fa;
+	double d = b - a, e = d;
+
+	for (int i = 0; i < 100; i++) {
+		if ((fb > 0 && fc > 0) || (fb < 0 && fc < 0)) {
+			c = a; fc = fa;
+			d = b - a; e = d;
+		}
+		if (fabs(fc) < fabs(fb)) {
+			a = b; b = c; c = a;
+			fa = fb; fb = fc; fc = fa;
+		}
+
+		double tol1 = 0.5*tol;
+		double xm = 0.5*(c - b);
+		if (fabs(xm) <= tol1 || fb == 0) {
+			return b;
+		}
+
+		if (fabs(e) >= tol1 && fabs(fa) > fabs(fb)) {
+			// attempt inverse quadratic interpolation
+			double p, q, r;
+			double s = fb/fa;
+			if (a == c) {
+				p = 2*xm*s;
+				q = 1 - s;
+			} else {
+				q = fa/fc;
+				r = fb/fc;
+				p = s*(2*xm*q*(q - r) - (b - a)*(r - 1));
+				q = (q - 1)*(r - 1)*(s - 1);
+			}
+			if (p > 0) {
+				q = -q;
+			}
+			p = fabs(p);
+			if (2*p < min(3*xm*q - fabs(tol1*q), fabs(e*q))) {
+				e = d;
+				d = p/q;
+			} else {
+				// interpolation failed, bisect
+				d = xm;
+				e = d;
+			}
+		} else {
+			// bounds decreasing too slowly, bisect
+			d = xm;
+			e = d;
+		}
+
+		a = b;
+		fa = fb;
+		b += (fabs(d) > tol1) ? d : ((xm > 0) ? tol1 : -tol1);
+		fb = s_mask_el(sat, gnd, b);
+	}
+
+	return b;
+}
+
+/*
+	Golden-section search for the highest elevation in [a, b].
+*/
+static double s_find_peak(const satellite& sat, const ground_station& gnd,
+                          double a, double b, double tol, double* f_peak)
+{
+	double x1 = b - GOLDEN*(b - a);
+	double x2 = a + GOLDEN*(b - a);
+	double f1 = s_mask_el(sat, gnd, x1);
+	double f2 = s_mask_el(sat, gnd, x2);
+
+	while (b - a > tol) {
+		if (f1 < f2) {
+			a = x1;
+			x1 = x2; f1 = f2;
+			x2 = a + GOLDEN*(b - a);
+			f2 = s_mask_el(sat, gnd, x2);
+		} else {
+			b = x2;
+			x2 = x1; f2 = f1;
+			x1 = b - GOLDEN*(b - a);
+			f1 = s_mask_el(sat, gnd, x1);
+		}
+	}
+
+	if (f1 > f2) {
+		*f_peak = f1;
+		return x1;
+	}
+	*f_peak = f2;
+	return x2;
+}
+
+/*
+	Fills in tca and max_el for a pass whose best coarse sample was t_best.
+*/
+static void s_refine_peak(const satellite& sat, const ground_station& gnd,
+                          double t_best, const pass_search& search, pass* p)
+{
+	double a = max(p->aos, t_best - search.step);
+	double b = min(p->los, t_best + search.step);
+	double f_peak;
+
+	p->tca = s_find_peak(sat, gnd, a, b, search.tolerance, &f_peak);
+	p->max_el = f_peak + gnd.min_el;
+}
+
+/*
+	Scans one chunk, appending the passes whose aos lies in it.
+	A pass that is still open at the end of the chunk is followed
+	past it, up to the end of the search.
+*/
+static void s_scan_chunk(const satellite* sats, const ground_station* gnds,
+                         const pass_task& task, const pass_search& search,
+                         vector<pass>* found)
+{
+	const satellite& sat = sats[task.sat];
+	const ground_station& gnd = gnds[task.gnd];
+
+	pass   p;
+	bool   in_pass = false;
+	double t0 = task.t_begin;
+	double f0 = s_mask_el(sat, gnd, t0);
+	double f_prev = (t0 > search.t_start) ? s_mask_el(sat, gnd, max(search.t_start, t0 - search.step)) : f0;
+	double t_best = t0, f_best = f0;
+
+	p.sat = task.sat;
+	p.gnd = task.gnd;
+
+	if (f0 >= 0) {
+		if (t0 > search.t_start) {
+			// the chunk before this one owns the pass in progress,
+			// skip to its end
+			while (f0 >= 0 && t0 < task.t_end) {
+				f_prev = f0;
+				t0 = min(t0 + search.step, search.t_end);
+				f0 = s_mask_el(sat, gnd, t0);
+			}
+		} else {
+			in_pass = true;
+			p.aos = t0;
+		}
+	}
+
+	while ((t0 < task.t_end || in_pass) && t0 < search.t_end) {
+		double t1 = min(t0 + search.step, search.t_end);
+		double f1 = s_mask_el(sat, gnd, t1);
+
+		if (in_pass) {
+			if (f0 > f_best) {
+				t_best = t0;
+				f_best = f0;
+			}
+			if (f1 < 0) {
+				p.los = s_find_crossing(sat, gnd, t0, f0, t1, f1, search.tolerance);
+				s_refine_peak(sat, gnd, t_best, search, &p);
+				found->push_back(p);
+				in_pass = false;
+			}
+		} else if (f1 >= 0) {
+			p.aos = s_find_crossing(sat, gnd, t0, f0, t1, f1, search.tolerance);
+			in_pass = true;
+			t_best = t1;
+			f_best = f1;
+		} else if (f0 > f_prev && f0 > f1 && t0 > search.t_start) {
+			// local maximum below the mask, the pass may peak between samples
+			double a = max(search.t_start, t0 - search.step);
+			double f_peak;
+			double t_peak = s_find_peak(sat, gnd, a, t1, search.tolerance, &f_peak);
+			if (f_peak >= 0) {
+				p.aos = s_find_crossing(sat, gnd, a, f_prev, t_peak, f_peak, search.tolerance);
+				p.los = s_find_crossing(sat, gnd, t_peak, f_peak, t1, f1, search.tolerance);
+				p.tca = t_peak;
+				p.max_el = f_peak + gnd.min_el;
+				found->push_back(p);
+			}
+		}
+
+		f_prev = f0;
+		t0 = t1;
+		f0 = f1;
+	}
+
+	if (in_pass) {
+		// still in view at the end of the search
+		p.los = search.t_end;
+		if (f0 > f_best) {
+			t_best = t0;
+		}
+		s_refine_peak(sat, gnd, t_best, search, &p);
+		found->push_back(p);
+	}
+}
+
+static bool s_pass_before(const pass& a, const pass& b)
+{
+	if (a.aos != b.aos) {
+		return a.aos < b.aos;
+	}
+	if (a.sat != b.sat) {
+		return a.sat < b.sat;
+	}
+	return a.gnd < b.gnd;
+}
+
+pass_search default_pass_search(void)
+{
+	pass_search search;
+	search.t_start = 0;
+	search.t_end = 7*24*3600;
+	search.step = 60;
+	search.tolerance = 0.01;
+	search.num_threads = (int)thread::hardware_concurrency();
+	if (search.num_threads < 1) {
+		search.num_threads = 1;
+	}
+	return search;
+}
+
+int find_passes(const satellite* sats, int num_sats,
+                const ground_station* gnds, int num_gnds,
+                const pass_search& search, vector<pass>* passes)
+{
+	if (!sats || !gnds || !passes || num_sats < 0 || num_gnds < 0 ||
+	    search.t_end < search.t_start || search.step <= 0 || search.tolerance <= 0) {
+		return -1;
+	}
+
+	int num_threads = (search.num_threads < 1) ? 1 : search.num_threads;
+
+	// chunks are whole numbers of steps, so every chunk
+	// samples the same time grid
+	double horizon = search.t_end - search.t_start;
+	double steps = ceil(horizon/search.step);
+	double steps_per_chunk = max(1.0, ceil(steps/(4*num_threads)));
+	double chunk = steps_per_chunk*search.step;
+
+	vector<pass_task> tasks;
+	for (int s = 0; s < num_sats; s++) {
+		for (int g = 0; g < num_gnds; g++) {
+			for (double t = search.t_start; t < search.t_end; t += chunk) {
+				pass_task task = { s, g, t, min(t + chunk, search.t_end) };
+				tasks.push_back(task);
+			}
+		}
+	}
+
+	vector< vector<pass> > found(tasks.size());
+	atomic<size_t> next(0);
+
+	auto worker = [&]() {
+		size_t i;
+		while ((i = next++) < tasks.size()) {
+			s_scan_chunk(sats, gnds, tasks[i], search, &found[i]);
+		}
+	};
+
+	vector<thread> pool;
+	for (int i = 1; i < num_threads; i++) {
+		pool.push_back(thread(worker));
+	}
+	worker();
+	for (size_t i = 0; i < pool.size(); i++) {
+		pool[i].join();
+	}
+
+	size_t first = passes->size();
+	for (size_t i = 0; i < found.size(); i++) {
+		passes->insert(passes->end(), found[i].begin(), found[i].end());
+	}
+	sort(passes->begin() + first, passes->end(), s_pass_before);
+
+	return (int)(passes->size() - first);
+}
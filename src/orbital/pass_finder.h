@@ -0,0 +1,68 @@
+/*
+ * FILE:    pass_finder.h
+ * PURPOSE: search long horizons for satellite passes over ground stations
+ * NOTES:   Instead of evaluating every second like gc_doppler.cpp's main(),
+ *          elevation is sampled every coarse step and each crossing of the
+ *          elevation mask is refined with Brent's method. Passes that peak
+ *          above the mask between two coarse samples are caught by refining
+ *          local maxima with a golden-section search.
+ *
+ *          The horizon is split into chunks and every
+ *          (satellite, ground station, chunk) triple is handed to a pool of
+ *          worker threads. A pass belongs to the chunk its AOS falls in.
+ */
+
+#ifndef _PASS_FINDER_H_
+#define _PASS_FINDER_H_
+
+#include <vector>
+#include "orbit_model.h"
+
+/*
+	A single contact between one satellite and one ground station.
+	Times are seconds since the satellite epoch.
+*/
+struct pass {
+	int    sat;    // index into the satellite array
+	int    gnd;    // index into the ground station array
+	double aos;    // acquisition of signal, s
+	double tca;    // time of closest approach (highest elevation), s
+	double los;    // loss of signal, s
+	double max_el; // elevation at tca, deg
+};
+
+/*
+	Search parameters.
+	step must be shorter than the shortest pass you care about
+	splitting; shorter passes are still found via their peak.
+*/
+struct pass_search {
+	double t_start;   // s
+	double t_end;     // s
+	double step;      // coarse step, s
+	double tolerance; // root and peak refinement tolerance, s
+	int    num_threads;
+};
+
+/*
+	Defaults: one week from t = 0, 60 s coarse step,
+	10 ms refinement, one thread per hardware thread.
+*/
+pass_search default_pass_search(void);
+
+/*
+	PARAMETERS:
+		sats, num_sats: satellites to search
+		gnds, num_gnds: ground stations to search
+		search: horizon, step and thread count
+		passes: output, appended with every pass found, ordered by aos
+	RETURNS:
+		number of passes found, or -1 if the parameters are invalid
+	NOTE: passes already in progress at search.t_start get aos = t_start,
+		passes still in progress at search.t_end get los = t_end.
+*/
+int find_passes(const satellite* sats, int num_sats,
+                const ground_station* gnds, int num_gnds,
+                const pass_search& search, std::vector<pass>* passes);
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ * FILE:    pass_finder_test.cpp
+ * PURPOSE: check find_passes against a brute force scan
+ * NOTES:   usage: pass_test [days]
+ *          Scans elevation every second, the way gc_doppler.cpp's main()
+ *          steps, and expects find_passes to report the same passes with
+ *          AOS and LOS within 1.5 s, for several masks and thread counts.
+ *          Thread counts change where the chunks fall, so passes that
+ *          straddle a chunk boundary are tried more than one way.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+#include "orbit_model.h"
+#include "gc_doppler.h"
+#include "pass_finder.h"
+
+using namespace std;
+
+// how far the refined AOS and LOS may be from the 1 s scan, s
+#define PASS_TEST_SLACK 1.5
+
+/*
+	The passes over gnd, one second at a time: AOS is the first
+	second at or above the mask, LOS the first below it again.
+*/
+static void s_scan(const satellite& sat, const ground_station& gnd, double t_end, vector<pass>* passes)
+{
+	pass p;
+	bool in_pass = false;
+
+	p.sat = 0;
+	p.gnd = 0;
+	p.max_el = -90;
+	for (double t = 0; t <= t_end; t += 1) {
+		double el = calc_look_elevation(sat, gnd, t);
+		if (el >= gnd.min_el) {
+			if (!in_pass) {
+				in_pass = true;
+				p.aos = t;
+				p.max_el = el;
+			}
+			if (el >= p.max_el) {
+				p.max_el = el;
+				p.tca = t;
+			}
+		} else if (in_pass) {
+			in_pass = false;
+			p.los = t;
+			passes->push_back(p);
+		}
+	}
+	if (in_pass) {
+		p.los = t_end;
+		passes->push_back(p);
+	}
+}
+
+/*
+	RETURNS:
+		number of mismatches, each printed
+*/
+static int s_compare(const vector<pass>& found, const vector<pass>& scanned, double min_el, int threads)
+{
+	int bad = 0;
+
+	if (found.size() != scanned.size()) {
+		printf("mask %.0f, %d threads: %u passes found, %u scanned\n",
+		       min_el, threads, (unsigned)found.size(), (unsigned)scanned.size());
+		return 1;
+	}
+	for (size_t i = 0; i < found.size(); i++) {
+		const pass& f = found[i];
+		const pass& s = scanned[i];
+		if (fabs(f.aos - s.aos) > PASS_TEST_SLACK || fabs(f.los - s.los) > PASS_TEST_SLACK ||
+		    f.max_el < s.max_el - 0.01 || f.tca < f.aos || f.tca > f.los) {
+			printf("mask %.0f, %d threads, pass %u: AOS %.2f LOS %.2f max el %.2f, scanned AOS %.0f LOS %.0f max el %.2f\n",
+			       min_el, threads, (unsigned)i, f.aos, f.los, f.max_el, s.aos, s.los, s.max_el);
+			bad++;
+		}
+	}
+	return bad;
+}
+
+int main(int argc, char** argv)
+{
+	double masks[] = { 0, 15, 45 };
+	int    threads[] = { 1, 3, 8 };
+	double days = 3;
+	int    bad = 0;
+	int    total = 0;
+
+	if (argc > 1) {
+		days = atof(argv[1]);
+	}
+
+	satellite   sat = gc_satellite();
+	pass_search search = default_pass_search();
+	search.t_end = days*24*3600;
+
+	for (size_t m = 0; m < sizeof(masks)/sizeof(masks[0]); m++) {
+		ground_station gnd = gc_ground_station(masks[m]);
+		vector<pass>   scanned;
+
+		s_scan(sat, gnd, search.t_end, &scanned);
+		total += (int)scanned.size();
+		for (size_t n = 0; n < sizeof(threads)/sizeof(threads[0]); n++) {
+			vector<pass> found;
+
+			search.num_threads = threads[n];
+			if (find_passes(&sat, 1, &gnd, 1, search, &found) < 0) {
+				printf("mask %.0f, %d threads: invalid search parameters\n", masks[m], threads[n]);
+				bad++;
+				continue;
+			}
+			bad += s_compare(found, scanned, masks[m], threads[n]);
+		}
+	}
+
+	if (bad) {
+		printf("Pass finder test failed, %d mismatches\n", bad);
+		return 1;
+	}
+	printf("%d passes over %.1f days matched the 1 s scan at every mask and thread count\n", total, days);
+	return 0;
+}
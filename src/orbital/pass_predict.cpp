@@ -0,0 +1,59 @@
+/*
+ * FILE:    pass_predict.cpp
+ * PURPOSE: list upcoming passes over the ground station
+ * NOTES:   usage: passes [days [min_el [threads]]]
+ *          Uses the same satellite and ground station as gc_doppler.cpp,
+ *          but searches days ahead instead of a fixed 10 minute window.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "orbit_model.h"
+#include "gc_doppler.h"
+#include "pass_finder.h"
+
+using namespace std;
+
+static void s_print_time(FILE* ofp, double t)
+{
+	int s = (int)t;
+	fprintf(ofp, "%4d days %2d hours %2d minutes %2d seconds", s/24/3600, (s/3600)%24, (s/60)%60, s%60);
+}
+
+int main(int argc, char** argv)
+{
+	pass_search search = default_pass_search();
+	ground_station gnd = gc_ground_station(15);
+	satellite sat = gc_satellite();
+
+	if (argc > 1) {
+		search.t_end = atof(argv[1])*24*3600;
+	}
+	if (argc > 2) {
+		gnd.min_el = atof(argv[2]);
+	}
+	if (argc > 3) {
+		search.num_threads = atoi(argv[3]);
+	}
+
+	vector<pass> passes;
+	if (find_passes(&sat, 1, &gnd, 1, search, &passes) < 0) {
+		fprintf(stderr, "invalid search parameters\n");
+		return 1;
+	}
+
+	for (size_t i = 0; i < passes.size(); i++) {
+		const pass& p = passes[i];
+		printf("%c AOS ", (p.max_el >= 45) ? '*' : ' ');
+		s_print_time(stdout, p.aos);
+		printf("   TCA ");
+		s_print_time(stdout, p.tca);
+		printf("   max el: %4.1f   duration: %5.1f minutes\n", p.max_el, (p.los - p.aos)/60);
+	}
+	printf("%u passes above %.1f degrees in %.1f days\n",
+	       (unsigned)passes.size(), gnd.min_el, (search.t_end - search.t_start)/24/3600);
+
+	return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * FILE:    rate_plan_gen.cpp
+ * PURPOSE: turn a predicted pass into a data rate plan for the satellite
+ * NOTES:   usage: rplan [pass [outfile [hysteresis [dwell]]]]
+ *          pass picks which of the next day's passes to plan (default 0),
+ *          hysteresis is in dB (default 2), dwell in seconds (default 30).
+ *          The plan format is described in ../rate_plan.h, and the written
+ *          plan is checked by loading it with the driver's own code.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+
+#include "orbit_model.h"
+#include "gc_doppler.h"
+#include "pass_finder.h"
+#include "link_budget.h"
+#include "rate_schedule.h"
+
+extern "C" {
+#include "../rate_plan.h"
+}
+
+using namespace std;
+
+// elevation mask, same as orbit.m
+#define MIN_EL 15 // deg
+
+static void s_put_u16(vector<uint8_t>* buf, uint16_t x)
+{
+	buf->push_back(x & 0xff);
+	buf->push_back(x >> 8);
+}
+
+static void s_put_u32(vector<uint8_t>* buf, uint32_t x)
+{
+	s_put_u16(buf, x & 0xffff);
+	s_put_u16(buf, x >> 16);
+}
+
+int main(int argc, char** argv)
+{
+	int which = (argc > 1) ? atoi(argv[1]) : 0;
+	const char* outfile = (argc > 2) ? argv[2] : "rate_plan.bin";
+	rate_schedule rs = default_rate_schedule();
+	link_budget lb = default_link_budget();
+
+	if (argc > 3) {
+		rs.hysteresis = atof(argv[3]);
+	}
+	if (argc > 4) {
+		rs.min_dwell = atof(argv[4]);
+	}
+	if (LINK_NUM_RATES != NUM_RATE_PROFILES) {
+		fprintf(stderr, "LINK_RATES and rate_profile disagree\n");
+		return 1;
+	}
+
+	ground_station gnd = gc_ground_station(MIN_EL);
+	satellite sat = gc_satellite();
+
+	pass_search search = default_pass_search();
+	search.t_end = 24*3600;
+	vector<pass> passes;
+	find_passes(&sat, 1, &gnd, 1, search, &passes);
+	if (which < 0 || which >= (int)passes.size()) {
+		fprintf(stderr, "only %u passes in the next day\n", (unsigned)passes.size());
+		return 1;
+	}
+
+	// whole seconds, so the plan lines up with the flight side's clock
+	pass p = passes[which];
+	p.aos = ceil(p.aos);
+	pass_link pl;
+	calc_pass_link(lb, sat, gnd, p, 1, &pl);
+
+	vector<rate_switch> plan;
+	calc_rate_schedule(lb, pl, rs, &plan);
+
+	uint32_t start = (uint32_t)plan[0].t;
+	if (plan.size() > 0xffff || plan.back().t - start > 0xffff) {
+		fprintf(stderr, "plan too long\n");
+		return 1;
+	}
+
+	vector<uint8_t> buf;
+	s_put_u16(&buf, plan.size());
+	s_put_u16(&buf, 0);
+	s_put_u32(&buf, start);
+	for (size_t i = 0; i < plan.size(); i++) {
+		s_put_u16(&buf, (uint16_t)(plan[i].t - start));
+		buf.push_back((uint8_t)plan[i].rate);
+		buf.push_back(0);
+	}
+
+	FILE* ofp = fopen(outfile, "wb");
+	if (!ofp || fwrite(&buf[0], 1, buf.size(), ofp) != buf.size()) {
+		fprintf(stderr, "could not write %s\n", outfile);
+		return 1;
+	}
+	fclose(ofp);
+
+	rate_plan rp;
+	if (RATE_PLAN_load(&rp, &buf[0], (uint16_t)buf.size()) != ERROR_NONE) {
+		fprintf(stderr, "generated plan does not load\n");
+		return 1;
+	}
+
+	printf("pass %d: t = %u s to %.0f s, max el %.1f deg\n", which, start, p.los, p.max_el);
+	for (size_t i = 0; i < plan.size(); i++) {
+		const link_sample& s = pl.samples[(size_t)(plan[i].t - pl.samples[0].t)];
+		printf("  t = %6.0f s   el: %4.1f   margin_dn: %+6.2f dB   -> %5.0f b/s\n",
+		       plan[i].t, s.el, s.margin_dn, LINK_RATES[plan[i].rate]);
+	}
+
+	double bits = calc_schedule_bits(lb, pl, plan);
+	printf("plan: %u switches, %u bytes written to %s\n", (unsigned)plan.size(), (unsigned)buf.size(), outfile);
+	printf("downlink: %.0f bits at %.0f b/s, %.0f bits planned (x%.2f), %.0f bits if every sample switched\n",
+	       pl.bits_fixed, lb.sens_rate, bits, (pl.bits_fixed > 0) ? bits/pl.bits_fixed : 0, pl.bits_adaptive);
+
+	return 0;
+}
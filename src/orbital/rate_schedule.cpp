@@ -0,0 +1,113 @@
+/*
+ * FILE:    rate_schedule.cpp
+ * PURPOSE: plan data rate switches over a pass, see rate_schedule.h
+ */
+
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include "link_budget.h"
+#include "rate_schedule.h"
+
+using namespace std;
+
+rate_schedule default_rate_schedule(void)
+{
+	rate_schedule rs;
+	rs.hysteresis = 2;
+	rs.min_dwell = 30;
+	return rs;
+}
+
+double calc_rate_margin(const link_budget& lb, double margin, int rate)
+{
+	// sensitivity worsens in step with the rate
+	return margin - 10*log10(LINK_RATES[rate]/lb.sens_rate);
+}
+
+// fastest rate with extra dB over min_margin at one sample, -1 if none
+static int s_best_rate(const link_budget& lb, const link_sample& s, double extra)
+{
+	for (int i = LINK_NUM_RATES - 1; i >= 0; i--) {
+		if (calc_rate_margin(lb, s.margin_dn, i) >= lb.min_margin + extra) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// fastest rate with extra dB to spare from sample i until min_dwell later
+static int s_hold_rate(const link_budget& lb, const pass_link& pl, int i, double min_dwell, double extra)
+{
+	int n = (int)pl.samples.size();
+	int rate = LINK_NUM_RATES - 1;
+
+	for (int j = i; j < n && pl.samples[j].t < pl.samples[i].t + min_dwell; j++) {
+		rate = min(rate, s_best_rate(lb, pl.samples[j], extra));
+	}
+	return rate;
+}
+
+static double s_sample_spacing(const pass_link& pl)
+{
+	return (pl.samples.size() > 1) ? pl.samples[1].t - pl.samples[0].t : 0;
+}
+
+void calc_rate_schedule(const link_budget& lb, const pass_link& pl, const rate_schedule& rs,
+                        vector<rate_switch>* plan)
+{
+	int n = (int)pl.samples.size();
+
+	plan->clear();
+	if (n == 0) {
+		return;
+	}
+
+	int rate = max(0, s_hold_rate(lb, pl, 0, rs.min_dwell, 0));
+	double last = pl.samples[0].t;
+	rate_switch sw = { last, rate };
+	plan->push_back(sw);
+
+	for (int i = 1; i < n; i++) {
+		const link_sample& s = pl.samples[i];
+		int next = rate;
+
+		if (s_best_rate(lb, s, 0) < rate) {
+			// current rate stopped closing, drop straight away
+			next = max(0, s_hold_rate(lb, pl, i, rs.min_dwell, 0));
+		} else if (s.t - last >= rs.min_dwell) {
+			next = max(rate, s_hold_rate(lb, pl, i, rs.min_dwell, rs.hysteresis));
+		}
+
+		if (next != rate) {
+			rate = next;
+			last = s.t;
+			sw.t = s.t;
+			sw.rate = rate;
+			plan->push_back(sw);
+		}
+	}
+}
+
+double calc_schedule_bits(const link_budget& lb, const pass_link& pl, const vector<rate_switch>& plan)
+{
+	double dt = s_sample_spacing(pl);
+	double bits = 0;
+	size_t k = 0;
+
+	if (plan.empty()) {
+		return 0;
+	}
+
+	for (size_t i = 0; i < pl.samples.size(); i++) {
+		const link_sample& s = pl.samples[i];
+		while (k + 1 < plan.size() && plan[k + 1].t <= s.t) {
+			k++;
+		}
+		if (calc_rate_margin(lb, s.margin_dn, plan[k].rate) >= lb.min_margin) {
+			bits += LINK_RATES[plan[k].rate]*dt;
+		}
+	}
+	return bits;
+}
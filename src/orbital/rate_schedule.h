@@ -0,0 +1,66 @@
+/*
+ * FILE:    rate_schedule.h
+ * PURPOSE: plan data rate switches over a pass from its predicted link margin
+ * NOTES:   Instead of orbit.m's single worst-case 2400 b/s, each pass gets a
+ *          time-ordered list of switches between the rates in LINK_RATES.
+ *          Since the whole pass is predicted in advance, a step up is only
+ *          taken if the faster rate will hold, with hysteresis to spare, for
+ *          at least min_dwell. A step down happens as soon as the current
+ *          rate stops closing, to whatever will hold for min_dwell.
+ *
+ *          Rate indices match rate_profile in ../rate_plan.h.
+ */
+
+#ifndef _RATE_SCHEDULE_H_
+#define _RATE_SCHEDULE_H_
+
+#include <vector>
+#include "link_budget.h"
+
+/*
+	One switch: from time t on, run at LINK_RATES[rate].
+*/
+struct rate_switch {
+	double t;    // s
+	int    rate; // index into LINK_RATES
+};
+
+/*
+	Scheduler parameters.
+*/
+struct rate_schedule {
+	double hysteresis; // dB above min_margin needed before stepping up
+	double min_dwell;  // s, shortest time to stay at a rate after stepping up
+};
+
+/*
+	RETURNS:
+		2 dB of hysteresis and 30 s of dwell
+*/
+rate_schedule default_rate_schedule(void);
+
+/*
+	RETURNS:
+		margin in dB at LINK_RATES[rate], given the margin at lb.sens_rate
+*/
+double calc_rate_margin(const link_budget& lb, double margin, int rate);
+
+/*
+	PARAMETERS:
+		lb: link budget pl was evaluated with
+		pl: downlink samples for the pass, from calc_pass_link
+		rs: scheduler parameters
+		plan: output, first switch at the first sample
+	NOTE: when no rate closes, the slowest one is planned.
+*/
+void calc_rate_schedule(const link_budget& lb, const pass_link& pl, const rate_schedule& rs,
+                        std::vector<rate_switch>* plan);
+
+/*
+	RETURNS:
+		downlink bits delivered following plan over pl's samples,
+		counting nothing for samples where the planned rate does not close
+*/
+double calc_schedule_bits(const link_budget& lb, const pass_link& pl, const std::vector<rate_switch>& plan);
+
+#endif
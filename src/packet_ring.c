@@ -0,0 +1,287 @@
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "error.h"
+#include "rxtx.h"
+#include "packet_ring.h"
+
+static uint8_t* s_PACKET_RING_slot(packet_ring* pr, unsigned int index) {
+	return pr->slab + (index & (pr->num_slots - 1)) * pr->stride;
+}
+
+static void s_PACKET_RING_set_len(uint8_t* slot, uint16_t len) {
+	slot[0] = (uint8_t)(len & 0xff);
+	slot[1] = (uint8_t)(len >> 8);
+}
+
+static uint16_t s_PACKET_RING_get_len(const uint8_t* slot) {
+	return (uint16_t)(slot[0] | (slot[1] << 8));
+}
+
+tcvr_error_t PACKET_RING_init(packet_ring* pr, uint8_t* slab, uint32_t slab_len, uint16_t num_slots, uint16_t slot_size) {
+	rxtx_fifo_stats fs;
+
+	if (!pr || !slab) {
+		return ERROR_NULL_POINTER;
+	}
+	if (num_slots == 0 || (num_slots & (num_slots - 1)) != 0 ||
+	    slab_len < PACKET_RING_SLAB_SIZE(num_slots, slot_size)) {
+		return ERROR_PARAMETER_OUT_OF_RANGE;
+	}
+
+	pr->slab = slab;
+	pr->stride = PACKET_RING_SLOT_STRIDE(slot_size);
+	pr->slot_size = slot_size;
+	pr->num_slots = num_slots;
+	pr->rx_filled = 0;
+	pr->rx_discard = 0;
+	pr->tx_sent = 0;
+	RXTX_get_fifo_stats(&fs);
+	pr->rx_errors = fs.rx_errors;
+	atomic_init(&pr->head, 0);
+	atomic_init(&pr->tail, 0);
+	return ERROR_NONE;
+}
+
+tcvr_error_t PACKET_RING_count(packet_ring* pr, uint16_t* count) {
+	if (!pr || !count) {
+		return ERROR_NULL_POINTER;
+	}
+
+	*count = (uint16_t)(atomic_load_explicit(&pr->head, memory_order_acquire) -
+	                    atomic_load_explicit(&pr->tail, memory_order_acquire));
+	return ERROR_NONE;
+}
+
+tcvr_error_t PACKET_RING_begin_write(packet_ring* pr, uint8_t** frame) {
+	unsigned int head;
+	unsigned int tail;
+
+	if (!pr || !frame) {
+		return ERROR_NULL_POINTER;
+	}
+
+	// head is ours, tail tells us which slots the consumer is done with
+	head = atomic_load_explicit(&pr->head, memory_order_relaxed);
+	tail = atomic_load_explicit(&pr->tail, memory_order_acquire);
+	if (head - tail >= pr->num_slots) {
+		return ERROR_PACKET_RING_FULL;
+	}
+
+	*frame = s_PACKET_RING_slot(pr, head) + PACKET_RING_SLOT_HEADER;
+	return ERROR_NONE;
+}
+
+tcvr_error_t PACKET_RING_end_write(packet_ring* pr, uint16_t len) {
+	unsigned int head;
+
+	if (!pr) {
+		return ERROR_NULL_POINTER;
+	}
+	if (len > pr->slot_size) {
+		return ERROR_PACKET_RING_FRAME_TOO_LONG;
+	}
+
+	head = atomic_load_explicit(&pr->head, memory_order_relaxed);
+	s_PACKET_RING_set_len(s_PACKET_RING_slot(pr, head), len);
+
+	// publish the frame, and its length, to the consumer
+	atomic_store_explicit(&pr->head, head + 1, memory_order_release);
+	return ERROR_NONE;
+}
+
+tcvr_error_t PACKET_RING_begin_read(packet_ring* pr, uint8_t** frame, uint16_t* len) {
+	unsigned int head;
+	unsigned int tail;
+	uint8_t*     slot;
+
+	if (!pr || !frame || !len) {
+		return ERROR_NULL_POINTER;
+	}
+
+	tail = atomic_load_explicit(&pr->tail, memory_order_relaxed);
+	head = atomic_load_explicit(&pr->head, memory_order_acquire);
+	if (head == tail) {
+		return ERROR_PACKET_RING_EMPTY;
+	}
+
+	slot = s_PACKET_RING_slot(pr, tail);
+	*frame = slot + PACKET_RING_SLOT_HEADER;
+	*len = s_PACKET_RING_get_len(slot);
+	return ERROR_NONE;
+}
+
+tcvr_error_t PACKET_RING_end_read(packet_ring* pr) {
+	unsigned int tail;
+
+	if (!pr) {
+		return ERROR_NULL_POINTER;
+	}
+
+	tail = atomic_load_explicit(&pr->tail, memory_order_relaxed);
+	if (atomic_load_explicit(&pr->head, memory_order_acquire) == tail) {
+		return ERROR_PACKET_RING_EMPTY;
+	}
+
+	// hand the slot back only once we are finished with it
+	atomic_store_explicit(&pr->tail, tail + 1, memory_order_release);
+	return ERROR_NONE;
+}
+
+tcvr_error_t PACKET_RING_rx_drain(packet_ring* pr, uint16_t frame_len, uint8_t* frames, uint8_t* status) {
+	tcvr_error_t    err = ERROR_NONE;
+	tcvr_error_t    dropped = ERROR_NONE;
+	uint8_t*        frame;
+	uint8_t         avail;
+	uint8_t         got;
+	uint8_t         done = 0;
+	uint16_t        need;
+	uint16_t        n;
+	rxtx_fifo_stats fs;
+
+	if (!pr) {
+		return ERROR_NULL_POINTER;
+	}
+	if (frames) {
+		*frames = 0;
+	}
+
+	// one look at the FIFO, anything arriving meanwhile waits for the next call
+	err = RX_queue_len(&avail, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	// an overflow cut short the frame being drained, once its salvage is in it can go
+	RXTX_get_fifo_stats(&fs);
+	if (fs.rx_errors != pr->rx_errors && !RXTX_salvage_pending()) {
+		pr->rx_filled = 0;
+		pr->rx_discard = 0;
+		pr->rx_errors = fs.rx_errors;
+	}
+
+	while (avail > 0) {
+		err = PACKET_RING_begin_write(pr, &frame);
+		if (err != ERROR_NONE) {
+			break;
+		}
+
+		// the rest of a frame too long for a slot goes through the free one and no further
+		if (pr->rx_discard > 0) {
+			n = (pr->rx_discard < pr->slot_size) ? pr->rx_discard : pr->slot_size;
+			n = (n < avail) ? n : avail;
+			err = RX_burst_dequeue(frame, (uint8_t)n, &got, status);
+			if (err != ERROR_NONE || got == 0) {
+				break;
+			}
+			pr->rx_discard -= got;
+			avail -= got;
+			continue;
+		}
+
+		if (frame_len == PACKET_RING_VARIABLE_LENGTH) {
+			// read the length byte on its own, then the rest
+			need = (pr->rx_filled == 0) ? 1 : 1 + (uint16_t)frame[0];
+		}
+		else {
+			need = frame_len;
+		}
+		if (need > pr->slot_size && pr->rx_filled > 0) {
+			// only its length byte is out of the FIFO, skip what follows it
+			pr->rx_discard = frame[0];
+			pr->rx_filled = 0;
+			dropped = ERROR_PACKET_RING_FRAME_TOO_LONG;
+			continue;
+		}
+		if (need > pr->slot_size) {
+			err = ERROR_PACKET_RING_FRAME_TOO_LONG;
+			break;
+		}
+
+		n = need - pr->rx_filled;
+		n = (n < avail) ? n : avail;
+		if (n > 0) {
+			err = RX_burst_dequeue(frame + pr->rx_filled, (uint8_t)n, &got, status);
+			if (err != ERROR_NONE) {
+				break;
+			}
+			if (got == 0) {
+				break;
+			}
+			pr->rx_filled += got;
+			avail -= got;
+		}
+
+		if (frame_len == PACKET_RING_VARIABLE_LENGTH && pr->rx_filled == 1 && frame[0] > 0) {
+			continue;
+		}
+		if (pr->rx_filled == need) {
+			PACKET_RING_end_write(pr, need);
+			pr->rx_filled = 0;
+			done++;
+		}
+	}
+
+	if (frames) {
+		*frames = done;
+	}
+	return (err != ERROR_NONE) ? err : dropped;
+}
+
+tcvr_error_t PACKET_RING_tx_feed(packet_ring* pr, uint8_t* frames, uint8_t* status) {
+	tcvr_error_t err = ERROR_NONE;
+	uint8_t*     frame;
+	uint16_t     len;
+	uint8_t      used;
+	uint8_t      room;
+	uint8_t      done = 0;
+	uint16_t     n;
+
+	if (!pr) {
+		return ERROR_NULL_POINTER;
+	}
+	if (frames) {
+		*frames = 0;
+	}
+
+	if (PACKET_RING_begin_read(pr, &frame, &len) != ERROR_NONE) {
+		return ERROR_NONE;
+	}
+
+	err = TX_queue_len(&used, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+	room = (used < TRANSCEIVER_FIFO_SIZE) ? TRANSCEIVER_FIFO_SIZE - used : 0;
+
+	for (;;) {
+		n = len - pr->tx_sent;
+		n = (n < room) ? n : room;
+		if (n > 0) {
+			// room was read once above, no need to read it again per frame
+			err = TX_burst_enqueue_unchecked(frame + pr->tx_sent, (uint8_t)n, status);
+			if (err != ERROR_NONE) {
+				break;
+			}
+			pr->tx_sent += n;
+			room -= n;
+		}
+
+		if (pr->tx_sent < len) {
+			break;
+		}
+		PACKET_RING_end_read(pr);
+		pr->tx_sent = 0;
+		done++;
+
+		if (room == 0 || PACKET_RING_begin_read(pr, &frame, &len) != ERROR_NONE) {
+			break;
+		}
+	}
+
+	if (frames) {
+		*frames = done;
+	}
+	return err;
+}
@@ -0,0 +1,133 @@
+#ifndef _PACKET_RING_H_
+#define _PACKET_RING_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "error.h"
+
+/*
+	Fixed-capacity ring of frame buffers between the radio and the
+	application, so neither side has to allocate or copy.
+
+	The caller supplies the slab, PACKET_RING_SLAB_SIZE bytes, and
+	nothing is allocated afterwards. Each slot holds one frame of
+	up to slot_size bytes behind a small length header.
+
+	There must be exactly one producer and one consumer, which may
+	run on different threads. The producer borrows the next free
+	slot with PACKET_RING_begin_write, fills it in place and hands
+	it over with PACKET_RING_end_write. The consumer borrows the
+	oldest full slot with PACKET_RING_begin_read, uses it in place
+	and gives it back with PACKET_RING_end_read. Neither call
+	blocks or takes a lock.
+
+	For RX the radio is the producer (PACKET_RING_rx_drain), for
+	TX the radio is the consumer (PACKET_RING_tx_feed).
+*/
+
+// slot header: uint16 frame length, then padding
+#define PACKET_RING_SLOT_HEADER   4
+#define PACKET_RING_SLOT_STRIDE(slot_size) (PACKET_RING_SLOT_HEADER + (((uint32_t)(slot_size) + 3) & ~(uint32_t)3))
+#define PACKET_RING_SLAB_SIZE(num_slots, slot_size) ((uint32_t)(num_slots) * PACKET_RING_SLOT_STRIDE(slot_size))
+
+// keeps the producer's and consumer's indices on separate cache lines
+#define PACKET_RING_CACHE_LINE 64
+
+/*
+	Frame length for PACKET_RING_rx_drain when the packet engine
+	is in variable length mode: the first byte of each frame is
+	the number of bytes that follow it.
+*/
+#define PACKET_RING_VARIABLE_LENGTH 0
+
+typedef struct packet_ring_s {
+	uint8_t*    slab;
+	uint32_t    stride;
+	uint16_t    slot_size;
+	uint16_t    num_slots;   // power of two
+
+	// producer only
+	_Alignas(PACKET_RING_CACHE_LINE)
+	atomic_uint head;        // slots ever written
+	uint16_t    rx_filled;   // bytes drained into the slot being written
+	uint16_t    rx_discard;  // bytes left of a frame too long for a slot
+	uint32_t    rx_errors;   // RX FIFO errors already accounted for
+
+	// consumer only
+	_Alignas(PACKET_RING_CACHE_LINE)
+	atomic_uint tail;        // slots ever read
+	uint16_t    tx_sent;     // bytes fed from the slot being read
+} packet_ring;
+
+/*
+	Sets up an empty ring over the caller's slab, which must
+	outlive it.
+	Returns ERROR_NONE if successful,
+	ERROR_PARAMETER_OUT_OF_RANGE if num_slots is not a power of two
+	or slab_len is less than PACKET_RING_SLAB_SIZE(num_slots, slot_size).
+*/
+tcvr_error_t PACKET_RING_init(packet_ring* pr, uint8_t* slab, uint32_t slab_len, uint16_t num_slots, uint16_t slot_size);
+
+/*
+	Outputs the number of full slots.
+	Returns ERROR_NONE if successful.
+*/
+tcvr_error_t PACKET_RING_count(packet_ring* pr, uint16_t* count);
+
+/*
+	Producer: borrows the next free slot, slot_size bytes.
+	Returns ERROR_NONE if successful,
+	ERROR_PACKET_RING_FULL if every slot is full.
+*/
+tcvr_error_t PACKET_RING_begin_write(packet_ring* pr, uint8_t** frame);
+
+/*
+	Producer: hands the borrowed slot to the consumer, holding
+	a frame of len bytes.
+	Returns ERROR_NONE if successful,
+	ERROR_PACKET_RING_FRAME_TOO_LONG if len is more than slot_size.
+*/
+tcvr_error_t PACKET_RING_end_write(packet_ring* pr, uint16_t len);
+
+/*
+	Consumer: borrows the oldest full slot.
+	Returns ERROR_NONE if successful,
+	ERROR_PACKET_RING_EMPTY if there is none.
+*/
+tcvr_error_t PACKET_RING_begin_read(packet_ring* pr, uint8_t** frame, uint16_t* len);
+
+/*
+	Consumer: gives the borrowed slot back to the producer.
+	Returns ERROR_NONE if successful.
+*/
+tcvr_error_t PACKET_RING_end_read(packet_ring* pr);
+
+/*
+	Producer: moves what is in the RX FIFO straight into the
+	slot being written, and hands the slot over once it holds a
+	whole frame of frame_len bytes, or PACKET_RING_VARIABLE_LENGTH.
+	Frames longer than the FIFO are built up over several calls.
+	A frame cut short by an RX FIFO overflow is dropped once the
+	bytes salvaged from it have been drained.
+	A variable length frame too long for a slot is thrown away,
+	over as many calls as it takes, and the frames after it are
+	drained as usual.
+	Outputs the number of frames completed, and reads chip status.
+	Returns ERROR_NONE if successful,
+	ERROR_PACKET_RING_FULL if bytes are waiting but no slot is free,
+	ERROR_PACKET_RING_FRAME_TOO_LONG if a frame will not fit a slot;
+	for a fixed frame_len the FIFO is left for the caller to flush.
+*/
+tcvr_error_t PACKET_RING_rx_drain(packet_ring* pr, uint16_t frame_len, uint8_t* frames, uint8_t* status);
+
+/*
+	Consumer: streams the oldest full slot straight into the TX
+	FIFO, as much as fits, and gives the slot back once all of it
+	has gone. Outputs the number of frames completed, and reads
+	chip status.
+	Returns ERROR_NONE if successful, including when there is
+	nothing to send or no room in the FIFO.
+*/
+tcvr_error_t PACKET_RING_tx_feed(packet_ring* pr, uint8_t* frames, uint8_t* status);
+
+#endif
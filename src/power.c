@@ -0,0 +1,277 @@
+
+#include <stdint.h>
+
+#include "error.h"
+#include "bits.h"
+#include "bang_registers.h"
+#include "strobe.h"
+#include "status_byte.h"
+#include "status_tracker.h"
+#include "clock.h"
+#include "xosc.h"
+#include "power.h"
+
+/*
+	eWOR: Event0 = EVENT0 * 2^(5*WOR_RES) / f_RCOSC, and each wake
+	listens for EVENT0 / 2^(RX_TIME+3) RCOSC periods (RX_TIME 7 is
+	no timeout), where f_RCOSC = f_XOSC / 1250. WOR_RES is always 0,
+	which covers intervals up to 2 s.
+*/
+#define POWER_RCOSC_DIVIDER 1250
+#define POWER_RX_TIME_NONE  7
+
+// WOR_CFG1
+BITS_FIELD(POWER_WOR_RES, 7, 6)
+BITS_FIELD(POWER_WOR_MODE, 5, 3)
+BITS_FIELD(POWER_EVENT1, 2, 0)
+// WOR_CFG0
+BITS_FIELD(POWER_DIV_256HZ_EN, 5, 5)
+BITS_FIELD(POWER_RC_MODE, 2, 1)
+BITS_FIELD(POWER_RC_PD, 0, 0)
+// RFEND_CFG1
+BITS_FIELD(POWER_RXOFF_MODE, 5, 4)
+BITS_FIELD(POWER_RX_TIME, 3, 1)
+BITS_FIELD(POWER_RX_TIME_QUAL, 0, 0)
+
+// WOR_RES 0, WOR_MODE normal, EVENT1 16 RCOSC periods for the XOSC to start
+#define POWER_WOR_CFG1 (BITS_FIELD_CONST(POWER_WOR_RES, 0) | BITS_FIELD_CONST(POWER_WOR_MODE, 1) | \
+                        BITS_FIELD_CONST(POWER_EVENT1, 4))
+// 256 Hz clock divider on, RCOSC calibration on, RCOSC running
+#define POWER_WOR_CFG0 (BITS_FIELD_CONST(POWER_DIV_256HZ_EN, 1) | BITS_FIELD_CONST(POWER_RC_MODE, 2) | \
+                        BITS_FIELD_CONST(POWER_RC_PD, 0))
+// RXOFF_MODE IDLE, RX_TIME, stay in RX on preamble or carrier
+#define POWER_RFEND_CFG1(rx_time) (BITS_FIELD_CONST(POWER_RXOFF_MODE, 0) | POWER_RX_TIME_value(rx_time) | \
+                                   BITS_FIELD_CONST(POWER_RX_TIME_QUAL, 1))
+
+/*
+	Rough figures from the data sheet: RX in high performance
+	mode, and the cost of each eWOR wake, the crystal starting
+	and the synthesizer settling. Sleep current (0.3 uA) is below
+	the resolution of the estimates.
+*/
+#define POWER_RX_UA   22000
+#define POWER_WAKE_UA 2000
+#define POWER_WAKE_US 500
+
+typedef struct power_profile_config_s {
+	uint16_t interval_ms;  // 0 for always in RX
+	uint8_t  rx_time;
+} power_profile_config;
+
+static const power_profile_config s_POWER_profiles[NUM_POWER_PROFILES] = {
+	{    0, POWER_RX_TIME_NONE }, // always RX
+	{   20, 0 },                  // listens 2.5 ms of every 20
+	{  100, 1 },                  // listens 6.25 ms of every 100
+	{ 1000, 3 }                   // listens 15.6 ms of every 1000
+};
+
+static int s_POWER_is_awake(power_state ps) {
+	return ps == POWER_IDLE || ps == POWER_RX;
+}
+
+static void s_POWER_account(power_manager* pm, uint32_t now) {
+	uint32_t dt = now - pm->since;
+
+	pm->time_in_state[pm->state] += dt;
+	if (s_POWER_is_awake(pm->state)) {
+		pm->time_in_status[pm->last_status] += dt;
+	}
+	pm->since = now;
+}
+
+static tcvr_error_t s_POWER_configure(power_manager* pm, uint8_t* status) {
+	const power_profile_config* pc = &s_POWER_profiles[pm->profile];
+	tcvr_error_t err;
+	uint8_t      wor[4];
+	uint32_t     event0;
+
+	if (pc->interval_ms) {
+		event0 = (uint32_t)pc->interval_ms * ((uint32_t)pm->xosc / POWER_RCOSC_DIVIDER) / 1000;
+
+		wor[0] = POWER_WOR_CFG1;
+		wor[1] = POWER_WOR_CFG0;
+		wor[2] = (uint8_t)(event0 >> 8);
+		wor[3] = (uint8_t)(event0 & 0xff);
+		err = REGISTER_burst_write(WOR_CFG1, wor, sizeof(wor), status);
+		if (err != ERROR_NONE) {
+			return err;
+		}
+	}
+
+	err = REGISTER_write(RFEND_CFG1, POWER_RFEND_CFG1(pc->rx_time), status);
+	if (err == ERROR_NONE) {
+		pm->reconfigure = 0;
+	}
+	return err;
+}
+
+static tcvr_error_t s_POWER_enter(power_manager* pm, power_state ps, uint8_t* status) {
+	tcvr_error_t err;
+
+	if (ps == POWER_RX || ps == POWER_WOR) {
+		err = s_POWER_configure(pm, status);
+		if (err != ERROR_NONE) {
+			return err;
+		}
+	}
+
+	// every state is entered from IDLE; SIDLE also ends eWOR and wakes the chip
+	err = STROBE_command_strobe(SIDLE, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	switch (ps) {
+	case POWER_SLEEP:
+		err = STROBE_command_strobe(SPWD, status);
+		break;
+	case POWER_XOFF:
+		err = STROBE_command_strobe(SXOFF, status);
+		break;
+	case POWER_RX:
+		err = STROBE_command_strobe(SRX, status);
+		break;
+	case POWER_WOR:
+		err = STROBE_command_strobe(SWORRST, status);
+		if (err == ERROR_NONE) {
+			err = STROBE_command_strobe(SWOR, status);
+		}
+		break;
+	default:
+		break;
+	}
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	pm->state = ps;
+	if (status) {
+		pm->last_status = STATUS_get_chip_status(*status);
+	}
+	return ERROR_NONE;
+}
+
+void POWER_init(power_manager* pm, const contact_window* windows, uint16_t num_windows,
+                XOSC_frequency xosc, uint32_t idle_lead, uint32_t xoff_lead, uint32_t now) {
+	int i;
+
+	if (!pm) {
+		return;
+	}
+
+	pm->windows = windows;
+	pm->num_windows = windows ? num_windows : 0;
+	pm->next = 0;
+	pm->xosc = xosc;
+	pm->profile = POWER_PROFILE_ALWAYS_RX;
+	pm->reconfigure = 1;
+	pm->idle_lead = idle_lead;
+	pm->xoff_lead = (xoff_lead > idle_lead) ? xoff_lead : idle_lead;
+	pm->state = POWER_IDLE;
+	pm->last_status = STATUS_IDLE;
+	pm->since = now;
+
+	for (i = 0; i < NUM_POWER_STATES; i++) {
+		pm->time_in_state[i] = 0;
+	}
+	for (i = 0; i < POWER_NUM_CHIP_STATUS; i++) {
+		pm->time_in_status[i] = 0;
+	}
+}
+
+tcvr_error_t POWER_set_profile(power_manager* pm, power_profile profile) {
+	if (!pm) {
+		return ERROR_NULL_POINTER;
+	}
+	if ((int)profile < 0 || profile >= NUM_POWER_PROFILES) {
+		return ERROR_POWER_PROFILE_UNKNOWN;
+	}
+
+	if (profile != pm->profile) {
+		pm->profile = profile;
+		pm->reconfigure = 1;
+	}
+	return ERROR_NONE;
+}
+
+tcvr_error_t POWER_update(power_manager* pm, uint32_t now, uint8_t* status) {
+	const contact_window* w;
+	status_tracker*       st;
+	power_state           want = POWER_SLEEP;
+	uint8_t               byt;
+	uint32_t              lead;
+	tcvr_error_t          err;
+
+	if (!pm) {
+		return ERROR_NULL_POINTER;
+	}
+	if (!status) {
+		status = &byt;
+	}
+
+	s_POWER_account(pm, now);
+
+	while (pm->next < pm->num_windows && pm->windows[pm->next].end <= now) {
+		pm->next++;
+	}
+
+	if (pm->next < pm->num_windows) {
+		w = &pm->windows[pm->next];
+		if (now >= w->start) {
+			want = s_POWER_profiles[pm->profile].interval_ms ? POWER_WOR : POWER_RX;
+		}
+		else {
+			lead = w->start - now;
+			if (lead <= pm->idle_lead) {
+				want = POWER_IDLE;
+			}
+			else if (lead <= pm->xoff_lead) {
+				want = POWER_XOFF;
+			}
+		}
+	}
+
+	if (want != pm->state || ((want == POWER_RX || want == POWER_WOR) && pm->reconfigure)) {
+		return s_POWER_enter(pm, want, status);
+	}
+
+	// sample the chip's state, but never wake it just to ask
+	if (s_POWER_is_awake(pm->state)) {
+		st = STATUS_TRACKER_attached();
+		if (st && st->ready && CLOCK_now_us() - st->seen_us < STATUS_TRACKER_STALE_US) {
+			// a recent transaction's status byte is as good as a new one
+			*status = st->last;
+			pm->last_status = st->state;
+			return ERROR_NONE;
+		}
+		err = STROBE_command_strobe(SNOP, status);
+		if (err != ERROR_NONE) {
+			return err;
+		}
+		pm->last_status = STATUS_get_chip_status(*status);
+	}
+	return ERROR_NONE;
+}
+
+tcvr_error_t POWER_profile_estimate(power_profile profile, uint32_t* latency_ms, uint32_t* current_ua) {
+	const power_profile_config* pc;
+
+	if ((int)profile < 0 || profile >= NUM_POWER_PROFILES) {
+		return ERROR_POWER_PROFILE_UNKNOWN;
+	}
+	pc = &s_POWER_profiles[profile];
+
+	if (latency_ms) {
+		*latency_ms = pc->interval_ms;
+	}
+	if (current_ua) {
+		if (pc->interval_ms == 0) {
+			*current_ua = POWER_RX_UA;
+		}
+		else {
+			*current_ua = (POWER_RX_UA >> (pc->rx_time + 3)) +
+			              (uint32_t)POWER_WAKE_UA * POWER_WAKE_US / (pc->interval_ms * 1000u);
+		}
+	}
+	return ERROR_NONE;
+}
@@ -0,0 +1,102 @@
+#ifndef _POWER_H_
+#define _POWER_H_
+
+#include <stdint.h>
+#include "error.h"
+#include "xosc.h"
+#include "status_byte.h"
+
+/*
+	Keeps the chip in the lowest power state the contact schedule
+	allows: SLEEP (SPWD) when the next contact is far off, XOFF
+	(SXOFF) when it is near, IDLE just before it so the crystal
+	has settled, and listening during it.
+
+	How it listens is the power profile. POWER_PROFILE_ALWAYS_RX
+	stays in RX. The sniff profiles use eWOR (SWOR): the chip
+	sleeps on its RC oscillator, wakes every interval, listens
+	briefly and goes back to sleep unless it hears a preamble or
+	carrier (RFEND_CFG1.RX_TIME_QUAL). Longer intervals draw less
+	current but the peer's preamble must then be at least one
+	interval long, and a frame can wait up to an interval to be
+	heard. POWER_profile_estimate gives both figures.
+
+	Contact windows are the caller's, eg. from orbit predictions,
+	in mission time order. All times are mission seconds.
+*/
+typedef enum power_state_e {
+	POWER_SLEEP,
+	POWER_XOFF,
+	POWER_IDLE,
+	POWER_RX,
+	POWER_WOR,
+	NUM_POWER_STATES
+} power_state;
+
+typedef enum power_profile_e {
+	POWER_PROFILE_ALWAYS_RX,
+	POWER_PROFILE_SNIFF_FAST,     //   20 ms interval
+	POWER_PROFILE_SNIFF_BALANCED, //  100 ms interval
+	POWER_PROFILE_SNIFF_SLOW,     // 1000 ms interval
+	NUM_POWER_PROFILES
+} power_profile;
+
+// chip states reported in the status byte, see chip_status
+#define POWER_NUM_CHIP_STATUS 8
+
+typedef struct contact_window_s {
+	uint32_t start;
+	uint32_t end;
+} contact_window;
+
+typedef struct power_manager_s {
+	const contact_window* windows;
+	uint16_t       num_windows;
+	uint16_t       next;          // first window not yet over
+	XOSC_frequency xosc;
+	power_profile  profile;
+	int            reconfigure;   // profile changed since it was last applied
+	uint32_t       idle_lead;     // be in IDLE this long before a window
+	uint32_t       xoff_lead;     // and in XOFF rather than SLEEP this long
+	power_state    state;
+	chip_status    last_status;   // from the last status byte while awake
+	uint32_t       since;         // time accounted up to
+
+	uint32_t       time_in_state[NUM_POWER_STATES];
+	uint32_t       time_in_status[POWER_NUM_CHIP_STATUS];
+} power_manager;
+
+/*
+	Starts managing a chip that is awake and in IDLE at time now.
+	Nothing is sent to the chip until POWER_update.
+*/
+void POWER_init(power_manager* pm, const contact_window* windows, uint16_t num_windows,
+                XOSC_frequency xosc, uint32_t idle_lead, uint32_t xoff_lead, uint32_t now);
+
+/*
+	Selects how to listen during contacts. Takes effect at the
+	next POWER_update.
+	Returns ERROR_NONE if successful, ERROR_POWER_PROFILE_UNKNOWN if
+	profile isn't one.
+*/
+tcvr_error_t POWER_set_profile(power_manager* pm, power_profile profile);
+
+/*
+	Accounts the time since the last call to the state the chip
+	was in, then moves it to the state wanted at time now. Meant
+	to be called about once a second.
+	Returns ERROR_NONE if successful, or the error from the
+	register writes or strobes.
+*/
+tcvr_error_t POWER_update(power_manager* pm, uint32_t now, uint8_t* status);
+
+/*
+	Rough worst case wake-up latency and average current of a
+	profile while listening, from the data sheet's RX and sleep
+	currents.
+	Returns ERROR_NONE if successful, ERROR_POWER_PROFILE_UNKNOWN if
+	profile isn't one.
+*/
+tcvr_error_t POWER_profile_estimate(power_profile profile, uint32_t* latency_ms, uint32_t* current_ua);
+
+#endif
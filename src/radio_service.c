@@ -0,0 +1,473 @@
+
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "error.h"
+#include "bang_registers.h"
+#include "strobe.h"
+#include "rxtx.h"
+#include "radio_service.h"
+
+static void s_RADIO_OP_init(radio_op* op, radio_op_type type) {
+	memset(op, 0, sizeof(*op));
+	op->type = type;
+}
+
+void RADIO_OP_write(radio_op* op, register_name rn, uint8_t value) {
+	s_RADIO_OP_init(op, RADIO_OP_WRITE);
+	op->rn = rn;
+	op->value = value;
+}
+
+void RADIO_OP_read(radio_op* op, register_name rn) {
+	s_RADIO_OP_init(op, RADIO_OP_READ);
+	op->rn = rn;
+}
+
+void RADIO_OP_burst_write(radio_op* op, register_name rn, uint8_t* data, uint8_t len) {
+	s_RADIO_OP_init(op, RADIO_OP_BURST_WRITE);
+	op->rn = rn;
+	op->data = data;
+	op->len = len;
+}
+
+void RADIO_OP_burst_read(radio_op* op, register_name rn, uint8_t* data, uint8_t len) {
+	s_RADIO_OP_init(op, RADIO_OP_BURST_READ);
+	op->rn = rn;
+	op->data = data;
+	op->len = len;
+}
+
+void RADIO_OP_strobe(radio_op* op, strobe_name sn) {
+	s_RADIO_OP_init(op, RADIO_OP_STROBE);
+	op->sn = sn;
+}
+
+void RADIO_OP_rx_dequeue(radio_op* op, uint8_t* data, uint8_t len) {
+	s_RADIO_OP_init(op, RADIO_OP_RX_DEQUEUE);
+	op->data = data;
+	op->len = len;
+}
+
+void RADIO_OP_tx_enqueue(radio_op* op, uint8_t* data, uint8_t len) {
+	s_RADIO_OP_init(op, RADIO_OP_TX_ENQUEUE);
+	op->data = data;
+	op->len = len;
+}
+
+// Queue
+// =====
+/*
+	Intrusive multi-producer single-consumer queue: producers
+	swap themselves in at head with one atomic exchange, the
+	worker follows the next links from tail. The stub keeps the
+	queue from ever being empty of nodes.
+*/
+
+static void s_RADIO_SERVICE_push(radio_service* rs, radio_op* op) {
+	radio_op* prev;
+
+	atomic_store_explicit(&op->next, NULL, memory_order_relaxed);
+	prev = atomic_exchange_explicit(&rs->head, op, memory_order_acq_rel);
+	atomic_store_explicit(&prev->next, op, memory_order_release);
+}
+
+/*
+	Returns the oldest op, or NULL if the queue is empty or a
+	producer is half way through pushing; its semaphore post
+	will wake the worker again.
+*/
+static radio_op* s_RADIO_SERVICE_pop(radio_service* rs) {
+	radio_op* tail = rs->tail;
+	radio_op* next = atomic_load_explicit(&tail->next, memory_order_acquire);
+
+	if (tail == &rs->stub) {
+		if (!next) {
+			return NULL;
+		}
+		rs->tail = next;
+		tail = next;
+		next = atomic_load_explicit(&tail->next, memory_order_acquire);
+	}
+	if (next) {
+		rs->tail = next;
+		return tail;
+	}
+	if (tail != atomic_load_explicit(&rs->head, memory_order_acquire)) {
+		return NULL;
+	}
+
+	// tail is the last op, put the stub behind it so it can be taken
+	s_RADIO_SERVICE_push(rs, &rs->stub);
+	next = atomic_load_explicit(&tail->next, memory_order_acquire);
+	if (next) {
+		rs->tail = next;
+		return tail;
+	}
+	return NULL;
+}
+
+// Worker
+// ======
+
+static int s_RADIO_SERVICE_is_write(const radio_op* op) {
+	return op->type == RADIO_OP_WRITE || op->type == RADIO_OP_BURST_WRITE;
+}
+
+static int s_RADIO_SERVICE_is_read(const radio_op* op) {
+	return op->type == RADIO_OP_READ || op->type == RADIO_OP_BURST_READ;
+}
+
+static uint8_t s_RADIO_SERVICE_len(const radio_op* op) {
+	return (op->type == RADIO_OP_WRITE || op->type == RADIO_OP_READ) ? 1 : op->len;
+}
+
+static uint8_t* s_RADIO_SERVICE_bytes(radio_op* op) {
+	return (op->type == RADIO_OP_WRITE || op->type == RADIO_OP_READ) ? &op->value : op->data;
+}
+
+/*
+	Returns 1 if b may be merged onto the end of a. Both must
+	already be the same kind of register op.
+*/
+static int s_RADIO_SERVICE_adjacent(const radio_op* a, uint8_t a_len, const radio_op* b) {
+	return (a->rn >> 8) == (b->rn >> 8) &&
+	       (uint32_t)a->rn + a_len == b->rn &&
+	       a_len + s_RADIO_SERVICE_len(b) <= RADIO_SERVICE_MAX_BURST;
+}
+
+static int s_RADIO_SERVICE_overlap(const radio_op* a, const radio_op* b) {
+	return a->rn < b->rn + s_RADIO_SERVICE_len(b) && b->rn < a->rn + s_RADIO_SERVICE_len(a);
+}
+
+/*
+	Sorts batch[first..last) by register, unless two writes
+	touch the same register, in which case their order matters.
+*/
+static void s_RADIO_SERVICE_sort(radio_op** batch, int first, int last) {
+	int i, j;
+
+	if (s_RADIO_SERVICE_is_write(batch[first])) {
+		for (i = first; i < last; i++) {
+			for (j = i + 1; j < last; j++) {
+				if (s_RADIO_SERVICE_overlap(batch[i], batch[j])) {
+					return;
+				}
+			}
+		}
+	}
+
+	// insertion sort, stable and the runs are short
+	for (i = first + 1; i < last; i++) {
+		radio_op* op = batch[i];
+		for (j = i; j > first && batch[j - 1]->rn > op->rn; j--) {
+			batch[j] = batch[j - 1];
+		}
+		batch[j] = op;
+	}
+}
+
+/*
+	Carries out a single op on its own.
+*/
+static void s_RADIO_SERVICE_execute(radio_service* rs, radio_op* op) {
+	switch (op->type) {
+	case RADIO_OP_WRITE:
+		op->err = REGISTER_write(op->rn, op->value, &op->status);
+		break;
+	case RADIO_OP_READ:
+		op->err = REGISTER_read(op->rn, &op->value, &op->status);
+		break;
+	case RADIO_OP_BURST_WRITE:
+		op->err = REGISTER_burst_write(op->rn, op->data, op->len, &op->status);
+		break;
+	case RADIO_OP_BURST_READ:
+		op->err = REGISTER_burst_read(op->rn, op->data, op->len, &op->status);
+		break;
+	case RADIO_OP_STROBE:
+		op->err = STROBE_command_strobe(op->sn, &op->status);
+		break;
+	case RADIO_OP_RX_DEQUEUE:
+		op->err = RX_burst_dequeue(op->data, op->len, &op->received, &op->status);
+		break;
+	case RADIO_OP_TX_ENQUEUE:
+		op->err = TX_burst_enqueue(op->data, op->len, &op->status);
+		break;
+	default:
+		op->err = ERROR_PARAMETER_OUT_OF_RANGE;
+		break;
+	}
+	rs->transactions++;
+}
+
+/*
+	Carries out batch[first..last), neighbouring registers of the
+	same kind, as one burst.
+*/
+static void s_RADIO_SERVICE_execute_merged(radio_service* rs, radio_op** batch, int first, int last) {
+	uint8_t      buf[RADIO_SERVICE_MAX_BURST];
+	uint8_t      len = 0;
+	uint8_t      status = 0;
+	tcvr_error_t err;
+	int          i;
+
+	if (last - first == 1) {
+		s_RADIO_SERVICE_execute(rs, batch[first]);
+		return;
+	}
+
+	if (s_RADIO_SERVICE_is_write(batch[first])) {
+		for (i = first; i < last; i++) {
+			memcpy(buf + len, s_RADIO_SERVICE_bytes(batch[i]), s_RADIO_SERVICE_len(batch[i]));
+			len += s_RADIO_SERVICE_len(batch[i]);
+		}
+		err = REGISTER_burst_write(batch[first]->rn, buf, len, &status);
+	}
+	else {
+		for (i = first; i < last; i++) {
+			len += s_RADIO_SERVICE_len(batch[i]);
+		}
+		err = REGISTER_burst_read(batch[first]->rn, buf, len, &status);
+		len = 0;
+		for (i = first; i < last; i++) {
+			memcpy(s_RADIO_SERVICE_bytes(batch[i]), buf + len, s_RADIO_SERVICE_len(batch[i]));
+			len += s_RADIO_SERVICE_len(batch[i]);
+		}
+	}
+	rs->transactions++;
+
+	for (i = first; i < last; i++) {
+		batch[i]->err = err;
+		batch[i]->status = status;
+	}
+}
+
+static void s_RADIO_SERVICE_complete(radio_service* rs, radio_op* op) {
+	rs->ops++;
+
+	if (op->callback) {
+		radio_callback callback = op->callback;
+		void*          ctx = op->ctx;
+		atomic_store_explicit(&op->done, 1, memory_order_release);
+		callback(op, ctx);
+		return;
+	}
+
+	pthread_mutex_lock(&rs->done_mutex);
+	atomic_store_explicit(&op->done, 1, memory_order_release);
+	pthread_cond_broadcast(&rs->done_cond);
+	pthread_mutex_unlock(&rs->done_mutex);
+}
+
+static void s_RADIO_SERVICE_run_batch(radio_service* rs, radio_op** batch, int n) {
+	int i = 0;
+	int j, k;
+
+	while (i < n) {
+		radio_op* op = batch[i];
+		int       write = s_RADIO_SERVICE_is_write(op);
+
+		if (!write && !s_RADIO_SERVICE_is_read(op)) {
+			s_RADIO_SERVICE_execute(rs, op);
+			i++;
+			continue;
+		}
+
+		// run of the same kind of register op
+		j = i + 1;
+		while (j < n && (write ? s_RADIO_SERVICE_is_write(batch[j]) : s_RADIO_SERVICE_is_read(batch[j]))) {
+			j++;
+		}
+		s_RADIO_SERVICE_sort(batch, i, j);
+
+		// merge neighbours into bursts
+		while (i < j) {
+			uint8_t len = s_RADIO_SERVICE_len(batch[i]);
+			k = i + 1;
+			while (k < j && s_RADIO_SERVICE_adjacent(batch[i], len, batch[k])) {
+				len += s_RADIO_SERVICE_len(batch[k]);
+				k++;
+			}
+			s_RADIO_SERVICE_execute_merged(rs, batch, i, k);
+			i = k;
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		s_RADIO_SERVICE_complete(rs, batch[i]);
+	}
+}
+
+/*
+	Waits out a hold, unless the service is stopping, when
+	everything queued goes out regardless.
+*/
+static void s_RADIO_SERVICE_wait_hold(radio_service* rs) {
+	pthread_mutex_lock(&rs->hold_mutex);
+	while (rs->held && atomic_load_explicit(&rs->running, memory_order_acquire)) {
+		pthread_cond_wait(&rs->hold_cond, &rs->hold_mutex);
+	}
+	pthread_mutex_unlock(&rs->hold_mutex);
+}
+
+static void* s_RADIO_SERVICE_worker(void* arg) {
+	radio_service* rs = (radio_service*)arg;
+	radio_op*      batch[RADIO_SERVICE_BATCH];
+	int            n;
+
+	for (;;) {
+		sem_wait(&rs->pending);
+		s_RADIO_SERVICE_wait_hold(rs);
+
+		do {
+			n = 0;
+			while (n < RADIO_SERVICE_BATCH && (batch[n] = s_RADIO_SERVICE_pop(rs)) != NULL) {
+				n++;
+			}
+			s_RADIO_SERVICE_run_batch(rs, batch, n);
+		} while (n == RADIO_SERVICE_BATCH);
+
+		if (!atomic_load_explicit(&rs->running, memory_order_acquire) &&
+		    atomic_load_explicit(&rs->head, memory_order_acquire) == rs->tail) {
+			break;
+		}
+	}
+	return NULL;
+}
+
+// Publicly Exported Functions
+// ===========================
+
+tcvr_error_t RADIO_SERVICE_start(radio_service* rs) {
+	if (!rs) {
+		return ERROR_NULL_POINTER;
+	}
+
+	atomic_init(&rs->stub.next, NULL);
+	atomic_init(&rs->head, &rs->stub);
+	rs->tail = &rs->stub;
+	rs->ops = 0;
+	rs->transactions = 0;
+	rs->held = 0;
+	atomic_init(&rs->running, 1);
+
+	if (sem_init(&rs->pending, 0, 0) != 0) {
+		return ERROR_OUT_OF_MEMORY;
+	}
+	if (pthread_mutex_init(&rs->done_mutex, NULL) != 0) {
+		sem_destroy(&rs->pending);
+		return ERROR_OUT_OF_MEMORY;
+	}
+	if (pthread_cond_init(&rs->done_cond, NULL) != 0) {
+		pthread_mutex_destroy(&rs->done_mutex);
+		sem_destroy(&rs->pending);
+		return ERROR_OUT_OF_MEMORY;
+	}
+	if (pthread_mutex_init(&rs->hold_mutex, NULL) != 0) {
+		pthread_cond_destroy(&rs->done_cond);
+		pthread_mutex_destroy(&rs->done_mutex);
+		sem_destroy(&rs->pending);
+		return ERROR_OUT_OF_MEMORY;
+	}
+	if (pthread_cond_init(&rs->hold_cond, NULL) != 0) {
+		pthread_mutex_destroy(&rs->hold_mutex);
+		pthread_cond_destroy(&rs->done_cond);
+		pthread_mutex_destroy(&rs->done_mutex);
+		sem_destroy(&rs->pending);
+		return ERROR_OUT_OF_MEMORY;
+	}
+	if (pthread_create(&rs->worker, NULL, s_RADIO_SERVICE_worker, rs) != 0) {
+		pthread_cond_destroy(&rs->hold_cond);
+		pthread_mutex_destroy(&rs->hold_mutex);
+		pthread_cond_destroy(&rs->done_cond);
+		pthread_mutex_destroy(&rs->done_mutex);
+		sem_destroy(&rs->pending);
+		return ERROR_OUT_OF_MEMORY;
+	}
+	return ERROR_NONE;
+}
+
+tcvr_error_t RADIO_SERVICE_stop(radio_service* rs) {
+	if (!rs) {
+		return ERROR_NULL_POINTER;
+	}
+	if (!atomic_exchange(&rs->running, 0)) {
+		return ERROR_RADIO_SERVICE_STOPPED;
+	}
+
+	// a held worker lets go once it sees the service stopping
+	pthread_mutex_lock(&rs->hold_mutex);
+	pthread_cond_broadcast(&rs->hold_cond);
+	pthread_mutex_unlock(&rs->hold_mutex);
+	sem_post(&rs->pending);
+	pthread_join(rs->worker, NULL);
+
+	pthread_cond_destroy(&rs->hold_cond);
+	pthread_mutex_destroy(&rs->hold_mutex);
+	pthread_cond_destroy(&rs->done_cond);
+	pthread_mutex_destroy(&rs->done_mutex);
+	sem_destroy(&rs->pending);
+	return ERROR_NONE;
+}
+
+tcvr_error_t RADIO_SERVICE_submit(radio_service* rs, radio_op* op) {
+	if (!rs || !op) {
+		return ERROR_NULL_POINTER;
+	}
+	if (!atomic_load_explicit(&rs->running, memory_order_acquire)) {
+		return ERROR_RADIO_SERVICE_STOPPED;
+	}
+
+	atomic_store_explicit(&op->done, 0, memory_order_relaxed);
+	s_RADIO_SERVICE_push(rs, op);
+	sem_post(&rs->pending);
+	return ERROR_NONE;
+}
+
+tcvr_error_t RADIO_SERVICE_hold(radio_service* rs) {
+	if (!rs) {
+		return ERROR_NULL_POINTER;
+	}
+	if (!atomic_load_explicit(&rs->running, memory_order_acquire)) {
+		return ERROR_RADIO_SERVICE_STOPPED;
+	}
+
+	pthread_mutex_lock(&rs->hold_mutex);
+	rs->held++;
+	pthread_mutex_unlock(&rs->hold_mutex);
+	return ERROR_NONE;
+}
+
+tcvr_error_t RADIO_SERVICE_release(radio_service* rs) {
+	if (!rs) {
+		return ERROR_NULL_POINTER;
+	}
+	if (!atomic_load_explicit(&rs->running, memory_order_acquire)) {
+		return ERROR_RADIO_SERVICE_STOPPED;
+	}
+
+	pthread_mutex_lock(&rs->hold_mutex);
+	if (rs->held > 0 && --rs->held == 0) {
+		pthread_cond_broadcast(&rs->hold_cond);
+	}
+	pthread_mutex_unlock(&rs->hold_mutex);
+	return ERROR_NONE;
+}
+
+tcvr_error_t RADIO_SERVICE_wait(radio_service* rs, radio_op* op) {
+	if (!rs || !op) {
+		return ERROR_NULL_POINTER;
+	}
+
+	if (!atomic_load_explicit(&op->done, memory_order_acquire)) {
+		pthread_mutex_lock(&rs->done_mutex);
+		while (!atomic_load_explicit(&op->done, memory_order_acquire)) {
+			pthread_cond_wait(&rs->done_cond, &rs->done_mutex);
+		}
+		pthread_mutex_unlock(&rs->done_mutex);
+	}
+	return op->err;
+}
@@ -0,0 +1,145 @@
+#ifndef _RADIO_SERVICE_H_
+#define _RADIO_SERVICE_H_
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "error.h"
+#include "bang_registers.h"
+#include "strobe.h"
+
+/*
+	Asynchronous front end to bang_registers.h, strobe.h and rxtx.h.
+
+	One worker thread owns the bus. Any number of threads submit
+	operations to it through a lock-free queue and carry on; each
+	operation completes through its callback, run on the worker,
+	or is waited on with RADIO_SERVICE_wait.
+
+	The worker takes everything queued at once. Within a run of
+	register writes (or reads) with no strobe or FIFO access in
+	between, it sorts them by address and merges neighbouring
+	registers into single burst transactions, so a burst of small
+	writes from different threads costs one transaction. Writes
+	are only reordered if none of them overlap.
+
+	Operations live in the caller's memory, nothing is allocated,
+	and an operation must not be touched from submission until it
+	completes.
+*/
+
+// most operations taken from the queue at once
+#define RADIO_SERVICE_BATCH     32
+// longest burst built out of merged operations
+#define RADIO_SERVICE_MAX_BURST 64
+
+typedef enum radio_op_type_e {
+	RADIO_OP_WRITE = 0,   // REGISTER_write
+	RADIO_OP_READ,        // REGISTER_read
+	RADIO_OP_BURST_WRITE, // REGISTER_burst_write
+	RADIO_OP_BURST_READ,  // REGISTER_burst_read
+	RADIO_OP_STROBE,      // STROBE_command_strobe
+	RADIO_OP_RX_DEQUEUE,  // RX_burst_dequeue
+	RADIO_OP_TX_ENQUEUE   // TX_burst_enqueue
+} radio_op_type;
+
+typedef struct radio_op_s radio_op;
+
+/*
+	Runs on the worker thread once op has completed. It may
+	submit further operations, but must not wait on any.
+*/
+typedef void (*radio_callback)(radio_op* op, void* ctx);
+
+struct radio_op_s {
+	// request
+	radio_op_type  type;
+	register_name  rn;
+	strobe_name    sn;
+	uint8_t*       data;     // burst and FIFO operations, caller's buffer
+	uint8_t        len;      // bytes in data
+	uint8_t        value;    // written by RADIO_OP_WRITE, read by RADIO_OP_READ
+	radio_callback callback; // NULL to use RADIO_SERVICE_wait
+	void*          ctx;
+
+	// result
+	tcvr_error_t   err;
+	uint8_t        status;   // chip status
+	uint8_t        received; // bytes actually dequeued by RADIO_OP_RX_DEQUEUE
+	atomic_int     done;
+
+	// queue link
+	_Atomic(radio_op*) next;
+};
+
+typedef struct radio_service_s {
+	pthread_t          worker;
+	sem_t              pending;
+	_Atomic(radio_op*) head;     // producers push here
+	radio_op*          tail;     // worker pops here
+	radio_op           stub;
+	atomic_int         running;
+	pthread_mutex_t    done_mutex;
+	pthread_cond_t     done_cond;
+	pthread_mutex_t    hold_mutex;
+	pthread_cond_t     hold_cond;
+	int                held;     // RADIO_SERVICE_hold depth
+
+	// worker only, read once stopped
+	unsigned long      ops;          // operations completed
+	unsigned long      transactions; // bus transactions used for them
+} radio_service;
+
+/*
+	Fill in an operation. They clear the callback, so set it
+	afterwards if wanted.
+*/
+void RADIO_OP_write(radio_op* op, register_name rn, uint8_t value);
+void RADIO_OP_read(radio_op* op, register_name rn);
+void RADIO_OP_burst_write(radio_op* op, register_name rn, uint8_t* data, uint8_t len);
+void RADIO_OP_burst_read(radio_op* op, register_name rn, uint8_t* data, uint8_t len);
+void RADIO_OP_strobe(radio_op* op, strobe_name sn);
+void RADIO_OP_rx_dequeue(radio_op* op, uint8_t* data, uint8_t len);
+void RADIO_OP_tx_enqueue(radio_op* op, uint8_t* data, uint8_t len);
+
+/*
+	Starts the worker thread.
+	Returns ERROR_NONE if successful.
+*/
+tcvr_error_t RADIO_SERVICE_start(radio_service* rs);
+
+/*
+	Completes everything already submitted, then stops the worker.
+	Nothing may be submitted while this runs.
+	Returns ERROR_NONE if successful.
+*/
+tcvr_error_t RADIO_SERVICE_stop(radio_service* rs);
+
+/*
+	Queues op for the worker. Safe from any thread, never blocks.
+	Returns ERROR_NONE if successful,
+	ERROR_RADIO_SERVICE_STOPPED if the worker is not running.
+*/
+tcvr_error_t RADIO_SERVICE_submit(radio_service* rs, radio_op* op);
+
+/*
+	Holds the worker off the queue until the matching
+	RADIO_SERVICE_release, so that everything submitted in between,
+	from any thread, is taken and merged as one batch (up to
+	RADIO_SERVICE_BATCH operations). Holds nest. Operations submitted
+	before the hold may already be on the bus.
+	Returns ERROR_NONE if successful,
+	ERROR_RADIO_SERVICE_STOPPED if the worker is not running.
+*/
+tcvr_error_t RADIO_SERVICE_hold(radio_service* rs);
+tcvr_error_t RADIO_SERVICE_release(radio_service* rs);
+
+/*
+	Blocks until op completes.
+	Returns op's error.
+*/
+tcvr_error_t RADIO_SERVICE_wait(radio_service* rs, radio_op* op);
+
+#endif
@@ -0,0 +1,196 @@
+
+#include <stdint.h>
+
+#include "error.h"
+#include "bang_registers.h"
+#include "strobe.h"
+#include "rate_plan.h"
+
+/*
+	symbol rate = (2^20 + SRATE_M) * 2^SRATE_E / 2^39 * fxosc
+	deviation   = (256 + DEV_M) * 2^DEV_E / 2^22 * fxosc
+	RX filter   = fxosc / (8 * 20 * BB_CIC_DECFACT)
+
+	Registers shared by every profile: DCFILT_CFG 0x1c,
+	PREAMBLE_CFG1 0x18 (4 bytes of 0xaa), PREAMBLE_CFG0 0x2a,
+	FREQ_IF_CFG 0x40, IQIC 0xc6, MDMCFG1 0x46, MDMCFG0 0x05.
+*/
+static const uint8_t s_RATE_PLAN_profiles[NUM_RATE_PROFILES][RATE_PROFILE_NUM_REGISTERS] = {
+	//  DEV_M  DEV_E  DCFILT PRE1   PRE0   IF     IQIC   CHANBW MDM1   MDM0   SR2    SR1    SR0
+	{   0x06,  0x09,  0x1c,  0x18,  0x2a,  0x40,  0xc6,  0x14,  0x46,  0x05,  0x43,  0xa9,  0x2a }, //  1200 b/s,  4 kHz dev,  10 kHz RX
+	{   0x06,  0x09,  0x1c,  0x18,  0x2a,  0x40,  0xc6,  0x14,  0x46,  0x05,  0x53,  0xa9,  0x2a }, //  2400 b/s,  4 kHz dev,  10 kHz RX
+	{   0x3b,  0x09,  0x1c,  0x18,  0x2a,  0x40,  0xc6,  0x0c,  0x46,  0x05,  0x63,  0xa9,  0x2a }, //  4800 b/s,  5 kHz dev,  17 kHz RX
+	{   0x3b,  0x0a,  0x1c,  0x18,  0x2a,  0x40,  0xc6,  0x08,  0x46,  0x05,  0x73,  0xa9,  0x2a }, //  9600 b/s, 10 kHz dev,  25 kHz RX
+	{   0x48,  0x0a,  0x1c,  0x18,  0x2a,  0x40,  0xc6,  0x05,  0x46,  0x05,  0x83,  0xa9,  0x2a }, // 19200 b/s, 10 kHz dev,  40 kHz RX
+	{   0x48,  0x0b,  0x1c,  0x18,  0x2a,  0x40,  0xc6,  0x02,  0x46,  0x05,  0x93,  0xa9,  0x2a }  // 38400 b/s, 20 kHz dev, 100 kHz RX
+};
+
+/*
+	What the modem registers were last set to, so a switch only
+	has to send the registers that change.
+*/
+static uint8_t      s_RATE_PLAN_shadow[RATE_PROFILE_NUM_REGISTERS];
+static int          s_RATE_PLAN_shadow_valid = 0;
+static rate_profile s_RATE_PLAN_current;
+
+static uint16_t s_RATE_PLAN_read_u16(const uint8_t* p) {
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t s_RATE_PLAN_read_u32(const uint8_t* p) {
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t s_RATE_PLAN_switch_time(const rate_plan* rp, uint16_t i) {
+	return rp->start + s_RATE_PLAN_read_u16(rp->switches + (uint32_t)i * RATE_PLAN_SWITCH_SIZE);
+}
+
+static rate_profile s_RATE_PLAN_switch_profile(const rate_plan* rp, uint16_t i) {
+	return (rate_profile)rp->switches[(uint32_t)i * RATE_PLAN_SWITCH_SIZE + 2];
+}
+
+tcvr_error_t RATE_PLAN_load(rate_plan* rp, const uint8_t* buf, uint16_t buf_len) {
+	const uint8_t* sw;
+	uint16_t       num_switches;
+	uint16_t       prev = 0;
+	uint16_t       i;
+
+	if (!rp || !buf) {
+		return ERROR_NULL_POINTER;
+	}
+	if (buf_len < RATE_PLAN_HEADER_SIZE) {
+		return ERROR_RATE_PLAN_MALFORMED;
+	}
+
+	num_switches = s_RATE_PLAN_read_u16(buf);
+	if (num_switches < 1 ||
+	    buf_len < RATE_PLAN_HEADER_SIZE + (uint32_t)num_switches * RATE_PLAN_SWITCH_SIZE) {
+		return ERROR_RATE_PLAN_MALFORMED;
+	}
+
+	// switches must be in time order and name real profiles
+	sw = buf + RATE_PLAN_HEADER_SIZE;
+	for (i = 0; i < num_switches; i++, sw += RATE_PLAN_SWITCH_SIZE) {
+		uint16_t offset = s_RATE_PLAN_read_u16(sw);
+		if (offset < prev || sw[2] >= NUM_RATE_PROFILES) {
+			return ERROR_RATE_PLAN_MALFORMED;
+		}
+		prev = offset;
+	}
+
+	rp->num_switches = num_switches;
+	rp->start = s_RATE_PLAN_read_u32(buf + 4);
+	rp->switches = buf + RATE_PLAN_HEADER_SIZE;
+	rp->next = 0;
+	return ERROR_NONE;
+}
+
+tcvr_error_t RATE_PLAN_next_time(const rate_plan* rp, uint32_t* t) {
+	if (!rp || !t) {
+		return ERROR_NULL_POINTER;
+	}
+	if (rp->next >= rp->num_switches) {
+		return ERROR_RATE_PLAN_FINISHED;
+	}
+
+	*t = s_RATE_PLAN_switch_time(rp, rp->next);
+	return ERROR_NONE;
+}
+
+tcvr_error_t RATE_PLAN_update(rate_plan* rp, uint32_t t, int resume_rx, uint8_t* status) {
+	tcvr_error_t err = ERROR_NONE;
+	uint16_t     due;
+
+	if (!rp) {
+		return ERROR_NULL_POINTER;
+	}
+
+	// find the last switch that is due, if we are late only it matters
+	due = rp->next;
+	while (due < rp->num_switches && s_RATE_PLAN_switch_time(rp, due) <= t) {
+		due++;
+	}
+	if (due == rp->next) {
+		return ERROR_NONE;
+	}
+	rp->next = due;
+
+	// the modem must not be demodulating while its registers change
+	err = STROBE_command_strobe(SIDLE, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	err = RATE_PLAN_set_profile(s_RATE_PLAN_switch_profile(rp, due - 1), status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	if (resume_rx) {
+		return STROBE_command_strobe(SRX, status);
+	}
+	return ERROR_NONE;
+}
+
+tcvr_error_t RATE_PLAN_set_profile(rate_profile prof, uint8_t* status) {
+	tcvr_error_t   err = ERROR_NONE;
+	const uint8_t* regs;
+	uint8_t        first = 0;
+	uint8_t        last = RATE_PROFILE_NUM_REGISTERS - 1;
+	uint8_t        i;
+
+	if ((int)prof < 0 || prof >= NUM_RATE_PROFILES) {
+		return ERROR_PARAMETER_OUT_OF_RANGE;
+	}
+	regs = s_RATE_PLAN_profiles[prof];
+
+	// narrow down to the span of registers that change
+	if (s_RATE_PLAN_shadow_valid) {
+		while (first < RATE_PROFILE_NUM_REGISTERS && regs[first] == s_RATE_PLAN_shadow[first]) {
+			first++;
+		}
+		if (first == RATE_PROFILE_NUM_REGISTERS) {
+			s_RATE_PLAN_current = prof;
+			return ERROR_NONE;
+		}
+		while (regs[last] == s_RATE_PLAN_shadow[last]) {
+			last--;
+		}
+	}
+
+	// burst writes need at least two bytes
+	if (first == last) {
+		err = REGISTER_write((register_name)(DEVIATION_M + first), regs[first], status);
+	}
+	else {
+		err = REGISTER_burst_write((register_name)(DEVIATION_M + first), (uint8_t*)&regs[first], last - first + 1, status);
+	}
+	if (err != ERROR_NONE) {
+		// no telling what made it to the chip
+		s_RATE_PLAN_shadow_valid = 0;
+		return err;
+	}
+
+	for (i = first; i <= last; i++) {
+		s_RATE_PLAN_shadow[i] = regs[i];
+	}
+	s_RATE_PLAN_shadow_valid = 1;
+	s_RATE_PLAN_current = prof;
+	return ERROR_NONE;
+}
+
+tcvr_error_t RATE_PLAN_current_profile(rate_profile* prof) {
+	if (!prof) {
+		return ERROR_NULL_POINTER;
+	}
+	if (!s_RATE_PLAN_shadow_valid) {
+		return ERROR_RATE_PLAN_PROFILE_UNKNOWN;
+	}
+
+	*prof = s_RATE_PLAN_current;
+	return ERROR_NONE;
+}
+
+void RATE_PLAN_forget_profile(void) {
+	s_RATE_PLAN_shadow_valid = 0;
+}
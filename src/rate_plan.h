@@ -0,0 +1,101 @@
+#ifndef _RATE_PLAN_H_
+#define _RATE_PLAN_H_
+
+#include <stdint.h>
+#include "error.h"
+
+/*
+	Data rate profiles, slowest first. Each one is a complete set
+	of modem registers, DEVIATION_M through SYMBOL_RATE0, for
+	2-GFSK with a 32 MHz crystal. The order matches LINK_RATES
+	in orbital/link_budget.h, so the ground can plan with rate
+	indices directly.
+*/
+typedef enum rate_profile_e {
+	RATE_PROFILE_1200 = 0,
+	RATE_PROFILE_2400,
+	RATE_PROFILE_4800,
+	RATE_PROFILE_9600,
+	RATE_PROFILE_19200,
+	RATE_PROFILE_38400,
+	NUM_RATE_PROFILES
+} rate_profile;
+
+// DEVIATION_M through SYMBOL_RATE0
+#define RATE_PROFILE_NUM_REGISTERS 13
+
+/*
+	Plan of rate switches for one pass, generated on the ground
+	by orbital/rplan from the predicted link margin and uplinked.
+
+	Serialized plan, all fields little-endian:
+
+		offset  size  field
+		0       2     number of switches, >= 1
+		2       2     reserved, zero
+		4       4     time of the first switch, mission seconds
+		8       4*n   switches, each:
+		                uint16 seconds after the first switch,
+		                       never decreasing
+		                uint8  rate_profile
+		                uint8  reserved, zero
+*/
+#define RATE_PLAN_HEADER_SIZE 8
+#define RATE_PLAN_SWITCH_SIZE 4
+
+typedef struct rate_plan_s {
+	const uint8_t* switches;     // switches inside the caller's buffer
+	uint16_t       num_switches;
+	uint32_t       start;
+	uint16_t       next;         // first switch not yet applied
+} rate_plan;
+
+/*
+	Checks a serialized plan and points rp at it. The buffer
+	is not copied, so it must outlive rp.
+	Returns ERROR_NONE if successful.
+*/
+tcvr_error_t RATE_PLAN_load(rate_plan* rp, const uint8_t* buf, uint16_t buf_len);
+
+/*
+	Outputs the mission time of the next switch that has not
+	been applied, so the caller can set a timer for it.
+	Returns ERROR_NONE if successful,
+	ERROR_RATE_PLAN_FINISHED if every switch has been applied.
+*/
+tcvr_error_t RATE_PLAN_next_time(const rate_plan* rp, uint32_t* t);
+
+/*
+	Applies the latest switch due at mission time t, skipping any
+	earlier ones it supersedes. The radio is strobed to IDLE, the
+	profile written, and strobed back to RX if resume_rx is non-zero.
+	Does nothing if no switch is due.
+	Returns ERROR_NONE if successful.
+*/
+tcvr_error_t RATE_PLAN_update(rate_plan* rp, uint32_t t, int resume_rx, uint8_t* status);
+
+/*
+	Writes a profile's registers. Only the span of registers that
+	differ from the last profile written goes out, as one burst,
+	so switching between neighbouring profiles is a few bytes.
+	status is only read if a register was written.
+	Returns ERROR_NONE if successful.
+*/
+tcvr_error_t RATE_PLAN_set_profile(rate_profile prof, uint8_t* status);
+
+/*
+	Outputs the last profile written.
+	Returns ERROR_NONE if successful,
+	ERROR_RATE_PLAN_PROFILE_UNKNOWN if no profile has been written
+	since start up or RATE_PLAN_forget_profile.
+*/
+tcvr_error_t RATE_PLAN_current_profile(rate_profile* prof);
+
+/*
+	Forgets what is in the modem registers, so the next
+	RATE_PLAN_set_profile writes all of them. Call after a
+	chip reset.
+*/
+void RATE_PLAN_forget_profile(void);
+
+#endif
@@ -0,0 +1,386 @@
+
+#include <stdint.h>
+#include <string.h>
+
+#include "error.h"
+#include "reed_solomon.h"
+
+#define RS_GF_POLY 0x187
+#define RS_FCR     112  // first consecutive root, as a power of RS_PRIM
+#define RS_PRIM    11   // the generator's roots are spaced alpha^11 apart
+#define RS_A0      RS_N // log of zero
+
+static int     s_RS_ready = 0;
+static uint8_t s_RS_alpha_to[RS_N + 1];      // log to value
+static uint8_t s_RS_index_of[RS_N + 1];      // value to log
+static uint8_t s_RS_genpoly[RS_PARITY + 1];  // log form
+static int     s_RS_iprim;                   // 1/RS_PRIM, mod RS_N
+
+/*
+	Rows of the conventional to dual basis matrix (the CCSDS
+	"T alpha l" matrix).
+*/
+static const uint8_t s_RS_tal[8] = { 0x8d, 0xef, 0xec, 0x86, 0xfa, 0x99, 0xaf, 0x7b };
+static uint8_t s_RS_to_dual[256];
+static uint8_t s_RS_from_dual[256];
+
+static int s_RS_modnn(int x) {
+	while (x >= RS_N) {
+		x -= RS_N;
+		x = (x >> 8) + (x & RS_N);
+	}
+	return x;
+}
+
+static void s_RS_init(void) {
+	int i, j, sr, root;
+
+	sr = 1;
+	for (i = 0; i < RS_N; i++) {
+		s_RS_index_of[sr] = (uint8_t)i;
+		s_RS_alpha_to[i] = (uint8_t)sr;
+		sr <<= 1;
+		if (sr & 0x100) {
+			sr ^= RS_GF_POLY;
+		}
+	}
+	s_RS_index_of[0] = RS_A0;
+	s_RS_alpha_to[RS_A0] = 0;
+
+	// the product of (x - alpha^root) over the 32 roots
+	s_RS_genpoly[0] = 1;
+	for (i = 0, root = RS_FCR*RS_PRIM; i < RS_PARITY; i++, root += RS_PRIM) {
+		s_RS_genpoly[i + 1] = 1;
+		for (j = i; j > 0; j--) {
+			if (s_RS_genpoly[j] != 0) {
+				s_RS_genpoly[j] = s_RS_genpoly[j - 1] ^ s_RS_alpha_to[s_RS_modnn(s_RS_index_of[s_RS_genpoly[j]] + root)];
+			}
+			else {
+				s_RS_genpoly[j] = s_RS_genpoly[j - 1];
+			}
+		}
+		s_RS_genpoly[0] = s_RS_alpha_to[s_RS_modnn(s_RS_index_of[s_RS_genpoly[0]] + root)];
+	}
+	for (i = 0; i <= RS_PARITY; i++) {
+		s_RS_genpoly[i] = s_RS_index_of[s_RS_genpoly[i]];
+	}
+
+	for (s_RS_iprim = 1; (s_RS_iprim % RS_PRIM) != 0; s_RS_iprim += RS_N);
+	s_RS_iprim /= RS_PRIM;
+
+	for (i = 0; i < 256; i++) {
+		s_RS_to_dual[i] = 0;
+		for (j = 0; j < 8; j++) {
+			if (i & (1 << j)) {
+				s_RS_to_dual[i] ^= s_RS_tal[7 - j];
+			}
+		}
+		s_RS_from_dual[s_RS_to_dual[i]] = (uint8_t)i;
+	}
+
+	s_RS_ready = 1;
+}
+
+/*
+	Systematic encoding of one codeword, conventional basis: the
+	remainder of data times x^32 divided by the generator.
+*/
+static void s_RS_encode(const uint8_t* data, uint8_t* parity) {
+	int     i, j;
+	uint8_t feedback;
+
+	memset(parity, 0, RS_PARITY);
+	for (i = 0; i < RS_K; i++) {
+		feedback = s_RS_index_of[data[i] ^ parity[0]];
+		if (feedback != RS_A0) {
+			for (j = 1; j < RS_PARITY; j++) {
+				parity[j] ^= s_RS_alpha_to[s_RS_modnn(feedback + s_RS_genpoly[RS_PARITY - j])];
+			}
+		}
+		memmove(parity, parity + 1, RS_PARITY - 1);
+		parity[RS_PARITY - 1] = (feedback != RS_A0) ? s_RS_alpha_to[s_RS_modnn(feedback + s_RS_genpoly[0])] : 0;
+	}
+}
+
+/*
+	Corrects one codeword in place, conventional basis: syndromes,
+	Berlekamp-Massey for the error locator, Chien search for its
+	roots and Forney for the error values.
+	Returns the number of bytes corrected, or -1 if there were too
+	many to correct.
+*/
+static int s_RS_decode(uint8_t* cw) {
+	uint8_t lambda[RS_PARITY + 1], b[RS_PARITY + 1], t[RS_PARITY + 1];
+	uint8_t omega[RS_PARITY + 1], reg[RS_PARITY + 1];
+	uint8_t s[RS_PARITY], root[RS_PARITY], loc[RS_PARITY];
+	int     i, j, k, r, el, count;
+	int     deg_lambda, deg_omega;
+	uint8_t q, tmp, num1, num2, den, discr;
+	int     error = 0;
+
+	for (i = 0; i < RS_PARITY; i++) {
+		s[i] = cw[0];
+	}
+	for (j = 1; j < RS_N; j++) {
+		for (i = 0; i < RS_PARITY; i++) {
+			if (s[i] == 0) {
+				s[i] = cw[j];
+			}
+			else {
+				s[i] = cw[j] ^ s_RS_alpha_to[s_RS_modnn(s_RS_index_of[s[i]] + (RS_FCR + i)*RS_PRIM)];
+			}
+		}
+	}
+	for (i = 0; i < RS_PARITY; i++) {
+		error |= s[i];
+		s[i] = s_RS_index_of[s[i]];
+	}
+	if (!error) {
+		return 0;
+	}
+
+	memset(lambda + 1, 0, RS_PARITY);
+	lambda[0] = 1;
+	for (i = 0; i <= RS_PARITY; i++) {
+		b[i] = s_RS_index_of[lambda[i]];
+	}
+
+	el = 0;
+	for (r = 1; r <= RS_PARITY; r++) {
+		tmp = 0;
+		for (i = 0; i < r; i++) {
+			if (lambda[i] != 0 && s[r - i - 1] != RS_A0) {
+				tmp ^= s_RS_alpha_to[s_RS_modnn(s_RS_index_of[lambda[i]] + s[r - i - 1])];
+			}
+		}
+		discr = s_RS_index_of[tmp];
+
+		if (discr == RS_A0) {
+			memmove(b + 1, b, RS_PARITY);
+			b[0] = RS_A0;
+			continue;
+		}
+
+		t[0] = lambda[0];
+		for (i = 0; i < RS_PARITY; i++) {
+			if (b[i] != RS_A0) {
+				t[i + 1] = lambda[i + 1] ^ s_RS_alpha_to[s_RS_modnn(discr + b[i])];
+			}
+			else {
+				t[i + 1] = lambda[i + 1];
+			}
+		}
+		if (2*el <= r - 1) {
+			el = r - el;
+			for (i = 0; i <= RS_PARITY; i++) {
+				b[i] = (lambda[i] == 0) ? RS_A0 : (uint8_t)s_RS_modnn(s_RS_index_of[lambda[i]] - discr + RS_N);
+			}
+		}
+		else {
+			memmove(b + 1, b, RS_PARITY);
+			b[0] = RS_A0;
+		}
+		memcpy(lambda, t, RS_PARITY + 1);
+	}
+
+	deg_lambda = 0;
+	for (i = 0; i <= RS_PARITY; i++) {
+		lambda[i] = s_RS_index_of[lambda[i]];
+		if (lambda[i] != RS_A0) {
+			deg_lambda = i;
+		}
+	}
+
+	memcpy(reg + 1, lambda + 1, RS_PARITY);
+	count = 0;
+	for (i = 1, k = s_RS_iprim - 1; i <= RS_N; i++, k = s_RS_modnn(k + s_RS_iprim)) {
+		q = 1;
+		for (j = deg_lambda; j > 0; j--) {
+			if (reg[j] != RS_A0) {
+				reg[j] = (uint8_t)s_RS_modnn(reg[j] + j);
+				q ^= s_RS_alpha_to[reg[j]];
+			}
+		}
+		if (q != 0) {
+			continue;
+		}
+		root[count] = (uint8_t)i;
+		loc[count] = (uint8_t)k;
+		if (++count == deg_lambda) {
+			break;
+		}
+	}
+	if (deg_lambda != count) {
+		return -1;
+	}
+
+	deg_omega = deg_lambda - 1;
+	for (i = 0; i <= deg_omega; i++) {
+		tmp = 0;
+		for (j = i; j >= 0; j--) {
+			if (s[i - j] != RS_A0 && lambda[j] != RS_A0) {
+				tmp ^= s_RS_alpha_to[s_RS_modnn(s[i - j] + lambda[j])];
+			}
+		}
+		omega[i] = s_RS_index_of[tmp];
+	}
+
+	for (j = count - 1; j >= 0; j--) {
+		num1 = 0;
+		for (i = deg_omega; i >= 0; i--) {
+			if (omega[i] != RS_A0) {
+				num1 ^= s_RS_alpha_to[s_RS_modnn(omega[i] + i*root[j])];
+			}
+		}
+		num2 = s_RS_alpha_to[s_RS_modnn(root[j]*(RS_FCR - 1) + RS_N)];
+		den = 0;
+
+		// the formal derivative of lambda: its odd terms
+		for (i = ((deg_lambda < RS_PARITY - 1) ? deg_lambda : RS_PARITY - 1) & ~1; i >= 0; i -= 2) {
+			if (lambda[i + 1] != RS_A0) {
+				den ^= s_RS_alpha_to[s_RS_modnn(lambda[i + 1] + i*root[j])];
+			}
+		}
+		if (num1 != 0) {
+			cw[loc[j]] ^= s_RS_alpha_to[s_RS_modnn(s_RS_index_of[num1] + s_RS_index_of[num2] + RS_N - s_RS_index_of[den])];
+		}
+	}
+
+	return count;
+}
+
+tcvr_error_t RS_encode_block(uint8_t* block, uint8_t depth, uint8_t dual_basis) {
+	uint8_t cw[RS_N];
+	int     c, i;
+
+	if (!block) {
+		return ERROR_NULL_POINTER;
+	}
+	if (depth < 1 || depth > RS_MAX_DEPTH) {
+		return ERROR_FEC_BAD_DEPTH;
+	}
+	if (!s_RS_ready) {
+		s_RS_init();
+	}
+
+	for (c = 0; c < depth; c++) {
+		for (i = 0; i < RS_K; i++) {
+			cw[i] = block[c + depth*i];
+			if (dual_basis) {
+				cw[i] = s_RS_from_dual[cw[i]];
+			}
+		}
+		s_RS_encode(cw, cw + RS_K);
+		for (i = RS_K; i < RS_N; i++) {
+			block[c + depth*i] = dual_basis ? s_RS_to_dual[cw[i]] : cw[i];
+		}
+	}
+
+	return ERROR_NONE;
+}
+
+/*
+	Decodes each codeword of a codeblock in place.
+	Returns the number that couldn't be corrected.
+*/
+static int s_RS_decode_block(uint8_t* block, uint8_t depth, uint8_t dual_basis, uint32_t* corrected) {
+	uint8_t cw[RS_N];
+	int     failed = 0;
+	int     c, i, n;
+
+	*corrected = 0;
+	for (c = 0; c < depth; c++) {
+		for (i = 0; i < RS_N; i++) {
+			cw[i] = block[c + depth*i];
+			if (dual_basis) {
+				cw[i] = s_RS_from_dual[cw[i]];
+			}
+		}
+
+		n = s_RS_decode(cw);
+		if (n < 0) {
+			failed++;
+			continue;
+		}
+		if (n == 0) {
+			continue;
+		}
+
+		*corrected += n;
+		for (i = 0; i < RS_N; i++) {
+			block[c + depth*i] = dual_basis ? s_RS_to_dual[cw[i]] : cw[i];
+		}
+	}
+
+	return failed;
+}
+
+tcvr_error_t RS_decode_block(uint8_t* block, uint8_t depth, uint8_t dual_basis, uint32_t* corrected) {
+	uint32_t fixed;
+	int      failed;
+
+	if (!block) {
+		return ERROR_NULL_POINTER;
+	}
+	if (depth < 1 || depth > RS_MAX_DEPTH) {
+		return ERROR_FEC_BAD_DEPTH;
+	}
+	if (!s_RS_ready) {
+		s_RS_init();
+	}
+
+	failed = s_RS_decode_block(block, depth, dual_basis, &fixed);
+	if (corrected) {
+		*corrected = fixed;
+	}
+	return failed ? ERROR_FEC_UNCORRECTABLE : ERROR_NONE;
+}
+
+tcvr_error_t RS_stream_init(rs_stream* rs, uint8_t depth, uint8_t dual_basis) {
+	if (!rs) {
+		return ERROR_NULL_POINTER;
+	}
+	if (depth < 1 || depth > RS_MAX_DEPTH) {
+		return ERROR_FEC_BAD_DEPTH;
+	}
+
+	rs->fill = 0;
+	rs->depth = depth;
+	rs->dual_basis = dual_basis;
+	rs->corrected = 0;
+	rs->failed = 0;
+	return ERROR_NONE;
+}
+
+tcvr_error_t RS_stream_decode(rs_stream* rs, const uint8_t* chunk, uint32_t len, uint32_t* used, const uint8_t** data) {
+	uint32_t size, n, fixed;
+	int      failed;
+
+	if (!rs || !chunk || !used || !data) {
+		return ERROR_NULL_POINTER;
+	}
+	*data = NULL;
+
+	size = RS_BLOCK_SIZE(rs->depth);
+	n = size - rs->fill;
+	if (n > len) {
+		n = len;
+	}
+	memcpy(rs->block + rs->fill, chunk, n);
+	rs->fill += n;
+	*used = n;
+
+	if (rs->fill < size) {
+		return ERROR_NONE;
+	}
+	rs->fill = 0;
+
+	if (!s_RS_ready) {
+		s_RS_init();
+	}
+	failed = s_RS_decode_block(rs->block, rs->depth, rs->dual_basis, &fixed);
+	rs->corrected += fixed;
+	rs->failed += failed;
+	*data = rs->block;
+	return failed ? ERROR_FEC_UNCORRECTABLE : ERROR_NONE;
+}
@@ -0,0 +1,81 @@
+#ifndef _REED_SOLOMON_H_
+#define _REED_SOLOMON_H_
+
+#include <stdint.h>
+#include "error.h"
+
+/*
+	The CCSDS (255,223) Reed-Solomon code: 223 data bytes and 32
+	check bytes per codeword, correcting up to 16 bad bytes.
+	Field polynomial x^8 + x^7 + x^2 + x + 1, code generator roots
+	alpha^(11*j) for j = 112..143.
+
+	CCSDS sends the symbols in the dual basis. That is optional
+	here, so the same code can talk to decoders that use the
+	conventional basis.
+
+	Codewords are interleaved to depth I (1 to RS_MAX_DEPTH): a
+	codeblock is I codewords, byte k belonging to codeword k % I,
+	so a burst of up to 16*I bad bytes on air is still
+	correctable. The first I*223 bytes of a codeblock are the data
+	and the last I*32 the check bytes.
+*/
+#define RS_N          255
+#define RS_K          223
+#define RS_PARITY     (RS_N - RS_K)
+#define RS_MAX_DEPTH  8
+
+#define RS_BLOCK_SIZE(depth) (RS_N * (uint32_t)(depth))
+#define RS_DATA_SIZE(depth)  (RS_K * (uint32_t)(depth))
+
+/*
+	Receiving side, fed a chunk at a time as bytes are drained
+	from the RX FIFO. Each codeblock is decoded in place as soon
+	as its last byte is in.
+*/
+typedef struct rs_stream_s {
+	uint8_t  block[RS_N * RS_MAX_DEPTH];
+	uint16_t fill;        // bytes of the current codeblock received
+	uint8_t  depth;
+	uint8_t  dual_basis;
+	uint32_t corrected;   // bytes corrected, all blocks so far
+	uint32_t failed;      // codewords that couldn't be corrected
+} rs_stream;
+
+/*
+	Fills in the check bytes of the codeblock at block, whose first
+	RS_DATA_SIZE(depth) bytes are the data.
+	Returns ERROR_NONE if successful, ERROR_FEC_BAD_DEPTH if depth
+	is not 1 to RS_MAX_DEPTH.
+*/
+tcvr_error_t RS_encode_block(uint8_t* block, uint8_t depth, uint8_t dual_basis);
+
+/*
+	Corrects the codeblock at block in place. If corrected isn't
+	NULL, the number of bytes corrected is written to it.
+	Returns ERROR_NONE if successful, ERROR_FEC_UNCORRECTABLE if any
+	codeword had too many errors (the others are still corrected),
+	ERROR_FEC_BAD_DEPTH if depth is not 1 to RS_MAX_DEPTH.
+*/
+tcvr_error_t RS_decode_block(uint8_t* block, uint8_t depth, uint8_t dual_basis, uint32_t* corrected);
+
+/*
+	Starts a stream of codeblocks of the given depth.
+	Returns ERROR_NONE if successful, ERROR_FEC_BAD_DEPTH if depth
+	is not 1 to RS_MAX_DEPTH.
+*/
+tcvr_error_t RS_stream_init(rs_stream* rs, uint8_t depth, uint8_t dual_basis);
+
+/*
+	Takes up to len bytes of the received stream, stopping at the
+	end of a codeblock, and sets *used to the number taken. If a
+	codeblock was completed it is decoded and *data points at its
+	RS_DATA_SIZE(depth) data bytes (until the next call); otherwise
+	*data is NULL. Call again with whatever is left of the chunk.
+	Returns ERROR_NONE if successful, ERROR_FEC_UNCORRECTABLE if the
+	completed codeblock could not be entirely corrected (*data is
+	still set).
+*/
+tcvr_error_t RS_stream_decode(rs_stream* rs, const uint8_t* chunk, uint32_t len, uint32_t* used, const uint8_t** data);
+
+#endif
@@ -1,7 +1,13 @@
 
+#include <string.h>
+
 #include "error.h"
 #include "spi.h"
 #include "bang_registers.h"
+#include "strobe.h"
+#include "status_byte.h"
+#include "status_tracker.h"
+#include "stats.h"
 #include "rxtx.h"
 
 #define RXTX_RX SPI_READ
@@ -10,17 +16,241 @@
 #define STANDARD_FIFO_ADDRESS 0x3f
 #define DIRECT_FIFO_ADDRESS 0x3e
 
+// bytes read out of an errored RX FIFO, handed out before anything newer
+static uint8_t         s_RXTX_salvage[TRANSCEIVER_FIFO_SIZE];
+static uint8_t         s_RXTX_salvage_pos = 0;
+static uint8_t         s_RXTX_salvage_len = 0;
+
+static strobe_name     s_RXTX_rx_rearm = SRX;
+static strobe_name     s_RXTX_tx_rearm = SRX;
+static rxtx_fifo_stats s_RXTX_stats;
+
+/*
+	Bursts data_len bytes to or from the standard FIFO access,
+	no questions asked. Outputs the status byte.
+*/
+static void s_RXTX_fifo_burst(uint8_t rw, uint8_t* data_arr, uint8_t data_len, uint8_t* status) {
+	uint8_t addr = (rw | SPI_BURST) | STANDARD_FIFO_ADDRESS;
+	uint8_t byt;
+
+	SPI_start_transaction();
+
+	SPI_transfer_bytes(&addr, &byt, 1);
+	if (rw == RXTX_RX) {
+		SPI_transfer_bytes(0, data_arr, data_len);
+	}
+	else {
+		SPI_transfer_bytes(data_arr, 0, data_len);
+	}
+
+	SPI_stop_transaction();
+
+	if (status) {
+		*status = byt;
+	}
+}
+
+static int s_RXTX_fifo_error(uint8_t status_byte) {
+	chip_status cs = STATUS_get_chip_status(status_byte);
+
+	return STATUS_chip_is_ready(status_byte) && (cs == STATUS_RXFIFOERROR || cs == STATUS_TXFIFOERROR);
+}
+
+/*
+	The flush has been strobed; re-arms with sn. The re-arming
+	strobe's own status byte is the state the flush left, so it
+	doubles as the check that the error is gone.
+*/
+static tcvr_error_t s_RXTX_rearm(strobe_name sn, uint8_t* status) {
+	tcvr_error_t err;
+
+	err = STROBE_command_strobe(sn, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+	if (s_RXTX_fifo_error(*status)) {
+		s_RXTX_stats.rearm_failures++;
+	}
+	return ERROR_NONE;
+}
+
+static tcvr_error_t s_RXTX_recover_rx(uint8_t* status) {
+	tcvr_error_t    err;
+	status_tracker* st;
+	uint8_t         n;
+	uint8_t         room;
+
+	err = REGISTER_read(NUM_RX_BYTES, &n, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	// make room behind anything salvaged earlier and not yet dequeued
+	if (s_RXTX_salvage_pos > 0) {
+		memmove(s_RXTX_salvage, s_RXTX_salvage + s_RXTX_salvage_pos, s_RXTX_salvage_len - s_RXTX_salvage_pos);
+		s_RXTX_salvage_len -= s_RXTX_salvage_pos;
+		s_RXTX_salvage_pos = 0;
+	}
+	room = TRANSCEIVER_FIFO_SIZE - s_RXTX_salvage_len;
+	n = (n < room) ? n : room;
+
+	if (n > 0) {
+		s_RXTX_fifo_burst(RXTX_RX, s_RXTX_salvage + s_RXTX_salvage_len, n, status);
+		s_RXTX_salvage_len += n;
+		s_RXTX_stats.rx_salvaged += n;
+	}
+
+	err = STROBE_command_strobe(SFRX, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+	s_RXTX_stats.rx_errors++;
+	STATS_add(STATS_RX_FIFO_ERRORS, 1);
+
+	st = STATUS_TRACKER_attached();
+	if (st) {
+		st->rx_fifo_error = 0;
+	}
+	return s_RXTX_rearm(s_RXTX_rx_rearm, status);
+}
+
+static tcvr_error_t s_RXTX_recover_tx(uint8_t* status) {
+	tcvr_error_t    err;
+	status_tracker* st;
+	uint8_t         n;
+
+	// whatever is left is part of a frame that has already gone out broken
+	err = REGISTER_read(NUM_TX_BYTES, &n, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+	s_RXTX_stats.tx_flushed += n;
+
+	err = STROBE_command_strobe(SFTX, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+	s_RXTX_stats.tx_errors++;
+	STATS_add(STATS_TX_FIFO_ERRORS, 1);
+
+	st = STATUS_TRACKER_attached();
+	if (st) {
+		st->tx_fifo_error = 0;
+	}
+	return s_RXTX_rearm(s_RXTX_tx_rearm, status);
+}
+
+void RXTX_set_rearm(strobe_name rx_rearm, strobe_name tx_rearm) {
+	s_RXTX_rx_rearm = rx_rearm;
+	s_RXTX_tx_rearm = tx_rearm;
+}
+
+tcvr_error_t RXTX_recover(uint8_t status_byte, uint8_t* status) {
+	uint8_t byt = status_byte;
+
+	if (!status) {
+		status = &byt;
+	}
+	*status = status_byte;
+
+	if (!s_RXTX_fifo_error(status_byte)) {
+		return ERROR_NONE;
+	}
+	if (STATUS_get_chip_status(status_byte) == STATUS_RXFIFOERROR) {
+		return s_RXTX_recover_rx(status);
+	}
+	return s_RXTX_recover_tx(status);
+}
+
+void RXTX_get_fifo_stats(rxtx_fifo_stats* stats) {
+	if (stats) {
+		*stats = s_RXTX_stats;
+	}
+}
+
+uint8_t RXTX_salvage_pending(void) {
+	return s_RXTX_salvage_len - s_RXTX_salvage_pos;
+}
+
+/*
+	Hands out up to n salvaged bytes, data_arr may be NULL to
+	drop them. Returns the number handed out.
+*/
+static uint8_t s_RXTX_take_salvage(uint8_t* data_arr, uint8_t n) {
+	uint8_t pending = RXTX_salvage_pending();
+
+	n = (n < pending) ? n : pending;
+	if (data_arr) {
+		memcpy(data_arr, s_RXTX_salvage + s_RXTX_salvage_pos, n);
+	}
+	s_RXTX_salvage_pos += n;
+	if (s_RXTX_salvage_pos == s_RXTX_salvage_len) {
+		s_RXTX_salvage_pos = 0;
+		s_RXTX_salvage_len = 0;
+	}
+	return n;
+}
+
 tcvr_error_t RX_queue_len(uint8_t* len, uint8_t* status) {
-	return REGISTER_read(NUM_RX_BYTES, len, status);
+	tcvr_error_t err;
+	uint8_t      byt;
+	uint8_t      n;
+
+	err = REGISTER_read(NUM_RX_BYTES, &n, &byt);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+	if (s_RXTX_fifo_error(byt)) {
+		if (STATUS_get_chip_status(byt) == STATUS_RXFIFOERROR) {
+			n = 0; // all of it is salvaged now
+		}
+		err = RXTX_recover(byt, &byt);
+		if (err != ERROR_NONE) {
+			return err;
+		}
+	}
+	if (status) {
+		*status = byt;
+	}
+
+	if (len) {
+		*len = RXTX_salvage_pending() ? RXTX_salvage_pending() : n;
+	}
+	return ERROR_NONE;
 }
 
 tcvr_error_t TX_queue_len(uint8_t* len, uint8_t* status) {
-	return REGISTER_read(NUM_TX_BYTES, len, status);
+	tcvr_error_t err;
+	uint8_t      byt;
+	uint8_t      n;
+
+	err = REGISTER_read(NUM_TX_BYTES, &n, &byt);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+	if (s_RXTX_fifo_error(byt)) {
+		if (STATUS_get_chip_status(byt) == STATUS_TXFIFOERROR) {
+			n = 0; // flushed
+		}
+		err = RXTX_recover(byt, &byt);
+		if (err != ERROR_NONE) {
+			return err;
+		}
+	}
+	if (status) {
+		*status = byt;
+	}
+
+	if (len) {
+		*len = n;
+	}
+	return ERROR_NONE;
 }
 
-tcvr_error_t RX_dequeue(uint8_t* data, uint8_t* status) {
+static tcvr_error_t s_RX_dequeue(uint8_t* data, uint8_t* status) {
 	tcvr_error_t err = ERROR_NONE;
 	uint8_t      addr = 0;
+	uint8_t      reply;
 	uint8_t      byt;
 
 	// Check if the RX FIFO is empty
@@ -31,6 +261,10 @@ tcvr_error_t RX_dequeue(uint8_t* data, uint8_t* status) {
 	if (byt == 0) {
 		return ERROR_RXTX_DEQUEUING_FROM_EMPTY_RX_FIFO;
 	}
+	if (RXTX_salvage_pending()) {
+		s_RXTX_take_salvage(data, 1);
+		return ERROR_NONE;
+	}
 
 	// RX FIFO Address
 	addr = (RXTX_RX | SPI_SINGLE) | STANDARD_FIFO_ADDRESS;
@@ -38,22 +272,23 @@ tcvr_error_t RX_dequeue(uint8_t* data, uint8_t* status) {
 	SPI_start_transaction();
 
 	// Transfer address
-	byt = SPI_transfer_byte(addr);
-	if (status) {
-		*status = byt;
-	}
+	SPI_transfer_bytes(&addr, &reply, 1);
 
 	// Read dequeued byte
-	byt = SPI_transfer_byte(0);
+	SPI_transfer_bytes(0, &byt, 1);
+
+	SPI_stop_transaction();
+
+	if (status) {
+		*status = reply;
+	}
 	if (data) {
 		*data = byt;
 	}
-
-	SPI_stop_transaction();
 	return ERROR_NONE;
 }
 
-tcvr_error_t TX_enqueue(uint8_t data, uint8_t* status) {
+static tcvr_error_t s_TX_enqueue(uint8_t data, uint8_t* status) {
 	tcvr_error_t err = ERROR_NONE;
 	uint8_t      addr = 0;
 	uint8_t      byt;
@@ -73,24 +308,29 @@ tcvr_error_t TX_enqueue(uint8_t data, uint8_t* status) {
 	SPI_start_transaction();
 
 	// Transfer address
-	byt = SPI_transfer_byte(addr);
-	if (status) {
-		*status = byt;
-	}
+	SPI_transfer_bytes(&addr, &byt, 1);
 
 	// Enqueue byte
-	SPI_transfer_byte(data);
+	SPI_transfer_bytes(&data, 0, 1);
 
 	SPI_stop_transaction();
+
+	if (status) {
+		*status = byt;
+	}
 	return ERROR_NONE;
 }
 
-tcvr_error_t RX_burst_dequeue(uint8_t* data_arr, uint8_t bytes_requested,
-                              uint8_t* bytes_received, uint8_t* status) {
+static tcvr_error_t s_RX_burst_dequeue(uint8_t* data_arr, uint8_t bytes_requested,
+                                uint8_t* bytes_received, uint8_t* status) {
 	tcvr_error_t err = ERROR_NONE;
-	uint8_t      addr = 0;
 	uint8_t      rx_fifo_len;
-	uint8_t      i;
+	uint8_t      byt;
+
+	if (!bytes_received) {
+		return ERROR_NULL_POINTER;
+	}
+	*bytes_received = 0;
 
 	// Check RX FIFO num items enqueued
 	err = RX_queue_len(&rx_fifo_len, status);
@@ -100,41 +340,61 @@ tcvr_error_t RX_burst_dequeue(uint8_t* data_arr, uint8_t bytes_requested,
 	// Limit bytes_requested to amount actually in queue
 	bytes_requested = (rx_fifo_len < bytes_requested) ? rx_fifo_len : bytes_requested;
 
-	// RX FIFO Address
-	addr = (RXTX_RX | SPI_BURST) | STANDARD_FIFO_ADDRESS;
-
-	SPI_start_transaction();
+	// salvage first, and never across the gap behind it
+	if (RXTX_salvage_pending()) {
+		*bytes_received = s_RXTX_take_salvage(data_arr, bytes_requested);
+		return ERROR_NONE;
+	}
 
-	// Transfer address
-	i = SPI_transfer_byte(addr);
+	// data_arr may be NULL to simply drain the queue
+	s_RXTX_fifo_burst(RXTX_RX, data_arr, bytes_requested, &byt);
 	if (status) {
-		*status = i;
+		*status = byt;
 	}
+	*bytes_received = bytes_requested;
 
-	// Read dequeued bytes
-	if (data_arr) {
-		for (i = 0; i < bytes_requested; i++) {
-			data_arr[i] = SPI_transfer_byte(0);
-		}	
+	// overflowed since the length was read: what was read is good, salvage the rest
+	if (s_RXTX_fifo_error(byt)) {
+		return RXTX_recover(byt, status);
 	}
-	else { // simply drain queue, without outputting data
-		for (i = 0; i < bytes_requested; i++) {
-			SPI_transfer_byte(0);
-		}	
+	return ERROR_NONE;
+}
+
+static tcvr_error_t s_TX_burst_enqueue_unchecked(const uint8_t* data_arr, uint8_t data_len, uint8_t* status) {
+	tcvr_error_t err;
+	uint8_t      byt;
+	int          underflow;
+
+	if (!data_arr) {
+		return ERROR_NULL_POINTER;
 	}
 
-	SPI_stop_transaction();
+	s_RXTX_fifo_burst(RXTX_TX, (uint8_t*)data_arr, data_len, &byt);
+
+	if (s_RXTX_fifo_error(byt)) {
+		underflow = (STATUS_get_chip_status(byt) == STATUS_TXFIFOERROR);
+		err = RXTX_recover(byt, &byt);
+		if (err != ERROR_NONE) {
+			return err;
+		}
+		// the flush took this write with it, so write it once more
+		if (underflow) {
+			s_RXTX_fifo_burst(RXTX_TX, (uint8_t*)data_arr, data_len, &byt);
+			STATS_add(STATS_RETRIES, 1);
+		}
+	}
+	if (status) {
+		*status = byt;
+	}
 	return ERROR_NONE;
 }
 
-tcvr_error_t TX_burst_enqueue(uint8_t* data_arr, uint8_t data_len, uint8_t* status) {
+static tcvr_error_t s_TX_burst_enqueue(uint8_t* data_arr, uint8_t data_len, uint8_t* status) {
 	tcvr_error_t err = ERROR_NONE;
-	uint8_t      addr = 0;
 	uint8_t      tx_fifo_len;
-	uint8_t      i;
 
 	if (!data_arr) {
-		return 0;
+		return ERROR_NULL_POINTER;
 	}
 
 	// Check TX FIFO num items enqueued
@@ -146,23 +406,46 @@ tcvr_error_t TX_burst_enqueue(uint8_t* data_arr, uint8_t data_len, uint8_t* stat
 		return ERROR_RXTX_ENQUEUING_TO_FULL_TX_FIFO;
 	}
 
-	// TX FIFO Address
-	addr = (RXTX_TX | SPI_BURST) | STANDARD_FIFO_ADDRESS;
+	return s_TX_burst_enqueue_unchecked(data_arr, data_len, status);
+}
 
-	SPI_start_transaction();
+tcvr_error_t RX_dequeue(uint8_t* data, uint8_t* status) {
+	uint64_t     start = STATS_start();
+	tcvr_error_t err = s_RX_dequeue(data, status);
 
-	// Transfer address
-	i = SPI_transfer_byte(addr);
-	if (status) {
-		*status = i;
-	}
+	STATS_record(STATS_API_RX, start, err);
+	return err;
+}
 
-	// Enqueue bytes
-	for (i = 0; i < data_len; i++) {
-		SPI_transfer_byte(data_arr[i]);
-	}
+tcvr_error_t TX_enqueue(uint8_t data, uint8_t* status) {
+	uint64_t     start = STATS_start();
+	tcvr_error_t err = s_TX_enqueue(data, status);
 
-	SPI_stop_transaction();
-	return ERROR_NONE;
+	STATS_record(STATS_API_TX, start, err);
+	return err;
 }
 
+tcvr_error_t RX_burst_dequeue(uint8_t* data_arr, uint8_t bytes_requested,
+                              uint8_t* bytes_received, uint8_t* status) {
+	uint64_t     start = STATS_start();
+	tcvr_error_t err = s_RX_burst_dequeue(data_arr, bytes_requested, bytes_received, status);
+
+	STATS_record(STATS_API_RX, start, err);
+	return err;
+}
+
+tcvr_error_t TX_burst_enqueue(uint8_t* data_arr, uint8_t data_len, uint8_t* status) {
+	uint64_t     start = STATS_start();
+	tcvr_error_t err = s_TX_burst_enqueue(data_arr, data_len, status);
+
+	STATS_record(STATS_API_TX, start, err);
+	return err;
+}
+
+tcvr_error_t TX_burst_enqueue_unchecked(const uint8_t* data_arr, uint8_t data_len, uint8_t* status) {
+	uint64_t     start = STATS_start();
+	tcvr_error_t err = s_TX_burst_enqueue_unchecked(data_arr, data_len, status);
+
+	STATS_record(STATS_API_TX, start, err);
+	return err;
+}
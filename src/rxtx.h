@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include "error.h"
+#include "strobe.h"
 
 /*
 	There are two FIFOs on the transceiver chip,
@@ -14,9 +15,58 @@
 #define DIRECT_FIFO_ADDRESS 0x3e
 #define STANDARD_FIFO_ADDRESS 0x3f
 
+/*
+	FIFO errors (RX overflow, TX underflow) are recovered from
+	inside the driver, as soon as a FIFO call sees one in the
+	status byte: whatever can still be read from the RX FIFO is
+	salvaged, the FIFO is flushed (SFRX/SFTX) and the chip is
+	re-armed with the strobe set by RXTX_set_rearm. That takes a
+	fixed handful of SPI transactions, so a single overflow costs
+	at most the frame it happened in.
+
+	Salvaged RX bytes are handed out before anything received
+	after the recovery, and RX_queue_len counts only them until
+	they have all been dequeued, so a call never reads across
+	the gap the overflow left in the data.
+*/
+typedef struct rxtx_fifo_stats_s {
+	uint32_t rx_errors;       // RX FIFO errors recovered from
+	uint32_t tx_errors;       // TX FIFO errors recovered from
+	uint32_t rx_salvaged;     // bytes read out of an errored RX FIFO
+	uint32_t tx_flushed;      // bytes thrown away with an errored TX FIFO
+	uint32_t rearm_failures;  // recoveries that left the chip in a FIFO error
+} rxtx_fifo_stats;
+
+/*
+	Sets the strobes that re-arm the chip after each kind of FIFO
+	error; SIDLE leaves it in IDLE. The defaults are SRX for both,
+	back to listening.
+*/
+void RXTX_set_rearm(strobe_name rx_rearm, strobe_name tx_rearm);
+
+/*
+	Recovers from the FIFO error status_byte shows, if any, for
+	status bytes got outside the FIFO calls, eg. from a status
+	tracker or an SNOP. Outputs the status byte after recovery.
+	Returns ERROR_NONE if successful, or the error from the reads
+	and strobes.
+*/
+tcvr_error_t RXTX_recover(uint8_t status_byte, uint8_t* status);
+
+/*
+	Copies out the FIFO error counts.
+*/
+void RXTX_get_fifo_stats(rxtx_fifo_stats* stats);
+
+/*
+	Returns the number of salvaged RX bytes not yet dequeued.
+*/
+uint8_t RXTX_salvage_pending(void);
+
 /*
 	Outputs number of bytes in RX FIFO and reads chip
-	status.
+	status. While salvaged bytes are pending, outputs
+	their number instead.
 	Returns 1 if successful, 0 otherwise.
 */
 tcvr_error_t RX_queue_len(uint8_t* len, uint8_t* status);
@@ -63,5 +113,13 @@ tcvr_error_t RX_burst_dequeue(uint8_t* data_arr, uint8_t bytes_requested, uint8_
 	Errors:   data_len must be <= TRANSCEIVER_FIFO_SIZE - current TX queue length.
 */
 tcvr_error_t TX_burst_enqueue(uint8_t* data_arr, uint8_t data_len, uint8_t* status);
+/*
+	The same, without first reading NUM_TX_BYTES, for callers that
+	already know how much room there is: one SPI transaction
+	instead of two.
+
+	Required: data_len must be <= TRANSCEIVER_FIFO_SIZE - current TX queue length.
+*/
+tcvr_error_t TX_burst_enqueue_unchecked(const uint8_t* data_arr, uint8_t data_len, uint8_t* status);
 
 #endif
@@ -0,0 +1,275 @@
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+#include <linux/spi/spidev.h>
+
+#include "../error.h"
+#include "../gpio.h"
+#include "../spi.h"
+#include "../bang_registers.h"
+#include "../strobe.h"
+#include "../linux_bus.h"
+
+/*
+	linux_bus.c against a fake kernel: the system calls it makes
+	through its linux_bus_io are recorded here, and each SPI
+	message is answered with its own byte offsets, so a read shows
+	which byte of the message it came from. It provides spi.h and
+	gpio.h itself, so it can't share an executable with the
+	simulated pins.
+*/
+
+#define FAKE_SPI_FD   3
+#define FAKE_CHIP_FD  4
+#define FAKE_CSN_FD   5
+#define FAKE_READY_FD 6
+
+#define FAKE_CSN_LINE   17
+#define FAKE_READY_LINE 27
+
+#define FAKE_MAX_MESSAGES 8
+
+typedef struct fake_message_s {
+	uint32_t transfers;
+	uint32_t len[LINUX_BUS_MAX_TRANSFERS];
+	uint8_t  cs_change[LINUX_BUS_MAX_TRANSFERS];
+	uint8_t  first_tx;  // the first byte clocked out, eg. the address
+	uint8_t  csn;       // the CSn line while it went out
+} fake_message;
+
+static fake_message messages[FAKE_MAX_MESSAGES];
+static uint32_t     num_messages;
+static uint8_t      spi_mode;
+static uint8_t      csn_level;
+static uint32_t     csn_edges;
+static uint32_t     ready_busy_reads; // SO reads still high before the chip is ready
+static uint32_t     ready_reads;
+static uint32_t     closes;
+
+static void s_fake_reset(void) {
+	memset(messages, 0, sizeof(messages));
+	num_messages = 0;
+	spi_mode = 0;
+	csn_level = 1;
+	csn_edges = 0;
+	ready_busy_reads = 0;
+	ready_reads = 0;
+	closes = 0;
+}
+
+static int s_fake_open(const char* path, int flags) {
+	if (strcmp(path, "/dev/spidev0.0") == 0) {
+		return FAKE_SPI_FD;
+	}
+	if (strcmp(path, "/dev/gpiochip0") == 0) {
+		return FAKE_CHIP_FD;
+	}
+	return -1;
+}
+
+static int s_fake_close(int fd) {
+	closes++;
+	return 0;
+}
+
+static int s_fake_spi_message(unsigned long request, struct spi_ioc_transfer* xfers) {
+	fake_message* m;
+	uint32_t      n = _IOC_SIZE(request) / sizeof(struct spi_ioc_transfer);
+	uint32_t      offset = 0;
+	uint32_t      i, j;
+
+	if (num_messages == FAKE_MAX_MESSAGES || n == 0 || n > LINUX_BUS_MAX_TRANSFERS) {
+		return -1;
+	}
+	m = &messages[num_messages++];
+	m->transfers = n;
+	m->csn = csn_level;
+	for (i = 0; i < n; i++) {
+		m->len[i] = xfers[i].len;
+		m->cs_change[i] = xfers[i].cs_change;
+		if (offset == 0 && xfers[i].len > 0 && xfers[i].tx_buf) {
+			m->first_tx = *(const uint8_t*)(uintptr_t)xfers[i].tx_buf;
+		}
+		for (j = 0; j < xfers[i].len; j++, offset++) {
+			if (xfers[i].rx_buf) {
+				((uint8_t*)(uintptr_t)xfers[i].rx_buf)[j] = (uint8_t)offset;
+			}
+		}
+	}
+	return (int)offset;
+}
+
+static int s_fake_ioctl(int fd, unsigned long request, void* arg) {
+	struct gpio_v2_line_request* req;
+	struct gpio_v2_line_values*  lv;
+
+	if (fd == FAKE_SPI_FD) {
+		if (request == SPI_IOC_WR_MODE) {
+			spi_mode = *(uint8_t*)arg;
+			return 0;
+		}
+		if (request == SPI_IOC_WR_BITS_PER_WORD || request == SPI_IOC_WR_MAX_SPEED_HZ) {
+			return 0;
+		}
+		if (_IOC_TYPE(request) == SPI_IOC_MAGIC && _IOC_NR(request) == 0) {
+			return s_fake_spi_message(request, (struct spi_ioc_transfer*)arg);
+		}
+		return -1;
+	}
+
+	if (fd == FAKE_CHIP_FD && request == GPIO_V2_GET_LINE_IOCTL) {
+		req = (struct gpio_v2_line_request*)arg;
+		if (req->num_lines != 1) {
+			return -1;
+		}
+		if (req->offsets[0] == FAKE_CSN_LINE && (req->config.flags & GPIO_V2_LINE_FLAG_OUTPUT)) {
+			req->fd = FAKE_CSN_FD;
+			return 0;
+		}
+		if (req->offsets[0] == FAKE_READY_LINE && (req->config.flags & GPIO_V2_LINE_FLAG_INPUT)) {
+			req->fd = FAKE_READY_FD;
+			return 0;
+		}
+		return -1;
+	}
+
+	lv = (struct gpio_v2_line_values*)arg;
+	if (fd == FAKE_CSN_FD && request == GPIO_V2_LINE_SET_VALUES_IOCTL) {
+		if ((uint8_t)(lv->bits & 1) != csn_level) {
+			csn_edges++;
+		}
+		csn_level = (uint8_t)(lv->bits & 1);
+		return 0;
+	}
+	if (fd == FAKE_READY_FD && request == GPIO_V2_LINE_GET_VALUES_IOCTL) {
+		// SO stays high for a couple of reads after CSn goes low
+		ready_reads++;
+		lv->bits = (ready_busy_reads > 0) ? 1 : 0;
+		if (ready_busy_reads > 0) {
+			ready_busy_reads--;
+		}
+		return 0;
+	}
+	return -1;
+}
+
+static const linux_bus_io fake_io = { s_fake_open, s_fake_close, s_fake_ioctl };
+
+/*
+	spidev drives CSn: a transaction is one message, its address
+	and data in separate transfers, and CSn stays asserted across
+	the transfers of a message. A byte sent early is the one
+	place a transaction spans messages, with cs_change keeping
+	CSn asserted in between.
+*/
+static int s_spidev_csn_test(void) {
+	linux_bus_config cfg = { "/dev/spidev0.0", 4000000, NULL, -1, -1 };
+	linux_bus_stats  stats;
+	uint8_t          data[4];
+	uint8_t          byt;
+	uint8_t          status = 0xff;
+	uint32_t         i;
+
+	LINUX_BUS_close();
+	s_fake_reset();
+	if (LINUX_BUS_open(&cfg, &fake_io) != ERROR_NONE || (spi_mode & SPI_NO_CS)) {
+		return 0;
+	}
+
+	// standard space burst read: 1 address byte, then the 4 registers
+	if (REGISTER_burst_read(FS_CFG, data, sizeof(data), &status) != ERROR_NONE ||
+	    num_messages != 1 || messages[0].transfers != 2 ||
+	    messages[0].len[0] != 1 || messages[0].len[1] != sizeof(data) ||
+	    messages[0].cs_change[0] || messages[0].cs_change[1] ||
+	    messages[0].first_tx != (SPI_READ | SPI_BURST | (FS_CFG & 0x3f)) || status != 0) {
+		return 0;
+	}
+	for (i = 0; i < sizeof(data); i++) {
+		if (data[i] != 1 + i) {
+			return 0;
+		}
+	}
+
+	// extended space read: the 2 byte address, then the register
+	if (REGISTER_read(FREQ2, &byt, &status) != ERROR_NONE ||
+	    num_messages != 2 || messages[1].transfers != 2 ||
+	    messages[1].len[0] != 2 || messages[1].len[1] != 1 ||
+	    messages[1].cs_change[0] || messages[1].cs_change[1] || byt != 2) {
+		return 0;
+	}
+
+	// SRES sends its byte straight away and ends with an empty transfer
+	if (STROBE_command_strobe(SRES, &status) != ERROR_NONE || num_messages != 4 ||
+	    messages[2].transfers != 1 || messages[2].len[0] != 1 || !messages[2].cs_change[0] ||
+	    messages[3].transfers != 1 || messages[3].len[0] != 0 || messages[3].cs_change[0]) {
+		return 0;
+	}
+
+	LINUX_BUS_get_stats(&stats);
+	LINUX_BUS_close();
+	return stats.messages == 4 && stats.transfers == 6 && stats.failed == 0 && closes == 1;
+}
+
+/*
+	A GPIO line drives CSn: spidev is told to leave it alone, the
+	line goes low around each message and back high after, the
+	ready line is polled until SO goes low first, and an early
+	byte needs neither cs_change nor an empty message to let go.
+*/
+static int s_gpio_csn_test(void) {
+	linux_bus_config cfg = { "/dev/spidev0.0", 4000000, "/dev/gpiochip0", FAKE_CSN_LINE, FAKE_READY_LINE };
+	uint8_t          byt;
+	uint8_t          status = 0xff;
+
+	LINUX_BUS_close();
+	s_fake_reset();
+	if (LINUX_BUS_open(&cfg, &fake_io) != ERROR_NONE || !(spi_mode & SPI_NO_CS) || csn_level != 1) {
+		return 0;
+	}
+
+	ready_busy_reads = 2;
+	if (REGISTER_write(FS_CFG, 0x14, &status) != ERROR_NONE ||
+	    num_messages != 1 || messages[0].transfers != 2 || messages[0].csn != 0 ||
+	    csn_level != 1 || csn_edges != 2 || ready_reads < 3) {
+		return 0;
+	}
+
+	if (STROBE_command_strobe(SRES, &status) != ERROR_NONE || num_messages != 2 ||
+	    messages[1].transfers != 1 || messages[1].cs_change[0] || messages[1].csn != 0 ||
+	    csn_level != 1 || csn_edges != 4) {
+		return 0;
+	}
+
+	if (REGISTER_read(FREQ2, &byt, &status) != ERROR_NONE || num_messages != 3 ||
+	    messages[2].len[0] != 2 || messages[2].cs_change[1] || byt != 2) {
+		return 0;
+	}
+
+	LINUX_BUS_close();
+	return closes == 4;
+}
+
+int main(int argc, char** argv) {
+	printf("Beginning linux bus test with spidev driving CSn...\n");
+
+	if (s_spidev_csn_test()) {
+		printf("Each transaction went out as one message, split into address and data\n");
+	}
+	else {
+		printf("Linux bus spidev CSn test failed\n");
+	}
+
+	printf("Beginning linux bus test with a GPIO line driving CSn...\n");
+
+	if (s_gpio_csn_test()) {
+		printf("CSn went low around each message, after waiting for SO\n");
+	}
+	else {
+		printf("Linux bus GPIO CSn test failed\n");
+	}
+
+	return 0;
+}
@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <stdio.h>
+#include <pthread.h>
 
 #include "../error.h"
 #include "../bits.h"
@@ -11,15 +12,1304 @@
 #include "../status_byte.h"
 #include "../freq_synth_config.h"
 #include "../chip_reset.h"
+#include "../packet_ring.h"
+#include "../radio_service.h"
+#include "../crc.h"
+#include "../whitening.h"
+#include "../conv.h"
+#include "../reed_solomon.h"
+#include "../rxtx.h"
+#include "../ax25.h"
+#include "../tx_batch.h"
+#include "../power.h"
+#include "../clock.h"
+#include "../status_tracker.h"
+#include "../turnaround.h"
+#include "../stats.h"
+#include "../survey.h"
+#include "../doppler_table.h"
+#include "../afc.h"
+#include "../arq.h"
+#include "../compress.h"
+#include "sim_iface.h"
 
 #define FIFO_SIZE 128
 
 /*
-	This program doesn't do anything yet, but I'm hoping
-	to simulate IO by providing an alternate implementation
-	of gpio.h that would fill the rx and tx buffers,
-	and a simulated register file, so that I could test
-	that everything is working without having a physical chip.
+	Lookups between points round to the nearest step, even across
+	the widest FREQOFF swing over the longest step, and retuning
+	writes the word, negated for TX, to FREQOFF1/FREQOFF0.
+*/
+static int s_doppler_table_test(void) {
+	// 3 points 10 s apart from t = 100
+	static const uint8_t table[] = {
+		3, 0, 10, 0, 100, 0, 0, 0,
+		0x00, 0x00, 10, (uint8_t)-110,
+		0x64, 0x00, 30, (uint8_t)-100,
+		0x9c, 0xff, 20, (uint8_t)-105
+	};
+	// 2 points 65535 s apart, FREQOFF from -32768 to 32767
+	static const uint8_t wide[] = {
+		2, 0, 0xff, 0xff, 0, 0, 0, 0,
+		0x00, 0x80, 0, 0,
+		0xff, 0x7f, 0, 0
+	};
+	// its last point would be after mission time 2^32 - 1
+	static const uint8_t wraps[] = {
+		2, 0, 0x10, 0, 0xf8, 0xff, 0xff, 0xff,
+		0, 0, 0, 0,
+		0, 0, 0, 0
+	};
+	doppler_table dt;
+	doppler_point dp;
+	uint32_t      end;
+	uint8_t       freqoff[2];
+	uint8_t       status = 0xff;
+
+	if (DOPPLER_TABLE_load(&dt, wraps, sizeof(wraps)) != ERROR_DOPPLER_TABLE_MALFORMED ||
+	    DOPPLER_TABLE_load(&dt, table, sizeof(table) - 1) != ERROR_DOPPLER_TABLE_MALFORMED) {
+		return 0;
+	}
+
+	if (DOPPLER_TABLE_load(&dt, wide, sizeof(wide)) != ERROR_NONE ||
+	    DOPPLER_TABLE_lookup(&dt, 65534, &dp) != ERROR_NONE || dp.freqoff != 32766 ||
+	    DOPPLER_TABLE_lookup(&dt, 1, &dp) != ERROR_NONE || dp.freqoff != -32767 ||
+	    DOPPLER_TABLE_lookup(&dt, 32768, &dp) != ERROR_NONE || dp.freqoff != 0) {
+		return 0;
+	}
+
+	if (DOPPLER_TABLE_load(&dt, table, sizeof(table)) != ERROR_NONE ||
+	    DOPPLER_TABLE_end(&dt, &end) != ERROR_NONE || end != 120 ||
+	    DOPPLER_TABLE_lookup(&dt, 99, &dp) != ERROR_DOPPLER_TABLE_TIME_OUT_OF_RANGE ||
+	    DOPPLER_TABLE_lookup(&dt, 121, &dp) != ERROR_DOPPLER_TABLE_TIME_OUT_OF_RANGE) {
+		return 0;
+	}
+	if (DOPPLER_TABLE_lookup(&dt, 104, &dp) != ERROR_NONE ||
+	    dp.freqoff != 40 || dp.elevation != 18 || dp.rssi != -106) {
+		return 0;
+	}
+	if (DOPPLER_TABLE_lookup(&dt, 115, &dp) != ERROR_NONE || dp.freqoff != 0 || dp.elevation != 25 ||
+	    DOPPLER_TABLE_lookup(&dt, 120, &dp) != ERROR_NONE || dp.freqoff != -100) {
+		return 0;
+	}
+
+	if (DOPPLER_TABLE_retune(&dt, 110, 0, &status) != ERROR_NONE ||
+	    REGISTER_burst_read(FREQOFF1, freqoff, 2, &status) != ERROR_NONE ||
+	    freqoff[0] != 0x00 || freqoff[1] != 0x64) {
+		return 0;
+	}
+	if (DOPPLER_TABLE_retune(&dt, 110, 1, &status) != ERROR_NONE ||
+	    REGISTER_burst_read(FREQOFF1, freqoff, 2, &status) != ERROR_NONE ||
+	    freqoff[0] != 0xff || freqoff[1] != 0x9c ||
+	    DOPPLER_TABLE_retune(&dt, 130, 0, &status) != ERROR_DOPPLER_TABLE_TIME_OUT_OF_RANGE) {
+		return 0;
+	}
+
+	REGISTER_burst_write(FREQOFF1, (uint8_t[]){ 0, 0 }, 2, &status);
+	return 1;
+}
+
+#define RING_SLOTS     4
+#define RING_SLOT_SIZE 64
+
+static uint8_t rx_slab[PACKET_RING_SLAB_SIZE(RING_SLOTS, RING_SLOT_SIZE)];
+static uint8_t tx_slab[PACKET_RING_SLAB_SIZE(RING_SLOTS, RING_SLOT_SIZE)];
+static packet_ring rx_ring;
+static packet_ring tx_ring;
+
+/*
+	Frames "arrive" in the simulated RX FIFO, are drained into a
+	ring and checked in place, then copied into the TX ring and fed
+	out through the simulated TX FIFO. A length byte too long for
+	a slot loses its frame, even one arriving over two drains, but
+	not the frame after it.
+*/
+static int s_packet_ring_test(void) {
+	uint8_t  air[] = { 3, 'a', 'b', 'c', 0, 5, 'h', 'e', 'l', 'l', 'o' };
+	uint8_t  sent[sizeof(air)];
+	uint8_t  noise[RING_SLOT_SIZE + 20];
+	uint8_t  status = 0xff;
+	uint8_t  frames = 0;
+	uint8_t* frame;
+	uint8_t* out;
+	uint16_t len;
+	uint16_t count = 0;
+	uint16_t i;
+
+	PACKET_RING_init(&rx_ring, rx_slab, sizeof(rx_slab), RING_SLOTS, RING_SLOT_SIZE);
+	PACKET_RING_init(&tx_ring, tx_slab, sizeof(tx_slab), RING_SLOTS, RING_SLOT_SIZE);
+
+	SIM_inject_rx_fifo(air, sizeof(air), SIM_GPIO_get_driver());
+	if (PACKET_RING_rx_drain(&rx_ring, PACKET_RING_VARIABLE_LENGTH, &frames, &status) != ERROR_NONE || frames != 3) {
+		return 0;
+	}
+
+	while (PACKET_RING_begin_read(&rx_ring, &frame, &len) == ERROR_NONE) {
+		if (PACKET_RING_begin_write(&tx_ring, &out) != ERROR_NONE) {
+			return 0;
+		}
+		for (i = 0; i < len; i++) {
+			out[i] = frame[i];
+		}
+		PACKET_RING_end_write(&tx_ring, len);
+		PACKET_RING_end_read(&rx_ring);
+		count++;
+	}
+
+	if (PACKET_RING_tx_feed(&tx_ring, &frames, &status) != ERROR_NONE || frames != count) {
+		return 0;
+	}
+	if (SIM_take_tx_fifo(sent, sizeof(sent), SIM_GPIO_get_driver()) != sizeof(air) ||
+	    memcmp(air, sent, sizeof(air)) != 0) {
+		return 0;
+	}
+
+	memset(noise, 0xa5, sizeof(noise));
+	noise[0] = sizeof(noise) - 1;
+	SIM_inject_rx_fifo(noise, sizeof(noise) / 2, SIM_GPIO_get_driver());
+	if (PACKET_RING_rx_drain(&rx_ring, PACKET_RING_VARIABLE_LENGTH, &frames, &status) != ERROR_PACKET_RING_FRAME_TOO_LONG ||
+	    frames != 0) {
+		return 0;
+	}
+	SIM_inject_rx_fifo(noise + sizeof(noise) / 2, sizeof(noise) - sizeof(noise) / 2, SIM_GPIO_get_driver());
+	SIM_inject_rx_fifo(air + 5, sizeof(air) - 5, SIM_GPIO_get_driver());
+	if (PACKET_RING_rx_drain(&rx_ring, PACKET_RING_VARIABLE_LENGTH, &frames, &status) != ERROR_NONE || frames != 1 ||
+	    PACKET_RING_begin_read(&rx_ring, &frame, &len) != ERROR_NONE ||
+	    len != sizeof(air) - 5 || memcmp(frame, air + 5, len) != 0) {
+		return 0;
+	}
+	PACKET_RING_end_read(&rx_ring);
+	return 1;
+}
+
+#define RATE_REGISTERS 13
+
+static radio_service service;
+static radio_op      writes[RATE_REGISTERS];
+
+/*
+	Each thread queues writes to every other modem register,
+	without waiting on them.
+*/
+static void* s_radio_service_writer(void* arg) {
+	int i;
+
+	for (i = *(int*)arg; i < RATE_REGISTERS; i += 2) {
+		RADIO_OP_write(&writes[i], (register_name)(DEVIATION_M + i), (uint8_t)(0x40 + i));
+		RADIO_SERVICE_submit(&service, &writes[i]);
+	}
+	return NULL;
+}
+
+/*
+	Two threads write the modem registers through the radio
+	service while it is held, so the writes go out as one merged
+	burst, then they are read back in another.
+*/
+static int s_radio_service_test(void) {
+	pthread_t threads[2];
+	int       first[2] = { 0, 1 };
+	uint8_t   back[RATE_REGISTERS];
+	radio_op  read;
+	int       i;
+
+	if (RADIO_SERVICE_start(&service) != ERROR_NONE || RADIO_SERVICE_hold(&service) != ERROR_NONE) {
+		return 0;
+	}
+	for (i = 0; i < 2; i++) {
+		pthread_create(&threads[i], NULL, s_radio_service_writer, &first[i]);
+	}
+	for (i = 0; i < 2; i++) {
+		pthread_join(threads[i], NULL);
+	}
+	RADIO_SERVICE_release(&service);
+	for (i = 0; i < RATE_REGISTERS; i++) {
+		if (RADIO_SERVICE_wait(&service, &writes[i]) != ERROR_NONE) {
+			return 0;
+		}
+	}
+
+	RADIO_OP_burst_read(&read, DEVIATION_M, back, RATE_REGISTERS);
+	RADIO_SERVICE_submit(&service, &read);
+	if (RADIO_SERVICE_wait(&service, &read) != ERROR_NONE) {
+		return 0;
+	}
+	RADIO_SERVICE_stop(&service);
+
+	printf("%lu operations in %lu transactions\n", service.ops, service.transactions);
+	if (service.ops != RATE_REGISTERS + 1 || service.transactions != 2) {
+		return 0;
+	}
+	for (i = 0; i < RATE_REGISTERS; i++) {
+		if (back[i] != 0x40 + i) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+#define CRC_TEST_MAX_LEN 300
+
+/*
+	Check values for both CRCs, both CRCs with and without
+	carry-less multiply over every length it folds up to
+	CRC_TEST_MAX_LEN, whole and in two pieces, and a whitening
+	round trip.
+*/
+static int s_framing_test(void) {
+	uint8_t    check[] = "123456789";
+	uint8_t    frame[200];
+	uint8_t    bulk[CRC_TEST_MAX_LEN];
+	uint8_t    first[] = { 0xff, 0xe1, 0x1d, 0x9a, 0xed, 0x85 };
+	whitening  w;
+	uint16_t   fcs;
+	uint16_t   crc16;
+	uint32_t   crc32;
+	uint32_t   len;
+	int        clmul;
+	int        i;
+
+	for (clmul = 1; clmul >= 0; clmul--) {
+		CRC_use_clmul(clmul);
+		if (CRC16(check, 9) != 0x906e || CRC32(check, 9) != 0xcbf43926) {
+			return 0;
+		}
+	}
+
+	for (i = 0; i < CRC_TEST_MAX_LEN; i++) {
+		bulk[i] = (uint8_t)(i * 167 + 13);
+	}
+	for (len = 64; len <= CRC_TEST_MAX_LEN; len++) {
+		CRC_use_clmul(0);
+		crc16 = CRC16(bulk, len);
+		crc32 = CRC32(bulk, len);
+
+		// nothing to compare against if the CPU can't do it
+		if (!CRC_use_clmul(1)) {
+			break;
+		}
+		if (CRC16(bulk, len) != crc16 || CRC32(bulk, len) != crc32 ||
+		    CRC16_final(CRC16_update(CRC16_update(CRC16_INIT, bulk, 5), bulk + 5, len - 5)) != crc16 ||
+		    CRC32_final(CRC32_update(CRC32_update(CRC32_INIT, bulk, 5), bulk + 5, len - 5)) != crc32) {
+			return 0;
+		}
+	}
+	CRC_use_clmul(1);
+
+	for (i = 0; i < 198; i++) {
+		frame[i] = (uint8_t)i;
+	}
+	fcs = CRC16(frame, 198);
+	frame[198] = (uint8_t)(fcs & 0xff);
+	frame[199] = (uint8_t)(fcs >> 8);
+
+	WHITEN_reset(&w);
+	WHITEN_apply(&w, frame, sizeof(frame));
+	for (i = 0; i < (int)sizeof(first); i++) {
+		if ((frame[i] ^ i) != first[i]) {
+			return 0;
+		}
+	}
+	WHITEN_reset(&w);
+	WHITEN_apply(&w, frame, 50);
+	WHITEN_apply(&w, frame + 50, sizeof(frame) - 50);
+
+	return CRC16_check(frame, sizeof(frame)) == ERROR_NONE;
+}
+
+static conv_decoder viterbi;
+static rs_stream    rs_rx;
+
+static int s_fec_test(void) {
+	uint8_t        data[100], out[100];
+	uint8_t        coded[CONV_ENCODED_SIZE(100)];
+	uint8_t        block[RS_BLOCK_SIZE(2)];
+	conv_encoder   enc;
+	const uint8_t* decoded = NULL;
+	uint32_t       used, off, n;
+	tcvr_error_t   err;
+	int            simd;
+	int            i;
+
+	for (i = 0; i < (int)sizeof(data); i++) {
+		data[i] = (uint8_t)(i*7 + 3);
+	}
+	CONV_encoder_reset(&enc);
+	CONV_encode(&enc, data, 60, coded);
+	CONV_encode(&enc, data + 60, 40, coded + 120);
+	CONV_encode_flush(&enc, coded + 200);
+
+	// a flipped bit every 50, spread well apart
+	for (i = 0; i < (int)sizeof(coded)*8; i += 50) {
+		coded[i >> 3] ^= (uint8_t)(0x80 >> (i & 7));
+	}
+
+	for (simd = 1; simd >= 0; simd--) {
+		CONV_use_simd(simd);
+		CONV_decoder_reset(&viterbi);
+		for (off = 0; off < sizeof(coded); off += n) {
+			n = (sizeof(coded) - off < 37) ? sizeof(coded) - off : 37;
+			if (CONV_decode_update(&viterbi, coded + off, n) != ERROR_NONE) {
+				return 0;
+			}
+		}
+		if (CONV_decode_final(&viterbi, out, sizeof(out)) != ERROR_NONE ||
+		    memcmp(out, data, sizeof(data))) {
+			return 0;
+		}
+	}
+	CONV_use_simd(1);
+
+	for (i = 0; i < (int)RS_DATA_SIZE(2); i++) {
+		block[i] = (uint8_t)(i ^ 0x5a);
+	}
+	if (RS_encode_block(block, 2, 1) != ERROR_NONE) {
+		return 0;
+	}
+
+	// a burst of 32 bad bytes is 16 in each codeword
+	for (i = 300; i < 332; i++) {
+		block[i] ^= 0xa5;
+	}
+
+	RS_stream_init(&rs_rx, 2, 1);
+	for (off = 0; off < sizeof(block); off += used) {
+		n = (sizeof(block) - off < FIFO_SIZE) ? sizeof(block) - off : FIFO_SIZE;
+		err = RS_stream_decode(&rs_rx, block + off, n, &used, &decoded);
+		if (err != ERROR_NONE) {
+			return 0;
+		}
+	}
+	if (!decoded || rs_rx.corrected != 32) {
+		return 0;
+	}
+	for (i = 0; i < (int)RS_DATA_SIZE(2); i++) {
+		if (decoded[i] != (uint8_t)(i ^ 0x5a)) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+#define AX25_TEST_FRAME 60
+
+static ax25_decoder ax25_rx;
+static uint8_t      ax25_frame[256];
+static uint8_t      ax25_raw[TRANSCEIVER_FIFO_SIZE];
+
+/*
+	A frame with flag-like and all-ones bytes in it goes out three
+	times, the middle one with a bit flipped, and is decoded a
+	chunk at a time; then once more through the simulated RX FIFO.
+*/
+static int s_ax25_test(void) {
+	uint8_t  frame[AX25_TEST_FRAME];
+	uint8_t  air[3 * AX25_ENCODED_SIZE(AX25_TEST_FRAME)];
+	uint8_t  status = 0xff;
+	uint32_t enc, off, n, used;
+	uint16_t len;
+	int      good = 0;
+	int      i;
+
+	memcpy(frame, "\x9c\x94\x6e\xa0\x40\x40\xe0\x9c\x6e\x98\x8a\x9a\x40\x61\x03\xf0", 16);
+	for (i = 16; i < AX25_TEST_FRAME; i++) {
+		frame[i] = (i % 3) ? (uint8_t)(i * 11) : ((i & 1) ? 0xff : AX25_FLAG);
+	}
+
+	if (AX25_encode(frame, AX25_TEST_FRAME, air, AX25_ENCODED_SIZE(AX25_TEST_FRAME), &enc) != ERROR_NONE) {
+		return 0;
+	}
+	memcpy(air + enc, air, enc);
+	memcpy(air + 2*enc, air, enc);
+	air[enc + enc/2] ^= 0x10;
+
+	AX25_decoder_init(&ax25_rx, ax25_frame, sizeof(ax25_frame));
+	for (off = 0; off < 3*enc; off += used) {
+		n = (3*enc - off < 23) ? 3*enc - off : 23;
+		AX25_decode(&ax25_rx, air + off, n, &used, &len);
+		if (len) {
+			if (len != AX25_TEST_FRAME || memcmp(ax25_frame, frame, len)) {
+				return 0;
+			}
+			good++;
+		}
+	}
+	if (good != 2 || ax25_rx.bad_fcs != 1) {
+		return 0;
+	}
+
+	AX25_decoder_init(&ax25_rx, ax25_frame, sizeof(ax25_frame));
+	SIM_inject_rx_fifo(air, (uint8_t)enc, SIM_GPIO_get_driver());
+	if (AX25_rx_drain(&ax25_rx, ax25_raw, &len, &status) != ERROR_NONE) {
+		return 0;
+	}
+	return len == AX25_TEST_FRAME && memcmp(ax25_frame, frame, len) == 0;
+}
+
+static tx_batch batch;
+
+/*
+	Ten small frames go out in one burst once the threshold is
+	reached, then a lone frame goes out when the latency cap is.
+*/
+static int s_tx_batch_test(void) {
+	uint8_t  frame[9];
+	uint8_t  sent[FIFO_SIZE];
+	uint8_t  status = 0xff;
+	int      i, j;
+
+	TX_BATCH_init(&batch, 1, 100, 50);
+	for (i = 0; i < 10; i++) {
+		memset(frame, 'a' + i, sizeof(frame));
+		if (TX_BATCH_add(&batch, frame, sizeof(frame), (uint32_t)i, &status) != ERROR_NONE) {
+			return 0;
+		}
+	}
+	if (batch.bursts != 1 || batch.frames_sent != 10 || batch.len != 0) {
+		return 0;
+	}
+	if (SIM_take_tx_fifo(sent, sizeof(sent), SIM_GPIO_get_driver()) != 100) {
+		return 0;
+	}
+	for (i = 0; i < 10; i++) {
+		if (sent[10*i] != sizeof(frame)) {
+			return 0;
+		}
+		for (j = 1; j < 10; j++) {
+			if (sent[10*i + j] != 'a' + i) {
+				return 0;
+			}
+		}
+	}
+
+	TX_BATCH_add(&batch, frame, 3, 200, &status);
+	TX_BATCH_poll(&batch, 220, &status);
+	if (batch.bursts != 1) {
+		return 0;
+	}
+	TX_BATCH_poll(&batch, 250, &status);
+	return batch.bursts == 2 && SIM_take_tx_fifo(sent, sizeof(sent), SIM_GPIO_get_driver()) == 4;
+}
+
+static const contact_window contacts[] = { { 100, 400 }, { 5000, 5600 } };
+static power_manager        power;
+static status_tracker       power_tracker;
+
+// a clock that only moves when told to, or not at all
+static uint64_t test_clock_us;
+
+static uint64_t s_test_clock(void) {
+	return test_clock_us;
+}
+
+/*
+	Steps through the approach to a contact, the contact and the
+	gap after it, checking the state chosen, the eWOR registers
+	written and the time accounted to each state.
+*/
+static int s_power_test(void) {
+	uint8_t  wor[4];
+	uint8_t  rfend;
+	uint8_t  status = 0xff;
+	uint32_t latency, current, prev_current = 0xffffffff;
+	int      p;
+
+	for (p = 0; p < NUM_POWER_PROFILES; p++) {
+		if (POWER_profile_estimate((power_profile)p, &latency, &current) != ERROR_NONE || current >= prev_current) {
+			return 0;
+		}
+		prev_current = current;
+	}
+
+	POWER_init(&power, contacts, 2, XOSC_FREQUENCY_40_MHZ, 2, 30, 0);
+	POWER_set_profile(&power, POWER_PROFILE_SNIFF_BALANCED);
+
+	POWER_update(&power, 0, &status);
+	if (power.state != POWER_SLEEP) {
+		return 0;
+	}
+	POWER_update(&power, 75, &status);
+	if (power.state != POWER_XOFF) {
+		return 0;
+	}
+	POWER_update(&power, 98, &status);
+	if (power.state != POWER_IDLE) {
+		return 0;
+	}
+	POWER_update(&power, 100, &status);
+	if (power.state != POWER_WOR) {
+		return 0;
+	}
+
+	// 100 ms at 32 kHz, listening for 1/16 of it
+	REGISTER_burst_read(WOR_CFG1, wor, sizeof(wor), &status);
+	REGISTER_read(RFEND_CFG1, &rfend, &status);
+	if (((wor[2] << 8) | wor[3]) != 3200 || rfend != 0x03) {
+		return 0;
+	}
+
+	// the SRX's own status byte is still from IDLE, and is stale by
+	// the next update, so RX is sampled with an SNOP
+	STATUS_TRACKER_init(&power_tracker);
+	STATUS_TRACKER_attach(&power_tracker);
+	CLOCK_set_source(s_test_clock);
+	test_clock_us = 0;
+	POWER_set_profile(&power, POWER_PROFILE_ALWAYS_RX);
+	POWER_update(&power, 200, &status);
+	test_clock_us += 100000;
+	POWER_update(&power, 300, &status);
+	STATUS_TRACKER_attach(NULL);
+	CLOCK_set_source(NULL);
+	if (power.state != POWER_RX || STATUS_get_chip_status(status) != STATUS_RX) {
+		return 0;
+	}
+	POWER_update(&power, 400, &status);
+	if (power.state != POWER_SLEEP) {
+		return 0;
+	}
+
+	return power.time_in_state[POWER_SLEEP] == 75 && power.time_in_state[POWER_XOFF] == 23 &&
+	       power.time_in_state[POWER_IDLE] == 2 && power.time_in_state[POWER_WOR] == 100 &&
+	       power.time_in_state[POWER_RX] == 200 && power.time_in_status[STATUS_RX] == 100;
+}
+
+static status_tracker tracker;
+
+static int s_status_tracker_test(void) {
+	tcvr_error_t err;
+	uint8_t      status = 0xff;
+	uint8_t      reg;
+	uint32_t     seen;
+
+	STATUS_TRACKER_init(&tracker);
+	STATUS_TRACKER_attach(&tracker);
+	if (STATUS_TRACKER_attached() != &tracker) {
+		return 0;
+	}
+
+	// the strobe's own status byte is still from IDLE, so one SNOP is needed
+	STROBE_command_strobe(SRX, &status);
+	if (STATUS_TRACKER_wait_for_state(&tracker, STATUS_RX, 100000, &status) != ERROR_NONE ||
+	    tracker.polls != 1 || STATUS_get_chip_status(status) != STATUS_RX) {
+		return 0;
+	}
+
+	// any transaction brings a fresh status byte, so waiting again costs nothing
+	REGISTER_read(RFEND_CFG1, &reg, &status);
+	seen = tracker.status_bytes;
+	if (STATUS_TRACKER_wait_for_state(&tracker, STATUS_RX, 100000, &status) != ERROR_NONE ||
+	    tracker.status_bytes != seen || tracker.polls != 1 || !tracker.ready) {
+		return 0;
+	}
+
+	STROBE_command_strobe(SIDLE, &status);
+	if (STATUS_TRACKER_wait_for_state(&tracker, STATUS_TX, 1000, &status) != ERROR_STATUS_TIMEOUT ||
+	    tracker.state != STATUS_IDLE || tracker.transitions != 2) {
+		return 0;
+	}
+
+	// with the clock stopped, the SNOPs alone bound the wait
+	CLOCK_set_source(s_test_clock);
+	seen = tracker.polls;
+	err = STATUS_TRACKER_wait_for_state(&tracker, STATUS_TX, 1000, &status);
+	CLOCK_set_source(NULL);
+	if (err != ERROR_STATUS_TIMEOUT || tracker.polls - seen != 1000 / STATUS_TRACKER_STALE_US + 1) {
+		return 0;
+	}
+
+	STATUS_TRACKER_attach(NULL);
+	seen = tracker.status_bytes;
+	STROBE_command_strobe(SNOP, &status);
+	return STATUS_TRACKER_attached() == NULL && !tracker.attached && tracker.status_bytes == seen;
+}
+
+#define FIFO_TEST_FRAME 20
+#define FIFO_TEST_SLOTS 8
+
+static packet_ring fifo_ring;
+static uint8_t     fifo_slab[PACKET_RING_SLAB_SIZE(FIFO_TEST_SLOTS, 32)];
+
+/*
+	An RX overflow mid-frame: the six whole frames still in the
+	FIFO are salvaged, the one cut short is dropped, and frames
+	received after the recovery come through. Then a TX underflow
+	is flushed by the next enqueue.
+*/
+static int s_fifo_recovery_test(void) {
+	uint8_t         air[8*FIFO_TEST_FRAME];
+	uint8_t         sent[16];
+	uint8_t         status = 0xff;
+	uint8_t         frames = 0;
+	uint8_t         expect[] = { 0, 1, 2, 3, 4, 5, 7 };
+	uint8_t*        frame;
+	uint16_t        len;
+	rxtx_fifo_stats before, after;
+	uint16_t        i;
+
+	for (i = 0; i < sizeof(air); i++) {
+		air[i] = (uint8_t)(i / FIFO_TEST_FRAME);
+	}
+	RXTX_get_fifo_stats(&before);
+	PACKET_RING_init(&fifo_ring, fifo_slab, sizeof(fifo_slab), FIFO_TEST_SLOTS, 32);
+
+	// 128 of the first 140 bytes fit, frame 6 is cut short
+	STROBE_command_strobe(SRX, &status);
+	SIM_inject_rx_fifo(air, 7*FIFO_TEST_FRAME, SIM_GPIO_get_driver());
+	if (PACKET_RING_rx_drain(&fifo_ring, FIFO_TEST_FRAME, &frames, &status) != ERROR_NONE || frames != 6) {
+		return 0;
+	}
+	STROBE_command_strobe(SNOP, &status);
+	if (STATUS_get_chip_status(status) != STATUS_RX) {
+		return 0;
+	}
+
+	SIM_inject_rx_fifo(air + 7*FIFO_TEST_FRAME, FIFO_TEST_FRAME, SIM_GPIO_get_driver());
+	if (PACKET_RING_rx_drain(&fifo_ring, FIFO_TEST_FRAME, &frames, &status) != ERROR_NONE || frames != 1) {
+		return 0;
+	}
+	for (i = 0; i < sizeof(expect); i++) {
+		if (PACKET_RING_begin_read(&fifo_ring, &frame, &len) != ERROR_NONE ||
+		    len != FIFO_TEST_FRAME || frame[0] != expect[i] || frame[len - 1] != expect[i]) {
+			return 0;
+		}
+		PACKET_RING_end_read(&fifo_ring);
+	}
+
+	// the FIFO runs dry while transmitting
+	STROBE_command_strobe(SIDLE, &status);
+	STROBE_command_strobe(STX, &status);
+	TX_burst_enqueue(air, 4, &status);
+	SIM_take_tx_fifo(sent, sizeof(sent), SIM_GPIO_get_driver());
+	RXTX_set_rearm(SRX, SIDLE);
+	if (TX_burst_enqueue(air + 2*FIFO_TEST_FRAME, 8, &status) != ERROR_NONE ||
+	    SIM_take_tx_fifo(sent, sizeof(sent), SIM_GPIO_get_driver()) != 8 || sent[0] != 2) {
+		return 0;
+	}
+	RXTX_set_rearm(SRX, SRX);
+
+	RXTX_get_fifo_stats(&after);
+	STROBE_command_strobe(SIDLE, &status);
+	return after.rx_errors - before.rx_errors == 1 && after.rx_salvaged - before.rx_salvaged == TRANSCEIVER_FIFO_SIZE &&
+	       after.tx_errors - before.tx_errors == 1 && after.rearm_failures == before.rearm_failures;
+}
+
+static turnaround ta;
+
+/*
+	A frame scheduled a few milliseconds out is preloaded, parked
+	in FSTXON ahead of time and fired from there.
+*/
+static int s_turnaround_test(void) {
+	tcvr_error_t err;
+	uint8_t      frame[] = { 5, 'a', 'c', 'k', '0', '1' };
+	uint8_t      sent[sizeof(frame)];
+	uint8_t      reg;
+	uint8_t      status = 0xff;
+	uint64_t     at;
+
+	STROBE_command_strobe(SIDLE, &status);
+	if (TURNAROUND_init(&ta, 1000000, 2000, &status) != ERROR_NONE || ta.calibrations != 1) {
+		return 0;
+	}
+	REGISTER_read(SETTLING_CFG, &reg, &status);
+	if (reg & (BIT_4 | BIT_3)) {
+		return 0;
+	}
+
+	at = CLOCK_now_us() + 20000;
+	if (TURNAROUND_schedule(&ta, frame, sizeof(frame), at, &status) != ERROR_NONE ||
+	    TURNAROUND_schedule(&ta, frame, sizeof(frame), at, &status) != ERROR_TURNAROUND_BUSY) {
+		return 0;
+	}
+	while (ta.state != TURNAROUND_PARKED && CLOCK_now_us() < at) {
+		TURNAROUND_poll(&ta, &status);
+	}
+	STROBE_command_strobe(SNOP, &status);
+	if (ta.state != TURNAROUND_PARKED || STATUS_get_chip_status(status) != STATUS_FSTXON) {
+		return 0;
+	}
+
+	if (TURNAROUND_fire(&ta, &status) != ERROR_NONE || STATUS_get_chip_status(status) != STATUS_TX ||
+	    ta.fired != 1 || TURNAROUND_fire(&ta, &status) != ERROR_TURNAROUND_NOTHING_SCHEDULED) {
+		return 0;
+	}
+	if (SIM_take_tx_fifo(sent, sizeof(sent), SIM_GPIO_get_driver()) != sizeof(frame) || memcmp(sent, frame, sizeof(frame))) {
+		return 0;
+	}
+
+	// a stopped clock never gets to the time, so firing gives up parked
+	STROBE_command_strobe(SIDLE, &status);
+	CLOCK_set_source(s_test_clock);
+	test_clock_us = 0;
+	if (TURNAROUND_schedule(&ta, frame, sizeof(frame), 1000, &status) != ERROR_NONE ||
+	    TURNAROUND_fire(&ta, &status) != ERROR_TURNAROUND_CLOCK_STOPPED || ta.state != TURNAROUND_PARKED) {
+		CLOCK_set_source(NULL);
+		return 0;
+	}
+	test_clock_us = 1000;
+	err = TURNAROUND_fire(&ta, &status);
+	CLOCK_set_source(NULL);
+	if (err != ERROR_NONE || ta.fired != 2 || SIM_take_tx_fifo(sent, sizeof(sent), SIM_GPIO_get_driver()) != sizeof(frame)) {
+		return 0;
+	}
+
+	STROBE_command_strobe(SIDLE, &status);
+	STROBE_command_strobe(SFTX, &status);
+	return 1;
+}
+
+BITS_FIELD(TEST_FIELD, 5, 3)
+
+/*
+	FS_CFG's band and lock detector fields through the field
+	accessors, the older ms/ls bitfield calls and the compile
+	time constants must all agree.
+*/
+static int s_bitfield_test(void) {
+	uint8_t   status = 0xff;
+	uint8_t   reg;
+	uint8_t   field;
+	freq_band fb;
+	int       enabled;
+
+	REGISTER_write(FS_CFG, 0xa5, &status);
+	FREQCONFIG_set_band(FREQ_BAND_420_480, &status);
+	FREQCONFIG_set_out_of_lock_detector_enabled(0, &status);
+	REGISTER_read(FS_CFG, &reg, &status);
+	if (reg != 0xa4) {
+		return 0;
+	}
+	if (FREQCONFIG_read_band(&fb, &status) != ERROR_NONE || fb != FREQ_BAND_420_480 ||
+	    FREQCONFIG_read_out_of_lock_detector_enabled(&enabled, &status) != ERROR_NONE || enabled) {
+		return 0;
+	}
+
+	REGISTER_write_bitfield(FS_CFG, 0x6, BIT_5, BIT_3, &status);
+	REGISTER_read_field(FS_CFG, TEST_FIELD, &field, &status);
+	if (field != 0x6) {
+		return 0;
+	}
+	REGISTER_write_field(FS_CFG, TEST_FIELD, 0x3, &status);
+	REGISTER_read_bitfield(FS_CFG, BIT_3, BIT_5, &field, &status);
+
+	return field == 0x3 && BITS_bitfield_mask(BIT_5, BIT_3) == TEST_FIELD_MASK &&
+	       BITS_FIELD_CONST(TEST_FIELD, 7) == 0x38 && TEST_FIELD_set(0xff, 0) == 0xc7;
+}
+
+static stats_block stats;
+static char        stats_text[4096];
+
+/*
+	A known mix of calls must show up exactly in the counters and
+	histograms, and in the dumps.
+*/
+static int s_stats_test(void) {
+	uint8_t  status = 0xff;
+	uint8_t  reg;
+	uint8_t  wor[4];
+	uint32_t len;
+	int      i;
+
+	STATS_reset();
+	REGISTER_write(FS_CFG, 0x14, &status);
+	REGISTER_read(FS_CFG, &reg, &status);
+	REGISTER_burst_read(WOR_CFG1, wor, sizeof(wor), &status);
+	for (i = 0; i < 3; i++) {
+		STROBE_command_strobe(SNOP, &status);
+	}
+	REGISTER_read(0x0001, &reg, &status); // not a register we know
+	STATS_snapshot(&stats);
+
+	if (stats.counters[STATS_CSN_CYCLES] != 6 || stats.counters[STATS_BYTES] != 12 ||
+	    stats.strobes[SNOP - STROBE_ADDRESS_START] != 3 || stats.strobes[SRX - STROBE_ADDRESS_START] != 0) {
+		return 0;
+	}
+	if (stats.apis[STATS_API_REGISTER_READ].count != 2 || stats.apis[STATS_API_REGISTER_READ].errors != 1 ||
+	    stats.apis[STATS_API_REGISTER_WRITE].count != 1 || stats.apis[STATS_API_REGISTER_BURST_READ].count != 1 ||
+	    stats.apis[STATS_API_STROBE].count != 3 || stats.apis[STATS_API_RX].count != 0) {
+		return 0;
+	}
+	if (STATS_percentile(&stats.apis[STATS_API_STROBE], 0.5) > STATS_percentile(&stats.apis[STATS_API_STROBE], 0.99) ||
+	    STATS_percentile(&stats.apis[STATS_API_STROBE], 1.0) != stats.apis[STATS_API_STROBE].max_us) {
+		return 0;
+	}
+
+	if (STATS_format_json(&stats, stats_text, sizeof(stats_text), &len) != ERROR_NONE ||
+	    stats_text[0] != '{' || stats_text[len - 1] != '}' || !strstr(stats_text, "\"csn_cycles\":6,") ||
+	    !strstr(stats_text, "\"SNOP\":3}")) {
+		return 0;
+	}
+	if (STATS_format_text(&stats, stats_text, 32, &len) != ERROR_STATS_BUFFER_TOO_SMALL || len != 31) {
+		return 0;
+	}
+	return STATS_format_text(&stats, stats_text, sizeof(stats_text), &len) == ERROR_NONE && strstr(stats_text, "strobe");
+}
+
+#define SURVEY_TEST_CHANNELS 241 // 435-438 MHz at 12.5 kHz
+
+static survey         sv;
+static survey_channel sv_channels[SURVEY_TEST_CHANNELS];
+
+// two occupied channels, and a third just under the threshold
+static int8_t s_survey_rssi(uint32_t freq_word, void* ctx) {
+	survey_channel* channels = (survey_channel*)ctx;
+
+	if (freq_word == channels[40].freq_word || freq_word == channels[200].freq_word) {
+		return -70;
+	}
+	if (freq_word == channels[120].freq_word) {
+		return -101;
+	}
+	return SIM_NOISE_FLOOR_DBM;
+}
+
+// channel 0 never gets a valid RSSI
+static int8_t s_survey_rssi_stuck(uint32_t freq_word, void* ctx) {
+	survey_channel* channels = (survey_channel*)ctx;
+
+	return (freq_word == channels[0].freq_word) ? SIM_RSSI_NEVER_VALID : SIM_NOISE_FLOOR_DBM;
+}
+
+/*
+	Two sweeps over the band must find exactly the occupied
+	channels, and leave calibration as it was. With the clock
+	stopped a sample must still finish, and one whose RSSI never
+	becomes valid is counted as invalid.
+*/
+static int s_survey_test(void) {
+	uint8_t  status = 0xff;
+	uint8_t  settling = 0;
+	uint16_t quietest = 0;
+	int      i;
+
+	if (SURVEY_freq_word(435000000, XOSC_FREQUENCY_32_MHZ) != 0x6cc000 ||
+	    SURVEY_init(&sv, sv_channels, SURVEY_TEST_CHANNELS, 479000000, 12500, XOSC_FREQUENCY_32_MHZ) != ERROR_SURVEY_NO_BAND ||
+	    SURVEY_init(&sv, sv_channels, SURVEY_TEST_CHANNELS, 435000000, 12500, XOSC_FREQUENCY_32_MHZ) != ERROR_NONE ||
+	    SURVEY_quietest(&sv, &quietest) != ERROR_SURVEY_NO_SAMPLES) {
+		return 0;
+	}
+	SIM_set_rssi_source(s_survey_rssi, sv_channels, SIM_GPIO_get_driver());
+
+	REGISTER_write(SETTLING_CFG, 0x03, &status); // FS_AUTOCAL never
+	for (i = 0; i < 2; i++) {
+		if (SURVEY_sweep(&sv, &status) != ERROR_NONE) {
+			return 0;
+		}
+	}
+	SIM_set_rssi_source(0, 0, SIM_GPIO_get_driver());
+	REGISTER_read(SETTLING_CFG, &settling, &status);
+	if (settling != 0x03 || sv.sweeps != 2 || sv.invalid != 0) {
+		return 0;
+	}
+
+	for (i = 0; i < SURVEY_TEST_CHANNELS; i++) {
+		if (sv_channels[i].samples != 2 || sv_channels[i].busy != ((i == 40 || i == 200) ? 2 : 0)) {
+			return 0;
+		}
+	}
+	if (sv_channels[40].peak_dbm != -70 || sv_channels[120].total_dbm != -202 ||
+	    SURVEY_quietest(&sv, &quietest) != ERROR_NONE || quietest != 0) {
+		return 0;
+	}
+
+	CLOCK_set_source(s_test_clock);
+	test_clock_us = 0;
+	SIM_set_rssi_source(s_survey_rssi_stuck, sv_channels, SIM_GPIO_get_driver());
+	if (SURVEY_sample(&sv, 0, &status) != ERROR_NONE || sv.invalid != 1 || sv_channels[0].samples != 2 ||
+	    SURVEY_sample(&sv, 1, &status) != ERROR_NONE || sv.invalid != 1 || sv_channels[1].samples != 3) {
+		CLOCK_set_source(NULL);
+		SIM_set_rssi_source(0, 0, SIM_GPIO_get_driver());
+		return 0;
+	}
+	CLOCK_set_source(NULL);
+	SIM_set_rssi_source(0, 0, SIM_GPIO_get_driver());
+	return 1;
+}
+
+static afc_report afc_rep;
+
+/*
+	The loop must pull the tuning from the prediction onto where
+	the signal really is, ignore an outlier, and settle there
+	without rewriting FREQOFF.
+*/
+static int s_afc_test(void) {
+	// 2 points 60 s apart from t = 1000, both predicting FREQOFF 1000
+	static const uint8_t table[] = {
+		2, 0, 60, 0, 0xe8, 0x03, 0, 0,
+		0xe8, 0x03, 10, (uint8_t)-100,
+		0xe8, 0x03, 10, (uint8_t)-100
+	};
+	doppler_table dt;
+	afc           a;
+	stats_block   sb;
+	uint8_t       status = 0xff;
+	uint8_t       air = 0x55;
+	uint8_t       freqoff[2];
+	uint32_t      t;
+
+	if (DOPPLER_TABLE_load(&dt, table, sizeof(table)) != ERROR_NONE ||
+	    AFC_init(&a, &dt, 9, 500) != ERROR_PARAMETER_OUT_OF_RANGE ||
+	    AFC_init(&a, &dt, 2, 500) != ERROR_NONE || AFC_track(&a, 1000, &status) != ERROR_NONE) {
+		return 0;
+	}
+
+	// the prediction is 200 off
+	STATS_reset();
+	SIM_set_signal_offset(1200, SIM_GPIO_get_driver());
+	for (t = 1001; t <= 1030; t++) {
+		SIM_inject_rx_fifo(&air, 1, SIM_GPIO_get_driver());
+		if (AFC_update(&a, t, &status) != ERROR_NONE) {
+			return 0;
+		}
+		if (t == 1010) {
+			SIM_set_signal_offset(1200 + 2000, SIM_GPIO_get_driver());
+			SIM_inject_rx_fifo(&air, 1, SIM_GPIO_get_driver());
+			AFC_update(&a, t, &status);
+			SIM_set_signal_offset(1200, SIM_GPIO_get_driver());
+		}
+	}
+	STATS_snapshot(&sb);
+	SIM_set_signal_offset(0, SIM_GPIO_get_driver());
+	STROBE_command_strobe(SFRX, &status);
+
+	REGISTER_burst_read(FREQOFF1, freqoff, 2, &status);
+	AFC_report(&a, &afc_rep);
+	return ((freqoff[0] << 8) | freqoff[1]) == 1200 && afc_rep.updates == 30 && afc_rep.rejected == 1 &&
+	       afc_rep.correction == 200 && afc_rep.max_abs == 200 && afc_rep.writes < 30 &&
+	       sb.apis[STATS_API_REGISTER_WRITE].count > 0 &&
+	       sb.apis[STATS_API_REGISTER_WRITE].count + sb.apis[STATS_API_REGISTER_BURST_WRITE].count == afc_rep.writes - 1;
+}
+
+#define ARQ_TEST_MESSAGES 64
+#define ARQ_TEST_PAYLOAD  24
+#define ARQ_TEST_BURST    8   // frames per downlink slot
+#define ARQ_TEST_BER      1500 // one bit in this many flipped
+
+static arq_tx   arq_sender;
+static arq_rx   arq_receiver;
+static uint16_t arq_min_window;
+static uint32_t arq_slots;
+static uint32_t arq_noise = 0x2545f491;
+
+static void s_arq_payload(uint8_t* out, uint16_t i) {
+	uint8_t j;
+
+	for (j = 0; j < ARQ_TEST_PAYLOAD; j++) {
+		out[j] = (uint8_t)(i * 7 + j);
+	}
+}
+
+// flips each bit with probability 1/ARQ_TEST_BER
+static void s_arq_corrupt(uint8_t* data, uint8_t len) {
+	uint8_t i, b;
+
+	for (i = 0; i < len; i++) {
+		for (b = 0; b < 8; b++) {
+			arq_noise ^= arq_noise << 13;
+			arq_noise ^= arq_noise >> 17;
+			arq_noise ^= arq_noise << 5;
+			if (arq_noise % ARQ_TEST_BER == 0) {
+				data[i] ^= (uint8_t)(1 << b);
+			}
+		}
+	}
+}
+
+/*
+	A run of payloads sent through the FIFOs with bit errors on
+	the way, and every fifth ACK lost, must come out complete and
+	in order, with the window narrowing as frames are lost.
+*/
+static int s_arq_test(void) {
+	uint8_t  status = 0xff;
+	uint8_t  payload[ARQ_MAX_PAYLOAD + 1];
+	uint8_t  expect[ARQ_TEST_PAYLOAD];
+	uint8_t  frame[ARQ_MAX_FRAME];
+	uint8_t  air[FIFO_SIZE];
+	uint8_t  ack[ARQ_ACK_SIZE];
+	uint8_t  len, n, got, k;
+	uint16_t submitted = 0;
+	uint16_t delivered = 0;
+
+	ARQ_tx_init(&arq_sender, 4);
+	ARQ_rx_init(&arq_receiver);
+	if (ARQ_tx_submit(&arq_sender, payload, ARQ_MAX_PAYLOAD + 1) != ERROR_ARQ_PAYLOAD_TOO_LONG ||
+	    ARQ_rx_ack(&arq_receiver, ack, sizeof(ack), &len) != ERROR_NONE || len != 0) {
+		return 0;
+	}
+
+	arq_min_window = arq_sender.window;
+	for (arq_slots = 0; delivered < ARQ_TEST_MESSAGES && arq_slots < 1000; arq_slots++) {
+		while (submitted < ARQ_TEST_MESSAGES) {
+			s_arq_payload(payload, submitted);
+			if (ARQ_tx_submit(&arq_sender, payload, ARQ_TEST_PAYLOAD) != ERROR_NONE) {
+				break;
+			}
+			submitted++;
+		}
+
+		// downlink
+		for (k = 0; k < ARQ_TEST_BURST; k++) {
+			if (ARQ_tx_next(&arq_sender, arq_slots, frame, sizeof(frame), &len) != ERROR_NONE) {
+				return 0;
+			}
+			if (len == 0) {
+				break;
+			}
+			TX_burst_enqueue(frame, len, &status);
+			n = SIM_take_tx_fifo(air, sizeof(air), SIM_GPIO_get_driver());
+			s_arq_corrupt(air, n);
+			SIM_inject_rx_fifo(air, n, SIM_GPIO_get_driver());
+			RX_burst_dequeue(frame, n, &got, &status);
+			ARQ_rx_receive(&arq_receiver, frame, got);
+		}
+
+		for (;;) {
+			if (ARQ_rx_deliver(&arq_receiver, payload, sizeof(payload), &len) != ERROR_NONE) {
+				return 0;
+			}
+			if (len == 0) {
+				break;
+			}
+			s_arq_payload(expect, delivered);
+			if (len != ARQ_TEST_PAYLOAD || memcmp(payload, expect, len)) {
+				return 0;
+			}
+			delivered++;
+		}
+
+		// uplink slot
+		ARQ_rx_ack(&arq_receiver, ack, sizeof(ack), &len);
+		if (len && arq_slots % 5 != 4) {
+			ARQ_tx_ack(&arq_sender, ack, len);
+		}
+		if (arq_sender.window < arq_min_window) {
+			arq_min_window = arq_sender.window;
+		}
+	}
+
+	return delivered == ARQ_TEST_MESSAGES && arq_receiver.delivered == ARQ_TEST_MESSAGES &&
+	       arq_receiver.bad > 0 && arq_sender.resent > 0 && arq_sender.lost > 0 &&
+	       arq_min_window < ARQ_MAX_WINDOW && arq_sender.bad_acks == 0;
+}
+
+#define TLM_CHANNELS     15  // orbit.m's 46 bytes: 7 16-bit, 8 32-bit
+#define TLM_RAW_BYTES    46
+#define TLM_MINUTES      64
+#define TLM_PER_FRAME    4   // a key record starts every frame
+
+static compress_lz tlm_lz;
+static uint32_t    tlm_air_bytes;
+static int         tlm_simd;
+static uint32_t    tlm_noise = 0x9e3779b9;
+
+static int32_t s_tlm_noise(int32_t range) {
+	tlm_noise ^= tlm_noise << 13;
+	tlm_noise ^= tlm_noise >> 17;
+	tlm_noise ^= tlm_noise << 5;
+	return (int32_t)(tlm_noise % (uint32_t)(2 * range + 1)) - range;
+}
+
+// slow temperatures and rails, livelier attitude, a clock and a counter
+static void s_tlm_sample(int32_t* s, uint32_t minute) {
+	int i;
+
+	for (i = 0; i < 7; i++) {
+		s[i] = 2000 + 100 * i + (int32_t)minute / 4 + s_tlm_noise(2);
+	}
+	for (i = 7; i < 13; i++) {
+		s[i] = 50000 * (i - 10) + 40 * (int32_t)minute + s_tlm_noise(300);
+	}
+	s[13] = (int32_t)(1700000000u + 60 * minute);
+	s[14] = (int32_t)(minute * 17);
+}
+
+/*
+	An hour of telemetry, 4 minutes a frame, delta coded and LZ
+	compressed, must come back exact through the FIFOs with either
+	decoder, a lost frame costing only itself. Random data must
+	stay within the LZ bound.
+*/
+static int s_compress_test(void) {
+	compress_delta enc, dec;
+	int32_t        sent[TLM_MINUTES][TLM_CHANNELS];
+	int32_t        got[TLM_CHANNELS];
+	uint8_t        dict[COMPRESS_DELTA_BOUND(TLM_CHANNELS)];
+	uint8_t        records[COMPRESS_LZ_MAX_INPUT];
+	uint8_t        packed[COMPRESS_LZ_BOUND(COMPRESS_LZ_MAX_INPUT)];
+	uint8_t        air[FIFO_SIZE];
+	uint8_t        plain[COMPRESS_LZ_MAX_INPUT];
+	uint8_t        plain_simd[COMPRESS_LZ_MAX_INPUT];
+	uint8_t        status = 0xff;
+	uint16_t       dict_len, len, n, used, plain_len, pos;
+	uint8_t        got_n;
+	uint32_t       minute, frame, i;
+
+	// both ends hold a nominal key record as the dictionary
+	s_tlm_sample(sent[0], 0);
+	COMPRESS_delta_init(&enc, TLM_CHANNELS, 0);
+	COMPRESS_delta_encode(&enc, sent[0], dict, sizeof(dict), &dict_len);
+	if (COMPRESS_lz_init(&tlm_lz, dict, dict_len) != ERROR_NONE ||
+	    COMPRESS_delta_init(&enc, TLM_CHANNELS, TLM_PER_FRAME) != ERROR_NONE ||
+	    COMPRESS_delta_init(&dec, TLM_CHANNELS, 0) != ERROR_NONE) {
+		return 0;
+	}
+
+	tlm_air_bytes = 0;
+	for (frame = 0; frame < TLM_MINUTES / TLM_PER_FRAME; frame++) {
+		len = 0;
+		for (minute = frame * TLM_PER_FRAME; minute < (frame + 1) * TLM_PER_FRAME; minute++) {
+			s_tlm_sample(sent[minute], minute);
+			if (COMPRESS_delta_encode(&enc, sent[minute], &records[len], (uint16_t)(sizeof(records) - len), &n) != ERROR_NONE) {
+				return 0;
+			}
+			len += n;
+		}
+		if (COMPRESS_lz_compress(&tlm_lz, records, len, packed, sizeof(packed), &n) != ERROR_NONE || n > FIFO_SIZE) {
+			return 0;
+		}
+
+		// frame 3 never arrives
+		tlm_air_bytes += n;
+		TX_burst_enqueue(packed, (uint8_t)n, &status);
+		n = SIM_take_tx_fifo(air, sizeof(air), SIM_GPIO_get_driver());
+		if (frame == 3) {
+			continue;
+		}
+		SIM_inject_rx_fifo(air, (uint8_t)n, SIM_GPIO_get_driver());
+		RX_burst_dequeue(air, (uint8_t)n, &got_n, &status);
+
+		COMPRESS_use_simd(0);
+		COMPRESS_lz_decompress(dict, dict_len, air, got_n, plain, sizeof(plain), &plain_len);
+		tlm_simd = COMPRESS_use_simd(1);
+		if (COMPRESS_lz_decompress(dict, dict_len, air, got_n, plain_simd, sizeof(plain_simd), &n) != ERROR_NONE ||
+		    n != len || plain_len != len || memcmp(plain, records, len) || memcmp(plain_simd, records, len)) {
+			return 0;
+		}
+
+		for (pos = 0, minute = frame * TLM_PER_FRAME; pos < len; pos += used, minute++) {
+			if (COMPRESS_delta_decode(&dec, &plain[pos], (uint16_t)(len - pos), got, &used) != ERROR_NONE ||
+			    memcmp(got, sent[minute], sizeof(got))) {
+				return 0;
+			}
+		}
+	}
+
+	// a delta record with the one before it missing
+	COMPRESS_delta_encode(&enc, sent[0], records, sizeof(records), &n);
+	COMPRESS_delta_encode(&enc, sent[1], records, sizeof(records), &n);
+	if (COMPRESS_delta_decode(&dec, records, n, got, &used) != ERROR_COMPRESS_OUT_OF_SYNC || used != n ||
+	    dec.records != TLM_MINUTES - TLM_PER_FRAME) {
+		return 0;
+	}
+
+	for (i = 0; i < sizeof(records); i++) {
+		records[i] = (uint8_t)s_tlm_noise(128);
+	}
+	if (COMPRESS_lz_compress(&tlm_lz, records, sizeof(records), packed, sizeof(packed), &n) != ERROR_NONE ||
+	    n > COMPRESS_LZ_BOUND(sizeof(records)) ||
+	    COMPRESS_lz_decompress(dict, dict_len, packed, n, plain, sizeof(plain), &plain_len) != ERROR_NONE ||
+	    plain_len != sizeof(records) || memcmp(plain, records, sizeof(records)) ||
+	    COMPRESS_lz_decompress(dict, dict_len, packed, (uint16_t)(n - 1), plain, sizeof(plain), &plain_len) == ERROR_NONE) {
+		return 0;
+	}
+	return 1;
+}
+
+#define SNAPSHOT_RX_BYTES 20
+#define SNAPSHOT_RESTORES 10000
+
+static uint32_t snapshot_len;
+static uint32_t snapshot_restore_ns;
+
+/*
+	A configured chip with a frame waiting is saved, knocked about
+	and restored, and must read back over the bus as it was, clock
+	and all. A damaged image changes nothing.
+*/
+static int s_snapshot_test(void) {
+	static uint8_t    image[SIM_SNAPSHOT_MAX_SIZE];
+	static uint8_t    bad[SIM_SNAPSHOT_MAX_SIZE];
+	sim_driver_handle dh = SIM_GPIO_get_driver();
+	uint8_t           air[SNAPSHOT_RX_BYTES];
+	uint8_t           got[SNAPSHOT_RX_BYTES];
+	uint8_t           reg, got_n;
+	uint8_t           status = 0xff;
+	uint64_t          at, start;
+	uint32_t          i;
+
+	for (i = 0; i < sizeof(air); i++) {
+		air[i] = (uint8_t)(0xa0 + i);
+	}
+	STROBE_command_strobe(SIDLE, &status);
+	STROBE_command_strobe(SFRX, &status);
+	REGISTER_write(FS_CFG, 0x14, &status);
+	REGISTER_write(FREQ2, 0x6c, &status);
+	STROBE_command_strobe(SRX, &status);
+	SIM_inject_rx_fifo(air, sizeof(air), dh);
+	SIM_advance_clock(1500, dh);
+
+	// an address byte and a data byte, 16 bits on the bus
+	at = SIM_get_clock_us(dh);
+	REGISTER_read(FS_CFG, &reg, &status);
+	if (SIM_get_clock_us(dh) != at + 16 || SIM_clock_now_us() != at + 16) {
+		return 0;
+	}
+	at += 16;
+
+	snapshot_len = SIM_snapshot(image, sizeof(image), dh);
+	if (snapshot_len == 0 || SIM_snapshot(image, snapshot_len - 1, dh) != 0) {
+		return 0;
+	}
+
+	REGISTER_write(FS_CFG, 0x00, &status);
+	REGISTER_write(FREQ2, 0x00, &status);
+	STROBE_command_strobe(SIDLE, &status);
+	STROBE_command_strobe(SFRX, &status);
+	SIM_advance_clock(250000, dh);
+
+	memcpy(bad, image, snapshot_len);
+	bad[SIM_SNAPSHOT_MAX_SIZE / 2] ^= 0x01;
+	if (SIM_restore(bad, snapshot_len, dh) || SIM_restore(image, snapshot_len - 1, dh) ||
+	    SIM_get_clock_us(dh) == at) {
+		return 0;
+	}
+
+	start = CLOCK_now_us();
+	for (i = 0; i < SNAPSHOT_RESTORES; i++) {
+		if (!SIM_restore(image, snapshot_len, dh)) {
+			return 0;
+		}
+	}
+	snapshot_restore_ns = (uint32_t)((CLOCK_now_us() - start) * 1000u / SNAPSHOT_RESTORES);
+	if (SIM_get_clock_us(dh) != at) {
+		return 0;
+	}
+
+	REGISTER_read(FS_CFG, &reg, &status);
+	if (reg != 0x14 || STATUS_get_chip_status(status) != STATUS_RX) {
+		return 0;
+	}
+	REGISTER_read(FREQ2, &reg, &status);
+	if (reg != 0x6c) {
+		return 0;
+	}
+	if (RX_burst_dequeue(got, sizeof(got), &got_n, &status) != ERROR_NONE ||
+	    got_n != sizeof(air) || memcmp(got, air, sizeof(air))) {
+		return 0;
+	}
+
+	STROBE_command_strobe(SIDLE, &status);
+	STROBE_command_strobe(SFRX, &status);
+	return 1;
+}
+
+/*
+	Runs each test against the simulated chip, which stands in
+	for gpio.h with its own register file and RX and TX FIFOs,
+	so the driver can be checked without a physical chip.
 */
 int main(int argc, char** argv) {
 	tcvr_error_t err = ERROR_NONE;
@@ -46,5 +1336,170 @@ int main(int argc, char** argv) {
 		printf("Value written: %u. Value read: %u\n", byt, test);
 	}
 
+	printf("Beginning Doppler table test...\n");
+
+	if (s_doppler_table_test()) {
+		printf("Doppler table interpolated and retuned FREQOFF\n");
+	}
+	else {
+		printf("Doppler table test failed\n");
+	}
+
+		printf("Beginning packet ring test...\n");
+
+	if (s_packet_ring_test()) {
+		printf("Frames came back out of the rings unchanged\n");
+	}
+	else {
+		printf("Packet ring test failed\n");
+	}
+
+	printf("Beginning radio service test...\n");
+
+	if (s_radio_service_test()) {
+		printf("Registers written from two threads read back correctly\n");
+	}
+	else {
+		printf("Radio service test failed\n");
+	}
+
+	printf("Beginning framing test...\n");
+
+	if (s_framing_test()) {
+		printf("CRCs and whitening check out\n");
+	}
+	else {
+		printf("Framing test failed\n");
+	}
+
+	printf("Beginning FEC test...\n");
+
+	if (s_fec_test()) {
+		printf("Convolutional and Reed-Solomon codes corrected every error\n");
+	}
+	else {
+		printf("FEC test failed\n");
+	}
+
+	printf("Beginning AX.25 test...\n");
+
+	if (s_ax25_test()) {
+		printf("AX.25 frames came back through the stuffing intact\n");
+	}
+	else {
+		printf("AX.25 test failed\n");
+	}
+
+	printf("Beginning TX batch test...\n");
+
+	if (s_tx_batch_test()) {
+		printf("Small frames were batched into single bursts\n");
+	}
+	else {
+		printf("TX batch test failed\n");
+	}
+
+	printf("Beginning power test...\n");
+
+	if (s_power_test()) {
+		printf("Power states followed the contact windows\n");
+	}
+	else {
+		printf("Power test failed\n");
+	}
+
+	printf("Beginning status tracker test...\n");
+
+	if (s_status_tracker_test()) {
+		printf("Chip state followed the status bytes of every transaction\n");
+	}
+	else {
+		printf("Status tracker test failed\n");
+	}
+
+	printf("Beginning FIFO recovery test...\n");
+
+	if (s_fifo_recovery_test()) {
+		printf("FIFO errors were recovered from without losing the link\n");
+	}
+	else {
+		printf("FIFO recovery test failed\n");
+	}
+
+	printf("Beginning turnaround test...\n");
+
+	if (s_turnaround_test()) {
+		printf("Preloaded frame fired from FSTXON, in TX %u us after STX\n", (unsigned)ta.max_latency_us);
+	}
+	else {
+		printf("Turnaround test failed\n");
+	}
+
+	printf("Beginning bitfield test...\n");
+
+	if (s_bitfield_test()) {
+		printf("Register fields read and wrote back through every accessor\n");
+	}
+	else {
+		printf("Bitfield test failed\n");
+	}
+
+	printf("Beginning stats test...\n");
+
+	if (s_stats_test()) {
+		printf("Counters and histograms matched the calls made:\n%s", stats_text);
+	}
+	else {
+		printf("Stats test failed\n");
+	}
+
+	printf("Beginning survey test...\n");
+
+	if (s_survey_test()) {
+		printf("Occupied channels found, %d channels swept in %u us\n", SURVEY_TEST_CHANNELS, sv.last_sweep_us);
+	}
+	else {
+		printf("Survey test failed\n");
+	}
+
+	printf("Beginning AFC test...\n");
+
+	if (s_afc_test()) {
+		printf("Tracked a 200 word prediction error with %u writes, residual mean %u rms %u\n",
+		       afc_rep.writes, afc_rep.mean_abs, afc_rep.rms);
+	}
+	else {
+		printf("AFC test failed\n");
+	}
+
+	printf("Beginning ARQ test...\n");
+
+	if (s_arq_test()) {
+		printf("%d payloads delivered in order in %u slots: %u frames sent, %u resent, %u corrupted, window down to %u\n",
+		       ARQ_TEST_MESSAGES, arq_slots, arq_sender.sent, arq_sender.resent, arq_receiver.bad, arq_min_window);
+	}
+	else {
+		printf("ARQ test failed\n");
+	}
+
+	printf("Beginning compression test...\n");
+
+	if (s_compress_test()) {
+		printf("%d minutes of telemetry in %u bytes instead of %d, SSE2 decoder %s\n",
+		       TLM_MINUTES, tlm_air_bytes, TLM_MINUTES * TLM_RAW_BYTES, tlm_simd ? "on" : "off");
+	}
+	else {
+		printf("Compression test failed\n");
+	}
+
+	printf("Beginning snapshot test...\n");
+
+	if (s_snapshot_test()) {
+		printf("Chip restored from a %u byte snapshot in %u ns\n", snapshot_len, snapshot_restore_ns);
+	}
+	else {
+		printf("Snapshot test failed\n");
+	}
+
 	return 0;
 }
@@ -1,5 +1,4 @@
 
-#include <stdlib.h> // malloc, free
 #include <stdint.h> // for uint8_t
 #include <string.h> // memset
 #include <stdio.h>
@@ -9,14 +8,61 @@
 #include "../gpio.h" // for HIGH, LOW
 #include "../spi.h" // for SPI_READ/WRITE, SPI_SINGLE/BURST
 #include "../strobe.h" // for STROBE_ADDRESS_START/STOP
+#include "../rxtx.h" // for FIFO addresses
+#include "../status_byte.h" // for chip_status
+#include "../crc.h" // for CRC16, closing snapshots
 #include "sim_iface.h"
 #include "sim.h"
 
-#define _DEBUG_SIM_
+// FIFO byte counts live in their status registers
+#define SIM_NUM_TXBYTES (NUM_TX_BYTES & 0xff)
+#define SIM_NUM_RXBYTES (NUM_RX_BYTES & 0xff)
+
+#define SIM_FREQ2 (FREQ2 & 0xff)
+#define SIM_RSSI1 (RSSI1 & 0xff)
+#define SIM_RSSI0 (RSSI0 & 0xff)
+#define SIM_FREQOFF1     (FREQOFF1 & 0xff)
+#define SIM_FREQOFF_EST1 (FREQOFF_EST1 & 0xff)
+
+// a snapshot: "SIM" and the version, the clock, the pins and state
+// machine, the signal offset, both register spaces, the bytes in the
+// RX then TX FIFO, and the CRC16 of all that, little endian throughout
+#define SIM_SNAPSHOT_VERSION 1
+#define SIM_SNAPSHOT_CLOCK   4
+#define SIM_SNAPSHOT_STATE   12
+#define SIM_SNAPSHOT_OFFSET  (SIM_SNAPSHOT_STATE + 13)
+#define SIM_SNAPSHOT_STD     (SIM_SNAPSHOT_OFFSET + 2)
+#define SIM_SNAPSHOT_EXT     (SIM_SNAPSHOT_STD + STANDARD_REGISTER_SPACE)
+#define SIM_SNAPSHOT_FIFOS   (SIM_SNAPSHOT_EXT + EXTENDED_REGISTER_SPACE)
+#define SIM_SNAPSHOT_FIXED   (SIM_SNAPSHOT_FIFOS + 2)
+
+#if SIM_SNAPSHOT_FIXED + 2*TRANSCEIVER_FIFO_SIZE != SIM_SNAPSHOT_MAX_SIZE
+#error SIM_SNAPSHOT_MAX_SIZE no longer matches the snapshot layout
+#endif
+
+// drivers come from here rather than the heap, as on the flight build
+static sim_driver s_SIM_drivers[SIM_MAX_DRIVERS];
+static uint8_t    s_SIM_in_use[SIM_MAX_DRIVERS];
+
+static sim_driver* s_SIM_take_driver(void) {
+	int i;
+
+	for (i = 0; i < SIM_MAX_DRIVERS; i++) {
+		if (!s_SIM_in_use[i]) {
+			s_SIM_in_use[i] = 1;
+			return &s_SIM_drivers[i];
+		}
+	}
+	return NULL;
+}
+
+static void s_SIM_give_driver(sim_driver* driver) {
+	s_SIM_in_use[driver - s_SIM_drivers] = 0;
+}
 
 sim_driver* SIM_create_sim_driver() {
 	int failure;
-	sim_driver* driver = (sim_driver*)malloc(sizeof(sim_driver));
+	sim_driver* driver = s_SIM_take_driver();
 
 #ifdef _DEBUG_SIM_
 	printf("Creating sim driver\n");
@@ -34,30 +80,33 @@ sim_driver* SIM_create_sim_driver() {
 
 	memset(driver->tx_fifo, 0, TRANSCEIVER_FIFO_SIZE*sizeof(driver->tx_fifo[0]));
 	memset(driver->rx_fifo, 0, TRANSCEIVER_FIFO_SIZE*sizeof(driver->rx_fifo[0]));	
+	driver->tx_fifo_head = 0;
+	driver->rx_fifo_head = 0;
 	memset(driver->standard_registers, 0, STANDARD_REGISTER_SPACE*sizeof(driver->standard_registers[0]));
 	memset(driver->extended_registers, 0, EXTENDED_REGISTER_SPACE*sizeof(driver->extended_registers[0]));
 
 	failure = pthread_mutex_init(&driver->MOSI_mutex, NULL);
 	if (failure) {
-		free(driver);
+		s_SIM_give_driver(driver);
 		return NULL;
 	}
 	failure = pthread_mutex_init(&driver->MISO_mutex, NULL);
 	if (failure) {
-		free(driver);
+		s_SIM_give_driver(driver);
 		return NULL;
 	}
 	failure = pthread_mutex_init(&driver->SCLK_mutex, NULL);
 	if (failure) {
-		free(driver);
+		s_SIM_give_driver(driver);
 		return NULL;
 	}
 	failure = pthread_mutex_init(&driver->SS_mutex, NULL);
 	if (failure) {
-		free(driver);
+		s_SIM_give_driver(driver);
 		return NULL;
 	}
 	driver->currently_accessing_extended = 0;
+	driver->extended_command = 0;
 
 	driver->chip_status = 0; // READY and IDLE
 	driver->current_output_byte = driver->chip_status;
@@ -66,7 +115,10 @@ sim_driver* SIM_create_sim_driver() {
 	driver->current_bit = BIT_7;
 
 	driver->current_command = SIM_IO_READY;
-
+	driver->rssi_source = NULL;
+	driver->rssi_ctx = NULL;
+	driver->signal_offset = 0;
+	driver->clock_ns = 0;
 
 #ifdef _DEBUG_SIM_
 	printf("Successfully created sim driver.\n");
@@ -83,7 +135,7 @@ void SIM_release_sim_driver(sim_driver** driver) {
 			pthread_mutex_destroy(&d->MISO_mutex);
 			pthread_mutex_destroy(&d->SCLK_mutex);
 			pthread_mutex_destroy(&d->SS_mutex);
-			free(d);
+			s_SIM_give_driver(d);
 			*driver = NULL;
 		}
 	}
@@ -160,6 +212,120 @@ uint8_t SIM_read_from_SS(sim_driver* driver) {
 	return LOW;
 }
 
+// FIFOs
+// =====
+
+/*
+	Appends a byte to a FIFO whose count is kept in
+	extended_registers[count_reg].
+	Returns 1 if there was room, 0 otherwise.
+*/
+static int s_SIM_fifo_push(sim_driver* driver, uint8_t* fifo, uint8_t head, uint8_t count_reg, uint8_t byt) {
+	uint8_t count = driver->extended_registers[count_reg];
+
+	if (count >= TRANSCEIVER_FIFO_SIZE) {
+		return 0;
+	}
+	fifo[(head + count) % TRANSCEIVER_FIFO_SIZE] = byt;
+	driver->extended_registers[count_reg] = count + 1;
+	return 1;
+}
+
+/*
+	Returns the oldest byte in a FIFO without removing it, or 0
+	if it is empty.
+*/
+static uint8_t s_SIM_fifo_peek(sim_driver* driver, uint8_t* fifo, uint8_t head, uint8_t count_reg) {
+	return (driver->extended_registers[count_reg] > 0) ? fifo[head] : 0;
+}
+
+/*
+	Removes the oldest byte in a FIFO, if any.
+*/
+static void s_SIM_fifo_pop(sim_driver* driver, uint8_t* head, uint8_t count_reg) {
+	if (driver->extended_registers[count_reg] > 0) {
+		*head = (*head + 1) % TRANSCEIVER_FIFO_SIZE;
+		driver->extended_registers[count_reg]--;
+	}
+}
+
+BITS_FIELD(SIM_CHIP_STATE, 6, 4)
+
+static void s_SIM_set_state(sim_driver* driver, chip_status cs) {
+	driver->chip_status = SIM_CHIP_STATE_set(driver->chip_status, (uint8_t)cs);
+}
+
+BITS_FIELD(SIM_RSSI_VALID, 0, 0)
+
+/*
+	Entering RX measures the RSSI at the current FREQ, leaving it
+	makes the RSSI invalid again.
+*/
+static void s_SIM_update_rssi(sim_driver* driver, int in_rx) {
+	uint8_t* freq = &driver->extended_registers[SIM_FREQ2];
+	uint32_t freq_word = ((uint32_t)freq[0] << 16) | ((uint32_t)freq[1] << 8) | freq[2];
+	int8_t   dbm = SIM_NOISE_FLOOR_DBM;
+
+	if (!in_rx) {
+		driver->extended_registers[SIM_RSSI0] = SIM_RSSI_VALID_set(driver->extended_registers[SIM_RSSI0], 0);
+		return;
+	}
+	if (driver->rssi_source) {
+		dbm = driver->rssi_source(freq_word, driver->rssi_ctx);
+	}
+	if (dbm == SIM_RSSI_NEVER_VALID) {
+		driver->extended_registers[SIM_RSSI0] = SIM_RSSI_VALID_set(driver->extended_registers[SIM_RSSI0], 0);
+		return;
+	}
+	driver->extended_registers[SIM_RSSI1] = (uint8_t)dbm;
+	driver->extended_registers[SIM_RSSI0] = SIM_RSSI_VALID_value(1);
+}
+
+/*
+	The chip's state follows the strobes straight away: there is
+	no calibration or settling time, and the sleep states (SPWD,
+	SXOFF, and the sleep between eWOR polls) end as soon as CSn
+	next goes low, as they would on the chip once the crystal is
+	up.
+*/
+static void s_SIM_do_strobe(sim_driver* driver, uint8_t strobe) {
+	if (strobe != SNOP) {
+		s_SIM_update_rssi(driver, strobe == SRX);
+	}
+
+	switch (strobe) {
+	case SFRX:
+		driver->rx_fifo_head = 0;
+		driver->extended_registers[SIM_NUM_RXBYTES] = 0;
+		s_SIM_set_state(driver, STATUS_IDLE);
+		break;
+	case SFTX:
+		driver->tx_fifo_head = 0;
+		driver->extended_registers[SIM_NUM_TXBYTES] = 0;
+		s_SIM_set_state(driver, STATUS_IDLE);
+		break;
+	case SRX:
+		s_SIM_set_state(driver, STATUS_RX);
+		break;
+	case STX:
+		s_SIM_set_state(driver, STATUS_TX);
+		break;
+	case SFSTXON:
+		s_SIM_set_state(driver, STATUS_FSTXON);
+		break;
+	case SIDLE:
+	case SCAL:
+	case SPWD:
+	case SXOFF:
+	case SWOR:
+		s_SIM_set_state(driver, STATUS_IDLE);
+		break;
+	default:
+		// no other strobe has an effect yet
+		break;
+	}
+}
+
 // ==
 
 static void s_SIM_reset_to_ready(sim_driver* driver) {
@@ -167,6 +333,7 @@ static void s_SIM_reset_to_ready(sim_driver* driver) {
 		driver->current_command = SIM_IO_READY;
 		driver->current_address = 0;
 		driver->currently_accessing_extended = 0;
+		driver->extended_command = 0;
 		driver->current_output_byte = driver->chip_status;
 		driver->current_input_byte = 0;
 	}
@@ -219,18 +386,29 @@ void SIM_do_command(sim_driver* driver) {
 				}
 			}
 			else if (address_portion == EXTENDED_REGISTER_SPACE_ADDRESS) {
+				// the next byte is the address, so remember the command
 				driver->current_command = SIM_IO_EXTENDED_SPACE;
 				driver->currently_accessing_extended = 1;
+				driver->extended_command = command_portion;
 			}
-			else if (address_portion >= STROBE_ADDRESS_START && command_portion <= STROBE_ADDRESS_END) {
-				// do probe effects, and go back to ready
+			else if (address_portion >= STROBE_ADDRESS_START && address_portion <= STROBE_ADDRESS_END) {
+				// do strobe effects, and go back to ready
+				s_SIM_do_strobe(driver, address_portion);
 				s_SIM_reset_to_ready(driver);
 			}
 			else if (address_portion == DIRECT_FIFO_ADDRESS) {
 
 			}
-			else /* if (command_portion == STANDARD_FIFO_ADDRESS)*/ {
-
+			else /* if (address_portion == STANDARD_FIFO_ADDRESS)*/ {
+				if ((command_portion & BIT_7) == SPI_READ) {
+					// RX FIFO, the oldest byte goes out next
+					driver->current_output_byte = s_SIM_fifo_peek(driver, driver->rx_fifo, driver->rx_fifo_head, SIM_NUM_RXBYTES);
+					driver->current_command = ((command_portion & BIT_6) == SPI_SINGLE) ? SIM_IO_SINGLE_RX_FIFO : SIM_IO_BURST_RX_FIFO;
+				}
+				else { // SPI_WRITE, TX FIFO
+					driver->current_output_byte = driver->chip_status;
+					driver->current_command = ((command_portion & BIT_6) == SPI_SINGLE) ? SIM_IO_SINGLE_TX_FIFO : SIM_IO_BURST_TX_FIFO;
+				}
 			}
 			break;
 		case SIM_IO_SINGLE_REGISTER_READ:
@@ -298,22 +476,23 @@ void SIM_do_command(sim_driver* driver) {
 			}
 			break;
 		case SIM_IO_EXTENDED_SPACE:
-			// input byte is
-			command_portion = driver->current_input_byte & 0xd0;
-			address_portion = driver->current_input_byte & 0x3f;
+			// input byte is the full 8-bit extended address,
+			// command was sent with EXTENDED_REGISTER_SPACE_ADDRESS
+			command_portion = driver->extended_command;
+			address_portion = driver->current_input_byte;
 			// Set address
 			driver->current_address = address_portion;
 			if ((command_portion & BIT_7) == SPI_READ) {
 				// Output register contents
-				/*if (address_portion <= EXTENDED_REGISTER_SPACE) { */
+				if (address_portion < EXTENDED_REGISTER_SPACE) {
 					driver->current_output_byte = driver->extended_registers[address_portion];
 #ifdef _DEBUG_SIM_
 					printf("\t\tCurrent output byte set to extended_registers[0x%x]=0x%x\n", address_portion, driver->current_output_byte);
-#endif					
-				/*}
+#endif
+				}
 				else {
 					driver->current_output_byte = 0;
-				}*/
+				}
 				// Update command
 				if ((command_portion & BIT_6) == SPI_SINGLE) {
 					driver->current_command = SIM_IO_SINGLE_REGISTER_READ;
@@ -333,13 +512,21 @@ void SIM_do_command(sim_driver* driver) {
 			}
 			break;
 		case SIM_IO_SINGLE_RX_FIFO:
-			// not implemented yet
+			// the byte has been clocked out, so remove it and go back to ready
+			s_SIM_fifo_pop(driver, &driver->rx_fifo_head, SIM_NUM_RXBYTES);
+			s_SIM_reset_to_ready(driver);
 			break;
 		case SIM_IO_SINGLE_TX_FIFO:
+			s_SIM_fifo_push(driver, driver->tx_fifo, driver->tx_fifo_head, SIM_NUM_TXBYTES, driver->current_input_byte);
+			s_SIM_reset_to_ready(driver);
 			break;
 		case SIM_IO_BURST_RX_FIFO:
+			// remove the byte just clocked out, and line up the next
+			s_SIM_fifo_pop(driver, &driver->rx_fifo_head, SIM_NUM_RXBYTES);
+			driver->current_output_byte = s_SIM_fifo_peek(driver, driver->rx_fifo, driver->rx_fifo_head, SIM_NUM_RXBYTES);
 			break;
 		case SIM_IO_BURST_TX_FIFO:
+			s_SIM_fifo_push(driver, driver->tx_fifo, driver->tx_fifo_head, SIM_NUM_TXBYTES, driver->current_input_byte);
 			break;
 		default:
 			s_SIM_reset_to_ready(driver);
@@ -352,6 +539,8 @@ void SIM_do_on_SCLK(uint8_t hiOrLo, sim_driver* driver) {
 	if (driver) {
 		if (hiOrLo == HIGH && driver->last_clock_value == LOW) {
 			uint8_t ss = SIM_read_from_SS(driver);
+
+			driver->clock_ns += SIM_SCLK_PERIOD_NS;
 			if (ss == LOW) {
 #ifdef _DEBUG_SIM_
 				printf("\t\tHit rising clock edge and IO is active\n");
@@ -459,3 +648,248 @@ void SIM_write_to_SS(uint8_t hiOrLo, sim_driver_handle dh) {
 	}	
 }
 
+/*
+	The demodulator's view of the signal: how far it is from the
+	tuning, FREQOFF included.
+*/
+static void s_SIM_estimate_offset(sim_driver* driver) {
+	uint8_t* freqoff = &driver->extended_registers[SIM_FREQOFF1];
+	uint8_t* est = &driver->extended_registers[SIM_FREQOFF_EST1];
+	uint16_t word = (uint16_t)(driver->signal_offset - (int16_t)((freqoff[0] << 8) | freqoff[1]));
+
+	est[0] = (uint8_t)(word >> 8);
+	est[1] = (uint8_t)(word & 0xff);
+}
+
+uint8_t SIM_inject_rx_fifo(const uint8_t* data, uint8_t len, sim_driver_handle dh) {
+	sim_driver* driver = (sim_driver*)dh;
+	uint8_t     i = 0;
+
+	if (driver && data) {
+		// the SPI side runs under SCLK_mutex
+		int failure = pthread_mutex_lock(&driver->SCLK_mutex);
+		if (failure) {
+			return 0;
+		}
+		while (i < len && s_SIM_fifo_push(driver, driver->rx_fifo, driver->rx_fifo_head, SIM_NUM_RXBYTES, data[i])) {
+			i++;
+		}
+		s_SIM_estimate_offset(driver);
+		if (i < len) {
+			// overflow, the rest is lost until the FIFO is flushed
+			s_SIM_set_state(driver, STATUS_RXFIFOERROR);
+		}
+		pthread_mutex_unlock(&driver->SCLK_mutex);
+	}
+	return i;
+}
+
+uint8_t SIM_take_tx_fifo(uint8_t* data, uint8_t max_len, sim_driver_handle dh) {
+	sim_driver* driver = (sim_driver*)dh;
+	uint8_t     i = 0;
+
+	if (driver && data) {
+		int failure = pthread_mutex_lock(&driver->SCLK_mutex);
+		if (failure) {
+			return 0;
+		}
+		while (i < max_len && driver->extended_registers[SIM_NUM_TXBYTES] > 0) {
+			data[i++] = driver->tx_fifo[driver->tx_fifo_head];
+			s_SIM_fifo_pop(driver, &driver->tx_fifo_head, SIM_NUM_TXBYTES);
+		}
+		if (i < max_len && SIM_CHIP_STATE_get(driver->chip_status) == STATUS_TX) {
+			// underflow, the FIFO ran dry mid-transmission
+			s_SIM_set_state(driver, STATUS_TXFIFOERROR);
+		}
+		pthread_mutex_unlock(&driver->SCLK_mutex);
+	}
+	return i;
+}
+
+void SIM_set_rssi_source(sim_rssi_source source, void* ctx, sim_driver_handle dh) {
+	sim_driver* driver = (sim_driver*)dh;
+
+	if (driver) {
+		int failure = pthread_mutex_lock(&driver->SCLK_mutex);
+		if (failure) {
+			return;
+		}
+		driver->rssi_source = source;
+		driver->rssi_ctx = ctx;
+		pthread_mutex_unlock(&driver->SCLK_mutex);
+	}
+}
+
+void SIM_set_signal_offset(int16_t freqoff, sim_driver_handle dh) {
+	sim_driver* driver = (sim_driver*)dh;
+
+	if (driver) {
+		int failure = pthread_mutex_lock(&driver->SCLK_mutex);
+		if (failure) {
+			return;
+		}
+		driver->signal_offset = freqoff;
+		pthread_mutex_unlock(&driver->SCLK_mutex);
+	}
+}
+
+void SIM_advance_clock(uint32_t us, sim_driver_handle dh) {
+	sim_driver* driver = (sim_driver*)dh;
+
+	if (driver) {
+		int failure = pthread_mutex_lock(&driver->SCLK_mutex);
+		if (failure) {
+			return;
+		}
+		driver->clock_ns += (uint64_t)us * 1000u;
+		pthread_mutex_unlock(&driver->SCLK_mutex);
+	}
+}
+
+uint64_t SIM_get_clock_us(sim_driver_handle dh) {
+	sim_driver* driver = (sim_driver*)dh;
+	uint64_t    ns = 0;
+
+	if (driver) {
+		int failure = pthread_mutex_lock(&driver->SCLK_mutex);
+		if (failure) {
+			return 0;
+		}
+		ns = driver->clock_ns;
+		pthread_mutex_unlock(&driver->SCLK_mutex);
+	}
+	return ns / 1000u;
+}
+
+uint64_t SIM_clock_now_us(void) {
+	return SIM_get_clock_us(SIM_GPIO_get_driver());
+}
+
+static void s_SIM_fifo_save(uint8_t* out, const uint8_t* fifo, uint8_t head, uint8_t count) {
+	uint8_t i;
+
+	for (i = 0; i < count; i++) {
+		out[i] = fifo[(head + i) % TRANSCEIVER_FIFO_SIZE];
+	}
+}
+
+uint32_t SIM_snapshot(uint8_t* image, uint32_t max_len, sim_driver_handle dh) {
+	sim_driver* driver = (sim_driver*)dh;
+	uint8_t*    state;
+	uint8_t     rx_count, tx_count;
+	uint32_t    len, i;
+	uint16_t    crc;
+	int         failure;
+
+	if (!driver || !image) {
+		return 0;
+	}
+	failure = pthread_mutex_lock(&driver->SCLK_mutex);
+	if (failure) {
+		return 0;
+	}
+	rx_count = driver->extended_registers[SIM_NUM_RXBYTES];
+	tx_count = driver->extended_registers[SIM_NUM_TXBYTES];
+	len = SIM_SNAPSHOT_FIXED + rx_count + tx_count;
+	if (len > max_len) {
+		pthread_mutex_unlock(&driver->SCLK_mutex);
+		return 0;
+	}
+
+	image[0] = 'S';
+	image[1] = 'I';
+	image[2] = 'M';
+	image[3] = SIM_SNAPSHOT_VERSION;
+	for (i = 0; i < 8; i++) {
+		image[SIM_SNAPSHOT_CLOCK + i] = (uint8_t)(driver->clock_ns >> (8*i));
+	}
+	state = &image[SIM_SNAPSHOT_STATE];
+	state[0]  = driver->MOSI_bit;
+	state[1]  = driver->MISO_bit;
+	state[2]  = driver->SCLK_bit;
+	state[3]  = driver->SS_bit;
+	state[4]  = driver->last_clock_value;
+	state[5]  = driver->currently_accessing_extended;
+	state[6]  = driver->extended_command;
+	state[7]  = driver->chip_status;
+	state[8]  = driver->current_output_byte;
+	state[9]  = driver->current_address;
+	state[10] = driver->current_input_byte;
+	state[11] = driver->current_bit;
+	state[12] = (uint8_t)driver->current_command;
+	image[SIM_SNAPSHOT_OFFSET]     = (uint8_t)((uint16_t)driver->signal_offset & 0xff);
+	image[SIM_SNAPSHOT_OFFSET + 1] = (uint8_t)((uint16_t)driver->signal_offset >> 8);
+	memcpy(&image[SIM_SNAPSHOT_STD], driver->standard_registers, STANDARD_REGISTER_SPACE);
+	memcpy(&image[SIM_SNAPSHOT_EXT], driver->extended_registers, EXTENDED_REGISTER_SPACE);
+	// only the bytes waiting, oldest first
+	s_SIM_fifo_save(&image[SIM_SNAPSHOT_FIFOS], driver->rx_fifo, driver->rx_fifo_head, rx_count);
+	s_SIM_fifo_save(&image[SIM_SNAPSHOT_FIFOS + rx_count], driver->tx_fifo, driver->tx_fifo_head, tx_count);
+	pthread_mutex_unlock(&driver->SCLK_mutex);
+
+	crc = CRC16(image, len - 2);
+	image[len - 2] = (uint8_t)(crc & 0xff);
+	image[len - 1] = (uint8_t)(crc >> 8);
+	return len;
+}
+
+uint8_t SIM_restore(const uint8_t* image, uint32_t len, sim_driver_handle dh) {
+	sim_driver*    driver = (sim_driver*)dh;
+	const uint8_t* state;
+	uint8_t        rx_count, tx_count;
+	uint64_t       clock_ns = 0;
+	uint32_t       i;
+	int            failure;
+
+	if (!driver || !image || len < SIM_SNAPSHOT_FIXED) {
+		return 0;
+	}
+	if (image[0] != 'S' || image[1] != 'I' || image[2] != 'M' || image[3] != SIM_SNAPSHOT_VERSION) {
+		return 0;
+	}
+	rx_count = image[SIM_SNAPSHOT_EXT + SIM_NUM_RXBYTES];
+	tx_count = image[SIM_SNAPSHOT_EXT + SIM_NUM_TXBYTES];
+	state = &image[SIM_SNAPSHOT_STATE];
+	if (rx_count > TRANSCEIVER_FIFO_SIZE || tx_count > TRANSCEIVER_FIFO_SIZE ||
+	    len != (uint32_t)(SIM_SNAPSHOT_FIXED + rx_count + tx_count) ||
+	    CRC16(image, len - 2) != (uint16_t)(image[len - 2] | (image[len - 1] << 8))) {
+		return 0;
+	}
+	// a bit the state machine could never be on, or a command it does not know
+	if (state[11] == 0 || (state[11] & (state[11] - 1)) || state[12] > SIM_IO_BURST_TX_FIFO) {
+		return 0;
+	}
+	for (i = 0; i < 8; i++) {
+		clock_ns |= (uint64_t)image[SIM_SNAPSHOT_CLOCK + i] << (8*i);
+	}
+
+	failure = pthread_mutex_lock(&driver->SCLK_mutex);
+	if (failure) {
+		return 0;
+	}
+	driver->clock_ns = clock_ns;
+	driver->MOSI_bit = state[0];
+	driver->MISO_bit = state[1];
+	driver->SCLK_bit = state[2];
+	driver->SS_bit   = state[3];
+	driver->last_clock_value = state[4];
+	driver->currently_accessing_extended = state[5];
+	driver->extended_command = state[6];
+	driver->chip_status = state[7];
+	driver->current_output_byte = state[8];
+	driver->current_address = state[9];
+	driver->current_input_byte = state[10];
+	driver->current_bit = state[11];
+	driver->current_command = (sim_io_command)state[12];
+	driver->signal_offset = (int16_t)(image[SIM_SNAPSHOT_OFFSET] | (image[SIM_SNAPSHOT_OFFSET + 1] << 8));
+	memcpy(driver->standard_registers, &image[SIM_SNAPSHOT_STD], STANDARD_REGISTER_SPACE);
+	memcpy(driver->extended_registers, &image[SIM_SNAPSHOT_EXT], EXTENDED_REGISTER_SPACE);
+	// the waiting bytes go back at the front of each FIFO
+	memset(driver->rx_fifo, 0, TRANSCEIVER_FIFO_SIZE);
+	memset(driver->tx_fifo, 0, TRANSCEIVER_FIFO_SIZE);
+	memcpy(driver->rx_fifo, &image[SIM_SNAPSHOT_FIFOS], rx_count);
+	memcpy(driver->tx_fifo, &image[SIM_SNAPSHOT_FIFOS + rx_count], tx_count);
+	driver->rx_fifo_head = 0;
+	driver->tx_fifo_head = 0;
+	pthread_mutex_unlock(&driver->SCLK_mutex);
+	return 1;
+}
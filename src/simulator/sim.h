@@ -7,6 +7,7 @@
 #include "../bits.h"
 #include "../bang_registers.h"
 #include "../rxtx.h"
+#include "sim_iface.h"
 
 typedef enum sim_io_command_e {
 	SIM_IO_READY,
@@ -33,17 +34,27 @@ typedef struct sim_driver_s {
 	uint8_t last_clock_value;
 	uint8_t tx_fifo[TRANSCEIVER_FIFO_SIZE];
 	uint8_t rx_fifo[TRANSCEIVER_FIFO_SIZE];
+	uint8_t tx_fifo_head; // oldest byte, count is in NUM_TXBYTES
+	uint8_t rx_fifo_head; // oldest byte, count is in NUM_RXBYTES
 	uint8_t standard_registers[STANDARD_REGISTER_SPACE];
 	uint8_t extended_registers[EXTENDED_REGISTER_SPACE];
 	uint8_t currently_accessing_extended;
+	uint8_t extended_command;
 	uint8_t chip_status;
 	uint8_t current_output_byte;
 	uint8_t current_address;
 	uint8_t current_input_byte;
 	bit_t   current_bit;
 	sim_io_command current_command;
+	sim_rssi_source rssi_source;
+	void*   rssi_ctx;
+	int16_t signal_offset;
+	uint64_t clock_ns; // the virtual clock, see SIM_get_clock_us
 } sim_driver;
 
+// how many drivers can exist at once
+#define SIM_MAX_DRIVERS 4
+
 sim_driver* SIM_create_sim_driver();
 void SIM_release_sim_driver(sim_driver** driver);
 
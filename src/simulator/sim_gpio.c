@@ -3,14 +3,19 @@
 #include "sim_iface.h"
 #include "sim.h"
 
-#define _DEBUG_SIM_GPIO_
-
 #ifdef _DEBUG_SIM_GPIO_
 #include <stdio.h>
 #endif
 
 static sim_driver_handle driver = NULL;
 
+sim_driver_handle SIM_GPIO_get_driver(void) {
+	if (driver == NULL) {
+		driver = (sim_driver_handle)SIM_create_sim_driver();
+	}
+	return driver;
+}
+
 void GPIO_write_MOSI(uint8_t hiOrLo) {
 	if (driver == NULL) {
 		driver = (sim_driver_handle)SIM_create_sim_driver();
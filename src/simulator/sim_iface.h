@@ -10,4 +10,70 @@ uint8_t SIM_read_from_MISO(sim_driver_handle dh);
 void SIM_write_to_SCLK(uint8_t hiOrLo, sim_driver_handle dh);
 void SIM_write_to_SS(uint8_t hiOrLo, sim_driver_handle dh);
 
+/*
+	The radio side of the FIFOs: bytes "received over the air"
+	are appended to the RX FIFO, and bytes "transmitted" are taken
+	from the TX FIFO. Both return the number of bytes moved.
+	Injecting more than fits overflows the RX FIFO, and asking
+	for more than there is while in TX underflows the TX FIFO;
+	either puts the chip in the FIFO error state until flushed.
+*/
+uint8_t SIM_inject_rx_fifo(const uint8_t* data, uint8_t len, sim_driver_handle dh);
+uint8_t SIM_take_tx_fifo(uint8_t* data, uint8_t max_len, sim_driver_handle dh);
+
+/*
+	Where the RSSI comes from: called on every SRX with the FREQ
+	word the chip is tuned to, returns the level there in dBm,
+	which the chip reports in RSSI1/RSSI0 until it leaves RX, or
+	SIM_RSSI_NEVER_VALID to keep RSSI_VALID clear there.
+	NULL, the default, is a flat SIM_NOISE_FLOOR_DBM.
+*/
+typedef int8_t (*sim_rssi_source)(uint32_t freq_word, void* ctx);
+void SIM_set_rssi_source(sim_rssi_source source, void* ctx, sim_driver_handle dh);
+
+#define SIM_NOISE_FLOOR_DBM  -120
+#define SIM_RSSI_NEVER_VALID INT8_MIN
+
+/*
+	Where on the band the frames injected from now on arrive, as
+	a FREQOFF word. Each injection leaves the chip's estimate of
+	how far that is from where it is tuned in FREQOFF_EST.
+*/
+void SIM_set_signal_offset(int16_t freqoff, sim_driver_handle dh);
+
+/*
+	The chip's own clock, which stands still between transactions:
+	it moves SIM_SCLK_PERIOD_NS on every rising SCLK edge, as on a
+	1 MHz bus, and as far as the test advances it, so a run times
+	the same on any host. SIM_clock_now_us is the GPIO driver's, in
+	the shape of a clock_source, so CLOCK_set_source(SIM_clock_now_us)
+	times the driver by it too.
+*/
+#define SIM_SCLK_PERIOD_NS 1000
+
+void SIM_advance_clock(uint32_t us, sim_driver_handle dh);
+uint64_t SIM_get_clock_us(sim_driver_handle dh);
+uint64_t SIM_clock_now_us(void);
+
+/*
+	The whole chip as a byte image: both register spaces, the bytes
+	waiting in each FIFO, the pins and SPI state machine, the signal
+	offset and the clock, closed by a CRC16. SIM_snapshot returns
+	its length, at most SIM_SNAPSHOT_MAX_SIZE, or 0 if it does not
+	fit in max_len. SIM_restore puts the chip back as it was and
+	returns 1, or 0, changing nothing, if the image is damaged or
+	not one of these. The RSSI source belongs to the test and is
+	left as it is. Take and restore them between transactions,
+	with CSn high.
+*/
+#define SIM_SNAPSHOT_MAX_SIZE 586
+
+uint32_t SIM_snapshot(uint8_t* image, uint32_t max_len, sim_driver_handle dh);
+uint8_t SIM_restore(const uint8_t* image, uint32_t len, sim_driver_handle dh);
+
+/*
+	The driver behind the simulated GPIO pins, created on first use.
+*/
+sim_driver_handle SIM_GPIO_get_driver(void);
+
 #endif
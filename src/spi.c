@@ -3,6 +3,7 @@
 #include "bits.h"
 #include "gpio.h"
 #include "spi.h"
+#include "stats.h"
 
 #define SPI_write_to_SI(A) (GPIO_write_MOSI(A))
 #define SPI_read_from_SO GPIO_read_MISO
@@ -11,6 +12,10 @@
 
 #define SPI_NUM_DELAY_CYCLES 10
 
+static spi_status_hook s_SPI_status_hook = 0;
+static void*           s_SPI_status_ctx = 0;
+static int             s_SPI_first_byte = 0;
+
 static void s_SPI_delay(int multiplier) {
 	int i;
 	int delay = multiplier * SPI_NUM_DELAY_CYCLES;
@@ -25,6 +30,8 @@ static void s_SPI_delay(int multiplier) {
 void SPI_start_transaction(void) {
 	SPI_write_to_CSn(LOW);
 	s_SPI_delay(1);
+	s_SPI_first_byte = 1;
+	STATS_add(STATS_CSN_CYCLES, 1);
 }
 
 void SPI_stop_transaction(void) {
@@ -37,7 +44,7 @@ void SPI_stop_transaction(void) {
 	          SPI_write_to_CSn(HIGH) after all done.
 */
 uint8_t SPI_transfer_byte(uint8_t byte_out) {
-	uint8_t byte_in;
+	uint8_t byte_in = 0;
 	uint8_t bit;
 
 	for (bit = 0; bit < 8; bit++) {
@@ -73,8 +80,33 @@ uint8_t SPI_transfer_byte(uint8_t byte_out) {
 
 	s_SPI_delay(1);
 
+	STATS_add(STATS_BYTES, 1);
+	if (s_SPI_first_byte) {
+		s_SPI_first_byte = 0;
+		if (s_SPI_status_hook) {
+			s_SPI_status_hook(byte_in, s_SPI_status_ctx);
+		}
+	}
+
 	return byte_in;
 }
 
+void SPI_transfer_bytes(const uint8_t* out, uint8_t* in, uint32_t len) {
+	uint32_t i;
+	uint8_t  byt;
+
+	for (i = 0; i < len; i++) {
+		byt = SPI_transfer_byte(out ? out[i] : 0);
+		if (in) {
+			in[i] = byt;
+		}
+	}
+}
+
+void SPI_set_status_hook(spi_status_hook hook, void* ctx) {
+	s_SPI_status_hook = hook;
+	s_SPI_status_ctx = ctx;
+}
+
 
 
@@ -35,4 +35,23 @@ void SPI_stop_transaction(void);
 */
 uint8_t SPI_transfer_byte(uint8_t byte_out);
 
+/*
+	Transfers len bytes within a transaction: out is clocked out
+	(zeros if NULL) and what comes back lands in in (dropped if
+	NULL). A backend that batches (see linux_bus.h) may hold the
+	transfer back and only fill in by the time
+	SPI_stop_transaction returns, so a byte needed before then
+	goes through SPI_transfer_byte, which always completes.
+*/
+void SPI_transfer_bytes(const uint8_t* out, uint8_t* in, uint32_t len);
+
+/*
+	Called with the first byte clocked in after each
+	SPI_start_transaction, which is always the chip status
+	byte, so every transaction keeps a status tracker (see
+	status_tracker.h) up to date for free. NULL turns it off.
+*/
+typedef void (*spi_status_hook)(uint8_t status_byte, void* ctx);
+void SPI_set_status_hook(spi_status_hook hook, void* ctx);
+
 #endif
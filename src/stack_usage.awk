@@ -0,0 +1,80 @@
+# Worst case stack of each public function in the flight build, from the
+# call graph GCC writes at link time with -fcallgraph-info=su: the function's
+# own frame plus the deepest chain of calls under it.
+#
+#   awk -f stack_usage.awk transceiver.ci nm-output
+#
+# nm-output is nm --defined-only -S -t d of the same object. A "+" after the
+# total means the chain leaves the build, through a function pointer, into
+# the board's functions (GPIO, memcpy), or back into itself, so the real
+# figure is that much more.
+
+function worst(f,    n, i, c, list, w, best) {
+	if (f in total) {
+		return total[f]
+	}
+	if (!(f in frame)) {
+		open_ended[f] = 1
+		return 0
+	}
+	if (f in visiting) {
+		return 0
+	}
+
+	visiting[f] = 1
+	best = 0
+	n = split(calls[f], list, SUBSEP)
+	for (i = 1; i <= n; i++) {
+		c = list[i]
+		if (c == "") {
+			continue
+		}
+		w = worst(c)
+		if ((c in open_ended) || (c in visiting)) {
+			open_ended[f] = 1
+		}
+		if (w > best) {
+			best = w
+		}
+	}
+	delete visiting[f]
+
+	total[f] = frame[f] + best
+	return total[f]
+}
+
+function quoted(line, key,    s) {
+	if (!match(line, key ": \"[^\"]*\"")) {
+		return ""
+	}
+	s = substr(line, RSTART, RLENGTH)
+	sub("^" key ": \"", "", s)
+	sub("\"$", "", s)
+	return s
+}
+
+FNR == NR && /^node:/ {
+	name = quoted($0, "title")
+	if (match($0, /\\n[0-9]+ bytes \([a-z,]*\)/)) {
+		s = substr($0, RSTART + 2, RLENGTH - 2)
+		frame[name] = s + 0
+		if (s ~ /dynamic/ && s !~ /bounded/) {
+			open_ended[name] = 1
+		}
+	}
+	next
+}
+
+FNR == NR && /^edge:/ {
+	calls[quoted($0, "sourcename")] = calls[quoted($0, "sourcename")] SUBSEP quoted($0, "targetname")
+	next
+}
+
+FNR == NR {
+	next
+}
+
+$3 ~ /^[Tt]$/ && $4 ~ /^[A-Z][A-Z0-9]*_/ && $4 !~ /\./ {
+	w = worst($4)
+	printf "%-36s %6d %6d %6d%s\n", $4, $2, frame[$4], w, ($4 in open_ended) ? "+" : ""
+}
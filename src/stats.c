@@ -0,0 +1,256 @@
+
+#include <stdint.h>
+#include <string.h>
+#ifndef TCVR_FREESTANDING
+#include <stdarg.h>
+#include <stdio.h>
+#endif
+
+#include "error.h"
+#include "strobe.h"
+#include "clock.h"
+#include "stats.h"
+
+static stats_block s_STATS_block;
+
+#ifndef TCVR_FREESTANDING
+static const char* s_STATS_api_names[NUM_STATS_APIS] = {
+	"register_read",
+	"register_write",
+	"register_burst_read",
+	"register_burst_write",
+	"strobe",
+	"rx",
+	"tx"
+};
+
+static const char* s_STATS_counter_names[NUM_STATS_COUNTERS] = {
+	"csn_cycles",
+	"bytes",
+	"retries",
+	"rx_fifo_errors",
+	"tx_fifo_errors"
+};
+
+static const char* s_STATS_strobe_names[STATS_NUM_STROBES] = {
+	"SRES", "SFSTXON", "SXOFF", "SCAL", "SRX", "STX", "SIDLE",
+	"SAFC", "SWOR", "SPWD", "SFRX", "SFTX", "SWORRST", "SNOP"
+};
+#endif
+
+static uint32_t s_STATS_bucket(uint32_t us) {
+	uint32_t e;
+
+	if (us < 2 * STATS_SUB_BUCKETS) {
+		return us;
+	}
+	// the top STATS_SUB_BITS + 1 bits pick the bucket
+	e = 31 - (uint32_t)__builtin_clz(us);
+	return (e - STATS_SUB_BITS) * STATS_SUB_BUCKETS + (us >> (e - STATS_SUB_BITS));
+}
+
+static uint32_t s_STATS_bucket_top(uint32_t bucket) {
+	uint32_t e;
+	uint32_t m;
+
+	if (bucket < 2 * STATS_SUB_BUCKETS) {
+		return bucket;
+	}
+	e = (bucket - STATS_SUB_BUCKETS) / STATS_SUB_BUCKETS + STATS_SUB_BITS;
+	m = bucket % STATS_SUB_BUCKETS + STATS_SUB_BUCKETS;
+	return (uint32_t)((((uint64_t)m + 1) << (e - STATS_SUB_BITS)) - 1);
+}
+
+void STATS_add(stats_counter c, uint32_t n) {
+	if ((unsigned)c < NUM_STATS_COUNTERS) {
+		s_STATS_block.counters[c] += n;
+	}
+}
+
+void STATS_strobe(uint8_t strobe) {
+	if (strobe >= STROBE_ADDRESS_START && strobe <= STROBE_ADDRESS_END) {
+		s_STATS_block.strobes[strobe - STROBE_ADDRESS_START]++;
+	}
+}
+
+uint64_t STATS_start(void) {
+	return CLOCK_now_us();
+}
+
+void STATS_record(stats_api api, uint64_t start, tcvr_error_t err) {
+	stats_histogram* h;
+	uint64_t         took = CLOCK_now_us() - start;
+	uint32_t         us = (took > UINT32_MAX) ? UINT32_MAX : (uint32_t)took;
+
+	if ((unsigned)api >= NUM_STATS_APIS) {
+		return;
+	}
+	h = &s_STATS_block.apis[api];
+
+	if (h->count == 0 || us < h->min_us) {
+		h->min_us = us;
+	}
+	if (us > h->max_us) {
+		h->max_us = us;
+	}
+	h->count++;
+	h->total_us += us;
+	h->buckets[s_STATS_bucket(us)]++;
+	if (err != ERROR_NONE) {
+		h->errors++;
+	}
+}
+
+void STATS_snapshot(stats_block* out) {
+	if (out) {
+		memcpy(out, &s_STATS_block, sizeof(*out));
+	}
+}
+
+void STATS_reset(void) {
+	memset(&s_STATS_block, 0, sizeof(s_STATS_block));
+	s_STATS_block.since_us = CLOCK_now_us();
+}
+
+uint32_t STATS_percentile(const stats_histogram* h, double fraction) {
+	uint64_t want;
+	uint64_t seen = 0;
+	uint32_t top;
+	uint32_t i;
+
+	if (!h || h->count == 0) {
+		return 0;
+	}
+	fraction = (fraction < 0) ? 0 : (fraction > 1) ? 1 : fraction;
+	want = (uint64_t)(fraction * h->count + 0.5);
+	want = (want == 0) ? 1 : want;
+
+	for (i = 0; i < STATS_BUCKETS; i++) {
+		seen += h->buckets[i];
+		if (seen >= want) {
+			top = s_STATS_bucket_top(i);
+			return (top < h->max_us) ? top : h->max_us;
+		}
+	}
+	return h->max_us;
+}
+
+#ifndef TCVR_FREESTANDING
+typedef struct stats_writer_s {
+	char*    buf;
+	uint32_t len;
+	uint32_t pos;
+	int      full;
+} stats_writer;
+
+static void s_STATS_printf(stats_writer* w, const char* fmt, ...) {
+	va_list args;
+	int     n;
+
+	if (w->full) {
+		return;
+	}
+	va_start(args, fmt);
+	n = vsnprintf(w->buf + w->pos, w->len - w->pos, fmt, args);
+	va_end(args);
+
+	if (n < 0 || (uint32_t)n >= w->len - w->pos) {
+		// keep what fit
+		w->pos = w->len - 1;
+		w->full = 1;
+		return;
+	}
+	w->pos += (uint32_t)n;
+}
+
+static tcvr_error_t s_STATS_finish(const stats_writer* w, uint32_t* written) {
+	if (written) {
+		*written = w->pos;
+	}
+	return w->full ? ERROR_STATS_BUFFER_TOO_SMALL : ERROR_NONE;
+}
+
+static uint32_t s_STATS_mean(const stats_histogram* h) {
+	return h->count ? (uint32_t)(h->total_us / h->count) : 0;
+}
+
+tcvr_error_t STATS_format_text(const stats_block* sb, char* buf, uint32_t len, uint32_t* written) {
+	stats_writer           w = { buf, len, 0, 0 };
+	const stats_histogram* h;
+	int                    i;
+
+	if (!sb || !buf) {
+		return ERROR_NULL_POINTER;
+	}
+	if (len == 0) {
+		return ERROR_STATS_BUFFER_TOO_SMALL;
+	}
+	buf[0] = '\0';
+
+	for (i = 0; i < NUM_STATS_COUNTERS; i++) {
+		s_STATS_printf(&w, "%-16s %llu\n", s_STATS_counter_names[i], (unsigned long long)sb->counters[i]);
+	}
+
+	s_STATS_printf(&w, "strobes         ");
+	for (i = 0; i < STATS_NUM_STROBES; i++) {
+		if (sb->strobes[i]) {
+			s_STATS_printf(&w, " %s %u", s_STATS_strobe_names[i], (unsigned)sb->strobes[i]);
+		}
+	}
+	s_STATS_printf(&w, "\n");
+
+	s_STATS_printf(&w, "%-22s %8s %6s %6s %6s %6s %6s %6s %6s\n",
+	               "api (us)", "calls", "errors", "min", "mean", "p50", "p99", "p99.9", "max");
+	for (i = 0; i < NUM_STATS_APIS; i++) {
+		h = &sb->apis[i];
+		if (h->count == 0) {
+			continue;
+		}
+		s_STATS_printf(&w, "%-22s %8u %6u %6u %6u %6u %6u %6u %6u\n", s_STATS_api_names[i],
+		               (unsigned)h->count, (unsigned)h->errors, (unsigned)h->min_us, (unsigned)s_STATS_mean(h),
+		               (unsigned)STATS_percentile(h, 0.5), (unsigned)STATS_percentile(h, 0.99),
+		               (unsigned)STATS_percentile(h, 0.999), (unsigned)h->max_us);
+	}
+
+	return s_STATS_finish(&w, written);
+}
+
+tcvr_error_t STATS_format_json(const stats_block* sb, char* buf, uint32_t len, uint32_t* written) {
+	stats_writer           w = { buf, len, 0, 0 };
+	const stats_histogram* h;
+	int                    i;
+
+	if (!sb || !buf) {
+		return ERROR_NULL_POINTER;
+	}
+	if (len == 0) {
+		return ERROR_STATS_BUFFER_TOO_SMALL;
+	}
+	buf[0] = '\0';
+
+	s_STATS_printf(&w, "{\"since_us\":%llu,\"counters\":{", (unsigned long long)sb->since_us);
+	for (i = 0; i < NUM_STATS_COUNTERS; i++) {
+		s_STATS_printf(&w, "%s\"%s\":%llu", i ? "," : "", s_STATS_counter_names[i],
+		               (unsigned long long)sb->counters[i]);
+	}
+
+	s_STATS_printf(&w, "},\"strobes\":{");
+	for (i = 0; i < STATS_NUM_STROBES; i++) {
+		s_STATS_printf(&w, "%s\"%s\":%u", i ? "," : "", s_STATS_strobe_names[i], (unsigned)sb->strobes[i]);
+	}
+
+	s_STATS_printf(&w, "},\"latency_us\":{");
+	for (i = 0; i < NUM_STATS_APIS; i++) {
+		h = &sb->apis[i];
+		s_STATS_printf(&w, "%s\"%s\":{\"calls\":%u,\"errors\":%u,\"min\":%u,\"mean\":%u,"
+		               "\"p50\":%u,\"p90\":%u,\"p99\":%u,\"p999\":%u,\"max\":%u}",
+		               i ? "," : "", s_STATS_api_names[i], (unsigned)h->count, (unsigned)h->errors,
+		               (unsigned)h->min_us, (unsigned)s_STATS_mean(h), (unsigned)STATS_percentile(h, 0.5),
+		               (unsigned)STATS_percentile(h, 0.9), (unsigned)STATS_percentile(h, 0.99),
+		               (unsigned)STATS_percentile(h, 0.999), (unsigned)h->max_us);
+	}
+	s_STATS_printf(&w, "}}");
+
+	return s_STATS_finish(&w, written);
+}
+#endif
@@ -0,0 +1,117 @@
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <stdint.h>
+#include "error.h"
+
+/*
+	Always-on counters and latency histograms for the device.
+
+	There is one block, on its own cache lines, written only by
+	whichever thread owns the bus (see radio_service.h), so the
+	counts are plain increments with no locking. A snapshot taken
+	from another thread while the bus is busy may be a call or
+	two out of date.
+
+	Latencies are whole API calls, in microseconds from
+	CLOCK_now_us, kept in HDR-style histograms: exact below 16 us,
+	then 8 buckets per power of two, so any value is within 12.5%
+	from 0 to over an hour in 240 buckets.
+*/
+typedef enum stats_api_e {
+	STATS_API_REGISTER_READ,
+	STATS_API_REGISTER_WRITE,
+	STATS_API_REGISTER_BURST_READ,
+	STATS_API_REGISTER_BURST_WRITE,
+	STATS_API_STROBE,
+	STATS_API_RX,          // RX_dequeue, RX_burst_dequeue
+	STATS_API_TX,          // TX_enqueue, TX_burst_enqueue*
+	NUM_STATS_APIS
+} stats_api;
+
+typedef enum stats_counter_e {
+	STATS_CSN_CYCLES,      // SPI transactions on the bus
+	STATS_BYTES,           // bytes clocked either way
+	STATS_RETRIES,         // transfers repeated after an error
+	STATS_RX_FIFO_ERRORS,
+	STATS_TX_FIFO_ERRORS,
+	NUM_STATS_COUNTERS
+} stats_counter;
+
+// strobes by type, indexed by strobe_name - STROBE_ADDRESS_START
+#define STATS_NUM_STROBES 14
+
+#define STATS_SUB_BITS    3
+#define STATS_SUB_BUCKETS (1 << STATS_SUB_BITS)
+#define STATS_BUCKETS     ((32 - STATS_SUB_BITS + 1) * STATS_SUB_BUCKETS)
+
+#define STATS_CACHE_LINE  64
+
+typedef struct stats_histogram_s {
+	uint32_t count;
+	uint32_t errors;       // calls that didn't return ERROR_NONE
+	uint32_t min_us;
+	uint32_t max_us;
+	uint64_t total_us;
+	uint32_t buckets[STATS_BUCKETS];
+} stats_histogram;
+
+typedef struct stats_block_s {
+	_Alignas(STATS_CACHE_LINE)
+	uint64_t        counters[NUM_STATS_COUNTERS];
+	uint32_t        strobes[STATS_NUM_STROBES];
+	uint64_t        since_us;  // when last reset
+	stats_histogram apis[NUM_STATS_APIS];
+} stats_block;
+
+/*
+	Adds n to a counter.
+*/
+void STATS_add(stats_counter c, uint32_t n);
+
+/*
+	Counts a strobe.
+*/
+void STATS_strobe(uint8_t strobe);
+
+/*
+	Returns the time to pass to STATS_record when the call ends.
+*/
+uint64_t STATS_start(void);
+
+/*
+	Records a call to api that started at start and returned err.
+*/
+void STATS_record(stats_api api, uint64_t start, tcvr_error_t err);
+
+/*
+	Copies out the block.
+*/
+void STATS_snapshot(stats_block* out);
+
+/*
+	Zeroes the block and starts counting again from now.
+*/
+void STATS_reset(void);
+
+/*
+	Returns the smallest latency at least fraction (0 to 1) of
+	the calls took no longer than, to within a bucket, or 0 if
+	there were none.
+*/
+uint32_t STATS_percentile(const stats_histogram* h, double fraction);
+
+#ifndef TCVR_FREESTANDING
+/*
+	Writes a snapshot as human readable text or as a JSON object
+	into buf, NUL terminated. Outputs the length written.
+	Returns ERROR_NONE if successful, ERROR_STATS_BUFFER_TOO_SMALL
+	if it didn't fit, in which case buf holds as much as did.
+	Not in the freestanding build, which has no stdio: send the
+	stats_block down and format it on the ground.
+*/
+tcvr_error_t STATS_format_text(const stats_block* sb, char* buf, uint32_t len, uint32_t* written);
+tcvr_error_t STATS_format_json(const stats_block* sb, char* buf, uint32_t len, uint32_t* written);
+#endif
+
+#endif
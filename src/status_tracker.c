@@ -0,0 +1,150 @@
+
+#include <stdint.h>
+
+#include "error.h"
+#include "spi.h"
+#include "strobe.h"
+#include "status_byte.h"
+#include "clock.h"
+#include "status_tracker.h"
+
+static status_tracker* s_STATUS_TRACKER_attached = 0;
+
+static void s_STATUS_TRACKER_hook(uint8_t status_byte, void* ctx) {
+	STATUS_TRACKER_record((status_tracker*)ctx, status_byte);
+}
+
+void STATUS_TRACKER_init(status_tracker* st) {
+	int i;
+
+	if (!st) {
+		return;
+	}
+
+	st->last = 0xff;
+	st->state = STATUS_IDLE;
+	st->ready = 0;
+	st->rx_fifo_error = 0;
+	st->tx_fifo_error = 0;
+	st->attached = 0;
+	st->seen_us = 0;
+	st->changed_us = 0;
+	for (i = 0; i < 8; i++) {
+		st->entered_us[i] = 0;
+	}
+	st->transitions = 0;
+	st->status_bytes = 0;
+	st->polls = 0;
+}
+
+void STATUS_TRACKER_attach(status_tracker* st) {
+	if (s_STATUS_TRACKER_attached) {
+		s_STATUS_TRACKER_attached->attached = 0;
+	}
+
+	s_STATUS_TRACKER_attached = st;
+	if (st) {
+		st->attached = 1;
+		SPI_set_status_hook(s_STATUS_TRACKER_hook, st);
+	}
+	else {
+		SPI_set_status_hook(0, 0);
+	}
+}
+
+status_tracker* STATUS_TRACKER_attached(void) {
+	return s_STATUS_TRACKER_attached;
+}
+
+void STATUS_TRACKER_record(status_tracker* st, uint8_t status_byte) {
+	uint64_t    now;
+	chip_status cs;
+
+	if (!st) {
+		return;
+	}
+
+	now = CLOCK_now_us();
+	st->last = status_byte;
+	st->seen_us = now;
+	st->status_bytes++;
+
+	st->ready = (uint8_t)STATUS_chip_is_ready(status_byte);
+	if (!st->ready) {
+		return;
+	}
+
+	cs = STATUS_get_chip_status(status_byte);
+	if (cs == STATUS_RXFIFOERROR) {
+		st->rx_fifo_error = 1;
+	}
+	else if (cs == STATUS_TXFIFOERROR) {
+		st->tx_fifo_error = 1;
+	}
+
+	if (cs != st->state) {
+		st->state = cs;
+		st->changed_us = now;
+		st->entered_us[cs] = now;
+		st->transitions++;
+	}
+}
+
+void STATUS_TRACKER_clear_fifo_errors(status_tracker* st) {
+	if (st) {
+		st->rx_fifo_error = 0;
+		st->tx_fifo_error = 0;
+	}
+}
+
+tcvr_error_t STATUS_TRACKER_wait_for_state(status_tracker* st, chip_status cs, uint32_t timeout_us, uint8_t* status) {
+	tcvr_error_t err;
+	uint64_t     start;
+	uint64_t     now;
+	uint64_t     last;
+	uint32_t     same = 0;
+	uint32_t     polls = 0;
+	uint32_t     max_polls = timeout_us / STATUS_TRACKER_STALE_US + 1;
+	uint8_t      byt;
+
+	if (!st) {
+		return ERROR_NULL_POINTER;
+	}
+
+	start = CLOCK_now_us();
+	last = start;
+	for (;;) {
+		if (st->ready && st->state == cs) {
+			break;
+		}
+
+		now = CLOCK_now_us();
+		same = (now == last) ? same + 1 : 0;
+		last = now;
+		if (now - start >= timeout_us || polls >= max_polls) {
+			if (status) {
+				*status = st->last;
+			}
+			return ERROR_STATUS_TIMEOUT;
+		}
+
+		// only ask when nothing else has told us lately, or the clock can't tell
+		if (now - st->seen_us >= STATUS_TRACKER_STALE_US || same >= STATUS_TRACKER_STOPPED_CHECKS) {
+			err = STROBE_command_strobe(SNOP, &byt);
+			if (err != ERROR_NONE) {
+				return err;
+			}
+			same = 0;
+			polls++;
+			st->polls++;
+			if (!st->attached) {
+				STATUS_TRACKER_record(st, byt);
+			}
+		}
+	}
+
+	if (status) {
+		*status = st->last;
+	}
+	return ERROR_NONE;
+}
@@ -0,0 +1,89 @@
+#ifndef _STATUS_TRACKER_H_
+#define _STATUS_TRACKER_H_
+
+#include <stdint.h>
+#include "error.h"
+#include "status_byte.h"
+
+/*
+	Keeps the chip's state as of the last status byte. Every SPI
+	transaction starts with one, so once a tracker is attached
+	it is fed by whatever the driver does, and knowing the
+	state rarely costs a transaction of its own.
+
+	Status bytes clocked in while CHIP_RDYn is high (the crystal
+	not yet running, eg. waking from SLEEP) carry no state and
+	only clear the ready flag. The FIFO error flags are sticky,
+	so an error seen in passing isn't missed, until cleared.
+	Times are from CLOCK_now_us.
+*/
+typedef struct status_tracker_s {
+	uint8_t     last;            // the latest status byte
+	chip_status state;
+	uint8_t     ready;           // CHIP_RDYn was low
+	uint8_t     rx_fifo_error;   // RX FIFO error seen since cleared
+	uint8_t     tx_fifo_error;   // TX FIFO error seen since cleared
+	uint8_t     attached;
+	uint64_t    seen_us;         // when the latest status byte came in
+	uint64_t    changed_us;      // when the state last changed
+	uint64_t    entered_us[8];   // when each chip_status was last entered
+	uint32_t    transitions;
+	uint32_t    status_bytes;
+	uint32_t    polls;           // SNOPs sent by STATUS_TRACKER_wait_for_state
+} status_tracker;
+
+/*
+	How old the latest status byte may be before waiting for a
+	state sends an SNOP to get a new one.
+*/
+#define STATUS_TRACKER_STALE_US 100
+
+/*
+	How many checks in a row the clock may read the same before
+	waiting takes it to have stopped (no clock source, as on the
+	freestanding build) and sends an SNOP anyway.
+*/
+#define STATUS_TRACKER_STOPPED_CHECKS 1000
+
+/*
+	Starts a tracker that knows nothing yet.
+*/
+void STATUS_TRACKER_init(status_tracker* st);
+
+/*
+	Feeds the tracker the status byte of every SPI transaction from
+	now on. Only one tracker is attached at a time; NULL detaches.
+*/
+void STATUS_TRACKER_attach(status_tracker* st);
+
+/*
+	Returns the attached tracker, or NULL.
+*/
+status_tracker* STATUS_TRACKER_attached(void);
+
+/*
+	Records a status byte, for callers that have one from
+	somewhere other than the SPI hook.
+*/
+void STATUS_TRACKER_record(status_tracker* st, uint8_t status_byte);
+
+/*
+	Forgets the FIFO errors seen so far, eg. once they are
+	handled.
+*/
+void STATUS_TRACKER_clear_fifo_errors(status_tracker* st);
+
+/*
+	Waits until the chip is ready and in state cs, for at most
+	timeout_us. The latest status byte is used as long as it is
+	fresh (STATUS_TRACKER_STALE_US); an SNOP is sent only when no
+	other transaction has brought a newer one. At most
+	timeout_us / STATUS_TRACKER_STALE_US + 1 SNOPs are sent, so
+	this times out even if the clock has stopped. Outputs the last
+	status byte.
+	Returns ERROR_NONE if successful, ERROR_STATUS_TIMEOUT if the
+	chip didn't get there in time.
+*/
+tcvr_error_t STATUS_TRACKER_wait_for_state(status_tracker* st, chip_status cs, uint32_t timeout_us, uint8_t* status);
+
+#endif
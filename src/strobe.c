@@ -4,6 +4,7 @@
 #include "error.h"
 #include "gpio.h"
 #include "spi.h"
+#include "stats.h"
 #include "strobe.h"
 
 static uint8_t s_get_address(strobe_name sn) {
@@ -14,7 +15,7 @@ static void s_delay() {
 	// nothing
 }
 
-tcvr_error_t STROBE_command_strobe(strobe_name sn, uint8_t* status) {
+static tcvr_error_t s_STROBE_command_strobe(strobe_name sn, uint8_t* status) {
 	uint8_t byt = 0;
 
 	if (sn < SRES || sn > SNOP) {
@@ -33,21 +34,33 @@ tcvr_error_t STROBE_command_strobe(strobe_name sn, uint8_t* status) {
 	// Write the address of the strobe register over SPI, which signals strobe
 	SPI_start_transaction();
 
-	byt = SPI_transfer_byte(byt);
-	if (status) {
-		*status = byt;
-	}
-
 	if (sn == SRES) {
 		// SRES is handled in a special way:
 		// we must wait until SO goes low before releasing
 		// CSn to high, ie. stopping transaction
+		byt = SPI_transfer_byte(byt);
 		while (GPIO_read_MISO() == HIGH) {
 			// wait
 			s_delay();
 		}
 	}
+	else {
+		SPI_transfer_bytes(&byt, &byt, 1);
+	}
 
 	SPI_stop_transaction();
+
+	if (status) {
+		*status = byt;
+	}
+	STATS_strobe((uint8_t)sn);
 	return ERROR_NONE;
 }
+
+tcvr_error_t STROBE_command_strobe(strobe_name sn, uint8_t* status) {
+	uint64_t     start = STATS_start();
+	tcvr_error_t err = s_STROBE_command_strobe(sn, status);
+
+	STATS_record(STATS_API_STROBE, start, err);
+	return err;
+}
@@ -0,0 +1,264 @@
+
+#include <stdint.h>
+
+#include "error.h"
+#include "bits.h"
+#include "bang_registers.h"
+#include "strobe.h"
+#include "freq_synth_config.h"
+#include "xosc.h"
+#include "clock.h"
+#include "survey.h"
+
+// SETTLING_CFG
+BITS_FIELD(SURVEY_FS_AUTOCAL, 4, 3)
+// RSSI0
+BITS_FIELD(SURVEY_CARRIER_SENSE, 2, 2)
+BITS_FIELD(SURVEY_CARRIER_SENSE_VALID, 1, 1)
+BITS_FIELD(SURVEY_RSSI_VALID, 0, 0)
+
+// calibrate on the way from IDLE to RX or TX
+#define SURVEY_FS_AUTOCAL_FROM_IDLE 1
+
+typedef struct survey_band_s {
+	uint32_t  low_hz;
+	uint32_t  high_hz;
+	uint8_t   lo_divider;
+	freq_band band;
+} survey_band;
+
+static const survey_band s_SURVEY_bands[] = {
+	{ 820000000, 960000000, 4,  FREQ_BAND_820_960 },
+	{ 420000000, 480000000, 8,  FREQ_BAND_420_480 },
+	{ 273000000, 320000000, 12, FREQ_BAND_273_320 },
+	{ 205000000, 240000000, 16, FREQ_BAND_205_240 },
+	{ 164000000, 192000000, 20, FREQ_BAND_164_192 },
+	{ 136000000, 160000000, 24, FREQ_BAND_136_160 }
+};
+
+#define SURVEY_NUM_BANDS (sizeof(s_SURVEY_bands) / sizeof(s_SURVEY_bands[0]))
+
+static const survey_band* s_SURVEY_band(uint32_t hz) {
+	uint32_t i;
+
+	for (i = 0; i < SURVEY_NUM_BANDS; i++) {
+		if (hz >= s_SURVEY_bands[i].low_hz && hz <= s_SURVEY_bands[i].high_hz) {
+			return &s_SURVEY_bands[i];
+		}
+	}
+	return 0;
+}
+
+uint32_t SURVEY_freq_word(uint32_t hz, XOSC_frequency xosc) {
+	const survey_band* b = s_SURVEY_band(hz);
+
+	if (!b) {
+		return 0;
+	}
+	// fRF = FREQ * fxosc / (LO divider * 2^16), rounded
+	return (uint32_t)((((uint64_t)hz * b->lo_divider << 16) + (uint32_t)xosc / 2) / (uint32_t)xosc);
+}
+
+tcvr_error_t SURVEY_init(survey* sv, survey_channel* channels, uint16_t num_channels,
+                         uint32_t first_hz, uint32_t spacing_hz, XOSC_frequency xosc) {
+	const survey_band* b;
+	uint32_t           last_hz;
+	uint16_t           i;
+
+	if (!sv || !channels) {
+		return ERROR_NULL_POINTER;
+	}
+	if (num_channels == 0) {
+		return ERROR_PARAMETER_OUT_OF_RANGE;
+	}
+
+	last_hz = first_hz + (uint32_t)(num_channels - 1) * spacing_hz;
+	b = s_SURVEY_band(first_hz);
+	if (!b || last_hz < first_hz || last_hz > b->high_hz) {
+		return ERROR_SURVEY_NO_BAND;
+	}
+
+	sv->channels = channels;
+	sv->num_channels = num_channels;
+	sv->band = b->band;
+	sv->first_hz = first_hz;
+	sv->spacing_hz = spacing_hz;
+	sv->settle_us = SURVEY_DEFAULT_SETTLE_US;
+	sv->threshold_dbm = SURVEY_DEFAULT_THRESHOLD_DBM;
+	sv->sweeps = 0;
+	sv->invalid = 0;
+	sv->last_sweep_us = 0;
+	sv->max_dwell_us = 0;
+
+	for (i = 0; i < num_channels; i++) {
+		channels[i].freq_word = SURVEY_freq_word(first_hz + (uint32_t)i * spacing_hz, xosc);
+		channels[i].samples = 0;
+		channels[i].busy = 0;
+		channels[i].total_dbm = 0;
+		channels[i].peak_dbm = INT8_MIN;
+	}
+	return ERROR_NONE;
+}
+
+tcvr_error_t SURVEY_sample(survey* sv, uint16_t i, uint8_t* status) {
+	tcvr_error_t    err;
+	survey_channel* ch;
+	uint8_t         freq[3];
+	uint8_t         rssi[2];
+	uint64_t        start;
+	uint64_t        rx;
+	uint64_t        now;
+	uint64_t        last;
+	uint32_t        same = 0;
+	uint32_t        polls;
+	int8_t          dbm;
+
+	if (!sv || !sv->channels) {
+		return ERROR_NULL_POINTER;
+	}
+	if (i >= sv->num_channels) {
+		return ERROR_PARAMETER_OUT_OF_RANGE;
+	}
+	ch = &sv->channels[i];
+
+	// FREQ2 holds the top byte, FREQ1 and FREQ0 follow it
+	freq[0] = (uint8_t)(ch->freq_word >> 16);
+	freq[1] = (uint8_t)(ch->freq_word >> 8);
+	freq[2] = (uint8_t)ch->freq_word;
+
+	start = CLOCK_now_us();
+	err = STROBE_command_strobe(SIDLE, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+	err = REGISTER_burst_write(FREQ2, freq, sizeof(freq), status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+	err = STROBE_command_strobe(SRX, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	// nothing read before settle_us could be valid, unless the clock has stopped
+	rx = CLOCK_now_us();
+	last = rx;
+	do {
+		now = CLOCK_now_us();
+		same = (now == last) ? same + 1 : 0;
+		last = now;
+	} while (now - rx < sv->settle_us && same < SURVEY_STOPPED_CHECKS);
+
+	for (polls = 1; ; polls++) {
+		err = REGISTER_burst_read(RSSI1, rssi, sizeof(rssi), status);
+		now = CLOCK_now_us();
+		if (err != ERROR_NONE) {
+			return err;
+		}
+		if (SURVEY_RSSI_VALID_get(rssi[1])) {
+			break;
+		}
+		if (now - rx >= SURVEY_RSSI_TIMEOUT_US || polls >= SURVEY_MAX_POLLS) {
+			sv->invalid++;
+			return ERROR_NONE;
+		}
+	}
+
+	if (now - start > sv->max_dwell_us) {
+		sv->max_dwell_us = (uint32_t)(now - start);
+	}
+
+	// RSSI1 holds the whole dB, RSSI0 the sixteenths
+	dbm = (int8_t)rssi[0];
+	ch->samples++;
+	ch->total_dbm += dbm;
+	if (dbm > ch->peak_dbm) {
+		ch->peak_dbm = dbm;
+	}
+	if (dbm >= sv->threshold_dbm ||
+	    (SURVEY_CARRIER_SENSE_VALID_get(rssi[1]) && SURVEY_CARRIER_SENSE_get(rssi[1]))) {
+		ch->busy++;
+	}
+	return ERROR_NONE;
+}
+
+tcvr_error_t SURVEY_sweep(survey* sv, uint8_t* status) {
+	tcvr_error_t err;
+	tcvr_error_t restore_err;
+	uint64_t     start;
+	uint8_t      settling;
+	uint16_t     i;
+
+	if (!sv || !sv->channels) {
+		return ERROR_NULL_POINTER;
+	}
+
+	start = CLOCK_now_us();
+	err = REGISTER_read(SETTLING_CFG, &settling, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+	err = REGISTER_write(SETTLING_CFG, SURVEY_FS_AUTOCAL_set(settling, SURVEY_FS_AUTOCAL_FROM_IDLE), status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	err = FREQCONFIG_set_band(sv->band, status);
+	for (i = 0; i < sv->num_channels && err == ERROR_NONE; i++) {
+		err = SURVEY_sample(sv, i, status);
+	}
+
+	// put things back whatever happened
+	restore_err = STROBE_command_strobe(SIDLE, status);
+	if (restore_err == ERROR_NONE) {
+		restore_err = REGISTER_write(SETTLING_CFG, settling, status);
+	}
+	if (err == ERROR_NONE) {
+		err = restore_err;
+	}
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	sv->sweeps++;
+	sv->last_sweep_us = (uint32_t)(CLOCK_now_us() - start);
+	return ERROR_NONE;
+}
+
+tcvr_error_t SURVEY_quietest(const survey* sv, uint16_t* index) {
+	const survey_channel* best = 0;
+	const survey_channel* ch;
+	int64_t               a, b;
+	uint16_t              i;
+
+	if (!sv || !sv->channels || !index) {
+		return ERROR_NULL_POINTER;
+	}
+
+	for (i = 0; i < sv->num_channels; i++) {
+		ch = &sv->channels[i];
+		if (ch->samples == 0) {
+			continue;
+		}
+		if (!best) {
+			best = ch;
+			continue;
+		}
+		// compare busy fractions, then means, without dividing
+		a = (int64_t)ch->busy * best->samples;
+		b = (int64_t)best->busy * ch->samples;
+		if (a == b) {
+			a = (int64_t)ch->total_dbm * best->samples;
+			b = (int64_t)best->total_dbm * ch->samples;
+		}
+		if (a < b) {
+			best = ch;
+		}
+	}
+
+	if (!best) {
+		return ERROR_SURVEY_NO_SAMPLES;
+	}
+	*index = (uint16_t)(best - sv->channels);
+	return ERROR_NONE;
+}
@@ -0,0 +1,109 @@
+#ifndef _SURVEY_H_
+#define _SURVEY_H_
+
+#include <stdint.h>
+#include "error.h"
+#include "freq_synth_config.h"
+#include "xosc.h"
+
+/*
+	Sweeps the receiver across a list of evenly spaced channels,
+	reading the RSSI on each, to find out which are in use before
+	picking one for the uplink.
+
+	The FREQ words are worked out once, on SURVEY_init, so a
+	retune is just SIDLE, a 3-byte burst to FREQ2..FREQ0 and SRX,
+	with the synthesizer calibrating on the way into RX. RSSI1 and
+	RSSI0 are then burst read together, settle_us after SRX and
+	again until RSSI_VALID, so no time is spent on reads that
+	can't be valid yet. With the default settings a 435-438 MHz
+	sweep at 12.5 kHz, 241 channels, takes well under a second.
+
+	A sample is busy if the RSSI is at or over threshold_dbm, or
+	the chip's carrier sense says so. RSSI is taken as dBm, ie.
+	AGC_GAIN_ADJUST is expected to hold the board's offset.
+*/
+typedef struct survey_channel_s {
+	uint32_t freq_word;      // FREQ2..FREQ0
+	uint16_t samples;
+	uint16_t busy;
+	int32_t  total_dbm;      // for the mean
+	int8_t   peak_dbm;
+} survey_channel;
+
+typedef struct survey_s {
+	survey_channel* channels;
+	uint16_t        num_channels;
+	freq_band       band;
+	uint32_t        first_hz;
+	uint32_t        spacing_hz;
+
+	// can be changed after SURVEY_init
+	uint32_t        settle_us;
+	int8_t          threshold_dbm;
+
+	uint32_t        sweeps;
+	uint32_t        invalid;        // samples RSSI never became valid for
+	uint32_t        last_sweep_us;  // how long the last sweep took
+	uint32_t        max_dwell_us;   // longest from SIDLE to a valid RSSI
+} survey;
+
+#define SURVEY_DEFAULT_SETTLE_US     50
+#define SURVEY_DEFAULT_THRESHOLD_DBM -100
+
+// how long to wait for RSSI_VALID after SRX before giving up on a channel
+#define SURVEY_RSSI_TIMEOUT_US 2000
+
+// reading RSSI1 and RSSI0 is 4 bytes on the bus, 3.2 us at the chip's fastest
+// SPI clock of 10 MHz, so this many reads can't come in under the timeout
+#define SURVEY_MAX_POLLS SURVEY_RSSI_TIMEOUT_US
+
+// how many times in a row the clock may read the same while settling before
+// it is taken to have stopped, eg. with no clock source set
+#define SURVEY_STOPPED_CHECKS 1000000
+
+/*
+	Returns the FREQ word that tunes the chip to hz, with crystal
+	xosc, or 0 if hz is outside every band.
+*/
+uint32_t SURVEY_freq_word(uint32_t hz, XOSC_frequency xosc);
+
+/*
+	Sets up num_channels channels, first_hz apart by spacing_hz,
+	in the caller's array, and zeroes the counts.
+	Returns ERROR_NONE if successful, ERROR_SURVEY_NO_BAND if the
+	channels don't all fall in one band.
+*/
+tcvr_error_t SURVEY_init(survey* sv, survey_channel* channels, uint16_t num_channels,
+                         uint32_t first_hz, uint32_t spacing_hz, XOSC_frequency xosc);
+
+/*
+	Takes one sample on channel i. The chip is left in RX there.
+	If the clock stops, settling ends after SURVEY_STOPPED_CHECKS
+	reads of it, and RSSI_VALID is polled SURVEY_MAX_POLLS times
+	at most.
+	Returns ERROR_NONE if successful, including when the RSSI
+	didn't become valid (counted in invalid), or the error from
+	the strobes or register accesses.
+*/
+tcvr_error_t SURVEY_sample(survey* sv, uint16_t i, uint8_t* status);
+
+/*
+	Takes a sample on every channel in turn, with the band set
+	and automatic calibration on for the sweep, and leaves the
+	chip in IDLE with SETTLING_CFG as it was. The chip's FREQ is
+	left on the last channel.
+	Returns ERROR_NONE if successful, or the first error from
+	SURVEY_sample or the register accesses.
+*/
+tcvr_error_t SURVEY_sweep(survey* sv, uint8_t* status);
+
+/*
+	Outputs the channel that was busy least often, and of those
+	the one with the lowest mean RSSI.
+	Returns ERROR_NONE if successful, ERROR_SURVEY_NO_SAMPLES if
+	no channel has been sampled.
+*/
+tcvr_error_t SURVEY_quietest(const survey* sv, uint16_t* index);
+
+#endif
@@ -0,0 +1,63 @@
+# Shared by src/Makefile, simulator/Makefile and orbital/Makefile: the
+# driver's sources, the build configurations and how objects are made.
+#
+#   make CONFIG=debug    -g, no optimization (the default)
+#   make CONFIG=release  -O2 and link-time optimization, so the SPI calls
+#                        inline into the register and FIFO loops across files
+#   make CONFIG=profile  release plus -g and frame pointers, for perf
+#   make CONFIG=pgo      release, built with a profile from the simulator
+#                        (make pgo in simulator/ does both passes)
+#
+# make DEBUG=1 traces every register access and bit on the bus on stdout.
+# Everything for a configuration goes in out/CONFIG next to this file.
+
+TRANSCEIVER_DIR:=$(patsubst ./,,$(dir $(lastword $(MAKEFILE_LIST))))
+
+CC=gcc
+AR=gcc-ar
+CONFIG?=debug
+PGO?=use
+
+TRANSCEIVER_SRCS=bits.c spi.c bang_registers.c strobe.c status_byte.c rxtx.c xosc.c freq_synth_config.c \
+	chip_reset.c doppler_table.c rate_plan.c packet_ring.c radio_service.c crc.c whitening.c conv.c \
+	reed_solomon.c ax25.c tx_batch.c power.c clock.c status_tracker.c turnaround.c stats.c survey.c \
+	afc.c arq.c compress.c
+
+WARNINGS=-Wall -Werror -Wextra -Wno-unused-parameter
+
+ifeq ($(CONFIG),debug)
+OPTFLAGS=-g
+else ifeq ($(CONFIG),release)
+OPTFLAGS=-O2 -flto=auto
+else ifeq ($(CONFIG),profile)
+OPTFLAGS=-O2 -flto=auto -g -fno-omit-frame-pointer
+else ifeq ($(CONFIG),pgo)
+ifeq ($(PGO),generate)
+OPTFLAGS=-O2 -flto=auto -fprofile-generate -fprofile-update=atomic
+else
+OPTFLAGS=-O2 -flto=auto -fprofile-use -fprofile-partial-training -Wno-missing-profile
+endif
+else
+$(error CONFIG must be debug, release, profile or pgo)
+endif
+
+OUT=$(TRANSCEIVER_DIR)out/$(CONFIG)$(if $(DEBUG),-trace)
+
+CFLAGS=$(WARNINGS) $(OPTFLAGS) -MMD -MP
+ifdef DEBUG
+CFLAGS+=-D_DEBUG_BANG_REGISTERS_ -D_DEBUG_SIM_ -D_DEBUG_SIM_GPIO_
+endif
+LDFLAGS=$(OPTFLAGS) -pthread
+
+TRANSCEIVER_OBJS=$(addprefix $(OUT)/,$(TRANSCEIVER_SRCS:.c=.o))
+TRANSCEIVER_LIB=$(OUT)/libtransceiver.a
+
+$(TRANSCEIVER_LIB): $(TRANSCEIVER_OBJS)
+	rm -f $@
+	$(AR) rcs $@ $^
+
+$(OUT)/%.o: $(TRANSCEIVER_DIR)%.c
+	@mkdir -p $(@D)
+	$(CC) $(CFLAGS) -c $< -o $@
+
+-include $(TRANSCEIVER_OBJS:.o=.d)
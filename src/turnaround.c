@@ -0,0 +1,249 @@
+
+#include <stdint.h>
+
+#include "error.h"
+#include "bits.h"
+#include "bang_registers.h"
+#include "strobe.h"
+#include "status_byte.h"
+#include "rxtx.h"
+#include "clock.h"
+#include "turnaround.h"
+
+// SETTLING_CFG
+BITS_FIELD(TURNAROUND_FS_AUTOCAL, 4, 3)
+BITS_FIELD(TURNAROUND_LOCK_TIME, 2, 1)
+BITS_FIELD(TURNAROUND_FSREG_TIME, 0, 0)
+// RFEND_CFG0
+BITS_FIELD(TURNAROUND_TXOFF_MODE, 5, 4)
+
+#define TURNAROUND_FS_AUTOCAL_NEVER 0
+#define TURNAROUND_TXOFF_MODE_RX    3
+
+// FS_AUTOCAL never, LOCK_TIME 75/30 us, FSREG_TIME 60 us (reset value but for FS_AUTOCAL)
+#define TURNAROUND_SETTLING_CFG (BITS_FIELD_CONST(TURNAROUND_FS_AUTOCAL, TURNAROUND_FS_AUTOCAL_NEVER) | \
+                                 BITS_FIELD_CONST(TURNAROUND_LOCK_TIME, 1) | BITS_FIELD_CONST(TURNAROUND_FSREG_TIME, 1))
+// TXOFF_MODE RX, the rest at reset values
+#define TURNAROUND_RFEND_CFG0   BITS_FIELD_CONST(TURNAROUND_TXOFF_MODE, TURNAROUND_TXOFF_MODE_RX)
+
+/*
+	Sends SNOPs until the chip reports cs, at most
+	TURNAROUND_MAX_POLLS of them, so a stopped clock can't keep
+	it waiting. Outputs when it first did.
+*/
+static tcvr_error_t s_TURNAROUND_wait(chip_status cs, uint64_t* when, uint8_t* status) {
+	tcvr_error_t err;
+	uint64_t     start = CLOCK_now_us();
+	uint64_t     now;
+	uint32_t     polls;
+
+	for (polls = 1; ; polls++) {
+		err = STROBE_command_strobe(SNOP, status);
+		now = CLOCK_now_us();
+		if (err != ERROR_NONE) {
+			return err;
+		}
+		if (STATUS_chip_is_ready(*status) && STATUS_get_chip_status(*status) == cs) {
+			break;
+		}
+		if (now - start >= TURNAROUND_TIMEOUT_US || polls >= TURNAROUND_MAX_POLLS) {
+			return ERROR_STATUS_TIMEOUT;
+		}
+	}
+
+	if (when) {
+		*when = now;
+	}
+	return ERROR_NONE;
+}
+
+tcvr_error_t TURNAROUND_init(turnaround* ta, uint32_t cal_interval_us, uint32_t park_lead_us, uint8_t* status) {
+	tcvr_error_t err;
+
+	if (!ta) {
+		return ERROR_NULL_POINTER;
+	}
+
+	ta->state = TURNAROUND_IDLE;
+	ta->cal_interval_us = cal_interval_us;
+	ta->park_lead_us = park_lead_us;
+	ta->last_cal_us = 0;
+	ta->fire_at_us = 0;
+	ta->last_latency_us = 0;
+	ta->min_latency_us = UINT32_MAX;
+	ta->max_latency_us = 0;
+	ta->total_latency_us = 0;
+	ta->fired = 0;
+	ta->late = 0;
+	ta->max_late_us = 0;
+	ta->calibrations = 0;
+
+	err = REGISTER_write(SETTLING_CFG, TURNAROUND_SETTLING_CFG, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+	err = REGISTER_write(RFEND_CFG0, TURNAROUND_RFEND_CFG0, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	return TURNAROUND_calibrate(ta, status);
+}
+
+tcvr_error_t TURNAROUND_calibrate(turnaround* ta, uint8_t* status) {
+	tcvr_error_t err;
+	uint8_t      byt;
+
+	if (!ta) {
+		return ERROR_NULL_POINTER;
+	}
+	if (ta->state != TURNAROUND_IDLE) {
+		return ERROR_TURNAROUND_BUSY;
+	}
+	if (!status) {
+		status = &byt;
+	}
+
+	err = STROBE_command_strobe(SCAL, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+	err = s_TURNAROUND_wait(STATUS_IDLE, &ta->last_cal_us, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	ta->calibrations++;
+	return ERROR_NONE;
+}
+
+tcvr_error_t TURNAROUND_schedule(turnaround* ta, uint8_t* frame, uint8_t len, uint64_t fire_at_us, uint8_t* status) {
+	tcvr_error_t err;
+
+	if (!ta || !frame) {
+		return ERROR_NULL_POINTER;
+	}
+	if (ta->state != TURNAROUND_IDLE) {
+		return ERROR_TURNAROUND_BUSY;
+	}
+
+	// the TX FIFO takes writes in any state, so the frame is ready long before STX
+	err = TX_burst_enqueue(frame, len, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	ta->fire_at_us = fire_at_us;
+	ta->state = TURNAROUND_SCHEDULED;
+	return ERROR_NONE;
+}
+
+tcvr_error_t TURNAROUND_poll(turnaround* ta, uint8_t* status) {
+	tcvr_error_t err;
+	uint64_t     now;
+	uint8_t      byt;
+
+	if (!ta) {
+		return ERROR_NULL_POINTER;
+	}
+	if (!status) {
+		status = &byt;
+	}
+	now = CLOCK_now_us();
+
+	if (ta->state == TURNAROUND_SCHEDULED) {
+		if (now + ta->park_lead_us < ta->fire_at_us) {
+			return ERROR_NONE;
+		}
+		// synthesizer on and locked, STX then only has the PA to ramp
+		err = STROBE_command_strobe(SFSTXON, status);
+		if (err == ERROR_NONE) {
+			ta->state = TURNAROUND_PARKED;
+		}
+		return err;
+	}
+
+	if (ta->state == TURNAROUND_IDLE && ta->cal_interval_us && now - ta->last_cal_us >= ta->cal_interval_us) {
+		// only calibrate a chip that is idle, never pull it out of RX for it
+		err = STROBE_command_strobe(SNOP, status);
+		if (err != ERROR_NONE) {
+			return err;
+		}
+		if (STATUS_chip_is_ready(*status) && STATUS_get_chip_status(*status) == STATUS_IDLE) {
+			return TURNAROUND_calibrate(ta, status);
+		}
+	}
+	return ERROR_NONE;
+}
+
+tcvr_error_t TURNAROUND_fire(turnaround* ta, uint8_t* status) {
+	tcvr_error_t err;
+	uint64_t     now;
+	uint64_t     strobed;
+	uint64_t     in_tx;
+	uint64_t     last;
+	uint32_t     same = 0;
+	uint32_t     late;
+	uint8_t      byt;
+
+	if (!ta) {
+		return ERROR_NULL_POINTER;
+	}
+	if (ta->state == TURNAROUND_IDLE) {
+		return ERROR_TURNAROUND_NOTHING_SCHEDULED;
+	}
+	if (!status) {
+		status = &byt;
+	}
+
+	if (ta->state == TURNAROUND_SCHEDULED) {
+		err = STROBE_command_strobe(SFSTXON, status);
+		if (err != ERROR_NONE) {
+			return err;
+		}
+		ta->state = TURNAROUND_PARKED;
+	}
+
+	if (CLOCK_now_us() > ta->fire_at_us) {
+		ta->late++;
+	}
+
+	// spin, a sleep would be far coarser than the turnaround itself
+	last = CLOCK_now_us();
+	do {
+		now = CLOCK_now_us();
+		same = (now == last) ? same + 1 : 0;
+		last = now;
+		if (same >= TURNAROUND_STOPPED_CHECKS) {
+			return ERROR_TURNAROUND_CLOCK_STOPPED;
+		}
+	} while (now < ta->fire_at_us);
+
+	err = STROBE_command_strobe(STX, status);
+	strobed = CLOCK_now_us();
+	if (err != ERROR_NONE) {
+		return err;
+	}
+	ta->state = TURNAROUND_IDLE;
+
+	late = (uint32_t)(strobed - ta->fire_at_us);
+	if (late > ta->max_late_us) {
+		ta->max_late_us = late;
+	}
+
+	err = s_TURNAROUND_wait(STATUS_TX, &in_tx, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	ta->last_latency_us = (uint32_t)(in_tx - strobed);
+	if (ta->last_latency_us < ta->min_latency_us) {
+		ta->min_latency_us = ta->last_latency_us;
+	}
+	if (ta->last_latency_us > ta->max_latency_us) {
+		ta->max_latency_us = ta->last_latency_us;
+	}
+	ta->total_latency_us += ta->last_latency_us;
+	ta->fired++;
+	return ERROR_NONE;
+}
@@ -0,0 +1,108 @@
+#ifndef _TURNAROUND_H_
+#define _TURNAROUND_H_
+
+#include <stdint.h>
+#include "error.h"
+
+/*
+	Sequences the strobes around a scheduled transmission so the
+	switch to TX costs as little as it can.
+
+	Automatic calibration (SETTLING_CFG.FS_AUTOCAL) is turned off,
+	so neither STX nor SRX waits for the synthesizer to calibrate.
+	Instead it is calibrated with SCAL while the chip is idle, on
+	TURNAROUND_init, every cal_interval and on demand, eg. after a
+	change of channel. TXOFF_MODE is RX, so the chip goes back to
+	listening as soon as the frame is out, eg. for the ACK.
+
+	A transmission is scheduled with its frame, which goes into
+	the TX FIFO straight away. TURNAROUND_poll parks the chip in
+	FSTXON, synthesizer locked, park_lead ahead of the time, and
+	TURNAROUND_fire waits out the rest and strobes STX on time.
+	Times are from CLOCK_now_us.
+*/
+typedef enum turnaround_state_e {
+	TURNAROUND_IDLE,       // nothing scheduled
+	TURNAROUND_SCHEDULED,  // frame in the TX FIFO, waiting to park
+	TURNAROUND_PARKED      // in FSTXON, waiting to fire
+} turnaround_state;
+
+typedef struct turnaround_s {
+	turnaround_state state;
+	uint32_t         cal_interval_us;
+	uint32_t         park_lead_us;
+	uint64_t         last_cal_us;
+	uint64_t         fire_at_us;
+
+	// STX to the chip reporting TX, measured
+	uint32_t         last_latency_us;
+	uint32_t         min_latency_us;
+	uint32_t         max_latency_us;
+	uint64_t         total_latency_us;
+	uint32_t         fired;
+	uint32_t         late;          // already overdue when fired
+	uint32_t         max_late_us;   // worst STX after its time
+	uint32_t         calibrations;
+} turnaround;
+
+// how long to wait for the chip to report TX after STX, or IDLE after SCAL
+#define TURNAROUND_TIMEOUT_US 2000
+
+// an SNOP is one byte on the bus, 0.8 us at the chip's fastest SPI clock
+// of 10 MHz, so even back to back this many take 3.2 ms, past the timeout
+#define TURNAROUND_MAX_POLLS (2 * TURNAROUND_TIMEOUT_US)
+
+// how many times in a row the clock may read the same before it is
+// taken to have stopped, eg. with no clock source set
+#define TURNAROUND_STOPPED_CHECKS 1000000
+
+/*
+	Turns automatic calibration off, sets TXOFF_MODE to RX and
+	calibrates. The chip must be in IDLE.
+	Returns ERROR_NONE if successful, ERROR_STATUS_TIMEOUT if the
+	calibration didn't finish, or the error from the register
+	writes or strobes.
+*/
+tcvr_error_t TURNAROUND_init(turnaround* ta, uint32_t cal_interval_us, uint32_t park_lead_us, uint8_t* status);
+
+/*
+	Calibrates the synthesizer (SCAL), from IDLE, and waits for
+	it to finish.
+	Returns ERROR_NONE if successful, ERROR_TURNAROUND_BUSY if a
+	transmission is scheduled, ERROR_STATUS_TIMEOUT if the
+	calibration didn't finish.
+*/
+tcvr_error_t TURNAROUND_calibrate(turnaround* ta, uint8_t* status);
+
+/*
+	Puts frame in the TX FIFO to go out at fire_at_us.
+	Returns ERROR_NONE if successful, ERROR_TURNAROUND_BUSY if a
+	transmission is already scheduled, or the error from
+	TX_burst_enqueue.
+*/
+tcvr_error_t TURNAROUND_schedule(turnaround* ta, uint8_t* frame, uint8_t len, uint64_t fire_at_us, uint8_t* status);
+
+/*
+	Parks the chip in FSTXON once the scheduled transmission is
+	park_lead away, and recalibrates when due if nothing is
+	scheduled and the chip is in IDLE. Meant to be called often,
+	at least once per park_lead.
+	Returns ERROR_NONE if successful, or the error from the
+	strobes.
+*/
+tcvr_error_t TURNAROUND_poll(turnaround* ta, uint8_t* status);
+
+/*
+	Waits until the scheduled time, parking first if poll hasn't,
+	strobes STX and measures how long the chip takes to report
+	TX. A transmission already overdue fires straight away and
+	counts as late.
+	Returns ERROR_NONE if successful,
+	ERROR_TURNAROUND_NOTHING_SCHEDULED if there is nothing to fire,
+	ERROR_TURNAROUND_CLOCK_STOPPED if the clock stopped before the
+	time came, leaving the chip parked,
+	ERROR_STATUS_TIMEOUT if the chip didn't report TX.
+*/
+tcvr_error_t TURNAROUND_fire(turnaround* ta, uint8_t* status);
+
+#endif
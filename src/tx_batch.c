@@ -0,0 +1,124 @@
+
+#include <stdint.h>
+#include <string.h>
+
+#include "error.h"
+#include "rxtx.h"
+#include "tx_batch.h"
+
+void TX_BATCH_init(tx_batch* tb, int length_prefix, uint16_t threshold, uint32_t max_latency) {
+	if (!tb) {
+		return;
+	}
+
+	tb->len = 0;
+	tb->frames = 0;
+	tb->length_prefix = length_prefix ? 1 : 0;
+	tb->threshold = (threshold < TRANSCEIVER_FIFO_SIZE) ? threshold : TRANSCEIVER_FIFO_SIZE;
+	tb->max_latency = max_latency;
+	tb->oldest = 0;
+	tb->bursts = 0;
+	tb->frames_sent = 0;
+}
+
+static int s_TX_BATCH_overdue(const tx_batch* tb, uint32_t now) {
+	return tb->frames > 0 && (uint32_t)(now - tb->oldest) >= tb->max_latency;
+}
+
+tcvr_error_t TX_BATCH_flush(tx_batch* tb, uint8_t* frames, uint8_t* status) {
+	tcvr_error_t err;
+	uint8_t      used;
+	uint16_t     room;
+	uint16_t     n = 0;
+	uint8_t      count = 0;
+
+	if (!tb) {
+		return ERROR_NULL_POINTER;
+	}
+	if (frames) {
+		*frames = 0;
+	}
+	if (tb->frames == 0) {
+		return ERROR_NONE;
+	}
+
+	err = TX_queue_len(&used, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+	room = (used < TRANSCEIVER_FIFO_SIZE) ? TRANSCEIVER_FIFO_SIZE - used : 0;
+
+	// whole frames only, so the packet engine never runs dry mid-frame
+	while (count < tb->frames && n + tb->sizes[count] <= room) {
+		n += tb->sizes[count++];
+	}
+	if (count == 0) {
+		return ERROR_NONE;
+	}
+
+	err = TX_burst_enqueue_unchecked(tb->staged, (uint8_t)n, status);
+	if (err != ERROR_NONE) {
+		return err;
+	}
+
+	// anything left over keeps the old timestamp, so it errs on the early side
+	memmove(tb->staged, tb->staged + n, tb->len - n);
+	memmove(tb->sizes, tb->sizes + count, tb->frames - count);
+	tb->len -= n;
+	tb->frames -= count;
+
+	tb->bursts++;
+	tb->frames_sent += count;
+	if (frames) {
+		*frames = count;
+	}
+	return ERROR_NONE;
+}
+
+tcvr_error_t TX_BATCH_add(tx_batch* tb, const uint8_t* frame, uint8_t len, uint32_t now, uint8_t* status) {
+	tcvr_error_t err;
+	uint16_t     size;
+
+	if (!tb || !frame) {
+		return ERROR_NULL_POINTER;
+	}
+
+	size = (uint16_t)len + tb->length_prefix;
+	if (size > TRANSCEIVER_FIFO_SIZE) {
+		return ERROR_TX_BATCH_FRAME_TOO_LONG;
+	}
+	if (tb->len + size > TX_BATCH_SIZE || tb->frames == TX_BATCH_MAX_FRAMES) {
+		err = TX_BATCH_flush(tb, NULL, status);
+		if (err != ERROR_NONE) {
+			return err;
+		}
+		if (tb->len + size > TX_BATCH_SIZE || tb->frames == TX_BATCH_MAX_FRAMES) {
+			return ERROR_TX_BATCH_FULL;
+		}
+	}
+
+	if (tb->frames == 0) {
+		tb->oldest = now;
+	}
+	if (tb->length_prefix) {
+		tb->staged[tb->len++] = len;
+	}
+	memcpy(tb->staged + tb->len, frame, len);
+	tb->len += len;
+	tb->sizes[tb->frames++] = (uint8_t)size;
+
+	if (tb->len >= tb->threshold || s_TX_BATCH_overdue(tb, now)) {
+		return TX_BATCH_flush(tb, NULL, status);
+	}
+	return ERROR_NONE;
+}
+
+tcvr_error_t TX_BATCH_poll(tx_batch* tb, uint32_t now, uint8_t* status) {
+	if (!tb) {
+		return ERROR_NULL_POINTER;
+	}
+	if (!s_TX_BATCH_overdue(tb, now)) {
+		return ERROR_NONE;
+	}
+	return TX_BATCH_flush(tb, NULL, status);
+}
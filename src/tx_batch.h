@@ -0,0 +1,71 @@
+#ifndef _TX_BATCH_H_
+#define _TX_BATCH_H_
+
+#include <stdint.h>
+#include "error.h"
+#include "rxtx.h"
+
+/*
+	Gathers small frames bound for the TX FIFO so they go in
+	together: one NUM_TX_BYTES read and one burst for as many
+	whole frames as there is room for, instead of both for every
+	frame.
+
+	Frames are staged until threshold bytes are waiting, or the
+	oldest has waited max_latency, and then flushed. Frames that
+	don't fit in the FIFO stay staged for the next flush. In
+	variable length mode (PKT_CFG0.LENGTH_CONFIG) each frame is
+	staged behind its length byte, as the packet engine expects.
+
+	Times are whatever the caller counts in, eg. milliseconds,
+	and may wrap.
+*/
+#define TX_BATCH_SIZE       (2 * TRANSCEIVER_FIFO_SIZE)
+#define TX_BATCH_MAX_FRAMES 64
+
+typedef struct tx_batch_s {
+	uint8_t  staged[TX_BATCH_SIZE];
+	uint16_t len;            // bytes staged, length bytes included
+	uint8_t  sizes[TX_BATCH_MAX_FRAMES]; // staged size of each frame
+	uint8_t  frames;         // frames staged
+	uint8_t  length_prefix;  // nonzero in variable length mode
+	uint16_t threshold;      // bytes staged that trigger a flush
+	uint32_t max_latency;    // longest a frame waits to be flushed
+	uint32_t oldest;         // time the oldest staged frame was added
+
+	uint32_t bursts;         // bursts written to the FIFO
+	uint32_t frames_sent;
+} tx_batch;
+
+/*
+	Starts an empty batch. threshold is capped at
+	TRANSCEIVER_FIFO_SIZE.
+*/
+void TX_BATCH_init(tx_batch* tb, int length_prefix, uint16_t threshold, uint32_t max_latency);
+
+/*
+	Stages a frame of len bytes at time now, then flushes if the
+	threshold or latency cap has been reached.
+	Returns ERROR_NONE if successful, ERROR_TX_BATCH_FRAME_TOO_LONG
+	if the frame (and its length byte) is bigger than the FIFO,
+	ERROR_TX_BATCH_FULL if there is no room left to stage it even
+	after a flush, or the error from the flush.
+*/
+tcvr_error_t TX_BATCH_add(tx_batch* tb, const uint8_t* frame, uint8_t len, uint32_t now, uint8_t* status);
+
+/*
+	Flushes if the oldest staged frame has waited max_latency.
+	Meant to be called regularly, eg. from the main loop.
+	Returns ERROR_NONE if successful, or the error from the flush.
+*/
+tcvr_error_t TX_BATCH_poll(tx_batch* tb, uint32_t now, uint8_t* status);
+
+/*
+	Writes as many whole staged frames as fit in the TX FIFO, in
+	one burst. Outputs the number of frames sent, and reads chip
+	status.
+	Returns ERROR_NONE if successful, including when nothing fit.
+*/
+tcvr_error_t TX_BATCH_flush(tx_batch* tb, uint8_t* frames, uint8_t* status);
+
+#endif
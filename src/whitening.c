@@ -0,0 +1,80 @@
+
+#include <stdint.h>
+#include <string.h>
+
+#include "whitening.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define WHITEN_BLOCK 16
+#else
+#define WHITEN_BLOCK 8
+#endif
+
+/*
+	One period of the sequence, plus a block's worth repeated from
+	the start, so a block read from any position never wraps.
+*/
+static uint8_t s_WHITEN_table[WHITENING_PERIOD + WHITEN_BLOCK];
+static int     s_WHITEN_ready = 0;
+
+static void s_WHITEN_init(void) {
+	uint16_t pn9 = 0x1ff;
+	int      i, j;
+
+	for (i = 0; i < WHITENING_PERIOD; i++) {
+		s_WHITEN_table[i] = (uint8_t)(pn9 & 0xff);
+		for (j = 0; j < 8; j++) {
+			pn9 = (pn9 >> 1) | (((pn9 ^ (pn9 >> 5)) & 1) << 8);
+		}
+	}
+	memcpy(s_WHITEN_table + WHITENING_PERIOD, s_WHITEN_table, WHITEN_BLOCK);
+	s_WHITEN_ready = 1;
+}
+
+void WHITEN_reset(whitening* w) {
+	if (w) {
+		w->pos = 0;
+	}
+}
+
+void WHITEN_apply(whitening* w, uint8_t* data, uint32_t len) {
+	uint32_t pos;
+
+	if (!w || !data) {
+		return;
+	}
+	if (!s_WHITEN_ready) {
+		s_WHITEN_init();
+	}
+
+	pos = w->pos;
+	while (len >= WHITEN_BLOCK) {
+#if defined(__SSE2__)
+		__m128i d = _mm_loadu_si128((const __m128i*)data);
+		__m128i k = _mm_loadu_si128((const __m128i*)(s_WHITEN_table + pos));
+		_mm_storeu_si128((__m128i*)data, _mm_xor_si128(d, k));
+#else
+		uint64_t d, k;
+		memcpy(&d, data, 8);
+		memcpy(&k, s_WHITEN_table + pos, 8);
+		d ^= k;
+		memcpy(data, &d, 8);
+#endif
+		data += WHITEN_BLOCK;
+		len -= WHITEN_BLOCK;
+		pos += WHITEN_BLOCK;
+		if (pos >= WHITENING_PERIOD) {
+			pos -= WHITENING_PERIOD;
+		}
+	}
+
+	while (len--) {
+		*data++ ^= s_WHITEN_table[pos++];
+		if (pos == WHITENING_PERIOD) {
+			pos = 0;
+		}
+	}
+
+	w->pos = (uint16_t)pos;
+}
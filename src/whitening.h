@@ -0,0 +1,37 @@
+#ifndef _WHITENING_H_
+#define _WHITENING_H_
+
+#include <stdint.h>
+
+/*
+	Software data whitening, the same as the CC1120 packet
+	engine's (PKT_CFG1.WHITE_DATA): the data is XORed with the
+	PN9 sequence x^9 + x^5 + 1, seeded with all ones, whose first
+	bytes are ff e1 1d 9a ed 85 ...
+
+	Whitening and de-whitening are the same operation. The
+	sequence repeats every WHITENING_PERIOD bytes and is
+	precomputed, so a buffer is whitened with wide XORs rather
+	than stepping the shift register bit by bit.
+
+	A frame can be whitened in pieces, eg. as it is drained from
+	the RX FIFO, by carrying the whitening state between calls.
+*/
+#define WHITENING_PERIOD 511
+
+typedef struct whitening_s {
+	uint16_t pos; // position in the sequence of the next byte
+} whitening;
+
+/*
+	Starts a new frame at the beginning of the sequence.
+*/
+void WHITEN_reset(whitening* w);
+
+/*
+	Whitens, or de-whitens, len bytes in place, continuing the
+	sequence from the last call.
+*/
+void WHITEN_apply(whitening* w, uint8_t* data, uint32_t len);
+
+#endif